@@ -94,6 +94,9 @@ void uninit_opts(void)
     av_dict_free(&format_opts);
     av_dict_free(&codec_opts);
     av_dict_free(&resample_opts);
+
+    /* print the messages still queued by the logging thread */
+    av_log_set_flags(av_log_get_flags() & ~AV_LOG_ASYNC);
 }
 
 void log_callback_help(void *ptr, int level, const char *fmt, va_list vl)
@@ -138,6 +141,7 @@ void exit_program(int ret)
     if (program_exit)
         program_exit(ret);
 
+    av_log_set_flags(av_log_get_flags() & ~AV_LOG_ASYNC);
     exit(ret);
 }
 
@@ -887,6 +891,14 @@ int opt_loglevel(void *optctx, const char *opt, const char *arg)
     int i;
 
     flags = av_log_get_flags();
+    if (!strncmp(arg, "async", 5)) {
+        flags |= AV_LOG_ASYNC;
+        arg += 5 + (arg[5] == '+');
+        if (!*arg) {
+            av_log_set_flags(flags);
+            return 0;
+        }
+    }
     tail = strstr(arg, "repeat");
     if (tail)
         flags &= ~AV_LOG_SKIP_REPEATED;
@@ -1036,6 +1048,37 @@ int opt_max_alloc(void *optctx, const char *opt, const char *arg)
     return 0;
 }
 
+int opt_mem_flags(void *optctx, const char *opt, const char *arg)
+{
+    static const struct { const char *name; int flag; } mem_flags[] = {
+        { "slab",       AV_MEM_FLAG_SLAB       },
+        { "huge_pages", AV_MEM_FLAG_HUGE_PAGES },
+        { "counters",   AV_MEM_FLAG_COUNTERS   },
+    };
+    const char *p = arg;
+    int flags = 0;
+    int i;
+
+    if (strcmp(arg, "0")) {
+        while (*p) {
+            size_t len = strcspn(p, "+");
+
+            for (i = 0; i < FF_ARRAY_ELEMS(mem_flags); i++)
+                if (strlen(mem_flags[i].name) == len &&
+                    !strncmp(p, mem_flags[i].name, len))
+                    break;
+            if (i == FF_ARRAY_ELEMS(mem_flags)) {
+                av_log(NULL, AV_LOG_FATAL, "Invalid mem_flags \"%s\".\n", arg);
+                exit_program(1);
+            }
+            flags |= mem_flags[i].flag;
+            p += len + (p[len] == '+');
+        }
+    }
+    av_mem_set_flags(flags);
+    return 0;
+}
+
 int opt_timelimit(void *optctx, const char *opt, const char *arg)
 {
 #if HAVE_SETRLIMIT
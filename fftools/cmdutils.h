@@ -103,6 +103,11 @@ int opt_report(const char *opt);
 
 int opt_max_alloc(void *optctx, const char *opt, const char *arg);
 
+/**
+ * Set the flags of the memory allocator.
+ */
+int opt_mem_flags(void *optctx, const char *opt, const char *arg);
+
 int opt_codec_debug(void *optctx, const char *opt, const char *arg);
 
 /**
@@ -239,6 +244,7 @@ void show_help_options(const OptionDef *options, const char *msg, int req_flags,
     { "report",      0,                    { (void*)opt_report },            "generate a report" },                     \
     { "max_alloc",   HAS_ARG,              { .func_arg = opt_max_alloc },    "set maximum size of a single allocated block", "bytes" }, \
     { "cpuflags",    HAS_ARG | OPT_EXPERT, { .func_arg = opt_cpuflags },     "force specific cpu flags", "flags" },     \
+    { "mem_flags",   HAS_ARG | OPT_EXPERT, { .func_arg = opt_mem_flags },    "set memory allocator flags", "flags" },   \
     { "hide_banner", OPT_BOOL | OPT_EXPERT, {&hide_banner},     "do not show program banner", "hide_banner" },          \
     CMDUTILS_COMMON_OPTIONS_AVDEVICE                                                                                    \
 
@@ -63,6 +63,7 @@
 #include "libavutil/time.h"
 #include "libavutil/thread.h"
 #include "libavutil/threadmessage.h"
+#include "libavutil/trace.h"
 #include "libavcodec/mathops.h"
 #include "libavformat/os_support.h"
 
@@ -606,12 +607,15 @@ static void ffmpeg_cleanup(int ret)
                    av_err2str(AVERROR(errno)));
     }
     av_freep(&vstats_filename);
+    av_freep(&benchmark_trace_filename);
 
     av_freep(&input_streams);
     av_freep(&input_files);
     av_freep(&output_streams);
     av_freep(&output_files);
 
+    av_thread_pool_free(&thread_pool);
+
     uninit_opts();
 
     avformat_network_deinit();
@@ -666,6 +670,29 @@ static void update_benchmark(const char *fmt, ...)
     }
 }
 
+static void write_benchmark_trace(void)
+{
+    AVIOContext *pb;
+    AVBPrint bp;
+    int ret;
+
+    av_trace_set_flags(0);
+    av_trace_report(NULL, AV_LOG_INFO);
+
+    av_bprint_init(&bp, 0, AV_BPRINT_SIZE_UNLIMITED);
+    ret = av_trace_export_json(&bp);
+    if (ret >= 0)
+        ret = avio_open2(&pb, benchmark_trace_filename, AVIO_FLAG_WRITE, &int_cb, NULL);
+    if (ret >= 0) {
+        avio_write(pb, bp.str, bp.len);
+        ret = avio_closep(&pb);
+    }
+    if (ret < 0)
+        av_log(NULL, AV_LOG_ERROR, "Error writing the benchmark trace to %s: %s\n",
+               benchmark_trace_filename, av_err2str(ret));
+    av_bprint_finalize(&bp, NULL);
+}
+
 static void close_all_output_streams(OutputStream *ost, OSTFinished this_stream, OSTFinished others)
 {
     int i;
@@ -2931,6 +2958,7 @@ static int init_input_stream(int ist_index, char *error, int error_len)
             return ret;
         }
 
+        ist->dec_ctx->thread_pool = thread_pool;
         if ((ret = avcodec_open2(ist->dec_ctx, codec, &ist->decoder_opts)) < 0) {
             if (ret == AVERROR_EXPERIMENTAL)
                 abort_codec_experimental(codec, 0);
@@ -3485,6 +3513,7 @@ static int init_output_stream(OutputStream *ost, char *error, int error_len)
             }
         }
 
+        ost->enc_ctx->thread_pool = thread_pool;
         if ((ret = avcodec_open2(ost->enc_ctx, codec, &ost->encoder_opts)) < 0) {
             if (ret == AVERROR_EXPERIMENTAL)
                 abort_codec_experimental(codec, 1);
@@ -4842,7 +4871,17 @@ int main(int argc, char **argv)
     ti = getutime() - ti;
     if (do_benchmark) {
         av_log(NULL, AV_LOG_INFO, "bench: utime=%0.3fs\n", ti / 1000000.0);
-    }
+        if (av_mem_get_flags() & AV_MEM_FLAG_COUNTERS)
+            av_log(NULL, AV_LOG_INFO, "bench: allocs=%"PRIu64" reallocs=%"PRIu64" frees=%"PRIu64
+                   " slab_allocs=%"PRIu64" huge_allocs=%"PRIu64"\n",
+                   av_mem_get_counter(AV_MEM_COUNTER_ALLOCS),
+                   av_mem_get_counter(AV_MEM_COUNTER_REALLOCS),
+                   av_mem_get_counter(AV_MEM_COUNTER_FREES),
+                   av_mem_get_counter(AV_MEM_COUNTER_SLAB_ALLOCS),
+                   av_mem_get_counter(AV_MEM_COUNTER_HUGE_ALLOCS));
+    }
+    if (benchmark_trace_filename)
+        write_benchmark_trace();
     av_log(NULL, AV_LOG_DEBUG, "%"PRIu64" frames successfully decoded, %"PRIu64" decoding errors\n",
            decode_error_stat[0], decode_error_stat[1]);
     if ((decode_error_stat[0] + decode_error_stat[1]) * max_error_rate < decode_error_stat[1])
@@ -43,6 +43,7 @@
 #include "libavutil/rational.h"
 #include "libavutil/thread.h"
 #include "libavutil/threadmessage.h"
+#include "libavutil/threadpool.h"
 
 #include "libswresample/swresample.h"
 
@@ -580,6 +581,7 @@ extern FilterGraph **filtergraphs;
 extern int        nb_filtergraphs;
 
 extern char *vstats_filename;
+extern char *benchmark_trace_filename;
 extern char *sdp_filename;
 
 extern float audio_drift_threshold;
@@ -622,6 +624,7 @@ extern AVBufferRef *hw_device_ctx;
 extern char *qsv_device;
 #endif
 extern HWDevice *filter_hw_device;
+extern AVThreadPool *thread_pool;
 
 
 void term_init(void);
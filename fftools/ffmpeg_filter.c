@@ -1003,6 +1003,8 @@ int configure_filtergraph(FilterGraph *fg)
     cleanup_filtergraph(fg);
     if (!(fg->graph = avfilter_graph_alloc()))
         return AVERROR(ENOMEM);
+    if (thread_pool)
+        avfilter_graph_set_thread_pool(fg->graph, thread_pool);
 
     if (simple) {
         OutputStream *ost = fg->outputs[0]->ost;
@@ -40,6 +40,7 @@
 #include "libavutil/parseutils.h"
 #include "libavutil/pixdesc.h"
 #include "libavutil/pixfmt.h"
+#include "libavutil/trace.h"
 
 #define DEFAULT_PASS_LOGFILENAME_PREFIX "ffmpeg2pass"
 
@@ -79,9 +80,11 @@ const HWAccel hwaccels[] = {
 };
 AVBufferRef *hw_device_ctx;
 HWDevice *filter_hw_device;
+AVThreadPool *thread_pool;
 
 char *vstats_filename;
 char *sdp_filename;
+char *benchmark_trace_filename;
 
 float audio_drift_threshold = 0.1;
 float dts_delta_threshold   = 10;
@@ -510,6 +513,17 @@ static int opt_filter_hw_device(void *optctx, const char *opt, const char *arg)
     return 0;
 }
 
+static int opt_thread_pool(void *optctx, const char *opt, const char *arg)
+{
+    int nb_threads = parse_number_or_die(opt, arg, OPT_INT, 0, INT_MAX);
+
+    if (thread_pool) {
+        av_log(NULL, AV_LOG_ERROR, "Only one thread pool can be used.\n");
+        return AVERROR(EINVAL);
+    }
+    return av_thread_pool_alloc(&thread_pool, nb_threads);
+}
+
 /**
  * Parse a metadata specifier passed as 'arg' parameter.
  * @param arg  metadata string to parse
@@ -2830,6 +2844,16 @@ static int opt_vstats_file(void *optctx, const char *opt, const char *arg)
     return 0;
 }
 
+static int opt_benchmark_trace(void *optctx, const char *opt, const char *arg)
+{
+    av_free(benchmark_trace_filename);
+    benchmark_trace_filename = av_strdup(arg);
+    if (!benchmark_trace_filename)
+        return AVERROR(ENOMEM);
+    av_trace_set_flags(AV_TRACE_FLAG_EVENTS | AV_TRACE_FLAG_COUNTERS);
+    return 0;
+}
+
 static int opt_vstats(void *optctx, const char *opt, const char *arg)
 {
     char filename[40];
@@ -3363,6 +3387,8 @@ const OptionDef options[] = {
         "add timings for benchmarking" },
     { "benchmark_all",  OPT_BOOL | OPT_EXPERT,                       { &do_benchmark_all },
       "add timings for each task" },
+    { "benchmark_trace", HAS_ARG | OPT_EXPERT,                       { .func_arg = opt_benchmark_trace },
+      "trace the time spent in each codec, filter and format, and write it to a JSON file", "filename" },
     { "progress",       HAS_ARG | OPT_EXPERT,                        { .func_arg = opt_progress },
       "write program-readable progress information", "url" },
     { "stdin",          OPT_BOOL | OPT_EXPERT,                       { &stdin_interaction },
@@ -3432,6 +3458,8 @@ const OptionDef options[] = {
         "set stream filtergraph", "filter_graph" },
     { "filter_threads",  HAS_ARG | OPT_INT,                          { &filter_nbthreads },
         "number of non-complex filter threads" },
+    { "thread_pool",     HAS_ARG | OPT_EXPERT,                       { .func_arg = opt_thread_pool },
+        "run the slice threads of all codecs and filtergraphs on one shared pool", "nb_threads" },
     { "filter_script",  HAS_ARG | OPT_STRING | OPT_SPEC | OPT_OUTPUT, { .off = OFFSET(filter_scripts) },
         "read stream filtergraph description from a file", "filename" },
     { "reinit_filter",  HAS_ARG | OPT_INT | OPT_SPEC | OPT_INPUT,    { .off = OFFSET(reinit_filters) },
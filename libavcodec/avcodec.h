@@ -40,6 +40,7 @@
 #include "libavutil/log.h"
 #include "libavutil/pixfmt.h"
 #include "libavutil/rational.h"
+#include "libavutil/threadpool.h"
 
 #include "version.h"
 
@@ -3254,6 +3255,19 @@ typedef struct AVCodecContext {
      * (with the display dimensions being determined by the crop_* fields).
      */
     int apply_cropping;
+
+    /**
+     * Shared thread pool to run the slice threading jobs on, instead of
+     * threads owned by the codec context. thread_count then limits the number
+     * of pool threads used by this context at once, with 0 meaning the pool
+     * size + 1. Frame threading is not affected and keeps its own threads,
+     * as do decoders whose main thread waits for the slice jobs it started.
+     * The pool is owned by the caller and must outlive the codec context.
+     *
+     * - encoding: Set by user before avcodec_open2().
+     * - decoding: Set by user before avcodec_open2().
+     */
+    AVThreadPool *thread_pool;
 } AVCodecContext;
 
 #if FF_API_CODEC_GET_SET
@@ -36,6 +36,7 @@
 #include "libavutil/imgutils.h"
 #include "libavutil/internal.h"
 #include "libavutil/intmath.h"
+#include "libavutil/trace.h"
 
 #include "avcodec.h"
 #include "bytestream.h"
@@ -395,7 +396,9 @@ static int decode_simple_internal(AVCodecContext *avctx, AVFrame *frame)
     if (HAVE_THREADS && avctx->active_thread_type & FF_THREAD_FRAME) {
         ret = ff_thread_decode_frame(avctx, frame, &got_frame, pkt);
     } else {
+        int64_t trace_start = av_trace_begin();
         ret = avctx->codec->decode(avctx, frame, &got_frame, pkt);
+        av_trace_end("decode", avctx->codec->name, trace_start);
 
         if (!(avctx->codec->caps_internal & FF_CODEC_CAP_SETS_PKT_DTS))
             frame->pkt_dts = pkt->dts;
@@ -606,9 +609,11 @@ static int decode_receive_frame_internal(AVCodecContext *avctx, AVFrame *frame)
 
     av_assert0(!frame->buf[0]);
 
-    if (avctx->codec->receive_frame)
+    if (avctx->codec->receive_frame) {
+        int64_t trace_start = av_trace_begin();
         ret = avctx->codec->receive_frame(avctx, frame);
-    else
+        av_trace_end("decode", avctx->codec->name, trace_start);
+    } else
         ret = decode_simple_receive_frame(avctx, frame);
 
     if (ret == AVERROR_EOF)
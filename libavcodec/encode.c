@@ -24,6 +24,7 @@
 #include "libavutil/imgutils.h"
 #include "libavutil/internal.h"
 #include "libavutil/samplefmt.h"
+#include "libavutil/trace.h"
 
 #include "avcodec.h"
 #include "frame_thread_encoder.h"
@@ -122,6 +123,7 @@ int attribute_align_arg avcodec_encode_audio2(AVCodecContext *avctx,
 {
     AVFrame *extended_frame = NULL;
     AVFrame *padded_frame = NULL;
+    int64_t trace_start;
     int ret;
     AVPacket user_pkt = *avpkt;
     int needs_realloc = !user_pkt.data;
@@ -195,7 +197,9 @@ int attribute_align_arg avcodec_encode_audio2(AVCodecContext *avctx,
 
     av_assert0(avctx->codec->encode2);
 
+    trace_start = av_trace_begin();
     ret = avctx->codec->encode2(avctx, avpkt, frame, got_packet_ptr);
+    av_trace_end("encode", avctx->codec->name, trace_start);
     if (!ret) {
         if (*got_packet_ptr) {
             if (!(avctx->codec->capabilities & AV_CODEC_CAP_DELAY)) {
@@ -265,6 +269,7 @@ int attribute_align_arg avcodec_encode_video2(AVCodecContext *avctx,
                                               const AVFrame *frame,
                                               int *got_packet_ptr)
 {
+    int64_t trace_start;
     int ret;
     AVPacket user_pkt = *avpkt;
     int needs_realloc = !user_pkt.data;
@@ -300,7 +305,9 @@ int attribute_align_arg avcodec_encode_video2(AVCodecContext *avctx,
 
     av_assert0(avctx->codec->encode2);
 
+    trace_start = av_trace_begin();
     ret = avctx->codec->encode2(avctx, avpkt, frame, got_packet_ptr);
+    av_trace_end("encode", avctx->codec->name, trace_start);
     av_assert0(ret <= 0);
 
     emms_c();
@@ -408,8 +415,12 @@ int attribute_align_arg avcodec_send_frame(AVCodecContext *avctx, const AVFrame
             return 0;
     }
 
-    if (avctx->codec->send_frame)
-        return avctx->codec->send_frame(avctx, frame);
+    if (avctx->codec->send_frame) {
+        int64_t trace_start = av_trace_begin();
+        int ret = avctx->codec->send_frame(avctx, frame);
+        av_trace_end("encode", avctx->codec->name, trace_start);
+        return ret;
+    }
 
     // Emulation via old API. Do it here instead of avcodec_receive_packet, because:
     // 1. if the AVFrame is not refcounted, the copying will be much more
@@ -431,9 +442,14 @@ int attribute_align_arg avcodec_receive_packet(AVCodecContext *avctx, AVPacket *
         return AVERROR(EINVAL);
 
     if (avctx->codec->receive_packet) {
+        int64_t trace_start;
+        int ret;
         if (avctx->internal->draining && !(avctx->codec->capabilities & AV_CODEC_CAP_DELAY))
             return AVERROR_EOF;
-        return avctx->codec->receive_packet(avctx, avpkt);
+        trace_start = av_trace_begin();
+        ret = avctx->codec->receive_packet(avctx, avpkt);
+        av_trace_end("encode", avctx->codec->name, trace_start);
+        return ret;
     }
 
     // Emulation via old API.
@@ -139,7 +139,8 @@ int ff_slice_thread_init(AVCodecContext *avctx)
         thread_count = avctx->thread_count = 1;
 
     if (!thread_count) {
-        int nb_cpus = av_cpu_count();
+        int nb_cpus = avctx->thread_pool ? av_thread_pool_get_nb_threads(avctx->thread_pool)
+                                         : av_cpu_count();
         if  (avctx->height)
             nb_cpus = FFMIN(nb_cpus, (avctx->height+15)/16);
         // use number of cores + 1 as thread count if there is more than one
@@ -156,7 +157,8 @@ int ff_slice_thread_init(AVCodecContext *avctx)
 
     avctx->internal->thread_ctx = c = av_mallocz(sizeof(*c));
     mainfunc = avctx->codec->caps_internal & FF_CODEC_CAP_SLICE_THREAD_HAS_MF ? &main_function : NULL;
-    if (!c || (thread_count = avpriv_slicethread_create(&c->thread, avctx, worker_func, mainfunc, thread_count)) <= 1) {
+    if (!c || (thread_count = avpriv_slicethread_create_pool(&c->thread, avctx->thread_pool, avctx, avctx,
+                                                   worker_func, mainfunc, thread_count, 0)) <= 1) {
         if (c)
             avpriv_slicethread_free(&c->thread);
         av_freep(&avctx->internal->thread_ctx);
@@ -33,6 +33,7 @@
 #include "libavutil/rational.h"
 #include "libavutil/samplefmt.h"
 #include "libavutil/thread.h"
+#include "libavutil/trace.h"
 
 #define FF_INTERNAL_FIELDS 1
 #include "framequeue.h"
@@ -1462,6 +1463,7 @@ static int ff_filter_activate_default(AVFilterContext *filter)
 
 int ff_filter_activate(AVFilterContext *filter)
 {
+    int64_t trace_start = av_trace_begin();
     int ret;
 
     /* Generic timeline support is not yet implemented but should be easy */
@@ -1470,6 +1472,7 @@ int ff_filter_activate(AVFilterContext *filter)
     filter->ready = 0;
     ret = filter->filter->activate ? filter->filter->activate(filter) :
           ff_filter_activate_default(filter);
+    av_trace_end("filter", filter->filter->name, trace_start);
     if (ret == FFERROR_NOT_READY)
         ret = 0;
     return ret;
@@ -1580,8 +1583,11 @@ int ff_inlink_make_frame_writable(AVFilterLink *link, AVFrame **rframe)
 
     switch (link->type) {
     case AVMEDIA_TYPE_VIDEO:
-        av_image_copy(out->data, out->linesize, (const uint8_t **)frame->data, frame->linesize,
-                      frame->format, frame->width, frame->height);
+        ret = ff_copy_video_frame(link->dst, out, frame);
+        if (ret < 0) {
+            av_frame_free(&out);
+            return ret;
+        }
         break;
     case AVMEDIA_TYPE_AUDIO:
         av_samples_copy(out->extended_data, frame->extended_data,
@@ -46,6 +46,7 @@
 #include "libavutil/samplefmt.h"
 #include "libavutil/pixfmt.h"
 #include "libavutil/rational.h"
+#include "libavutil/threadpool.h"
 
 #include "libavfilter/version.h"
 
@@ -938,6 +939,17 @@ int avfilter_graph_create_filter(AVFilterContext **filt_ctx, const AVFilter *fil
  */
 void avfilter_graph_set_auto_convert(AVFilterGraph *graph, unsigned flags);
 
+/**
+ * Run the slice threading jobs of the filters in this graph on a shared
+ * thread pool instead of threads owned by the graph. Must be called before
+ * adding any filters to the graph; AVFilterGraph.nb_threads then limits the
+ * number of pool threads used by the graph at once, with 0 meaning the pool
+ * size + 1. The pool must outlive the graph.
+ *
+ * This has no effect if AVFilterGraph.execute is set.
+ */
+void avfilter_graph_set_thread_pool(AVFilterGraph *graph, AVThreadPool *pool);
+
 enum {
     AVFILTER_AUTO_CONVERT_ALL  =  0, /**< all automatic conversions enabled */
     AVFILTER_AUTO_CONVERT_NONE = -1, /**< all automatic conversions disabled */
@@ -596,17 +596,46 @@ static void blend_line_hv(uint8_t *dst, int dst_delta,
 {
     int x;
 
+    if (l2depth == 3 && !hsub && !vsub) {
+        /* 8-bit mask on a plane that is not subsampled: blend_pixel() reduces
+         * to a single multiply-add per pixel with the same rounding */
+        mask += xm;
+        for (x = 0; x < w; x++) {
+            const unsigned a = mask[x] * alpha;
+            dst[x * dst_delta] = ((0x1010101 - a) * dst[x * dst_delta] + a * src) >> 24;
+        }
+        return;
+    }
+
     if (left) {
         blend_pixel(dst, src, alpha, mask, mask_linesize, l2depth,
                     left, hband, hsub + vsub, xm);
         dst += dst_delta;
         xm += left;
     }
-    for (x = 0; x < w; x++) {
-        blend_pixel(dst, src, alpha, mask, mask_linesize, l2depth,
-                    1 << hsub, hband, hsub + vsub, xm);
-        dst += dst_delta;
-        xm += 1 << hsub;
+    if (l2depth == 3) {
+        /* 8-bit mask: add up the mask values without unpacking them */
+        for (x = 0; x < w; x++) {
+            const uint8_t *m = mask + xm;
+            unsigned i, y, t = 0, a;
+
+            for (y = 0; y < hband; y++) {
+                for (i = 0; i < 1 << hsub; i++)
+                    t += m[i];
+                m += mask_linesize;
+            }
+            a = (t >> (hsub + vsub)) * alpha;
+            *dst = ((0x1010101 - a) * *dst + a * src) >> 24;
+            dst += dst_delta;
+            xm += 1 << hsub;
+        }
+    } else {
+        for (x = 0; x < w; x++) {
+            blend_pixel(dst, src, alpha, mask, mask_linesize, l2depth,
+                        1 << hsub, hband, hsub + vsub, xm);
+            dst += dst_delta;
+            xm += 1 << hsub;
+        }
     }
     if (right)
         blend_pixel(dst, src, alpha, mask, mask_linesize, l2depth,
@@ -31,6 +31,112 @@
 
 #define KNOWN(l) (!FF_LAYOUT2COUNT(l)) /* for readability */
 
+/* Pixel and sample formats are small integers, merged through bitsets;
+ * sample rates are not and fall back to quadratic loops. */
+#define FORMAT_SET_SIZE FFMAX((int)AV_PIX_FMT_NB, (int)AV_SAMPLE_FMT_NB)
+
+typedef struct FormatSet {
+    uint64_t bits[(FORMAT_SET_SIZE + 63) / 64];
+} FormatSet;
+
+#define FORMAT_SET_HAS(set, fmt) \
+    ((unsigned)(fmt) < FORMAT_SET_SIZE && (set)->bits[(fmt) >> 6] >> ((fmt) & 63) & 1)
+
+/**
+ * Fill set with the formats of f.
+ * @return 0 if some format does not fit in a set
+ */
+static int fill_format_set(FormatSet *set, const AVFilterFormats *f)
+{
+    int i;
+
+    memset(set, 0, sizeof(*set));
+    for (i = 0; i < f->nb_formats; i++) {
+        unsigned fmt = f->formats[i];
+
+        if (fmt >= FORMAT_SET_SIZE)
+            return 0;
+        set->bits[fmt >> 6] |= 1ULL << (fmt & 63);
+    }
+    return 1;
+}
+
+/**
+ * Store the formats of a which are also in b into dst, if not NULL, in the
+ * order of a.
+ * @return the number of common formats, or a negative value if one of the
+ *         lists has duplicates
+ */
+static int intersect_formats(int *dst, const AVFilterFormats *a,
+                             const AVFilterFormats *b)
+{
+    int i, j, nb = 0, max = FFMIN(a->nb_formats, b->nb_formats);
+    FormatSet set;
+
+    if (fill_format_set(&set, b)) {
+        for (i = 0; i < a->nb_formats; i++) {
+            if (!FORMAT_SET_HAS(&set, a->formats[i]))
+                continue;
+            if (nb >= max)
+                return AVERROR(EINVAL);
+            if (dst)
+                dst[nb] = a->formats[i];
+            nb++;
+        }
+        return nb;
+    }
+
+    for (i = 0; i < a->nb_formats; i++)
+        for (j = 0; j < b->nb_formats; j++)
+            if (a->formats[i] == b->formats[j]) {
+                if (nb >= max)
+                    return AVERROR(EINVAL);
+                if (dst)
+                    dst[nb] = a->formats[i];
+                nb++;
+            }
+    return nb;
+}
+
+/**
+ * Check that merging two pixel formats lists does not lose chroma or alpha.
+ * It happens if both lists have formats with chroma (resp. alpha), but the
+ * only formats in common do not have it (e.g. YUV+gray vs. RGB+gray): in
+ * that case, the merging would select the gray format, possibly causing a
+ * lossy conversion elsewhere in the graph.
+ */
+static int keeps_components(const AVFilterFormats *a, const AVFilterFormats *b)
+{
+    int alpha_a = 0, alpha_b = 0, alpha_common = 0;
+    int chroma_a = 0, chroma_b = 0, chroma_common = 0;
+    FormatSet set;
+    int i;
+
+    /* pixel formats always fit in a set */
+    if (!fill_format_set(&set, b))
+        return 0;
+
+    for (i = 0; i < b->nb_formats; i++) {
+        const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(b->formats[i]);
+        alpha_b  |= !!(desc->flags & AV_PIX_FMT_FLAG_ALPHA);
+        chroma_b |= desc->nb_components > 1;
+    }
+    for (i = 0; i < a->nb_formats; i++) {
+        const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(a->formats[i]);
+        int alpha  = !!(desc->flags & AV_PIX_FMT_FLAG_ALPHA);
+        int chroma = desc->nb_components > 1;
+
+        alpha_a  |= alpha;
+        chroma_a |= chroma;
+        if (FORMAT_SET_HAS(&set, a->formats[i])) {
+            alpha_common  |= alpha;
+            chroma_common |= chroma;
+        }
+    }
+    return (alpha_common  || !(alpha_a  && alpha_b)) &&
+           (chroma_common || !(chroma_a && chroma_b));
+}
+
 /**
  * Add all refs from a to ret and destroy a.
  */
@@ -60,7 +166,7 @@ do {                                                                       \
  */
 #define MERGE_FORMATS(ret, a, b, fmts, nb, type, fail)                          \
 do {                                                                            \
-    int i, j, k = 0, count = FFMIN(a->nb, b->nb);                               \
+    int k = 0, count = FFMIN(a->nb, b->nb);                                     \
                                                                                 \
     if (!(ret = av_mallocz(sizeof(*ret))))                                      \
         goto fail;                                                              \
@@ -68,17 +174,12 @@ do {
     if (count) {                                                                \
         if (!(ret->fmts = av_malloc_array(count, sizeof(*ret->fmts))))          \
             goto fail;                                                          \
-        for (i = 0; i < a->nb; i++)                                             \
-            for (j = 0; j < b->nb; j++)                                         \
-                if (a->fmts[i] == b->fmts[j]) {                                 \
-                    if(k >= FFMIN(a->nb, b->nb)){                               \
-                        av_log(NULL, AV_LOG_ERROR, "Duplicate formats in %s detected\n", __FUNCTION__); \
-                        av_free(ret->fmts);                                     \
-                        av_free(ret);                                           \
-                        return NULL;                                            \
-                    }                                                           \
-                    ret->fmts[k++] = a->fmts[i];                                \
-                }                                                               \
+        if ((k = intersect_formats(ret->fmts, a, b)) < 0) {                     \
+            av_log(NULL, AV_LOG_ERROR, "Duplicate formats in %s detected\n", __FUNCTION__); \
+            av_free(ret->fmts);                                                 \
+            av_free(ret);                                                       \
+            return NULL;                                                        \
+        }                                                                       \
     }                                                                           \
     ret->nb = k;                                                                \
     /* check that there was at least one common format */                       \
@@ -93,35 +194,13 @@ AVFilterFormats *ff_merge_formats(AVFilterFormats *a, AVFilterFormats *b,
                                   enum AVMediaType type)
 {
     AVFilterFormats *ret = NULL;
-    int i, j;
-    int alpha1=0, alpha2=0;
-    int chroma1=0, chroma2=0;
 
     if (a == b)
         return a;
 
-    /* Do not lose chroma or alpha in merging.
-       It happens if both lists have formats with chroma (resp. alpha), but
-       the only formats in common do not have it (e.g. YUV+gray vs.
-       RGB+gray): in that case, the merging would select the gray format,
-       possibly causing a lossy conversion elsewhere in the graph.
-       To avoid that, pretend that there are no common formats to force the
-       insertion of a conversion filter. */
-    if (type == AVMEDIA_TYPE_VIDEO)
-        for (i = 0; i < a->nb_formats; i++)
-            for (j = 0; j < b->nb_formats; j++) {
-                const AVPixFmtDescriptor *adesc = av_pix_fmt_desc_get(a->formats[i]);
-                const AVPixFmtDescriptor *bdesc = av_pix_fmt_desc_get(b->formats[j]);
-                alpha2 |= adesc->flags & bdesc->flags & AV_PIX_FMT_FLAG_ALPHA;
-                chroma2|= adesc->nb_components > 1 && bdesc->nb_components > 1;
-                if (a->formats[i] == b->formats[j]) {
-                    alpha1 |= adesc->flags & AV_PIX_FMT_FLAG_ALPHA;
-                    chroma1|= adesc->nb_components > 1;
-                }
-            }
-
-    // If chroma or alpha can be lost through merging then do not merge
-    if (alpha2 > alpha1 || chroma2 > chroma1)
+    /* Do not lose chroma or alpha in merging: pretend that there are no
+       common formats to force the insertion of a conversion filter. */
+    if (type == AVMEDIA_TYPE_VIDEO && !keeps_components(a, b))
         return NULL;
 
     MERGE_FORMATS(ret, a, b, formats, nb_formats, AVFilterFormats, fail);
@@ -136,6 +215,16 @@ fail:
     return NULL;
 }
 
+int ff_can_merge_formats(const AVFilterFormats *a, const AVFilterFormats *b,
+                         enum AVMediaType type)
+{
+    if (a == b)
+        return 1;
+    if (type == AVMEDIA_TYPE_VIDEO && !keeps_components(a, b))
+        return 0;
+    return intersect_formats(NULL, a, b) > 0;
+}
+
 AVFilterFormats *ff_merge_samplerates(AVFilterFormats *a,
                                       AVFilterFormats *b)
 {
@@ -163,6 +252,13 @@ fail:
     return NULL;
 }
 
+int ff_can_merge_samplerates(const AVFilterFormats *a, const AVFilterFormats *b)
+{
+    if (a == b || !a->nb_formats || !b->nb_formats)
+        return 1;
+    return intersect_formats(NULL, a, b) > 0;
+}
+
 AVFilterChannelLayouts *ff_merge_channel_layouts(AVFilterChannelLayouts *a,
                                                  AVFilterChannelLayouts *b)
 {
@@ -349,24 +445,24 @@ int ff_add_channel_layout(AVFilterChannelLayouts **l, uint64_t channel_layout)
 
 AVFilterFormats *ff_all_formats(enum AVMediaType type)
 {
-    AVFilterFormats *ret = NULL;
+    int fmts[FORMAT_SET_SIZE + 1];
+    int nb = 0;
 
+    /* this is called for every filter of a graph, build the list at once */
     if (type == AVMEDIA_TYPE_VIDEO) {
         const AVPixFmtDescriptor *desc = NULL;
-        while ((desc = av_pix_fmt_desc_next(desc))) {
-            if (ff_add_format(&ret, av_pix_fmt_desc_get_id(desc)) < 0)
-                return NULL;
-        }
+        while ((desc = av_pix_fmt_desc_next(desc)))
+            fmts[nb++] = av_pix_fmt_desc_get_id(desc);
     } else if (type == AVMEDIA_TYPE_AUDIO) {
         enum AVSampleFormat fmt = 0;
-        while (av_get_sample_fmt_name(fmt)) {
-            if (ff_add_format(&ret, fmt) < 0)
-                return NULL;
-            fmt++;
-        }
+        while (av_get_sample_fmt_name(fmt))
+            fmts[nb++] = fmt++;
     }
+    if (!nb)
+        return NULL;
+    fmts[nb] = -1;
 
-    return ret;
+    return ff_make_format_list(fmts);
 }
 
 const int64_t avfilter_all_channel_layouts[] = {
@@ -121,6 +121,12 @@ AVFilterChannelLayouts *ff_merge_channel_layouts(AVFilterChannelLayouts *a,
 AVFilterFormats *ff_merge_samplerates(AVFilterFormats *a,
                                       AVFilterFormats *b);
 
+/**
+ * Check if ff_merge_samplerates() would succeed on a and b, without
+ * modifying them.
+ */
+int ff_can_merge_samplerates(const AVFilterFormats *a, const AVFilterFormats *b);
+
 /**
  * Construct an empty AVFilterChannelLayouts/AVFilterFormats struct --
  * representing any channel layout (with known disposition)/sample rate.
@@ -238,6 +244,13 @@ AVFilterFormats *ff_planar_sample_fmts(void);
 AVFilterFormats *ff_merge_formats(AVFilterFormats *a, AVFilterFormats *b,
                                   enum AVMediaType type);
 
+/**
+ * Check if ff_merge_formats() would succeed on a and b, without modifying
+ * them.
+ */
+int ff_can_merge_formats(const AVFilterFormats *a, const AVFilterFormats *b,
+                         enum AVMediaType type);
+
 /**
  * Add *ref as a new reference to formats.
  * That is the pointers will point like in the ascii art below:
@@ -148,6 +148,7 @@ struct AVFilterPad {
 struct AVFilterGraphInternal {
     void *thread;
     avfilter_execute_func *thread_execute;
+    AVThreadPool *thread_pool;
     FFFrameQueueGlobal frame_queues;
 };
 
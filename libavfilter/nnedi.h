@@ -0,0 +1,54 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef AVFILTER_NNEDI_H
+#define AVFILTER_NNEDI_H
+
+#include <stdint.h>
+
+typedef struct NNEDIDSPContext {
+    /**
+     * Evaluate n neurons of len inputs each:
+     * vals[i] = dot(data, weights + i * len) * scale[0] + weights[n * len + i]
+     *
+     * @param len multiple of 4
+     */
+    void (*dot_prod)(const float *data, const float *weights, float *vals,
+                     int n, int len, const float *scale);
+
+    /**
+     * Integer version of the above without the scaling:
+     * sums[i] = dot(data, weights + i * len)
+     *
+     * @param len multiple of 16
+     */
+    void (*dot_prods)(const int16_t *data, const int16_t *weights,
+                      int32_t *sums, int n, int len);
+
+    /**
+     * Apply the elliott activation function x / (1 + |x|) in place.
+     *
+     * @param n multiple of 4
+     */
+    void (*elliott)(float *data, int n);
+} NNEDIDSPContext;
+
+void ff_nnedi_init_dsp(NNEDIDSPContext *dsp);
+void ff_nnedi_init_dsp_x86(NNEDIDSPContext *dsp);
+
+#endif /* AVFILTER_NNEDI_H */
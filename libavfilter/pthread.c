@@ -73,9 +73,11 @@ static int thread_execute(AVFilterContext *ctx, avfilter_action_func *func,
     return 0;
 }
 
-static int thread_init_internal(ThreadContext *c, int nb_threads)
+static int thread_init_internal(ThreadContext *c, AVThreadPool *pool,
+                                const AVFilterGraph *graph, int nb_threads)
 {
-    nb_threads = avpriv_slicethread_create(&c->thread, c, worker_func, NULL, nb_threads);
+    nb_threads = avpriv_slicethread_create_pool(&c->thread, pool, graph, c, worker_func, NULL,
+                                                nb_threads, AVPRIV_SLICETHREAD_FLAG_UNORDERED);
     if (nb_threads <= 1)
         avpriv_slicethread_free(&c->thread);
     return FFMAX(nb_threads, 1);
@@ -94,7 +96,8 @@ int ff_graph_thread_init(AVFilterGraph *graph)
     if (!graph->internal->thread)
         return AVERROR(ENOMEM);
 
-    ret = thread_init_internal(graph->internal->thread, graph->nb_threads);
+    ret = thread_init_internal(graph->internal->thread, graph->internal->thread_pool,
+                               graph, graph->nb_threads);
     if (ret <= 1) {
         av_freep(&graph->internal->thread);
         graph->thread_type = 0;
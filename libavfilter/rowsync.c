@@ -0,0 +1,104 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "libavutil/common.h"
+#include "libavutil/error.h"
+#include "libavutil/mem.h"
+#include "rowsync.h"
+
+int ff_row_sync_init(FFRowSync *rs, int max_rows)
+{
+    int ret;
+
+    rs->max_rows = max_rows;
+    rs->progress = av_malloc_array(max_rows, sizeof(*rs->progress));
+    if (!rs->progress)
+        return AVERROR(ENOMEM);
+#if HAVE_THREADS
+    atomic_init(&rs->nb_waiting, 0);
+    if ((ret = pthread_mutex_init(&rs->mutex, NULL))) {
+        av_freep(&rs->progress);
+        return AVERROR(ret);
+    }
+    if ((ret = pthread_cond_init(&rs->cond, NULL))) {
+        pthread_mutex_destroy(&rs->mutex);
+        av_freep(&rs->progress);
+        return AVERROR(ret);
+    }
+#endif
+    ff_row_sync_reset(rs, max_rows, 0);
+    return 0;
+}
+
+void ff_row_sync_uninit(FFRowSync *rs)
+{
+    if (!rs->progress)
+        return;
+#if HAVE_THREADS
+    pthread_cond_destroy(&rs->cond);
+    pthread_mutex_destroy(&rs->mutex);
+#endif
+    av_freep(&rs->progress);
+}
+
+void ff_row_sync_reset(FFRowSync *rs, int nb_rows, int nb_cols)
+{
+    int i;
+
+    rs->nb_rows = FFMIN(nb_rows, rs->max_rows);
+    rs->nb_cols = nb_cols;
+    atomic_init(&rs->next_row, 0);
+    for (i = 0; i < rs->nb_rows; i++)
+        atomic_init(&rs->progress[i], 0);
+}
+
+int ff_row_sync_next(FFRowSync *rs)
+{
+    int row = atomic_fetch_add(&rs->next_row, 1);
+    return row < rs->nb_rows ? row : -1;
+}
+
+void ff_row_sync_wait(FFRowSync *rs, int row, int nb_done)
+{
+    nb_done = FFMIN(nb_done, rs->nb_cols);
+
+    if (!row || atomic_load(&rs->progress[row - 1]) >= nb_done)
+        return;
+
+#if HAVE_THREADS
+    pthread_mutex_lock(&rs->mutex);
+    atomic_fetch_add(&rs->nb_waiting, 1);
+    while (atomic_load(&rs->progress[row - 1]) < nb_done)
+        pthread_cond_wait(&rs->cond, &rs->mutex);
+    atomic_fetch_sub(&rs->nb_waiting, 1);
+    pthread_mutex_unlock(&rs->mutex);
+#endif
+}
+
+void ff_row_sync_report(FFRowSync *rs, int row, int nb_done)
+{
+    atomic_store(&rs->progress[row], nb_done);
+
+#if HAVE_THREADS
+    if (atomic_load(&rs->nb_waiting)) {
+        pthread_mutex_lock(&rs->mutex);
+        pthread_cond_broadcast(&rs->cond);
+        pthread_mutex_unlock(&rs->mutex);
+    }
+#endif
+}
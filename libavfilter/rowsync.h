@@ -0,0 +1,76 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef AVFILTER_ROWSYNC_H
+#define AVFILTER_ROWSYNC_H
+
+#include <stdatomic.h>
+
+#include "libavutil/thread.h"
+
+/**
+ * Wavefront synchronization of rows processed by several slice jobs.
+ *
+ * Rows are handed out in order with ff_row_sync_next() and each row waits for
+ * the row above it to be far enough ahead before processing a column, so that
+ * filters whose rows depend on the previous row produce the same output as
+ * when processing all rows on a single thread.
+ */
+typedef struct FFRowSync {
+    int max_rows;
+    int nb_rows;
+    int nb_cols;
+    atomic_int next_row;
+    atomic_int *progress;           ///< number of columns done in each row
+#if HAVE_THREADS
+    atomic_int nb_waiting;
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+#endif
+} FFRowSync;
+
+/**
+ * Allocate the state for up to max_rows rows.
+ */
+int ff_row_sync_init(FFRowSync *rs, int max_rows);
+
+void ff_row_sync_uninit(FFRowSync *rs);
+
+/**
+ * Prepare for processing nb_rows rows of nb_cols columns. Must not be called
+ * while rows are being processed.
+ */
+void ff_row_sync_reset(FFRowSync *rs, int nb_rows, int nb_cols);
+
+/**
+ * Return the next row to process, or -1 if all rows were handed out.
+ */
+int ff_row_sync_next(FFRowSync *rs);
+
+/**
+ * Wait until at least nb_done columns (clipped to the row width) of the row
+ * above row are processed.
+ */
+void ff_row_sync_wait(FFRowSync *rs, int row, int nb_done);
+
+/**
+ * Mark the first nb_done columns of row as processed.
+ */
+void ff_row_sync_report(FFRowSync *rs, int row, int nb_done);
+
+#endif /* AVFILTER_ROWSYNC_H */
@@ -0,0 +1,40 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef AVFILTER_SMARTBLUR_H
+#define AVFILTER_SMARTBLUR_H
+
+#include <stdint.h>
+
+typedef struct SmartblurDSPContext {
+    /**
+     * Limit the blurred line dst against the source line src: a positive
+     * threshold keeps the blur only where it changed a pixel by at most
+     * threshold, a negative one only where it changed it by more than
+     * -2 * threshold, easing in between.
+     *
+     * @param w         multiple of 16
+     * @param threshold nonzero
+     */
+    void (*threshold)(uint8_t *dst, const uint8_t *src, int w, int threshold);
+} SmartblurDSPContext;
+
+void ff_smartblur_init_dsp(SmartblurDSPContext *dsp);
+void ff_smartblur_init_dsp_x86(SmartblurDSPContext *dsp);
+
+#endif /* AVFILTER_SMARTBLUR_H */
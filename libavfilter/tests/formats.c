@@ -20,9 +20,163 @@
 
 #include "libavfilter/formats.c"
 
+#include "libavutil/bprint.h"
+#include "libavutil/lfg.h"
+#include "libavutil/time.h"
+
 #undef printf
 
-int main(void)
+/* the intersection of a and b the way the lists were merged before the
+ * format sets, with quadratic loops */
+static int merge_ref(int *dst, const AVFilterFormats *a, const AVFilterFormats *b,
+                     enum AVMediaType type)
+{
+    int alpha1 = 0, alpha2 = 0, chroma1 = 0, chroma2 = 0;
+    int i, j, nb = 0;
+
+    for (i = 0; i < a->nb_formats; i++)
+        for (j = 0; j < b->nb_formats; j++) {
+            if (type == AVMEDIA_TYPE_VIDEO) {
+                const AVPixFmtDescriptor *adesc = av_pix_fmt_desc_get(a->formats[i]);
+                const AVPixFmtDescriptor *bdesc = av_pix_fmt_desc_get(b->formats[j]);
+                alpha2 |= adesc->flags & bdesc->flags & AV_PIX_FMT_FLAG_ALPHA;
+                chroma2|= adesc->nb_components > 1 && bdesc->nb_components > 1;
+                if (a->formats[i] == b->formats[j]) {
+                    alpha1 |= adesc->flags & AV_PIX_FMT_FLAG_ALPHA;
+                    chroma1|= adesc->nb_components > 1;
+                }
+            }
+            if (a->formats[i] == b->formats[j])
+                dst[nb++] = a->formats[i];
+        }
+    return alpha2 > alpha1 || chroma2 > chroma1 ? 0 : nb;
+}
+
+/* a shuffled list of formats, sample rates for AVMEDIA_TYPE_UNKNOWN */
+static AVFilterFormats *random_formats(AVLFG *lfg, enum AVMediaType type)
+{
+    int max  = type == AVMEDIA_TYPE_VIDEO ? AV_PIX_FMT_NB :
+               type == AVMEDIA_TYPE_AUDIO ? AV_SAMPLE_FMT_NB : 192000;
+    int mul  = type == AVMEDIA_TYPE_UNKNOWN ? 8000 : 1;
+    int step = av_lfg_get(lfg) % 40 + 1;
+    AVFilterFormats *f = NULL;
+    int i, j, fmt;
+
+    for (fmt = av_lfg_get(lfg) % step; fmt * mul < max; fmt += av_lfg_get(lfg) % step + 1) {
+        if (type == AVMEDIA_TYPE_VIDEO &&
+            (!av_pix_fmt_desc_get(fmt) ||
+             av_pix_fmt_desc_get(fmt)->flags & AV_PIX_FMT_FLAG_HWACCEL))
+            continue;
+        if (ff_add_format(&f, fmt * mul) < 0)
+            exit(1);
+    }
+    if (!f && ff_add_format(&f, 0) < 0)
+        exit(1);
+    for (i = f->nb_formats - 1; i > 0; i--) {
+        j = av_lfg_get(lfg) % (i + 1);
+        FFSWAP(int, f->formats[i], f->formats[j]);
+    }
+    return f;
+}
+
+static int check_merges(void)
+{
+    static const enum AVMediaType types[] = {
+        AVMEDIA_TYPE_VIDEO, AVMEDIA_TYPE_AUDIO, AVMEDIA_TYPE_UNKNOWN,
+    };
+    int ref[AV_PIX_FMT_NB];
+    int i, t, errors = 0;
+    AVLFG lfg;
+
+    av_lfg_init(&lfg, 1);
+    for (t = 0; t < FF_ARRAY_ELEMS(types); t++) {
+        for (i = 0; i < 1000; i++) {
+            AVFilterFormats *a = random_formats(&lfg, types[t]);
+            AVFilterFormats *b = random_formats(&lfg, types[t]);
+            AVFilterFormats *ref_a = NULL, *ref_b = NULL, *ret;
+            int nb = merge_ref(ref, a, b, types[t]), can;
+
+            if (types[t] == AVMEDIA_TYPE_UNKNOWN) {
+                can = ff_can_merge_samplerates(a, b);
+            } else {
+                can = ff_can_merge_formats(a, b, types[t]);
+            }
+            if (ff_formats_ref(a, &ref_a) < 0 || ff_formats_ref(b, &ref_b) < 0)
+                exit(1);
+            if (types[t] == AVMEDIA_TYPE_UNKNOWN) {
+                ret = ff_merge_samplerates(a, b);
+            } else {
+                ret = ff_merge_formats(a, b, types[t]);
+            }
+
+            if (!nb != !ret || !nb != !can ||
+                (ret && (ret->nb_formats != nb ||
+                         memcmp(ret->formats, ref, nb * sizeof(*ref))))) {
+                fprintf(stderr, "merge %d of type %d: %d formats expected, "
+                        "can merge %d, merged %d\n", i, types[t], nb, can,
+                        ret ? ret->nb_formats : -1);
+                errors++;
+            }
+            ff_formats_unref(&ref_a);
+            ff_formats_unref(&ref_b);
+        }
+    }
+    return errors;
+}
+
+static const char *const pix_fmts[] = {
+    "yuv420p", "rgb24", "gray", "yuva444p", "nv12", "yuv422p10",
+};
+
+static const char *const sample_fmts[] = {
+    "s16", "fltp", "s32", "dblp",
+};
+
+/* time the configuration of a graph of nb_chains video and audio chains
+ * with different formats on each filter, so that the conversion filters
+ * are inserted */
+static void bench_graph(int nb_chains)
+{
+    int64_t best = INT64_MAX;
+    int nb_filters = 0;
+    int run, i;
+
+    for (run = 0; run < 5; run++) {
+        AVFilterGraph *graph = avfilter_graph_alloc();
+        AVBPrint bp;
+        int64_t t;
+
+        av_bprint_init(&bp, 0, AV_BPRINT_SIZE_UNLIMITED);
+        for (i = 0; i < nb_chains; i++) {
+            const char *p0 = pix_fmts[i % FF_ARRAY_ELEMS(pix_fmts)];
+            const char *p1 = pix_fmts[(i + 1) % FF_ARRAY_ELEMS(pix_fmts)];
+            const char *s0 = sample_fmts[i % FF_ARRAY_ELEMS(sample_fmts)];
+            const char *s1 = sample_fmts[(i + 1) % FF_ARRAY_ELEMS(sample_fmts)];
+
+            av_bprintf(&bp, "%stestsrc=s=32x32,format=%s,hflip,format=%s,"
+                       "vflip,split[v%d],null,nullsink;[v%d]transpose,nullsink;"
+                       "sine,aformat=%s:channel_layouts=stereo,volume,"
+                       "aformat=%s:sample_rates=%d,asplit[a%d],anull,anullsink;"
+                       "[a%d]pan=mono|c0=c0,anullsink",
+                       i ? ";" : "", p0, p1, i, i, s0, s1, 8000 << (i % 3), i, i);
+        }
+        if (!graph || !av_bprint_is_complete(&bp) ||
+            avfilter_graph_parse_ptr(graph, bp.str, NULL, NULL, NULL) < 0)
+            exit(1);
+
+        t = av_gettime_relative();
+        if (avfilter_graph_config(graph, NULL) < 0)
+            exit(1);
+        best = FFMIN(best, av_gettime_relative() - t);
+        nb_filters = graph->nb_filters;
+
+        avfilter_graph_free(&graph);
+        av_bprint_finalize(&bp, NULL);
+    }
+    printf("%5d filters: %8.3f ms\n", nb_filters, best / 1000.0);
+}
+
+int main(int argc, char **argv)
 {
     const int64_t *cl;
     char buf[512];
@@ -50,6 +204,14 @@ int main(void)
         "0x3",
     };
 
+    if (argc > 1 && !strcmp(argv[1], "-t")) {
+        avfilter_register_all();
+        av_log_set_level(AV_LOG_ERROR);
+        for (i = 8; i <= 512; i *= 4)
+            bench_graph(i);
+        return 0;
+    }
+
     for (cl = avfilter_all_channel_layouts; *cl != -1; cl++) {
         av_get_channel_layout_string(buf, sizeof(buf), -1, *cl);
         printf("%s\n", buf);
@@ -64,5 +226,8 @@ int main(void)
         printf ("%d = ff_parse_channel_layout(%016"PRIX64", %2d, %s);\n", ret ? -1 : 0, layout, count, teststrings[i]);
     }
 
-    return 0;
+    i = check_merges();
+    printf("%d merge errors\n", i);
+
+    return !!i;
 }
@@ -0,0 +1,157 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "libavfilter/vf_tonemap.c"
+
+#include "libavutil/lfg.h"
+
+#define WIDTH     1021
+#define MAX_ERROR 1e-4
+
+static const char *const algo_names[TONEMAP_MAX] = {
+    "none", "linear", "gamma", "clip", "reinhard", "hable", "mobius",
+};
+
+static double hable_ref(double in)
+{
+    double a = 0.15, b = 0.50, c = 0.10, d = 0.20, e = 0.02, f = 0.30;
+    return (in * (in * a + b * c) + d * e) / (in * (in * a + b) + d * f) - e / f;
+}
+
+static double mobius_ref(double in, double j, double peak)
+{
+    double a, b;
+
+    if (in <= j)
+        return in;
+
+    a = -j * j * (peak - 1.0) / (j * j - 2.0 * j + peak);
+    b = (j * j - 2.0 * j * peak + peak) / FFMAX(peak - 1.0, 1e-6);
+
+    return (b * b + 2.0 * b * j + j * j) / (b - a) * (in + a) / (in + b);
+}
+
+/* per-pixel double precision version of the filter */
+static void tonemap_ref(const TonemapContext *s, double rgb[3], double peak)
+{
+    double sig, sig_orig;
+    int i;
+
+    if (s->desat > 0) {
+        double luma = s->coeffs->cr * rgb[0] + s->coeffs->cg * rgb[1] + s->coeffs->cb * rgb[2];
+        double overbright = FFMAX(luma - s->desat, 1e-6) / FFMAX(luma, 1e-6);
+        for (i = 0; i < 3; i++)
+            rgb[i] = MIX(rgb[i], luma, overbright);
+    }
+
+    sig = FFMAX(FFMAX3(rgb[0], rgb[1], rgb[2]), 1e-6);
+    sig_orig = sig;
+
+    switch (s->tonemap) {
+    default:
+    case TONEMAP_NONE:
+        break;
+    case TONEMAP_LINEAR:
+        sig = sig * s->param / peak;
+        break;
+    case TONEMAP_GAMMA:
+        sig = sig > 0.05 ? pow(sig / peak, 1.0 / s->param)
+                         : sig * pow(0.05 / peak, 1.0 / s->param) / 0.05;
+        break;
+    case TONEMAP_CLIP:
+        sig = av_clipd(sig * s->param, 0, 1.0);
+        break;
+    case TONEMAP_HABLE:
+        sig = hable_ref(sig) / hable_ref(peak);
+        break;
+    case TONEMAP_REINHARD:
+        sig = sig / (sig + s->param) * (peak + s->param) / peak;
+        break;
+    case TONEMAP_MOBIUS:
+        sig = mobius_ref(sig, s->param, peak);
+        break;
+    }
+
+    for (i = 0; i < 3; i++)
+        rgb[i] *= sig / sig_orig;
+}
+
+static double test(AVLFG *lfg, enum TonemapAlgorithm algo, double desat,
+                   double peak, int lut)
+{
+    TonemapContext s = { .tonemap = algo, .param = NAN, .desat = desat, .use_lut = lut };
+    AVFilterContext ctx = { .priv = &s };
+    float in[3][WIDTH], out[3][WIDTH];
+    double err = 0;
+    int i, x;
+
+    init(&ctx);
+    s.coeffs = &luma_coefficients[AVCOL_SPC_BT709];
+    update_curve(&s, peak);
+    if (lut)
+        update_lut(&s, peak);
+
+    /* cover the whole range up to a bit above the peak, with a share of
+     * near black values for the linear segment of gamma */
+    for (x = 0; x < WIDTH; x++)
+        for (i = 0; i < 3; i++)
+            in[i][x] = av_lfg_get(lfg) / (double)UINT32_MAX * peak * 1.2 /
+                       (x & 3 ? 1 : 100);
+
+    tonemap_line_funcs[algo](&s, out[0], out[2], out[1],
+                             in[0], in[2], in[1], WIDTH);
+
+    for (x = 0; x < WIDTH; x++) {
+        double rgb[3] = { in[0][x], in[1][x], in[2][x] };
+
+        tonemap_ref(&s, rgb, peak);
+        for (i = 0; i < 3; i++)
+            err = FFMAX(err, fabs(out[i][x] - rgb[i]) / FFMAX(fabs(rgb[i]), 1e-3));
+    }
+
+    printf("%-8s desat=%g peak=%-4g lut=%d: max relative error %.3e%s\n",
+           algo_names[algo], desat, peak, lut, err, err < MAX_ERROR ? "" : " FAIL");
+    return err;
+}
+
+int main(void)
+{
+    static const double peaks[] = { 1.5, 4, 12, 100 };
+    AVLFG lfg;
+    double err[2] = { 0 };
+    int algo, d, p, lut;
+
+    av_lfg_init(&lfg, 0xdeadbeef);
+
+    for (lut = 0; lut <= 1; lut++) {
+        for (algo = 0; algo < TONEMAP_MAX; algo++) {
+            for (d = 0; d <= 2; d += 2) {
+                for (p = 0; p < FF_ARRAY_ELEMS(peaks); p++) {
+                    double e = test(&lfg, algo, d, peaks[p], lut);
+                    err[lut] = FFMAX(err[lut], e);
+                }
+            }
+        }
+    }
+
+    printf("max relative error against double precision: %.3e, limit %g\n",
+           err[0], MAX_ERROR);
+    printf("max relative error with the lookup table: %.3e, limit %g\n",
+           err[1], MAX_ERROR);
+    return FFMAX(err[0], err[1]) >= MAX_ERROR;
+}
@@ -28,6 +28,26 @@
 #define MIN_MATRIX_SIZE 3
 #define MAX_MATRIX_SIZE 63
 
+typedef struct UnsharpDSPContext {
+    /**
+     * Run w columns of line through the steps vertical state machine
+     * stages held in pairs of consecutive sc lines, sc_stride elements
+     * apart, leaving the vertical sums in line.
+     *
+     * @param w multiple of 8
+     */
+    void (*vertical)(uint32_t *line, uint32_t *sc, int sc_stride,
+                     int steps, int w);
+
+    /**
+     * dst[x] = clip(src[x] + (((src[x] - ((blur[x] + halfscale) >> scalebits))
+     *                          * amount) >> 16))
+     *
+     * @param w multiple of 8
+     */
+    void (*output)(uint8_t *dst, const uint8_t *src, const uint32_t *blur,
+                   int w, int amount, int scalebits, int halfscale);
+} UnsharpDSPContext;
 
 typedef struct UnsharpFilterParam {
     int msize_x;                             ///< matrix width
@@ -37,7 +57,7 @@ typedef struct UnsharpFilterParam {
     int steps_y;                             ///< vertical step count
     int scalebits;                           ///< bits to shift pixel
     int32_t halfscale;                       ///< amount to add to pixel
-    uint32_t *sc[MAX_MATRIX_SIZE - 1];       ///< finite state machine storage
+    uint32_t *sc;                            ///< finite state machine storage, one block of lines per thread
 } UnsharpFilterParam;
 
 typedef struct UnsharpContext {
@@ -47,8 +67,13 @@ typedef struct UnsharpContext {
     UnsharpFilterParam luma;   ///< luma parameters (width, height, amount)
     UnsharpFilterParam chroma; ///< chroma parameters (width, height, amount)
     int hsub, vsub;
+    int nb_threads;
     int opencl;
     int (* apply_unsharp)(AVFilterContext *ctx, AVFrame *in, AVFrame *out);
+    UnsharpDSPContext dsp;
 } UnsharpContext;
 
+void ff_unsharp_init_dsp(UnsharpDSPContext *dsp);
+void ff_unsharp_init_dsp_x86(UnsharpDSPContext *dsp);
+
 #endif /* AVFILTER_UNSHARP_H */
@@ -0,0 +1,50 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef AVFILTER_VECTORSCOPE_H
+#define AVFILTER_VECTORSCOPE_H
+
+#include <stdint.h>
+
+/* the 8-bit scope works on rows of 256 points, one 256x256 map per thread */
+#define VECTORSCOPE_MAP_SIZE (256 * 256)
+
+typedef struct VectorscopeDSPContext {
+    /**
+     * Merge one row of nb_maps hit maps, VECTORSCOPE_MAP_SIZE elements
+     * apart, into the 256 entries of dst: the sum of the counts, or their
+     * maximum for max_maps.
+     *
+     * @param nb_maps at least 1
+     */
+    void (*sum_maps)(uint32_t *dst, const uint32_t *maps, int nb_maps);
+    void (*max_maps)(uint32_t *dst, const uint32_t *maps, int nb_maps);
+
+    /**
+     * Add the intensity of hits[x] hits to the 256 pixels of dst, saturating:
+     * dst[x] = FFMIN(dst[x] + FFMIN(hits[x], 256) * intensity, 255)
+     *
+     * @param intensity 0 to 255
+     */
+    void (*add_hits)(uint8_t *dst, const uint32_t *hits, int intensity);
+} VectorscopeDSPContext;
+
+void ff_vectorscope_init_dsp(VectorscopeDSPContext *dsp);
+void ff_vectorscope_init_dsp_x86(VectorscopeDSPContext *dsp);
+
+#endif /* AVFILTER_VECTORSCOPE_H */
@@ -48,14 +48,19 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *in)
 {
     AVFilterLink *outlink = inlink->dst->outputs[0];
     AVFrame *out = ff_get_video_buffer(outlink, in->width, in->height);
+    int ret;
 
     if (!out) {
         av_frame_free(&in);
         return AVERROR(ENOMEM);
     }
     av_frame_copy_props(out, in);
-    av_frame_copy(out, in);
+    ret = ff_copy_video_frame(inlink->dst, out, in);
     av_frame_free(&in);
+    if (ret < 0) {
+        av_frame_free(&out);
+        return ret;
+    }
     return ff_filter_frame(outlink, out);
 }
 
@@ -82,4 +87,5 @@ AVFilter ff_vf_copy = {
     .inputs      = avfilter_vf_copy_inputs,
     .outputs     = avfilter_vf_copy_outputs,
     .query_formats = query_formats,
+    .flags       = AVFILTER_FLAG_SLICE_THREADS,
 };
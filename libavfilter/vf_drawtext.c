@@ -134,6 +134,38 @@ enum expansion_mode {
     EXP_STRFTIME,
 };
 
+typedef struct RunGlyph {
+    struct Glyph *glyph;
+    int x, y;                       ///< position of the glyph bitmap relative to the text
+} RunGlyph;
+
+/**
+ * Glyph bitmaps of a run composited into one 8-bit mask, so that a layer
+ * is blended with a single call per slice rather than one call per glyph.
+ */
+typedef struct RunMask {
+    uint8_t *data;                  ///< composited mask, NULL if never usable
+    int linesize;
+    int x, y, w, h;                 ///< position and size relative to the text
+    unsigned phases;                ///< alignments on the chroma grid the mask is usable at
+} RunMask;
+
+/**
+ * Text laid out at a given font size. It is reused for the following frames
+ * as long as the text and the font size do not change.
+ */
+typedef struct TextRun {
+    char *text;                     ///< text the run was laid out for
+    unsigned int fontsize;          ///< font size the run was laid out for
+    int w, h;                       ///< width and height of the text
+    int y_min, y_max;               ///< min glyph descent and max glyph ascent
+    RunGlyph *glyphs;               ///< glyphs to draw, in text order
+    int nb_glyphs;
+    unsigned int glyphs_size;       ///< allocated size of glyphs
+    int y0, y1;                     ///< rows covered by the glyphs and their borders
+    RunMask masks[2];               ///< composited glyphs and glyph borders
+} TextRun;
+
 typedef struct DrawTextContext {
     const AVClass *class;
     int exp_mode;                   ///< expansion mode to use for the text
@@ -178,6 +210,8 @@ typedef struct DrawTextContext {
     FT_Face face;                   ///< freetype font face handle
     FT_Stroker stroker;             ///< freetype stroker handle
     struct AVTreeNode *glyphs;      ///< rendered glyphs, stored using the UTF-32 char code
+    TextRun run;                    ///< last laid out text
+    int nb_threads;
     char *x_expr;                   ///< expression for x position
     char *y_expr;                   ///< expression for y position
     AVExpr *x_pexpr, *y_pexpr;      ///< parsed expressions for x and y
@@ -811,6 +845,12 @@ static av_cold void uninit(AVFilterContext *ctx)
     av_tree_destroy(s->glyphs);
     s->glyphs = NULL;
 
+    av_freep(&s->run.text);
+    av_freep(&s->run.glyphs);
+    av_freep(&s->run.masks[0].data);
+    av_freep(&s->run.masks[1].data);
+    s->run.nb_glyphs = s->run.glyphs_size = 0;
+
     FT_Done_Face(s->face);
     FT_Stroker_Done(s->stroker);
     FT_Done_FreeType(s->library);
@@ -826,6 +866,9 @@ static int config_input(AVFilterLink *inlink)
     int ret;
 
     ff_draw_init(&s->dc, inlink->format, FF_DRAW_PROCESS_ALPHA);
+    s->nb_threads = ff_filter_get_nb_threads(ctx);
+    /* the composited masks depend on the chroma subsampling */
+    av_freep(&s->run.text);
     ff_draw_color(&s->dc, &s->fontcolor,   s->fontcolor.rgba);
     ff_draw_color(&s->dc, &s->shadowcolor, s->shadowcolor.rgba);
     ff_draw_color(&s->dc, &s->bordercolor, s->bordercolor.rgba);
@@ -1166,20 +1209,25 @@ static int expand_text(AVFilterContext *ctx, char *text, AVBPrint *bp)
     return 0;
 }
 
-static int draw_glyphs(DrawTextContext *s, AVFrame *frame,
-                       int width, int height,
-                       FFDrawColor *color,
-                       int x, int y, int borderw)
+/**
+ * Collect the glyphs of the laid out text that get drawn, with their
+ * positions, and the rows they cover.
+ */
+static int collect_glyphs(DrawTextContext *s, const char *text)
 {
-    char *text = s->expanded_text.str;
+    TextRun *run = &s->run;
     uint32_t code = 0;
-    int i, x1, y1;
-    uint8_t *p;
-    Glyph *glyph = NULL;
+    const uint8_t *p;
+    Glyph *glyph;
+    int i;
+
+    run->nb_glyphs = 0;
+    run->y0 = INT_MAX;
+    run->y1 = INT_MIN;
 
     for (i = 0, p = text; *p; i++) {
-        FT_Bitmap bitmap;
         Glyph dummy = { 0 };
+        RunGlyph *g;
         GET_UTF8(code, *p++, continue;);
 
         /* skip new line chars, just go to new line */
@@ -1190,132 +1238,162 @@ static int draw_glyphs(DrawTextContext *s, AVFrame *frame,
         dummy.fontsize = s->fontsize;
         glyph = av_tree_find(s->glyphs, &dummy, glyph_cmp, NULL);
 
-        bitmap = borderw ? glyph->border_bitmap : glyph->bitmap;
-
         if (glyph->bitmap.pixel_mode != FT_PIXEL_MODE_MONO &&
             glyph->bitmap.pixel_mode != FT_PIXEL_MODE_GRAY)
             return AVERROR(EINVAL);
 
-        x1 = s->positions[i].x+s->x+x - borderw;
-        y1 = s->positions[i].y+s->y+y - borderw;
-
-        ff_blend_mask(&s->dc, color,
-                      frame->data, frame->linesize, width, height,
-                      bitmap.buffer, bitmap.pitch,
-                      bitmap.width, bitmap.rows,
-                      bitmap.pixel_mode == FT_PIXEL_MODE_MONO ? 0 : 3,
-                      0, x1, y1);
+        g = av_fast_realloc(run->glyphs, &run->glyphs_size,
+                            (run->nb_glyphs + 1) * sizeof(*run->glyphs));
+        if (!g)
+            return AVERROR(ENOMEM);
+        run->glyphs = g;
+        g = &run->glyphs[run->nb_glyphs++];
+        g->glyph = glyph;
+        g->x     = s->positions[i].x;
+        g->y     = s->positions[i].y;
+
+        run->y0 = FFMIN(run->y0, g->y - s->borderw);
+        run->y1 = FFMAX(run->y1, g->y + (int)glyph->bitmap.rows);
+        if (s->borderw)
+            run->y1 = FFMAX(run->y1, g->y - s->borderw + (int)glyph->border_bitmap.rows);
     }
 
     return 0;
 }
 
-
-static void update_color_with_alpha(DrawTextContext *s, FFDrawColor *color, const FFDrawColor incolor)
+static inline int glyph_pixel(const FT_Bitmap *bitmap, int x, int y)
 {
-    *color = incolor;
-    color->rgba[3] = (color->rgba[3] * s->alpha) / 255;
-    ff_draw_color(&s->dc, color, color->rgba);
+    const uint8_t *p = bitmap->buffer + y * bitmap->pitch;
+
+    if (bitmap->pixel_mode == FT_PIXEL_MODE_MONO)
+        return p[x >> 3] & (0x80 >> (x & 7)) ? 255 : 0;
+    return p[x];
 }
 
-static void update_alpha(DrawTextContext *s)
+/**
+ * Composite the glyph bitmaps, or their borders, of the run into one mask.
+ * Blending it gives the same result as blending the glyphs one after the
+ * other as long as no chroma pixel is covered by two glyphs, since a zero
+ * mask leaves a pixel untouched. Whether that holds depends on where the
+ * mask falls on the chroma grid, so it is recorded for every alignment.
+ */
+static int composite_run(DrawTextContext *s, RunMask *m, int border)
 {
-    double alpha = av_expr_eval(s->a_pexpr, s->var_values, &s->prng);
+    const TextRun *run = &s->run;
+    const int bw = border ? s->borderw : 0;
+    const int hsub = s->dc.hsub_max, vsub = s->dc.vsub_max;
+    int x0 = INT_MAX, y0 = INT_MAX, x1 = INT_MIN, y1 = INT_MIN;
+    int ow, oh, phase, i, x, y;
+    int *owner;
+
+    av_freep(&m->data);
+    m->phases = 0;
+
+    for (i = 0; i < run->nb_glyphs; i++) {
+        const RunGlyph *g = &run->glyphs[i];
+        const FT_Bitmap *bitmap = border ? &g->glyph->border_bitmap :
+                                           &g->glyph->bitmap;
+
+        if (!bitmap->width || !bitmap->rows)
+            continue;
+        x0 = FFMIN(x0, g->x - bw);
+        y0 = FFMIN(y0, g->y - bw);
+        x1 = FFMAX(x1, g->x - bw + (int)bitmap->width);
+        y1 = FFMAX(y1, g->y - bw + (int)bitmap->rows);
+    }
+    if (x0 >= x1)
+        return 0;
 
-    if (isnan(alpha))
-        return;
+    m->x = x0;
+    m->y = y0;
+    m->w = m->linesize = x1 - x0;
+    m->h = y1 - y0;
 
-    if (alpha >= 1.0)
-        s->alpha = 255;
-    else if (alpha <= 0)
-        s->alpha = 0;
-    else
-        s->alpha = 256 * alpha;
+    ow = (m->w >> hsub) + 2;
+    oh = (m->h >> vsub) + 2;
+    if (!(owner = av_malloc_array(ow * oh, sizeof(*owner))))
+        return AVERROR(ENOMEM);
+
+    for (phase = 0; phase < 1 << (hsub + vsub); phase++) {
+        const int px = phase & ((1 << hsub) - 1), py = phase >> hsub;
+        int shared = 0;
+
+        memset(owner, 0, ow * oh * sizeof(*owner));
+        for (i = 0; i < run->nb_glyphs && !shared; i++) {
+            const RunGlyph *g = &run->glyphs[i];
+            const FT_Bitmap *bitmap = border ? &g->glyph->border_bitmap :
+                                               &g->glyph->bitmap;
+            const int gx = g->x - bw - x0 + px, gy = g->y - bw - y0 + py;
+
+            for (y = 0; y < bitmap->rows && !shared; y++) {
+                for (x = 0; x < bitmap->width; x++) {
+                    int *o = &owner[((gy + y) >> vsub) * ow + ((gx + x) >> hsub)];
+
+                    if (!glyph_pixel(bitmap, x, y))
+                        continue;
+                    if (*o && *o != i + 1) {
+                        shared = 1;
+                        break;
+                    }
+                    *o = i + 1;
+                }
+            }
+        }
+        if (!shared)
+            m->phases |= 1U << phase;
+    }
+    av_free(owner);
+
+    if (!m->phases)
+        return 0;
+
+    /* no two glyphs cover the same pixel at this point */
+    if (!(m->data = av_mallocz_array(m->h, m->linesize)))
+        return AVERROR(ENOMEM);
+    for (i = 0; i < run->nb_glyphs; i++) {
+        const RunGlyph *g = &run->glyphs[i];
+        const FT_Bitmap *bitmap = border ? &g->glyph->border_bitmap :
+                                           &g->glyph->bitmap;
+        uint8_t *dst = m->data + (g->y - bw - y0) * m->linesize + g->x - bw - x0;
+
+        for (y = 0; y < bitmap->rows; y++, dst += m->linesize)
+            for (x = 0; x < bitmap->width; x++)
+                dst[x] |= glyph_pixel(bitmap, x, y);
+    }
+
+    return 0;
 }
 
-static int draw_text(AVFilterContext *ctx, AVFrame *frame,
-                     int width, int height)
+/**
+ * Load the glyphs of text and compute their positions, unless it was already
+ * done for the same text at the same font size.
+ */
+static int layout_text(AVFilterContext *ctx, const char *text, int len)
 {
     DrawTextContext *s = ctx->priv;
-    AVFilterLink *inlink = ctx->inputs[0];
-
+    TextRun *run = &s->run;
     uint32_t code = 0, prev_code = 0;
     int x = 0, y = 0, i = 0, ret;
-    int max_text_line_w = 0, len;
-    int box_w, box_h;
-    char *text;
-    uint8_t *p;
+    int max_text_line_w = 0;
+    const uint8_t *p;
     int y_min = 32000, y_max = -32000;
     int x_min = 32000, x_max = -32000;
     FT_Vector delta;
     Glyph *glyph = NULL, *prev_glyph = NULL;
     Glyph dummy = { 0 };
 
-    time_t now = time(0);
-    struct tm ltime;
-    AVBPrint *bp = &s->expanded_text;
-
-    FFDrawColor fontcolor;
-    FFDrawColor shadowcolor;
-    FFDrawColor bordercolor;
-    FFDrawColor boxcolor;
+    if (run->text && run->fontsize == s->fontsize && !strcmp(run->text, text))
+        return 0;
 
-    av_bprint_clear(bp);
+    av_freep(&run->text);
 
-    if(s->basetime != AV_NOPTS_VALUE)
-        now= frame->pts*av_q2d(ctx->inputs[0]->time_base) + s->basetime/1000000;
-
-    switch (s->exp_mode) {
-    case EXP_NONE:
-        av_bprintf(bp, "%s", s->text);
-        break;
-    case EXP_NORMAL:
-        if ((ret = expand_text(ctx, s->text, &s->expanded_text)) < 0)
-            return ret;
-        break;
-    case EXP_STRFTIME:
-        localtime_r(&now, &ltime);
-        av_bprint_strftime(bp, s->text, &ltime);
-        break;
-    }
-
-    if (s->tc_opt_string) {
-        char tcbuf[AV_TIMECODE_STR_SIZE];
-        av_timecode_make_string(&s->tc, tcbuf, inlink->frame_count_out);
-        av_bprint_clear(bp);
-        av_bprintf(bp, "%s%s", s->text, tcbuf);
-    }
-
-    if (!av_bprint_is_complete(bp))
-        return AVERROR(ENOMEM);
-    text = s->expanded_text.str;
-    if ((len = s->expanded_text.len) > s->nb_positions) {
+    if (len > s->nb_positions) {
         if (!(s->positions =
               av_realloc(s->positions, len*sizeof(*s->positions))))
             return AVERROR(ENOMEM);
         s->nb_positions = len;
     }
 
-    if (s->fontcolor_expr[0]) {
-        /* If expression is set, evaluate and replace the static value */
-        av_bprint_clear(&s->expanded_fontcolor);
-        if ((ret = expand_text(ctx, s->fontcolor_expr, &s->expanded_fontcolor)) < 0)
-            return ret;
-        if (!av_bprint_is_complete(&s->expanded_fontcolor))
-            return AVERROR(ENOMEM);
-        av_log(s, AV_LOG_DEBUG, "Evaluated fontcolor is '%s'\n", s->expanded_fontcolor.str);
-        ret = av_parse_color(s->fontcolor.rgba, s->expanded_fontcolor.str, -1, s);
-        if (ret)
-            return ret;
-        ff_draw_color(&s->dc, &s->fontcolor, s->fontcolor.rgba);
-    }
-
-    x = 0;
-    y = 0;
-
-    if ((ret = update_fontsize(ctx)) < 0)
-        return ret;
-
     /* load and cache glyphs */
     for (i = 0, p = text; *p; i++) {
         GET_UTF8(code, *p++, continue;);
@@ -1378,13 +1456,228 @@ static int draw_text(AVFilterContext *ctx, AVFrame *frame,
 
     max_text_line_w = FFMAX(x, max_text_line_w);
 
-    s->var_values[VAR_TW] = s->var_values[VAR_TEXT_W] = max_text_line_w;
-    s->var_values[VAR_TH] = s->var_values[VAR_TEXT_H] = y + s->max_glyph_h;
+    run->w     = max_text_line_w;
+    run->h     = y + s->max_glyph_h;
+    run->y_min = y_min;
+    run->y_max = y_max;
+
+    if ((ret = collect_glyphs(s, text)) < 0 ||
+        (ret = composite_run(s, &run->masks[0], 0)) < 0 ||
+        (s->borderw && (ret = composite_run(s, &run->masks[1], 1)) < 0))
+        return ret;
+
+    if (!(run->text = av_strdup(text)))
+        return AVERROR(ENOMEM);
+    run->fontsize = s->fontsize;
+
+    return 0;
+}
+
+typedef struct TextLayer {
+    FFDrawColor *color;
+    int glyphs;                     ///< draw the glyphs of the run rather than a box
+    int borderw;                    ///< draw the glyph borders of this width
+    int x, y, w, h;                 ///< box, or position of the text for glyphs
+} TextLayer;
+
+typedef struct ThreadData {
+    AVFrame *frame;
+    int width, height;
+    TextLayer layers[4];
+    int nb_layers;
+    int y_start, y_end;             ///< rows covered by the layers
+} ThreadData;
+
+static int draw_text_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    DrawTextContext *s = ctx->priv;
+    const TextRun *run = &s->run;
+    ThreadData *td = arg;
+    AVFrame *frame = td->frame;
+    const int h = td->y_end - td->y_start;
+    /* keep slices aligned on chroma rows so that no pixel is blended twice */
+    const int hmask = (1 << s->dc.hsub_max) - 1;
+    const int vmask = (1 << s->dc.vsub_max) - 1;
+    const int align = ~vmask;
+    const int slice_start = (td->y_start + (h *  jobnr   ) / nb_jobs) & align;
+    const int slice_end   = jobnr == nb_jobs - 1 ? td->y_end :
+                            (td->y_start + (h * (jobnr+1)) / nb_jobs) & align;
+    int i, j;
+
+    for (i = 0; i < td->nb_layers; i++) {
+        const TextLayer *l = &td->layers[i];
+        const RunMask *m = &run->masks[!!l->borderw];
+
+        if (!l->glyphs) {
+            const int y0 = FFMAX(l->y, slice_start);
+            const int y1 = FFMIN(l->y + l->h, slice_end);
+
+            if (y0 < y1)
+                ff_blend_rectangle(&s->dc, l->color,
+                                   frame->data, frame->linesize, td->width, td->height,
+                                   l->x, y0, l->w, y1 - y0);
+            continue;
+        }
+
+        if (m->phases & 1U << (((l->y + m->y) & vmask) << s->dc.hsub_max |
+                               ((l->x + m->x) & hmask))) {
+            const int x  = l->x + m->x;
+            const int y  = l->y + m->y;
+            const int y0 = FFMAX(y, slice_start);
+            const int y1 = FFMIN(y + m->h, slice_end);
+
+            if (y0 < y1)
+                ff_blend_mask(&s->dc, l->color,
+                              frame->data, frame->linesize, td->width, td->height,
+                              m->data + (y0 - y) * m->linesize, m->linesize,
+                              m->w, y1 - y0, 3, 0, x, y0);
+            continue;
+        }
+
+        /* otherwise blend the glyphs one after the other, as overlapping
+         * glyphs and glyphs sharing a chroma pixel depend on the order */
+        for (j = 0; j < run->nb_glyphs; j++) {
+            const RunGlyph *g = &run->glyphs[j];
+            const FT_Bitmap *bitmap = l->borderw ? &g->glyph->border_bitmap :
+                                                   &g->glyph->bitmap;
+            const int x  = l->x + g->x - l->borderw;
+            const int y  = l->y + g->y - l->borderw;
+            const int y0 = FFMAX(y, slice_start);
+            const int y1 = FFMIN(y + (int)bitmap->rows, slice_end);
+
+            if (y0 >= y1)
+                continue;
+            ff_blend_mask(&s->dc, l->color,
+                          frame->data, frame->linesize, td->width, td->height,
+                          bitmap->buffer + (y0 - y) * bitmap->pitch, bitmap->pitch,
+                          bitmap->width, y1 - y0,
+                          bitmap->pixel_mode == FT_PIXEL_MODE_MONO ? 0 : 3,
+                          0, x, y0);
+        }
+    }
+
+    return 0;
+}
+
+static void add_layer(ThreadData *td, const TextRun *run, FFDrawColor *color,
+                      int glyphs, int borderw, int x, int y, int w, int h)
+{
+    TextLayer *l = &td->layers[td->nb_layers++];
+
+    l->color   = color;
+    l->glyphs  = glyphs;
+    l->borderw = borderw;
+    l->x       = x;
+    l->y       = y;
+    l->w       = w;
+    l->h       = h;
+    if (glyphs) {
+        td->y_start = FFMIN(td->y_start, y + run->y0);
+        td->y_end   = FFMAX(td->y_end,   y + run->y1);
+    } else if (w > 0 && h > 0) {
+        td->y_start = FFMIN(td->y_start, y);
+        td->y_end   = FFMAX(td->y_end,   y + h);
+    }
+}
+
+static void update_color_with_alpha(DrawTextContext *s, FFDrawColor *color, const FFDrawColor incolor)
+{
+    *color = incolor;
+    color->rgba[3] = (color->rgba[3] * s->alpha) / 255;
+    ff_draw_color(&s->dc, color, color->rgba);
+}
+
+static void update_alpha(DrawTextContext *s)
+{
+    double alpha = av_expr_eval(s->a_pexpr, s->var_values, &s->prng);
+
+    if (isnan(alpha))
+        return;
+
+    if (alpha >= 1.0)
+        s->alpha = 255;
+    else if (alpha <= 0)
+        s->alpha = 0;
+    else
+        s->alpha = 256 * alpha;
+}
+
+static int draw_text(AVFilterContext *ctx, AVFrame *frame,
+                     int width, int height)
+{
+    DrawTextContext *s = ctx->priv;
+    AVFilterLink *inlink = ctx->inputs[0];
+
+    TextRun *run = &s->run;
+    ThreadData td = { 0 };
+    int ret;
+    int box_w, box_h;
+
+    time_t now = time(0);
+    struct tm ltime;
+    AVBPrint *bp = &s->expanded_text;
+
+    FFDrawColor fontcolor;
+    FFDrawColor shadowcolor;
+    FFDrawColor bordercolor;
+    FFDrawColor boxcolor;
+
+    av_bprint_clear(bp);
+
+    if(s->basetime != AV_NOPTS_VALUE)
+        now= frame->pts*av_q2d(ctx->inputs[0]->time_base) + s->basetime/1000000;
+
+    switch (s->exp_mode) {
+    case EXP_NONE:
+        av_bprintf(bp, "%s", s->text);
+        break;
+    case EXP_NORMAL:
+        if ((ret = expand_text(ctx, s->text, &s->expanded_text)) < 0)
+            return ret;
+        break;
+    case EXP_STRFTIME:
+        localtime_r(&now, &ltime);
+        av_bprint_strftime(bp, s->text, &ltime);
+        break;
+    }
+
+    if (s->tc_opt_string) {
+        char tcbuf[AV_TIMECODE_STR_SIZE];
+        av_timecode_make_string(&s->tc, tcbuf, inlink->frame_count_out);
+        av_bprint_clear(bp);
+        av_bprintf(bp, "%s%s", s->text, tcbuf);
+    }
+
+    if (!av_bprint_is_complete(bp))
+        return AVERROR(ENOMEM);
+
+    if (s->fontcolor_expr[0]) {
+        /* If expression is set, evaluate and replace the static value */
+        av_bprint_clear(&s->expanded_fontcolor);
+        if ((ret = expand_text(ctx, s->fontcolor_expr, &s->expanded_fontcolor)) < 0)
+            return ret;
+        if (!av_bprint_is_complete(&s->expanded_fontcolor))
+            return AVERROR(ENOMEM);
+        av_log(s, AV_LOG_DEBUG, "Evaluated fontcolor is '%s'\n", s->expanded_fontcolor.str);
+        ret = av_parse_color(s->fontcolor.rgba, s->expanded_fontcolor.str, -1, s);
+        if (ret)
+            return ret;
+        ff_draw_color(&s->dc, &s->fontcolor, s->fontcolor.rgba);
+    }
+
+    if ((ret = update_fontsize(ctx)) < 0)
+        return ret;
+
+    if ((ret = layout_text(ctx, s->expanded_text.str, s->expanded_text.len)) < 0)
+        return ret;
+
+    s->var_values[VAR_TW] = s->var_values[VAR_TEXT_W] = run->w;
+    s->var_values[VAR_TH] = s->var_values[VAR_TEXT_H] = run->h;
 
     s->var_values[VAR_MAX_GLYPH_W] = s->max_glyph_w;
     s->var_values[VAR_MAX_GLYPH_H] = s->max_glyph_h;
-    s->var_values[VAR_MAX_GLYPH_A] = s->var_values[VAR_ASCENT ] = y_max;
-    s->var_values[VAR_MAX_GLYPH_D] = s->var_values[VAR_DESCENT] = y_min;
+    s->var_values[VAR_MAX_GLYPH_A] = s->var_values[VAR_ASCENT ] = run->y_max;
+    s->var_values[VAR_MAX_GLYPH_D] = s->var_values[VAR_DESCENT] = run->y_min;
 
     s->var_values[VAR_LINE_H] = s->var_values[VAR_LH] = s->max_glyph_h;
 
@@ -1398,8 +1691,8 @@ static int draw_text(AVFilterContext *ctx, AVFrame *frame,
     update_color_with_alpha(s, &bordercolor, s->bordercolor);
     update_color_with_alpha(s, &boxcolor   , s->boxcolor   );
 
-    box_w = FFMIN(width - 1 , max_text_line_w);
-    box_h = FFMIN(height - 1, y + s->max_glyph_h);
+    box_w = FFMIN(width - 1 , run->w);
+    box_h = FFMIN(height - 1, run->h);
 
     if (s->fix_bounds) {
 
@@ -1427,27 +1720,32 @@ static int draw_text(AVFilterContext *ctx, AVFrame *frame,
             s->y = FFMAX(height - box_h - offsetbottom, 0);
     }
 
-    /* draw box */
+    td.frame   = frame;
+    td.width   = width;
+    td.height  = height;
+    td.y_start = INT_MAX;
+    td.y_end   = INT_MIN;
+
     if (s->draw_box)
-        ff_blend_rectangle(&s->dc, &boxcolor,
-                           frame->data, frame->linesize, width, height,
-                           s->x - s->boxborderw, s->y - s->boxborderw,
-                           box_w + s->boxborderw * 2, box_h + s->boxborderw * 2);
-
-    if (s->shadowx || s->shadowy) {
-        if ((ret = draw_glyphs(s, frame, width, height,
-                               &shadowcolor, s->shadowx, s->shadowy, 0)) < 0)
-            return ret;
+        add_layer(&td, run, &boxcolor, 0, 0,
+                  s->x - s->boxborderw, s->y - s->boxborderw,
+                  box_w + s->boxborderw * 2, box_h + s->boxborderw * 2);
+
+    if (run->nb_glyphs) {
+        if (s->shadowx || s->shadowy)
+            add_layer(&td, run, &shadowcolor, 1, 0,
+                      s->x + s->shadowx, s->y + s->shadowy, 0, 0);
+        if (s->borderw)
+            add_layer(&td, run, &bordercolor, 1, s->borderw, s->x, s->y, 0, 0);
+        add_layer(&td, run, &fontcolor, 1, 0, s->x, s->y, 0, 0);
     }
 
-    if (s->borderw) {
-        if ((ret = draw_glyphs(s, frame, width, height,
-                               &bordercolor, 0, 0, s->borderw)) < 0)
-            return ret;
-    }
-    if ((ret = draw_glyphs(s, frame, width, height,
-                           &fontcolor, 0, 0, 0)) < 0)
-        return ret;
+    /* draw all the layers, band by band */
+    td.y_start = FFMAX(td.y_start, 0) & ~((1 << s->dc.vsub_max) - 1);
+    td.y_end   = FFMIN(td.y_end, height);
+    if (td.y_start < td.y_end)
+        ctx->internal->execute(ctx, draw_text_slice, &td, NULL,
+                               FFMIN(s->nb_threads, td.y_end - td.y_start));
 
     return 0;
 }
@@ -1520,5 +1818,5 @@ AVFilter ff_vf_drawtext = {
     .inputs        = avfilter_vf_drawtext_inputs,
     .outputs       = avfilter_vf_drawtext_outputs,
     .process_command = command,
-    .flags         = AVFILTER_FLAG_SUPPORT_TIMELINE_GENERIC,
+    .flags         = AVFILTER_FLAG_SUPPORT_TIMELINE_GENERIC | AVFILTER_FLAG_SLICE_THREADS,
 };
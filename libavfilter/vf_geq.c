@@ -48,6 +48,8 @@ typedef struct GEQContext {
     int planes;                 ///< number of planes
     int is_rgb;
     int bps;
+    double *x_values;           ///< values of X for a row
+    double *results;            ///< results of a row for each thread
 } GEQContext;
 
 enum { Y = 0, U, V, A, G, B, R };
@@ -222,8 +224,10 @@ static int geq_query_formats(AVFilterContext *ctx)
 
 static int geq_config_props(AVFilterLink *inlink)
 {
-    GEQContext *geq = inlink->dst->priv;
+    AVFilterContext *ctx = inlink->dst;
+    GEQContext *geq = ctx->priv;
     const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(inlink->format);
+    int x;
 
     av_assert0(desc);
 
@@ -231,6 +235,16 @@ static int geq_config_props(AVFilterLink *inlink)
     geq->vsub = desc->log2_chroma_h;
     geq->bps = desc->comp[0].depth;
     geq->planes = desc->nb_components;
+
+    av_freep(&geq->x_values);
+    av_freep(&geq->results);
+    geq->x_values = av_malloc_array(inlink->w, sizeof(*geq->x_values));
+    geq->results  = av_malloc_array(inlink->w, ff_filter_get_nb_threads(ctx) * sizeof(*geq->results));
+    if (!geq->x_values || !geq->results)
+        return AVERROR(ENOMEM);
+    for (x = 0; x < inlink->w; x++)
+        geq->x_values[x] = x;
+
     return 0;
 }
 
@@ -251,11 +265,13 @@ static int slice_geq_filter(AVFilterContext *ctx, void *arg, int jobnr, int nb_j
     const int linesize = td->linesize;
     const int slice_start = (height *  jobnr) / nb_jobs;
     const int slice_end = (height * (jobnr+1)) / nb_jobs;
-    int x, y;
+    double *res = geq->results + jobnr * width;
+    int x, y, ret;
     uint8_t *ptr;
     uint16_t *ptr16;
 
     double values[VAR_VARS_NB];
+    const double *arrays[VAR_VARS_NB] = { [VAR_X] = geq->x_values };
     values[VAR_W] = geq->values[VAR_W];
     values[VAR_H] = geq->values[VAR_H];
     values[VAR_N] = geq->values[VAR_N];
@@ -263,26 +279,20 @@ static int slice_geq_filter(AVFilterContext *ctx, void *arg, int jobnr, int nb_j
     values[VAR_SH] = geq->values[VAR_SH];
     values[VAR_T] = geq->values[VAR_T];
 
-    if (geq->bps == 8) {
-        for (y = slice_start; y < slice_end; y++) {
-            ptr = geq->dst + linesize * y;
-            values[VAR_Y] = y;
+    for (y = slice_start; y < slice_end; y++) {
+        values[VAR_Y] = y;
+        ret = av_expr_eval_array(geq->e[plane], res, width, values, arrays, geq);
+        if (ret < 0)
+            return ret;
 
-            for (x = 0; x < width; x++) {
-                values[VAR_X] = x;
-                ptr[x] = av_expr_eval(geq->e[plane], values, geq);
-            }
-            ptr += linesize;
-        }
-    }
-    else {
-        for (y = slice_start; y < slice_end; y++) {
+        if (geq->bps == 8) {
+            ptr = geq->dst + linesize * y;
+            for (x = 0; x < width; x++)
+                ptr[x] = res[x];
+        } else {
             ptr16 = geq->dst16 + (linesize/2) * y;
-            values[VAR_Y] = y;
-            for (x = 0; x < width; x++) {
-                values[VAR_X] = x;
-                ptr16[x] = av_expr_eval(geq->e[plane], values, geq);
-            }
+            for (x = 0; x < width; x++)
+                ptr16[x] = res[x];
         }
     }
 
@@ -342,6 +352,8 @@ static av_cold void geq_uninit(AVFilterContext *ctx)
 
     for (i = 0; i < FF_ARRAY_ELEMS(geq->e); i++)
         av_expr_free(geq->e[i]);
+    av_freep(&geq->x_values);
+    av_freep(&geq->results);
 }
 
 static const AVFilterPad geq_inputs[] = {
@@ -32,6 +32,8 @@
 typedef struct HistogramContext {
     const AVClass *class;               ///< AVClass context for log and options purpose
     unsigned       histogram[256*256];
+    unsigned      *histograms;          ///< per-thread partial histograms
+    int            nb_threads;
     int            histogram_size;
     int            mult;
     int            ncomp;
@@ -190,6 +192,8 @@ static const uint8_t black_gbrp_color[4] = { 0, 0, 0, 255 };
 static const uint8_t white_yuva_color[4] = { 255, 127, 127, 255 };
 static const uint8_t white_gbrp_color[4] = { 255, 255, 255, 255 };
 
+#define NB_SUBHISTOGRAMS 4
+
 static int config_input(AVFilterLink *inlink)
 {
     HistogramContext *h = inlink->dst->priv;
@@ -223,6 +227,13 @@ static int config_input(AVFilterLink *inlink)
     h->planewidth[1]  = h->planewidth[2]  = AV_CEIL_RSHIFT(inlink->w, h->desc->log2_chroma_w);
     h->planewidth[0]  = h->planewidth[3]  = inlink->w;
 
+    h->nb_threads = ff_filter_get_nb_threads(inlink->dst);
+    av_freep(&h->histograms);
+    h->histograms = av_malloc_array(h->nb_threads, NB_SUBHISTOGRAMS * h->histogram_size *
+                                                   sizeof(*h->histograms));
+    if (!h->histograms)
+        return AVERROR(ENOMEM);
+
     return 0;
 }
 
@@ -246,6 +257,56 @@ static int config_output(AVFilterLink *outlink)
     return 0;
 }
 
+typedef struct ThreadData {
+    AVFrame *in;
+    int plane;
+} ThreadData;
+
+/* Every job counts a band of rows into its own histogram. 8-bit rows are
+ * spread over interleaved sub-histograms so that runs of equal values do
+ * not wait on each other's increment of the same counter. */
+static int compute_histogram(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    HistogramContext *h = ctx->priv;
+    ThreadData *td = arg;
+    const int p = td->plane;
+    const int height = h->planeheight[p];
+    const int width = h->planewidth[p];
+    const int slice_start = (height *  jobnr     ) / nb_jobs;
+    const int slice_end   = (height * (jobnr + 1)) / nb_jobs;
+    const int size = h->histogram_size;
+    unsigned *hist = h->histograms + jobnr * NB_SUBHISTOGRAMS * size;
+    int i, j;
+
+    if (size <= 256) {
+        unsigned *hist1 = hist + size, *hist2 = hist1 + size, *hist3 = hist2 + size;
+
+        memset(hist, 0, NB_SUBHISTOGRAMS * size * sizeof(*hist));
+        for (i = slice_start; i < slice_end; i++) {
+            const uint8_t *src = td->in->data[p] + i * td->in->linesize[p];
+            for (j = 0; j < width - 3; j += 4) {
+                hist [src[j + 0]]++;
+                hist1[src[j + 1]]++;
+                hist2[src[j + 2]]++;
+                hist3[src[j + 3]]++;
+            }
+            for (; j < width; j++)
+                hist[src[j]]++;
+        }
+        for (i = 0; i < size; i++)
+            hist[i] += hist1[i] + hist2[i] + hist3[i];
+    } else {
+        memset(hist, 0, size * sizeof(*hist));
+        for (i = slice_start; i < slice_end; i++) {
+            const uint16_t *src = (const uint16_t *)(td->in->data[p] + i * td->in->linesize[p]);
+            for (j = 0; j < width; j++)
+                hist[src[j]]++;
+        }
+    }
+
+    return 0;
+}
+
 static int filter_frame(AVFilterLink *inlink, AVFrame *in)
 {
     HistogramContext *h   = inlink->dst->priv;
@@ -286,28 +347,25 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *in)
     for (m = 0, k = 0; k < h->ncomp; k++) {
         const int p = h->desc->comp[k].plane;
         const int height = h->planeheight[p];
-        const int width = h->planewidth[p];
         double max_hval_log;
         unsigned max_hval = 0;
-        int start, startx;
+        int start, startx, nb_jobs;
+        ThreadData td;
 
         if (!((1 << k) & h->components))
             continue;
         startx = m * h->histogram_size * (h->display_mode == 1);
         start = m++ * (h->level_height + h->scale_height) * (h->display_mode == 2);
 
-        if (h->histogram_size <= 256) {
-            for (i = 0; i < height; i++) {
-                const uint8_t *src = in->data[p] + i * in->linesize[p];
-                for (j = 0; j < width; j++)
-                    h->histogram[src[j]]++;
-            }
-        } else {
-            for (i = 0; i < height; i++) {
-                const uint16_t *src = (const uint16_t *)(in->data[p] + i * in->linesize[p]);
-                for (j = 0; j < width; j++)
-                    h->histogram[src[j]]++;
-            }
+        td.in    = in;
+        td.plane = p;
+        nb_jobs  = FFMIN(height, h->nb_threads);
+        ctx->internal->execute(ctx, compute_histogram, &td, NULL, nb_jobs);
+
+        for (i = 0; i < h->histogram_size; i++) {
+            h->histogram[i] = 0;
+            for (j = 0; j < nb_jobs; j++)
+                h->histogram[i] += h->histograms[j * NB_SUBHISTOGRAMS * h->histogram_size + i];
         }
 
         for (i = 0; i < h->histogram_size; i++)
@@ -348,14 +406,19 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *in)
                     AV_WN16(out->data[p] + (j + start) * out->linesize[p] + startx * 2 + i * 2, i);
             }
         }
-
-        memset(h->histogram, 0, h->histogram_size * sizeof(unsigned));
     }
 
     av_frame_free(&in);
     return ff_filter_frame(outlink, out);
 }
 
+static av_cold void uninit(AVFilterContext *ctx)
+{
+    HistogramContext *h = ctx->priv;
+
+    av_freep(&h->histograms);
+}
+
 static const AVFilterPad inputs[] = {
     {
         .name         = "default",
@@ -380,7 +443,9 @@ AVFilter ff_vf_histogram = {
     .description   = NULL_IF_CONFIG_SMALL("Compute and draw a histogram."),
     .priv_size     = sizeof(HistogramContext),
     .query_formats = query_formats,
+    .uninit        = uninit,
     .inputs        = inputs,
     .outputs       = outputs,
     .priv_class    = &histogram_class,
+    .flags         = AVFILTER_FLAG_SLICE_THREADS,
 };
@@ -42,6 +42,8 @@
 #include "vf_hqdn3d.h"
 
 #define LUT_BITS (depth==16 ? 8 : 4)
+#define HQDN3D_MIN_BAND_WIDTH 16 ///< narrowest chroma band of the threaded path
+#define HQDN3D_SYNC_ROWS       8 ///< rows a band waits for at once from its left neighbor
 #define LOAD(x) (((depth == 8 ? src[x] : AV_RN16A(src + (x) * 2)) << (16 - depth))\
                  + (((1 << (16 - depth)) - 1) >> 1))
 #define STORE(x,val) (depth == 8 ? dst[x] = (val) >> (16 - depth) : \
@@ -76,6 +78,27 @@ static void denoise_temporal(uint8_t *src, uint8_t *dst,
     }
 }
 
+av_always_inline
+static uint32_t denoise_row(uint8_t *src, uint8_t *dst,
+                            uint16_t *line_ant, uint16_t *frame_ant,
+                            int w, int16_t *spatial, int16_t *temporal,
+                            uint32_t pixel_ant, int depth)
+{
+    long x;
+    uint32_t tmp;
+
+    for (x = 0; x < w-1; x++) {
+        line_ant[x] = tmp = lowpass(line_ant[x], pixel_ant, spatial, depth);
+        pixel_ant = lowpass(pixel_ant, LOAD(x+1), spatial, depth);
+        frame_ant[x] = tmp = lowpass(frame_ant[x], tmp, temporal, depth);
+        STORE(x, tmp);
+    }
+    line_ant[x] = tmp = lowpass(line_ant[x], pixel_ant, spatial, depth);
+    frame_ant[x] = tmp = lowpass(frame_ant[x], tmp, temporal, depth);
+    STORE(x, tmp);
+    return pixel_ant;
+}
+
 av_always_inline
 static void denoise_spatial(HQDN3DContext *s,
                             uint8_t *src, uint8_t *dst,
@@ -103,20 +126,97 @@ static void denoise_spatial(HQDN3DContext *s,
         src += sstride;
         dst += dstride;
         frame_ant += w;
-        if (s->denoise_row[depth]) {
-            s->denoise_row[depth](src, dst, line_ant, frame_ant, w, spatial, temporal);
-            continue;
+        if (s->denoise_row[depth])
+            s->denoise_row[depth](src, dst, line_ant, frame_ant, w, spatial, temporal, LOAD(0));
+        else
+            denoise_row(src, dst, line_ant, frame_ant, w, spatial, temporal, LOAD(0), depth);
+    }
+}
+
+av_always_inline
+static void init_frame_ant(uint8_t *src, uint16_t *frame_ant,
+                           int w, int h, int x0, int x1, int sstride, int depth)
+{
+    long x, y;
+
+    for (y = 0; y < h; y++, src += sstride, frame_ant += w)
+        for (x = x0; x < x1; x++)
+            frame_ant[x] = LOAD(x);
+}
+
+/* The threaded path splits each plane into column bands. The vertical and
+ * temporal recursions stay within a band, but each row of a band starts from
+ * the horizontal state at the right edge of the band to its left. The bands
+ * therefore run as a wavefront: a band hands that state for each row over
+ * through s->carry and waits for it from its left neighbor. */
+av_always_inline
+static void denoise_band(HQDN3DContext *s, int band, int nb_bands,
+                         int row0, int nb_rows, int *ready,
+                         uint8_t *src, uint8_t *dst,
+                         uint16_t *line_ant, uint16_t *frame_ant,
+                         int w, int h, int sstride, int dstride,
+                         int16_t *spatial, int16_t *temporal,
+                         int fill_prev, int depth)
+{
+    int x0 = (w *  band     ) / nb_bands;
+    int x1 = (w * (band + 1)) / nb_bands;
+    int offset = depth == 8 ? x0 : 2 * x0;
+    uint16_t *carry = s->carry + band * nb_rows + row0;
+    long x, y;
+    uint32_t pixel_ant;
+    uint32_t tmp;
+
+    if (fill_prev)
+        init_frame_ant(src, frame_ant, w, h, x0, x1, sstride, depth);
+
+    if (!spatial[0]) {
+        for (y = 0; y < h; y++)
+            denoise_temporal(src + y * sstride + offset, dst + y * dstride + offset,
+                             frame_ant + y * w + x0, x1 - x0, 1,
+                             sstride, dstride, temporal, depth);
+        ff_row_sync_report(&s->sync, band, row0 + h);
+        return;
+    }
+
+    spatial  += 256 << LUT_BITS;
+    temporal += 256 << LUT_BITS;
+
+    for (y = 0; y < h; y++) {
+        if (band) {
+            if (row0 + y >= *ready) {
+                *ready = FFMIN(row0 + y + HQDN3D_SYNC_ROWS, nb_rows);
+                ff_row_sync_wait(&s->sync, band, *ready);
+            }
+            pixel_ant = carry[y - nb_rows];
+        } else {
+            pixel_ant = LOAD(0);
         }
-        pixel_ant = LOAD(0);
-        for (x = 0; x < w-1; x++) {
-            line_ant[x] = tmp = lowpass(line_ant[x], pixel_ant, spatial, depth);
-            pixel_ant = lowpass(pixel_ant, LOAD(x+1), spatial, depth);
-            frame_ant[x] = tmp = lowpass(frame_ant[x], tmp, temporal, depth);
-            STORE(x, tmp);
+
+        if (!y) {
+            for (x = x0; x < x1; x++) {
+                line_ant[x] = tmp = pixel_ant = lowpass(pixel_ant, LOAD(x), spatial, depth);
+                frame_ant[x] = tmp = lowpass(frame_ant[x], tmp, temporal, depth);
+                STORE(x, tmp);
+            }
+        } else {
+            if (s->denoise_row[depth])
+                pixel_ant = s->denoise_row[depth](src + offset, dst + offset,
+                                                  line_ant + x0, frame_ant + x0,
+                                                  x1 - x0, spatial, temporal, pixel_ant);
+            else
+                pixel_ant = denoise_row(src + offset, dst + offset,
+                                        line_ant + x0, frame_ant + x0,
+                                        x1 - x0, spatial, temporal, pixel_ant, depth);
+            if (x1 < w)
+                pixel_ant = lowpass(pixel_ant, LOAD(x1), spatial, depth);
         }
-        line_ant[x] = tmp = lowpass(line_ant[x], pixel_ant, spatial, depth);
-        frame_ant[x] = tmp = lowpass(frame_ant[x], tmp, temporal, depth);
-        STORE(x, tmp);
+
+        carry[y] = pixel_ant;
+        ff_row_sync_report(&s->sync, band, row0 + y + 1);
+
+        src += sstride;
+        dst += dstride;
+        frame_ant += w;
     }
 }
 
@@ -129,18 +229,12 @@ static int denoise_depth(HQDN3DContext *s,
 {
     // FIXME: For 16-bit depth, frame_ant could be a pointer to the previous
     // filtered frame rather than a separate buffer.
-    long x, y;
     uint16_t *frame_ant = *frame_ant_ptr;
     if (!frame_ant) {
-        uint8_t *frame_src = src;
         *frame_ant_ptr = frame_ant = av_malloc_array(w, h*sizeof(uint16_t));
         if (!frame_ant)
             return AVERROR(ENOMEM);
-        for (y = 0; y < h; y++, src += sstride, frame_ant += w)
-            for (x = 0; x < w; x++)
-                frame_ant[x] = LOAD(x);
-        src = frame_src;
-        frame_ant = *frame_ant_ptr;
+        init_frame_ant(src, frame_ant, w, h, 0, w, sstride, depth);
     }
 
     if (spatial[0])
@@ -191,6 +285,45 @@ static int16_t *precalc_coefs(double dist25, int depth)
     return ct;
 }
 
+typedef struct ThreadData {
+    AVFrame *in, *out;
+    int fill_prev[3];
+} ThreadData;
+
+#define DEPTH_SWITCH(func, ...)                                                \
+    switch (s->depth) {                                                        \
+    case  8: func(__VA_ARGS__,  8); break;                                     \
+    case  9: func(__VA_ARGS__,  9); break;                                     \
+    case 10: func(__VA_ARGS__, 10); break;                                     \
+    case 16: func(__VA_ARGS__, 16); break;                                     \
+    }
+
+static int denoise_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    HQDN3DContext *s = ctx->priv;
+    ThreadData *td = arg;
+    AVFrame *in = td->in, *out = td->out;
+    int band = ff_row_sync_next(&s->sync);
+    int c, row0 = 0, ready = 0;
+
+    for (c = 0; c < 3; c++) {
+        int w = AV_CEIL_RSHIFT(in->width,  (!!c * s->hsub));
+        int h = AV_CEIL_RSHIFT(in->height, (!!c * s->vsub));
+
+        DEPTH_SWITCH(denoise_band, s, band, nb_jobs, row0, s->sync.nb_cols, &ready,
+                     in->data[c], out->data[c],
+                     s->line + c * in->width, s->frame_prev[c],
+                     w, h, in->linesize[c], out->linesize[c],
+                     s->coefs[c ? CHROMA_SPATIAL : LUMA_SPATIAL],
+                     s->coefs[c ? CHROMA_TMP     : LUMA_TMP],
+                     td->fill_prev[c]);
+        row0 += h;
+    }
+    emms_c();
+
+    return 0;
+}
+
 #define PARAM1_DEFAULT 4.0
 #define PARAM2_DEFAULT 3.0
 #define PARAM3_DEFAULT 6.0
@@ -224,6 +357,8 @@ static av_cold void uninit(AVFilterContext *ctx)
     av_freep(&s->coefs[2]);
     av_freep(&s->coefs[3]);
     av_freep(&s->line);
+    av_freep(&s->carry);
+    ff_row_sync_uninit(&s->sync);
     av_freep(&s->frame_prev[0]);
     av_freep(&s->frame_prev[1]);
     av_freep(&s->frame_prev[2]);
@@ -263,7 +398,7 @@ static int config_input(AVFilterLink *inlink)
 {
     HQDN3DContext *s = inlink->dst->priv;
     const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(inlink->format);
-    int i;
+    int i, ret;
 
     uninit(inlink->dst);
 
@@ -271,10 +406,22 @@ static int config_input(AVFilterLink *inlink)
     s->vsub  = desc->log2_chroma_h;
     s->depth = desc->comp[0].depth;
 
-    s->line = av_malloc_array(inlink->w, sizeof(*s->line));
+    s->nb_threads = ff_filter_get_nb_threads(inlink->dst);
+
+    /* one line buffer per plane, the threaded path filters them concurrently */
+    s->line = av_malloc_array(inlink->w, 3 * sizeof(*s->line));
     if (!s->line)
         return AVERROR(ENOMEM);
 
+    /* horizontal state at the left edge of each band for each row */
+    s->carry = av_malloc_array(s->nb_threads,
+                               (inlink->h + 2 * AV_CEIL_RSHIFT(inlink->h, s->vsub)) *
+                               sizeof(*s->carry));
+    if (!s->carry)
+        return AVERROR(ENOMEM);
+    if ((ret = ff_row_sync_init(&s->sync, s->nb_threads)) < 0)
+        return ret;
+
     for (i = 0; i < 4; i++) {
         s->coefs[i] = precalc_coefs(s->strength[i], s->depth);
         if (!s->coefs[i])
@@ -295,6 +442,7 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *in)
 
     AVFrame *out;
     int c, direct = av_frame_is_writable(in) && !ctx->is_disabled;
+    int nb_bands = FFMIN(s->nb_threads, AV_CEIL_RSHIFT(in->width, s->hsub) / HQDN3D_MIN_BAND_WIDTH);
 
     if (direct) {
         out = in;
@@ -308,14 +456,36 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *in)
         av_frame_copy_props(out, in);
     }
 
-    for (c = 0; c < 3; c++) {
-        denoise(s, in->data[c], out->data[c],
-                s->line, &s->frame_prev[c],
-                AV_CEIL_RSHIFT(in->width,  (!!c * s->hsub)),
-                AV_CEIL_RSHIFT(in->height, (!!c * s->vsub)),
-                in->linesize[c], out->linesize[c],
-                s->coefs[c ? CHROMA_SPATIAL : LUMA_SPATIAL],
-                s->coefs[c ? CHROMA_TMP     : LUMA_TMP]);
+    if (nb_bands > 1) {
+        ThreadData td = { .in = in, .out = out };
+
+        for (c = 0; c < 3; c++) {
+            if (s->frame_prev[c])
+                continue;
+            s->frame_prev[c] = av_malloc_array(AV_CEIL_RSHIFT(in->width,  (!!c * s->hsub)),
+                                               AV_CEIL_RSHIFT(in->height, (!!c * s->vsub)) * sizeof(uint16_t));
+            if (!s->frame_prev[c]) {
+                if (!direct)
+                    av_frame_free(&out);
+                av_frame_free(&in);
+                return AVERROR(ENOMEM);
+            }
+            td.fill_prev[c] = 1;
+        }
+
+        ff_row_sync_reset(&s->sync, nb_bands,
+                          in->height + 2 * AV_CEIL_RSHIFT(in->height, s->vsub));
+        ctx->internal->execute(ctx, denoise_slice, &td, NULL, nb_bands);
+    } else {
+        for (c = 0; c < 3; c++) {
+            denoise(s, in->data[c], out->data[c],
+                    s->line, &s->frame_prev[c],
+                    AV_CEIL_RSHIFT(in->width,  (!!c * s->hsub)),
+                    AV_CEIL_RSHIFT(in->height, (!!c * s->vsub)),
+                    in->linesize[c], out->linesize[c],
+                    s->coefs[c ? CHROMA_SPATIAL : LUMA_SPATIAL],
+                    s->coefs[c ? CHROMA_TMP     : LUMA_TMP]);
+        }
     }
 
     if (ctx->is_disabled) {
@@ -370,5 +540,5 @@ AVFilter ff_vf_hqdn3d = {
     .query_formats = query_formats,
     .inputs        = avfilter_vf_hqdn3d_inputs,
     .outputs       = avfilter_vf_hqdn3d_outputs,
-    .flags         = AVFILTER_FLAG_SUPPORT_TIMELINE_INTERNAL,
+    .flags         = AVFILTER_FLAG_SUPPORT_TIMELINE_INTERNAL | AVFILTER_FLAG_SLICE_THREADS,
 };
@@ -28,15 +28,20 @@
 
 #include "libavutil/opt.h"
 
+#include "rowsync.h"
+
 typedef struct HQDN3DContext {
     const AVClass *class;
     int16_t *coefs[4];
     uint16_t *line;
     uint16_t *frame_prev[3];
+    uint16_t *carry;
+    FFRowSync sync;
     double strength[4];
     int hsub, vsub;
     int depth;
-    void (*denoise_row[17])(uint8_t *src, uint8_t *dst, uint16_t *line_ant, uint16_t *frame_ant, ptrdiff_t w, int16_t *spatial, int16_t *temporal);
+    int nb_threads;
+    int (*denoise_row[17])(uint8_t *src, uint8_t *dst, uint16_t *line_ant, uint16_t *frame_ant, ptrdiff_t w, int16_t *spatial, int16_t *temporal, int pixel_ant);
 } HQDN3DContext;
 
 #define LUMA_SPATIAL   0
@@ -65,10 +65,14 @@ typedef struct LUT2Context {
     int tlut2;
     AVFrame *prev_frame;        /* only used with tlut2 */
 
-    void (*lut2)(struct LUT2Context *s, AVFrame *dst, AVFrame *srcx, AVFrame *srcy);
+    int (*lut2)(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs);
 
 } LUT2Context;
 
+typedef struct ThreadData {
+    AVFrame *out, *srcx, *srcy;
+} ThreadData;
+
 #define OFFSET(x) offsetof(LUT2Context, x)
 #define FLAGS AV_OPT_FLAG_FILTERING_PARAM|AV_OPT_FLAG_VIDEO_PARAM
 
@@ -158,20 +162,27 @@ static int config_inputy(AVFilterLink *inlink)
     return 0;
 }
 
-static void lut2_8bit(struct LUT2Context *s, AVFrame *out, AVFrame *srcx, AVFrame *srcy)
+static int lut2_8bit(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
 {
+    LUT2Context *s = ctx->priv;
+    ThreadData *td = arg;
+    AVFrame *out  = td->out;
+    AVFrame *srcx = td->srcx;
+    AVFrame *srcy = td->srcy;
     int p, y, x;
 
     for (p = 0; p < s->nb_planes; p++) {
+        const int slice_start = (s->height[p] *  jobnr   ) / nb_jobs;
+        const int slice_end   = (s->height[p] * (jobnr+1)) / nb_jobs;
         const uint16_t *lut = s->lut[p];
         const uint8_t *srcxx, *srcyy;
         uint8_t *dst;
 
-        dst   = out->data[p];
-        srcxx = srcx->data[p];
-        srcyy = srcy->data[p];
+        dst   = out->data[p]  + slice_start * out->linesize[p];
+        srcxx = srcx->data[p] + slice_start * srcx->linesize[p];
+        srcyy = srcy->data[p] + slice_start * srcy->linesize[p];
 
-        for (y = 0; y < s->height[p]; y++) {
+        for (y = slice_start; y < slice_end; y++) {
             for (x = 0; x < s->width[p]; x++) {
                 dst[x] = lut[(srcyy[x] << s->depthx) | srcxx[x]];
             }
@@ -181,22 +192,31 @@ static void lut2_8bit(struct LUT2Context *s, AVFrame *out, AVFrame *srcx, AVFram
             srcyy += srcy->linesize[p];
         }
     }
+
+    return 0;
 }
 
-static void lut2_16bit(struct LUT2Context *s, AVFrame *out, AVFrame *srcx, AVFrame *srcy)
+static int lut2_16bit(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
 {
+    LUT2Context *s = ctx->priv;
+    ThreadData *td = arg;
+    AVFrame *out  = td->out;
+    AVFrame *srcx = td->srcx;
+    AVFrame *srcy = td->srcy;
     int p, y, x;
 
     for (p = 0; p < s->nb_planes; p++) {
+        const int slice_start = (s->height[p] *  jobnr   ) / nb_jobs;
+        const int slice_end   = (s->height[p] * (jobnr+1)) / nb_jobs;
         const uint16_t *lut = s->lut[p];
         const uint16_t *srcxx, *srcyy;
         uint16_t *dst;
 
-        dst   = (uint16_t *)out->data[p];
-        srcxx = (uint16_t *)srcx->data[p];
-        srcyy = (uint16_t *)srcy->data[p];
+        dst   = (uint16_t *)(out->data[p]  + slice_start * out->linesize[p]);
+        srcxx = (uint16_t *)(srcx->data[p] + slice_start * srcx->linesize[p]);
+        srcyy = (uint16_t *)(srcy->data[p] + slice_start * srcy->linesize[p]);
 
-        for (y = 0; y < s->height[p]; y++) {
+        for (y = slice_start; y < slice_end; y++) {
             for (x = 0; x < s->width[p]; x++) {
                 dst[x] = lut[(srcyy[x] << s->depthx) | srcxx[x]];
             }
@@ -206,6 +226,8 @@ static void lut2_16bit(struct LUT2Context *s, AVFrame *out, AVFrame *srcx, AVFra
             srcyy += srcy->linesize[p] / 2;
         }
     }
+
+    return 0;
 }
 
 static int process_frame(FFFrameSync *fs)
@@ -214,6 +236,7 @@ static int process_frame(FFFrameSync *fs)
     LUT2Context *s = fs->opaque;
     AVFilterLink *outlink = ctx->outputs[0];
     AVFrame *out, *srcx = NULL, *srcy = NULL;
+    ThreadData td;
     int ret;
 
     if ((ret = ff_framesync_get_frame(&s->fs, 0, &srcx, 0)) < 0 ||
@@ -230,7 +253,11 @@ static int process_frame(FFFrameSync *fs)
             return AVERROR(ENOMEM);
         av_frame_copy_props(out, srcx);
 
-        s->lut2(s, out, srcx, srcy);
+        td.out  = out;
+        td.srcx = srcx;
+        td.srcy = srcy;
+        ctx->internal->execute(ctx, s->lut2, &td, NULL,
+                               FFMIN(s->height[0], ff_filter_get_nb_threads(ctx)));
     }
 
     out->pts = av_rescale_q(s->fs.pts, s->fs.time_base, outlink->time_base);
@@ -385,7 +412,8 @@ AVFilter ff_vf_lut2 = {
     .activate      = activate,
     .inputs        = inputs,
     .outputs       = outputs,
-    .flags         = AVFILTER_FLAG_SUPPORT_TIMELINE_INTERNAL,
+    .flags         = AVFILTER_FLAG_SUPPORT_TIMELINE_INTERNAL |
+                     AVFILTER_FLAG_SLICE_THREADS,
 };
 
 #if CONFIG_TLUT2_FILTER
@@ -401,10 +429,12 @@ static av_cold int init(AVFilterContext *ctx)
 
 static int tlut2_filter_frame(AVFilterLink *inlink, AVFrame *frame)
 {
-    LUT2Context *s = inlink->dst->priv;
-    AVFilterLink *outlink = inlink->dst->outputs[0];
+    AVFilterContext *ctx = inlink->dst;
+    LUT2Context *s = ctx->priv;
+    AVFilterLink *outlink = ctx->outputs[0];
 
     if (s->prev_frame) {
+        ThreadData td;
         AVFrame *out = ff_get_video_buffer(outlink, outlink->w, outlink->h);
         if (!out) {
             av_frame_free(&s->prev_frame);
@@ -412,7 +442,13 @@ static int tlut2_filter_frame(AVFilterLink *inlink, AVFrame *frame)
             return AVERROR(ENOMEM);
         }
         av_frame_copy_props(out, frame);
-        s->lut2(s, out, frame, s->prev_frame);
+
+        td.out  = out;
+        td.srcx = frame;
+        td.srcy = s->prev_frame;
+        ctx->internal->execute(ctx, s->lut2, &td, NULL,
+                               FFMIN(s->height[0], ff_filter_get_nb_threads(ctx)));
+
         av_frame_free(&s->prev_frame);
         s->prev_frame = frame;
         return ff_filter_frame(outlink, out);
@@ -454,6 +490,7 @@ AVFilter ff_vf_tlut2 = {
     .uninit        = uninit,
     .inputs        = tlut2_inputs,
     .outputs       = tlut2_outputs,
+    .flags         = AVFILTER_FLAG_SLICE_THREADS,
 };
 
 #endif
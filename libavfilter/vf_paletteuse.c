@@ -31,6 +31,7 @@
 #include "filters.h"
 #include "framesync.h"
 #include "internal.h"
+#include "rowsync.h"
 
 enum dithering_mode {
     DITHERING_NONE,
@@ -75,15 +76,28 @@ struct cache_node {
     int nb_entries;
 };
 
+/* error diffusion rows are processed in chunks of this many pixels */
+#define DIFFUSION_CHUNK 32
+
+typedef struct ThreadData {
+    AVFrame *in, *out;
+    int x_start, y_start;   ///< processing window
+    int w, h;
+} ThreadData;
+
 struct PaletteUseContext;
 
-typedef int (*set_frame_func)(struct PaletteUseContext *s, AVFrame *out, AVFrame *in,
-                              int x_start, int y_start, int width, int height);
+/* process the rows [y0,y1) and columns [x0,x1) of the processing window */
+typedef int (*set_frame_func)(struct PaletteUseContext *s, struct cache_node *cache,
+                              const ThreadData *td, int x0, int x1, int y0, int y1);
 
 typedef struct PaletteUseContext {
     const AVClass *class;
     FFFrameSync fs;
-    struct cache_node cache[CACHE_SIZE];    /* lookup cache */
+    struct cache_node *cache;               /* lookup cache, one per job */
+    int nb_threads;
+    int *job_ret;
+    FFRowSync row_sync;                     /* error diffusion wavefront */
     struct color_node map[AVPALETTE_COUNT]; /* 3D-Tree (KD-Tree with K=3) for reverse colormap */
     uint32_t palette[AVPALETTE_COUNT];
     int transparency_index; /* index in the palette of transparency. -1 if there is no transparency in the palette. */
@@ -338,7 +352,8 @@ end:
  * Note: a, r, g, and b are the components of color, but are passed as well to avoid
  * recomputing them (they are generally computed by the caller for other uses).
  */
-static av_always_inline int color_get(PaletteUseContext *s, uint32_t color,
+static av_always_inline int color_get(PaletteUseContext *s, struct cache_node *cache,
+                                      uint32_t color,
                                       uint8_t a, uint8_t r, uint8_t g, uint8_t b,
                                       const enum color_search_method search_method)
 {
@@ -348,7 +363,7 @@ static av_always_inline int color_get(PaletteUseContext *s, uint32_t color,
     const uint8_t ghash = g & ((1<<NBITS)-1);
     const uint8_t bhash = b & ((1<<NBITS)-1);
     const unsigned hash = rhash<<(NBITS*2) | ghash<<NBITS | bhash;
-    struct cache_node *node = &s->cache[hash];
+    struct cache_node *node = &cache[hash];
     struct cached_color *e;
 
     // first, check for transparency
@@ -372,7 +387,7 @@ static av_always_inline int color_get(PaletteUseContext *s, uint32_t color,
     return e->pal_entry;
 }
 
-static av_always_inline int get_dst_color_err(PaletteUseContext *s,
+static av_always_inline int get_dst_color_err(PaletteUseContext *s, struct cache_node *cache,
                                               uint32_t c, int *er, int *eg, int *eb,
                                               const enum color_search_method search_method)
 {
@@ -381,7 +396,7 @@ static av_always_inline int get_dst_color_err(PaletteUseContext *s,
     const uint8_t g = c >>  8 & 0xff;
     const uint8_t b = c       & 0xff;
     uint32_t dstc;
-    const int dstx = color_get(s, c, a, r, g, b, search_method);
+    const int dstx = color_get(s, cache, c, a, r, g, b, search_method);
     if (dstx < 0)
         return dstx;
     dstc = s->palette[dstx];
@@ -391,22 +406,28 @@ static av_always_inline int get_dst_color_err(PaletteUseContext *s,
     return dstx;
 }
 
-static av_always_inline int set_frame(PaletteUseContext *s, AVFrame *out, AVFrame *in,
-                                      int x_start, int y_start, int w, int h,
+static av_always_inline int set_frame(PaletteUseContext *s, struct cache_node *cache,
+                                      const ThreadData *td, int x0, int x1, int y0, int y1,
                                       enum dithering_mode dither,
                                       const enum color_search_method search_method)
 {
     int x, y;
-    const int src_linesize = in ->linesize[0] >> 2;
-    const int dst_linesize = out->linesize[0];
-    uint32_t *src = ((uint32_t *)in ->data[0]) + y_start*src_linesize;
-    uint8_t  *dst =              out->data[0]  + y_start*dst_linesize;
-
-    w += x_start;
-    h += y_start;
-
-    for (y = y_start; y < h; y++) {
-        for (x = x_start; x < w; x++) {
+    const int x_start = td->x_start;
+    const int y_start = td->y_start;
+    const int w = x_start + td->w;
+    const int h = y_start + td->h;
+    const int src_linesize = td->in ->linesize[0] >> 2;
+    const int dst_linesize = td->out->linesize[0];
+    uint32_t *src = ((uint32_t *)td->in ->data[0]) + (y_start + y0)*src_linesize;
+    uint8_t  *dst =              td->out->data[0]  + (y_start + y0)*dst_linesize;
+
+    x0 += x_start;
+    x1 += x_start;
+    y0 += y_start;
+    y1 += y_start;
+
+    for (y = y0; y < y1; y++) {
+        for (x = x0; x < x1; x++) {
             int er, eg, eb;
 
             if (dither == DITHERING_BAYER) {
@@ -418,7 +439,7 @@ static av_always_inline int set_frame(PaletteUseContext *s, AVFrame *out, AVFram
                 const uint8_t r = av_clip_uint8(r8 + d);
                 const uint8_t g = av_clip_uint8(g8 + d);
                 const uint8_t b = av_clip_uint8(b8 + d);
-                const int color = color_get(s, src[x], a8, r, g, b, search_method);
+                const int color = color_get(s, cache, src[x], a8, r, g, b, search_method);
 
                 if (color < 0)
                     return color;
@@ -426,7 +447,7 @@ static av_always_inline int set_frame(PaletteUseContext *s, AVFrame *out, AVFram
 
             } else if (dither == DITHERING_HECKBERT) {
                 const int right = x < w - 1, down = y < h - 1;
-                const int color = get_dst_color_err(s, src[x], &er, &eg, &eb, search_method);
+                const int color = get_dst_color_err(s, cache, src[x], &er, &eg, &eb, search_method);
 
                 if (color < 0)
                     return color;
@@ -438,7 +459,7 @@ static av_always_inline int set_frame(PaletteUseContext *s, AVFrame *out, AVFram
 
             } else if (dither == DITHERING_FLOYD_STEINBERG) {
                 const int right = x < w - 1, down = y < h - 1, left = x > x_start;
-                const int color = get_dst_color_err(s, src[x], &er, &eg, &eb, search_method);
+                const int color = get_dst_color_err(s, cache, src[x], &er, &eg, &eb, search_method);
 
                 if (color < 0)
                     return color;
@@ -452,7 +473,7 @@ static av_always_inline int set_frame(PaletteUseContext *s, AVFrame *out, AVFram
             } else if (dither == DITHERING_SIERRA2) {
                 const int right  = x < w - 1, down  = y < h - 1, left  = x > x_start;
                 const int right2 = x < w - 2,                    left2 = x > x_start + 1;
-                const int color = get_dst_color_err(s, src[x], &er, &eg, &eb, search_method);
+                const int color = get_dst_color_err(s, cache, src[x], &er, &eg, &eb, search_method);
 
                 if (color < 0)
                     return color;
@@ -471,7 +492,7 @@ static av_always_inline int set_frame(PaletteUseContext *s, AVFrame *out, AVFram
 
             } else if (dither == DITHERING_SIERRA2_4A) {
                 const int right = x < w - 1, down = y < h - 1, left = x > x_start;
-                const int color = get_dst_color_err(s, src[x], &er, &eg, &eb, search_method);
+                const int color = get_dst_color_err(s, cache, src[x], &er, &eg, &eb, search_method);
 
                 if (color < 0)
                     return color;
@@ -486,7 +507,7 @@ static av_always_inline int set_frame(PaletteUseContext *s, AVFrame *out, AVFram
                 const uint8_t r = src[x] >> 16 & 0xff;
                 const uint8_t g = src[x] >>  8 & 0xff;
                 const uint8_t b = src[x]       & 0xff;
-                const int color = color_get(s, src[x], a, r, g, b, search_method);
+                const int color = color_get(s, cache, src[x], a, r, g, b, search_method);
 
                 if (color < 0)
                     return color;
@@ -499,6 +520,42 @@ static av_always_inline int set_frame(PaletteUseContext *s, AVFrame *out, AVFram
     return 0;
 }
 
+static int set_frame_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    PaletteUseContext *s = ctx->priv;
+    FFRowSync *rs = &s->row_sync;
+    const ThreadData *td = arg;
+    struct cache_node *cache = s->cache + jobnr * CACHE_SIZE;
+    int x, y, ret;
+
+    if (s->dither == DITHERING_NONE || s->dither == DITHERING_BAYER) {
+        const int slice_start = (td->h *  jobnr   ) / nb_jobs;
+        const int slice_end   = (td->h * (jobnr+1)) / nb_jobs;
+
+        return s->set_frame(s, cache, td, 0, td->w, slice_start, slice_end);
+    }
+
+    /* Error diffusion: a pixel gets error from up to 2 pixels on its left on
+     * its row and from up to 2 pixels on its right on the row above, and
+     * spreads error up to 2 pixels on its right on its row. A row can then
+     * be processed as long as it stays 4 pixels behind the row above it. */
+    while ((y = ff_row_sync_next(rs)) >= 0) {
+        for (x = 0; x < td->w; x += DIFFUSION_CHUNK) {
+            const int x1 = FFMIN(x + DIFFUSION_CHUNK, td->w);
+
+            ff_row_sync_wait(rs, y, x1 + 4);
+            ret = s->set_frame(s, cache, td, x, x1, y, y + 1);
+            if (ret < 0) {
+                /* do not leave the next row waiting */
+                ff_row_sync_report(rs, y, td->w);
+                return ret;
+            }
+            ff_row_sync_report(rs, y, x1);
+        }
+    }
+    return 0;
+}
+
 #define INDENT 4
 static void disp_node(AVBPrint *buf,
                       const struct color_node *map,
@@ -896,7 +953,8 @@ static void set_processing_window(enum diff_mode diff_mode,
 
 static int apply_palette(AVFilterLink *inlink, AVFrame *in, AVFrame **outf)
 {
-    int x, y, w, h, ret;
+    int i, x, y, w, h, nb_jobs, ret = 0;
+    ThreadData td;
     AVFilterContext *ctx = inlink->dst;
     PaletteUseContext *s = ctx->priv;
     AVFilterLink *outlink = inlink->dst->outputs[0];
@@ -926,7 +984,24 @@ static int apply_palette(AVFilterLink *inlink, AVFrame *in, AVFrame **outf)
     ff_dlog(ctx, "%dx%d rect: (%d;%d) -> (%d,%d) [area:%dx%d]\n",
             w, h, x, y, x+w, y+h, in->width, in->height);
 
-    ret = s->set_frame(s, out, in, x, y, w, h);
+    td.in      = in;
+    td.out     = out;
+    td.x_start = x;
+    td.y_start = y;
+    td.w       = w;
+    td.h       = h;
+    nb_jobs = FFMIN(h, s->nb_threads);
+    /* The bayer cache is keyed on the source color but looked up with the
+     * dithered one. With bayer_scale=0 the dither range is wide enough for
+     * two dithered values of a color to share a cache slot, so the output
+     * depends on the order the pixels are visited in. */
+    if (s->dither == DITHERING_BAYER && !s->bayer_scale)
+        nb_jobs = 1;
+    ff_row_sync_reset(&s->row_sync, h, w);
+    ctx->internal->execute(ctx, set_frame_slice, &td, s->job_ret, nb_jobs);
+    for (i = 0; i < nb_jobs; i++)
+        if ((ret = s->job_ret[i]) < 0)
+            break;
     if (ret < 0) {
         av_frame_free(&out);
         *outf = NULL;
@@ -940,6 +1015,18 @@ static int apply_palette(AVFilterLink *inlink, AVFrame *in, AVFrame **outf)
     return 0;
 }
 
+static void free_job_state(PaletteUseContext *s)
+{
+    int i;
+
+    if (s->cache)
+        for (i = 0; i < s->nb_threads * CACHE_SIZE; i++)
+            av_freep(&s->cache[i].entries);
+    av_freep(&s->cache);
+    av_freep(&s->job_ret);
+    ff_row_sync_uninit(&s->row_sync);
+}
+
 static int config_output(AVFilterLink *outlink)
 {
     int ret;
@@ -956,6 +1043,15 @@ static int config_output(AVFilterLink *outlink)
     outlink->w = ctx->inputs[0]->w;
     outlink->h = ctx->inputs[0]->h;
 
+    free_job_state(s);
+    s->nb_threads = FFMAX(1, FFMIN(outlink->h, ff_filter_get_nb_threads(ctx)));
+    s->cache   = av_calloc(s->nb_threads * CACHE_SIZE, sizeof(*s->cache));
+    s->job_ret = av_calloc(s->nb_threads, sizeof(*s->job_ret));
+    if (!s->cache || !s->job_ret)
+        return AVERROR(ENOMEM);
+    if ((ret = ff_row_sync_init(&s->row_sync, outlink->h)) < 0)
+        return ret;
+
     outlink->time_base = ctx->inputs[0]->time_base;
     if ((ret = ff_framesync_configure(&s->fs)) < 0)
         return ret;
@@ -988,9 +1084,10 @@ static void load_palette(PaletteUseContext *s, const AVFrame *palette_frame)
     if (s->new) {
         memset(s->palette, 0, sizeof(s->palette));
         memset(s->map, 0, sizeof(s->map));
-        for (i = 0; i < CACHE_SIZE; i++)
+        for (i = 0; i < s->nb_threads * CACHE_SIZE; i++) {
             av_freep(&s->cache[i].entries);
-        memset(s->cache, 0, sizeof(s->cache));
+            s->cache[i].nb_entries = 0;
+        }
     }
 
     i = 0;
@@ -1041,10 +1138,10 @@ error:
 }
 
 #define DEFINE_SET_FRAME(color_search, name, value)                             \
-static int set_frame_##name(PaletteUseContext *s, AVFrame *out, AVFrame *in,    \
-                            int x_start, int y_start, int w, int h)             \
+static int set_frame_##name(PaletteUseContext *s, struct cache_node *cache,     \
+                            const ThreadData *td, int x0, int x1, int y0, int y1) \
 {                                                                               \
-    return set_frame(s, out, in, x_start, y_start, w, h, value, color_search);  \
+    return set_frame(s, cache, td, x0, x1, y0, y1, value, color_search);        \
 }
 
 #define DEFINE_SET_FRAME_COLOR_SEARCH(color_search, color_search_macro)                                 \
@@ -1107,12 +1204,10 @@ static int activate(AVFilterContext *ctx)
 
 static av_cold void uninit(AVFilterContext *ctx)
 {
-    int i;
     PaletteUseContext *s = ctx->priv;
 
     ff_framesync_uninit(&s->fs);
-    for (i = 0; i < CACHE_SIZE; i++)
-        av_freep(&s->cache[i].entries);
+    free_job_state(s);
     av_frame_free(&s->last_in);
     av_frame_free(&s->last_out);
 }
@@ -1149,4 +1244,5 @@ AVFilter ff_vf_paletteuse = {
     .inputs        = paletteuse_inputs,
     .outputs       = paletteuse_outputs,
     .priv_class    = &paletteuse_class,
+    .flags         = AVFILTER_FLAG_SLICE_THREADS,
 };
@@ -25,6 +25,7 @@
  * Ported from MPlayer libmpcodecs/vf_smartblur.c by Michael Niedermayer.
  */
 
+#include "libavutil/imgutils.h"
 #include "libavutil/opt.h"
 #include "libavutil/pixdesc.h"
 #include "libswscale/swscale.h"
@@ -32,6 +33,7 @@
 #include "avfilter.h"
 #include "formats.h"
 #include "internal.h"
+#include "smartblur.h"
 
 #define RADIUS_MIN 0.1
 #define RADIUS_MAX 5.0
@@ -47,7 +49,9 @@ typedef struct FilterParam {
     float              strength;
     int                threshold;
     float              quality;
-    struct SwsContext *filter_context;
+    int                nb_slices;
+    int                margin;          ///< rows the filter reaches above and below a pixel
+    struct SwsContext **filter_context; ///< one context per slice
 } FilterParam;
 
 typedef struct SmartblurContext {
@@ -57,6 +61,10 @@ typedef struct SmartblurContext {
     int          hsub;
     int          vsub;
     unsigned int sws_flags;
+    uint8_t     *temp;                  ///< per-thread output of the blur when slicing
+    int          temp_linesize;
+    int          temp_size;             ///< size in bytes of the buffer of one thread
+    SmartblurDSPContext dsp;
 } SmartblurContext;
 
 #define OFFSET(x) offsetof(SmartblurContext, x)
@@ -103,15 +111,28 @@ static av_cold int init(AVFilterContext *ctx)
            s->luma.radius, s->luma.strength, s->luma.threshold,
            s->chroma.radius, s->chroma.strength, s->chroma.threshold);
 
+    ff_smartblur_init_dsp(&s->dsp);
+
     return 0;
 }
 
+static void free_sws_contexts(FilterParam *f)
+{
+    int i;
+
+    for (i = 0; i < f->nb_slices && f->filter_context; i++)
+        sws_freeContext(f->filter_context[i]);
+    av_freep(&f->filter_context);
+    f->nb_slices = 0;
+}
+
 static av_cold void uninit(AVFilterContext *ctx)
 {
     SmartblurContext *s = ctx->priv;
 
-    sws_freeContext(s->luma.filter_context);
-    sws_freeContext(s->chroma.filter_context);
+    free_sws_contexts(&s->luma);
+    free_sws_contexts(&s->chroma);
+    av_freep(&s->temp);
 }
 
 static int query_formats(AVFilterContext *ctx)
@@ -130,10 +151,17 @@ static int query_formats(AVFilterContext *ctx)
     return ff_set_common_formats(ctx, fmts_list);
 }
 
-static int alloc_sws_context(FilterParam *f, int width, int height, unsigned int flags)
+/* Slices are blurred by separate contexts that see margin extra rows on
+ * each side, so rows inside a slice get the same filter taps as when the
+ * whole plane is scaled at once. swscale pads the vertical filter to up to
+ * 8 taps and rounds the coefficients differently near the picture edges, so
+ * the margin has to cover the padded size rather than just the gaussian. */
+static int alloc_sws_context(FilterParam *f, int width, int height, unsigned int flags,
+                             int nb_threads)
 {
     SwsVector *vec;
     SwsFilter sws_filter;
+    int ret = 0;
 
     vec = sws_getGaussianVec(f->radius, f->quality);
 
@@ -144,104 +172,208 @@ static int alloc_sws_context(FilterParam *f, int width, int height, unsigned int
     vec->coeff[vec->length / 2] += 1.0 - f->strength;
     sws_filter.lumH = sws_filter.lumV = vec;
     sws_filter.chrH = sws_filter.chrV = NULL;
-    f->filter_context = sws_getCachedContext(NULL,
-                                             width, height, AV_PIX_FMT_GRAY8,
-                                             width, height, AV_PIX_FMT_GRAY8,
-                                             flags, &sws_filter, NULL, NULL);
-
-    sws_freeVec(vec);
 
-    if (!f->filter_context)
-        return AVERROR(EINVAL);
+    free_sws_contexts(f);
+    f->margin = FFALIGN(vec->length, 8);
+    f->filter_context = av_mallocz_array(FFMIN(height, nb_threads), sizeof(*f->filter_context));
+    if (!f->filter_context) {
+        ret = AVERROR(ENOMEM);
+        goto end;
+    }
+    for (f->nb_slices = 0; f->nb_slices < FFMIN(height, nb_threads); f->nb_slices++) {
+        const int slice_start = (height *  f->nb_slices     ) / FFMIN(height, nb_threads);
+        const int slice_end   = (height * (f->nb_slices + 1)) / FFMIN(height, nb_threads);
+        const int h = FFMIN(slice_end + f->margin, height) - FFMAX(slice_start - f->margin, 0);
+
+        f->filter_context[f->nb_slices] = sws_getCachedContext(NULL,
+                                                               width, h, AV_PIX_FMT_GRAY8,
+                                                               width, h, AV_PIX_FMT_GRAY8,
+                                                               flags, &sws_filter, NULL, NULL);
+        if (!f->filter_context[f->nb_slices]) {
+            ret = AVERROR(EINVAL);
+            break;
+        }
+    }
 
-    return 0;
+end:
+    sws_freeVec(vec);
+    return ret;
 }
 
 static int config_props(AVFilterLink *inlink)
 {
-    SmartblurContext *s = inlink->dst->priv;
+    AVFilterContext *ctx = inlink->dst;
+    SmartblurContext *s = ctx->priv;
     const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(inlink->format);
+    const int nb_threads = ff_filter_get_nb_threads(ctx);
+    int ret;
 
     s->hsub = desc->log2_chroma_w;
     s->vsub = desc->log2_chroma_h;
 
-    alloc_sws_context(&s->luma, inlink->w, inlink->h, s->sws_flags);
-    alloc_sws_context(&s->chroma,
-                      AV_CEIL_RSHIFT(inlink->w, s->hsub),
-                      AV_CEIL_RSHIFT(inlink->h, s->vsub),
-                      s->sws_flags);
+    if ((ret = alloc_sws_context(&s->luma, inlink->w, inlink->h, s->sws_flags,
+                                 nb_threads)) < 0 ||
+        (ret = alloc_sws_context(&s->chroma,
+                                 AV_CEIL_RSHIFT(inlink->w, s->hsub),
+                                 AV_CEIL_RSHIFT(inlink->h, s->vsub),
+                                 s->sws_flags, nb_threads)) < 0)
+        return ret;
+
+    av_freep(&s->temp);
+    if (nb_threads > 1) {
+        /* a slice of luma with its margins is the largest thing to hold */
+        s->temp_linesize = FFALIGN(inlink->w, 32);
+        s->temp_size     = s->temp_linesize *
+                           (inlink->h / s->luma.nb_slices + 1 +
+                            2 * FFMAX(s->luma.margin, s->chroma.margin));
+        s->temp = av_malloc_array(s->luma.nb_slices, s->temp_size);
+        if (!s->temp)
+            return AVERROR(ENOMEM);
+    }
 
     return 0;
 }
 
-static void blur(uint8_t       *dst, const int dst_linesize,
-                 const uint8_t *src, const int src_linesize,
-                 const int w, const int h, const int threshold,
-                 struct SwsContext *filter_context)
+static void threshold_c(uint8_t *dst, const uint8_t *src, int w, int threshold)
 {
-    int x, y;
+    int x;
     int orig, filtered;
     int diff;
-    /* Declare arrays of 4 to get aligned data */
-    const uint8_t* const src_array[4] = {src};
-    uint8_t *dst_array[4]             = {dst};
-    int src_linesize_array[4] = {src_linesize};
-    int dst_linesize_array[4] = {dst_linesize};
-
-    sws_scale(filter_context, src_array, src_linesize_array,
-              0, h, dst_array, dst_linesize_array);
 
     if (threshold > 0) {
-        for (y = 0; y < h; ++y) {
-            for (x = 0; x < w; ++x) {
-                orig     = src[x + y * src_linesize];
-                filtered = dst[x + y * dst_linesize];
-                diff     = orig - filtered;
-
-                if (diff > 0) {
-                    if (diff > 2 * threshold)
-                        dst[x + y * dst_linesize] = orig;
-                    else if (diff > threshold)
-                        /* add 'diff' and subtract 'threshold' from 'filtered' */
-                        dst[x + y * dst_linesize] = orig - threshold;
-                } else {
-                    if (-diff > 2 * threshold)
-                        dst[x + y * dst_linesize] = orig;
-                    else if (-diff > threshold)
-                        /* add 'diff' and 'threshold' to 'filtered' */
-                        dst[x + y * dst_linesize] = orig + threshold;
-                }
+        for (x = 0; x < w; ++x) {
+            orig     = src[x];
+            filtered = dst[x];
+            diff     = orig - filtered;
+
+            if (diff > 0) {
+                if (diff > 2 * threshold)
+                    dst[x] = orig;
+                else if (diff > threshold)
+                    /* add 'diff' and subtract 'threshold' from 'filtered' */
+                    dst[x] = orig - threshold;
+            } else {
+                if (-diff > 2 * threshold)
+                    dst[x] = orig;
+                else if (-diff > threshold)
+                    /* add 'diff' and 'threshold' to 'filtered' */
+                    dst[x] = orig + threshold;
             }
         }
     } else if (threshold < 0) {
-        for (y = 0; y < h; ++y) {
-            for (x = 0; x < w; ++x) {
-                orig     = src[x + y * src_linesize];
-                filtered = dst[x + y * dst_linesize];
-                diff     = orig - filtered;
-
-                if (diff > 0) {
-                    if (diff <= -threshold)
-                        dst[x + y * dst_linesize] = orig;
-                    else if (diff <= -2 * threshold)
-                        /* subtract 'diff' and 'threshold' from 'orig' */
-                        dst[x + y * dst_linesize] = filtered - threshold;
-                } else {
-                    if (diff >= threshold)
-                        dst[x + y * dst_linesize] = orig;
-                    else if (diff >= 2 * threshold)
-                        /* add 'threshold' and subtract 'diff' from 'orig' */
-                        dst[x + y * dst_linesize] = filtered + threshold;
-                }
+        for (x = 0; x < w; ++x) {
+            orig     = src[x];
+            filtered = dst[x];
+            diff     = orig - filtered;
+
+            if (diff > 0) {
+                if (diff <= -threshold)
+                    dst[x] = orig;
+                else if (diff <= -2 * threshold)
+                    /* subtract 'diff' and 'threshold' from 'orig' */
+                    dst[x] = filtered - threshold;
+            } else {
+                if (diff >= threshold)
+                    dst[x] = orig;
+                else if (diff >= 2 * threshold)
+                    /* add 'threshold' and subtract 'diff' from 'orig' */
+                    dst[x] = filtered + threshold;
             }
         }
     }
 }
 
+av_cold void ff_smartblur_init_dsp(SmartblurDSPContext *dsp)
+{
+    dsp->threshold = threshold_c;
+
+    if (ARCH_X86)
+        ff_smartblur_init_dsp_x86(dsp);
+}
+
+static void apply_threshold(const SmartblurDSPContext *dsp,
+                            uint8_t       *dst, const int dst_linesize,
+                            const uint8_t *src, const int src_linesize,
+                            const int w, const int h, const int threshold)
+{
+    const int w16 = w & ~15;
+    int y;
+
+    if (!threshold)
+        return;
+
+    for (y = 0; y < h; ++y) {
+        dsp->threshold(dst, src, w16, threshold);
+        threshold_c(dst + w16, src + w16, w - w16, threshold);
+        dst += dst_linesize;
+        src += src_linesize;
+    }
+}
+
+typedef struct ThreadData {
+    FilterParam   *f;
+    uint8_t       *dst;
+    const uint8_t *src;
+    int dst_linesize;
+    int src_linesize;
+    int w, h;
+} ThreadData;
+
+static int blur_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    SmartblurContext *s = ctx->priv;
+    ThreadData *td = arg;
+    const int slice_start = (td->h *  jobnr     ) / nb_jobs;
+    const int slice_end   = (td->h * (jobnr + 1)) / nb_jobs;
+    const int start = FFMAX(slice_start - td->f->margin, 0);
+    const int end   = FFMIN(slice_end   + td->f->margin, td->h);
+    uint8_t *dst = td->dst + slice_start * td->dst_linesize;
+    const uint8_t *src = td->src + slice_start * td->src_linesize;
+    /* Declare arrays of 4 to get aligned data */
+    const uint8_t* const src_array[4] = { td->src + start * td->src_linesize };
+    uint8_t *dst_array[4]             = { td->dst };
+    int src_linesize_array[4] = { td->src_linesize };
+    int dst_linesize_array[4] = { td->dst_linesize };
+
+    if (nb_jobs > 1) {
+        dst_array[0]          = s->temp + jobnr * s->temp_size;
+        dst_linesize_array[0] = s->temp_linesize;
+    }
+
+    sws_scale(td->f->filter_context[jobnr], src_array, src_linesize_array,
+              0, end - start, dst_array, dst_linesize_array);
+
+    if (nb_jobs > 1)
+        av_image_copy_plane(dst, td->dst_linesize,
+                            dst_array[0] + (slice_start - start) * s->temp_linesize,
+                            s->temp_linesize, td->w, slice_end - slice_start);
+
+    apply_threshold(&s->dsp, dst, td->dst_linesize, src, td->src_linesize,
+                    td->w, slice_end - slice_start, td->f->threshold);
+
+    return 0;
+}
+
+static void blur(AVFilterContext *ctx,
+                 uint8_t       *dst, const int dst_linesize,
+                 const uint8_t *src, const int src_linesize,
+                 const int w, const int h, FilterParam *f)
+{
+    ThreadData td = {
+        .f = f,
+        .dst = dst, .dst_linesize = dst_linesize,
+        .src = src, .src_linesize = src_linesize,
+        .w = w, .h = h,
+    };
+
+    ctx->internal->execute(ctx, blur_slice, &td, NULL, f->nb_slices);
+}
+
 static int filter_frame(AVFilterLink *inlink, AVFrame *inpic)
 {
-    SmartblurContext  *s  = inlink->dst->priv;
-    AVFilterLink *outlink     = inlink->dst->outputs[0];
+    AVFilterContext *ctx = inlink->dst;
+    SmartblurContext  *s  = ctx->priv;
+    AVFilterLink *outlink     = ctx->outputs[0];
     AVFrame *outpic;
     int cw = AV_CEIL_RSHIFT(inlink->w, s->hsub);
     int ch = AV_CEIL_RSHIFT(inlink->h, s->vsub);
@@ -253,20 +385,17 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *inpic)
     }
     av_frame_copy_props(outpic, inpic);
 
-    blur(outpic->data[0], outpic->linesize[0],
+    blur(ctx, outpic->data[0], outpic->linesize[0],
          inpic->data[0],  inpic->linesize[0],
-         inlink->w, inlink->h, s->luma.threshold,
-         s->luma.filter_context);
+         inlink->w, inlink->h, &s->luma);
 
     if (inpic->data[2]) {
-        blur(outpic->data[1], outpic->linesize[1],
+        blur(ctx, outpic->data[1], outpic->linesize[1],
              inpic->data[1],  inpic->linesize[1],
-             cw, ch, s->chroma.threshold,
-             s->chroma.filter_context);
-        blur(outpic->data[2], outpic->linesize[2],
+             cw, ch, &s->chroma);
+        blur(ctx, outpic->data[2], outpic->linesize[2],
              inpic->data[2],  inpic->linesize[2],
-             cw, ch, s->chroma.threshold,
-             s->chroma.filter_context);
+             cw, ch, &s->chroma);
     }
 
     av_frame_free(&inpic);
@@ -301,5 +430,5 @@ AVFilter ff_vf_smartblur = {
     .inputs        = smartblur_inputs,
     .outputs       = smartblur_outputs,
     .priv_class    = &smartblur_class,
-    .flags         = AVFILTER_FLAG_SUPPORT_TIMELINE_GENERIC,
+    .flags         = AVFILTER_FLAG_SUPPORT_TIMELINE_GENERIC | AVFILTER_FLAG_SLICE_THREADS,
 };
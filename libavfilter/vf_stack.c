@@ -29,6 +29,25 @@
 #include "framesync.h"
 #include "video.h"
 
+/* Maximum number of output frames the inputs can render into at once */
+#define MAX_CANVASES 8
+
+/* Inputs render into the output frame only if the data they write past
+ * their width, when rounding it up to the SIMD register size, stays inside
+ * their region. */
+#define REGION_ALIGN 64
+
+typedef struct Canvas {
+    AVFrame *frame;             ///< output frame, NULL if the slot is free
+    int64_t index;              ///< index of the buffers of each input aliasing it
+} Canvas;
+
+typedef struct StackInput {
+    int x[4];                   ///< offset of the region of the input in bytes
+    int y[4];                   ///< offset of the region of the input in rows
+    int64_t nb_buffers;         ///< number of buffers requested by the input
+} StackInput;
+
 typedef struct StackContext {
     const AVClass *class;
     const AVPixFmtDescriptor *desc;
@@ -39,6 +58,11 @@ typedef struct StackContext {
 
     AVFrame **frames;
     FFFrameSync fs;
+
+    StackInput *inputs;
+    Canvas canvases[MAX_CANVASES];
+    int direct;                 ///< whether the inputs may render into the output
+    int nb_misses;              ///< frames copied in a row while direct
 } StackContext;
 
 static int query_formats(AVFilterContext *ctx)
@@ -58,6 +82,113 @@ static int query_formats(AVFilterContext *ctx)
     return ff_set_common_formats(ctx, pix_fmts);
 }
 
+static void free_view_buffer(void *opaque, uint8_t *data)
+{
+    AVBufferRef *buf = opaque;
+    av_buffer_unref(&buf);
+}
+
+static void release_canvases(StackContext *s, int64_t max_index)
+{
+    int i;
+
+    for (i = 0; i < MAX_CANVASES; i++)
+        if (s->canvases[i].frame && s->canvases[i].index <= max_index)
+            av_frame_free(&s->canvases[i].frame);
+}
+
+/*
+ * The n-th buffer of the size of the link requested by each input is a view
+ * of the region of the input in the n-th canvas, an output frame allocated
+ * when the first input asks for its n-th buffer. When all the frames to
+ * stack are views of the same canvas, the canvas is output as is and nothing
+ * is copied. Otherwise (inputs with different frame rates, buffers dropped
+ * upstream...), the frames are copied into a new output frame as usual, and
+ * the next buffers of the inputs are paired again. Once an input sends a
+ * frame without having requested any buffer, e.g. a buffer source, or the
+ * pairing keeps failing, e.g. because an input requests buffers it does not
+ * send, the canvases are not allocated any more.
+ *
+ * Each view has buffers of its own, referencing the ones of the canvas, so
+ * that it is writable.
+ */
+static AVFrame *get_video_buffer(AVFilterLink *inlink, int w, int h)
+{
+    AVFilterContext *ctx = inlink->dst;
+    AVFilterLink *outlink = ctx->outputs[0];
+    StackContext *s = ctx->priv;
+    StackInput *in = &s->inputs[FF_INLINK_IDX(inlink)];
+    int64_t index;
+    Canvas *c;
+    AVFrame *frame;
+    int p;
+
+    if (!s->direct || w != inlink->w || h != inlink->h)
+        return ff_default_get_video_buffer(inlink, w, h);
+
+    index = in->nb_buffers++;
+    c = &s->canvases[index % MAX_CANVASES];
+    if (c->frame && c->index > index)
+        return ff_default_get_video_buffer(inlink, w, h);
+
+    /* an input is too far behind to ever complete the canvas in the slot */
+    if (c->frame && c->index < index)
+        av_frame_free(&c->frame);
+    if (!c->frame) {
+        c->frame = ff_get_video_buffer(outlink, outlink->w, outlink->h);
+        if (!c->frame)
+            return NULL;
+        c->index = index;
+    }
+
+    frame = av_frame_alloc();
+    if (!frame)
+        return NULL;
+    frame->format = inlink->format;
+    frame->width  = w;
+    frame->height = h;
+
+    for (p = 0; p < s->nb_planes; p++) {
+        AVBufferRef *buf = av_frame_get_plane_buffer(c->frame, p);
+        AVBufferRef *ref = av_buffer_ref(buf);
+
+        frame->data[p]     = c->frame->data[p] + in->y[p] * c->frame->linesize[p] + in->x[p];
+        frame->linesize[p] = c->frame->linesize[p];
+        if (ref)
+            frame->buf[p] = av_buffer_create(frame->data[p], buf->data + buf->size - frame->data[p],
+                                             free_view_buffer, ref, 0);
+        if (!frame->buf[p]) {
+            av_buffer_unref(&ref);
+            av_frame_free(&frame);
+            return NULL;
+        }
+    }
+    frame->extended_data = frame->data;
+
+    return frame;
+}
+
+/* Return the canvas the frame of an input is a view of, NULL if none. */
+static Canvas *find_canvas(StackContext *s, int i, AVFrame *frame)
+{
+    StackInput *in = &s->inputs[i];
+    int c, p;
+
+    for (c = 0; c < MAX_CANVASES; c++) {
+        AVFrame *canvas = s->canvases[c].frame;
+
+        if (!canvas)
+            continue;
+        for (p = 0; p < s->nb_planes; p++)
+            if (frame->linesize[p] != canvas->linesize[p] ||
+                frame->data[p] != canvas->data[p] + in->y[p] * canvas->linesize[p] + in->x[p])
+                break;
+        if (p == s->nb_planes)
+            return &s->canvases[c];
+    }
+    return NULL;
+}
+
 static av_cold int init(AVFilterContext *ctx)
 {
     StackContext *s = ctx->priv;
@@ -70,10 +201,15 @@ static av_cold int init(AVFilterContext *ctx)
     if (!s->frames)
         return AVERROR(ENOMEM);
 
+    s->inputs = av_calloc(s->nb_inputs, sizeof(*s->inputs));
+    if (!s->inputs)
+        return AVERROR(ENOMEM);
+
     for (i = 0; i < s->nb_inputs; i++) {
         AVFilterPad pad = { 0 };
 
         pad.type = AVMEDIA_TYPE_VIDEO;
+        pad.get_video_buffer = get_video_buffer;
         pad.name = av_asprintf("input%d", i);
         if (!pad.name)
             return AVERROR(ENOMEM);
@@ -94,11 +230,50 @@ static int process_frame(FFFrameSync *fs)
     StackContext *s = fs->opaque;
     AVFrame **in = s->frames;
     AVFrame *out;
+    Canvas *canvas = NULL;
     int i, p, ret, offset[4] = { 0 };
 
     for (i = 0; i < s->nb_inputs; i++) {
+        Canvas *c;
+
         if ((ret = ff_framesync_get_frame(&s->fs, i, &in[i], 0)) < 0)
             return ret;
+
+        c = find_canvas(s, i, in[i]);
+        if (!c && !s->inputs[i].nb_buffers && s->direct) {
+            s->direct = 0;
+            release_canvases(s, INT64_MAX);
+        }
+        if (!i)
+            canvas = c;
+        else if (c != canvas)
+            canvas = NULL;
+    }
+
+    if (canvas) {
+        s->nb_misses = 0;
+        out = canvas->frame;
+        canvas->frame = NULL;
+        release_canvases(s, canvas->index);
+        out->pts = av_rescale_q(s->fs.pts, s->fs.time_base, outlink->time_base);
+        out->sample_aspect_ratio = outlink->sample_aspect_ratio;
+        return ff_filter_frame(outlink, out);
+    }
+
+    /* the inputs are out of step, e.g. after a dropped frame: pair their
+     * next buffers again, unless that did not help for longer than the
+     * buffers in flight can explain */
+    if (s->direct && ++s->nb_misses > MAX_CANVASES) {
+        s->direct = 0;
+        release_canvases(s, INT64_MAX);
+    }
+    if (s->direct) {
+        int64_t next = 0;
+
+        for (i = 0; i < s->nb_inputs; i++)
+            next = FFMAX(next, s->inputs[i].nb_buffers);
+        for (i = 0; i < s->nb_inputs; i++)
+            s->inputs[i].nb_buffers = next;
     }
 
     out = ff_get_video_buffer(outlink, outlink->w, outlink->h);
@@ -152,6 +327,7 @@ static int config_output(AVFilterLink *outlink)
     int height = ctx->inputs[0]->h;
     int width = ctx->inputs[0]->w;
     FFFrameSyncIn *in;
+    int x[4] = { 0 }, y[4] = { 0 };
     int i, ret;
 
     if (s->is_vertical) {
@@ -177,6 +353,28 @@ static int config_output(AVFilterLink *outlink)
         return AVERROR_BUG;
     s->nb_planes = av_pix_fmt_count_planes(outlink->format);
 
+    s->direct = 1;
+    for (i = 0; i < s->nb_inputs; i++) {
+        int linesize[4], p;
+
+        if ((ret = av_image_fill_linesizes(linesize, ctx->inputs[i]->format,
+                                           ctx->inputs[i]->w)) < 0)
+            return ret;
+
+        for (p = 0; p < s->nb_planes; p++) {
+            int h = ctx->inputs[i]->h;
+
+            if (p == 1 || p == 2)
+                h = AV_CEIL_RSHIFT(h, s->desc->log2_chroma_h);
+            s->inputs[i].x[p] = s->is_vertical ? 0 : x[p];
+            s->inputs[i].y[p] = s->is_vertical ? y[p] : 0;
+            x[p] += linesize[p];
+            y[p] += h;
+            if (!s->is_vertical && i < s->nb_inputs - 1 && linesize[p] % REGION_ALIGN)
+                s->direct = 0;
+        }
+    }
+
     outlink->w          = width;
     outlink->h          = height;
     outlink->time_base  = time_base;
@@ -209,6 +407,8 @@ static av_cold void uninit(AVFilterContext *ctx)
 
     ff_framesync_uninit(&s->fs);
     av_freep(&s->frames);
+    release_canvases(s, INT64_MAX);
+    av_freep(&s->inputs);
 
     for (i = 0; i < ctx->nb_inputs; i++)
         av_freep(&ctx->input_pads[i].name);
@@ -28,6 +28,7 @@
 #include <string.h>
 
 #include "libavutil/imgutils.h"
+#include "libavutil/intfloat.h"
 #include "libavutil/internal.h"
 #include "libavutil/intreadwrite.h"
 #include "libavutil/mastering_display_metadata.h"
@@ -41,6 +42,16 @@
 
 #define REFERENCE_WHITE 100.0f
 
+/* The curve lookup table is indexed by the exponent and the top LUT_BITS
+ * mantissa bits of the signal, which gives 1 << LUT_BITS segments per octave
+ * from 2^LUT_MIN_EXP, below the 1e-6 floor of the signal, to 2^LUT_MAX_EXP. */
+#define LUT_BITS     6
+#define LUT_SHIFT    (23 - LUT_BITS)
+#define LUT_MIN_EXP  -20
+#define LUT_MAX_EXP  8
+#define LUT_SIZE     ((LUT_MAX_EXP - LUT_MIN_EXP) << LUT_BITS)
+#define LUT_BASE     ((LUT_MIN_EXP + 127) << LUT_BITS)
+
 enum TonemapAlgorithm {
     TONEMAP_NONE,
     TONEMAP_LINEAR,
@@ -76,8 +87,23 @@ typedef struct TonemapContext {
     double peak;
 
     const LumaCoefficients *coeffs;
+
+    /* constants of the curve for the peak of the current frame */
+    float curve_mul;
+    float curve_exp;
+    float curve_low;
+    float curve_a, curve_b;
+
+    int use_lut;
+    double lut_peak;                ///< peak the lookup table was built for
+    float lut[LUT_SIZE + 1];        ///< mapped signal at the start of each segment
 } TonemapContext;
 
+typedef struct ThreadData {
+    const AVFrame *in;
+    AVFrame *out;
+} ThreadData;
+
 static const enum AVPixelFormat pix_fmts[] = {
     AV_PIX_FMT_GBRPF32,
     AV_PIX_FMT_GBRAPF32,
@@ -139,94 +165,199 @@ static double determine_signal_peak(AVFrame *in)
     return peak;
 }
 
-static float hable(float in)
+static av_always_inline float hable(float in)
 {
     float a = 0.15f, b = 0.50f, c = 0.10f, d = 0.20f, e = 0.02f, f = 0.30f;
     return (in * (in * a + b * c) + d * e) / (in * (in * a + b) + d * f) - e / f;
 }
 
-static float mobius(float in, float j, double peak)
+static void update_curve(TonemapContext *s, double peak)
 {
+    const float j = s->param;
     float a, b;
 
-    if (in <= j)
-        return in;
-
-    a = -j * j * (peak - 1.0f) / (j * j - 2.0f * j + peak);
-    b = (j * j - 2.0f * j * peak + peak) / FFMAX(peak - 1.0f, 1e-6);
-
-    return (b * b + 2.0f * b * j + j * j) / (b - a) * (in + a) / (in + b);
-}
-
-#define MIX(x,y,a) (x) * (1 - (a)) + (y) * (a)
-static void tonemap(TonemapContext *s, AVFrame *out, const AVFrame *in,
-                    const AVPixFmtDescriptor *desc, int x, int y, double peak)
-{
-    const float *r_in = (const float *)(in->data[0] + x * desc->comp[0].step + y * in->linesize[0]);
-    const float *b_in = (const float *)(in->data[1] + x * desc->comp[1].step + y * in->linesize[1]);
-    const float *g_in = (const float *)(in->data[2] + x * desc->comp[2].step + y * in->linesize[2]);
-    float *r_out = (float *)(out->data[0] + x * desc->comp[0].step + y * out->linesize[0]);
-    float *b_out = (float *)(out->data[1] + x * desc->comp[1].step + y * out->linesize[1]);
-    float *g_out = (float *)(out->data[2] + x * desc->comp[2].step + y * out->linesize[2]);
-    float sig, sig_orig;
-
-    /* load values */
-    *r_out = *r_in;
-    *b_out = *b_in;
-    *g_out = *g_in;
-
-    /* desaturate to prevent unnatural colors */
-    if (s->desat > 0) {
-        float luma = s->coeffs->cr * *r_in + s->coeffs->cg * *g_in + s->coeffs->cb * *b_in;
-        float overbright = FFMAX(luma - s->desat, 1e-6) / FFMAX(luma, 1e-6);
-        *r_out = MIX(*r_in, luma, overbright);
-        *g_out = MIX(*g_in, luma, overbright);
-        *b_out = MIX(*b_in, luma, overbright);
-    }
-
-    /* pick the brightest component, reducing the value range as necessary
-     * to keep the entire signal in range and preventing discoloration due to
-     * out-of-bounds clipping */
-    sig = FFMAX(FFMAX3(*r_out, *g_out, *b_out), 1e-6);
-    sig_orig = sig;
-
-    switch(s->tonemap) {
-    default:
-    case TONEMAP_NONE:
-        // do nothing
-        break;
+    switch (s->tonemap) {
     case TONEMAP_LINEAR:
-        sig = sig * s->param / peak;
+        s->curve_mul = s->param / peak;
         break;
     case TONEMAP_GAMMA:
-        sig = sig > 0.05f ? pow(sig / peak, 1.0f / s->param)
-                          : sig * pow(0.05f / peak, 1.0f / s->param) / 0.05f;
+        s->curve_mul = 1.0f / peak;
+        s->curve_exp = 1.0f / s->param;
+        s->curve_low = pow(0.05f / peak, 1.0f / s->param) / 0.05f;
         break;
     case TONEMAP_CLIP:
-        sig = av_clipf(sig * s->param, 0, 1.0f);
+        s->curve_mul = s->param;
         break;
     case TONEMAP_HABLE:
-        sig = hable(sig) / hable(peak);
+        s->curve_mul = hable(peak);
         break;
     case TONEMAP_REINHARD:
-        sig = sig / (sig + s->param) * (peak + s->param) / peak;
+        s->curve_mul = (peak + s->param) / peak;
         break;
     case TONEMAP_MOBIUS:
-        sig = mobius(sig, s->param, peak);
+        a = -j * j * (peak - 1.0f) / (j * j - 2.0f * j + peak);
+        b = (j * j - 2.0f * j * peak + peak) / FFMAX(peak - 1.0f, 1e-6);
+        s->curve_a   = a;
+        s->curve_b   = b;
+        s->curve_mul = (b * b + 2.0f * b * j + j * j) / (b - a);
         break;
     }
+}
+
+static av_always_inline float tonemap_curve(const TonemapContext *s, float sig,
+                                           enum TonemapAlgorithm algo)
+{
+    switch (algo) {
+    default:
+    case TONEMAP_NONE:
+        // do nothing
+        return sig;
+    case TONEMAP_LINEAR:
+        return sig * s->curve_mul;
+    case TONEMAP_GAMMA:
+        return sig > 0.05f ? powf(sig * s->curve_mul, s->curve_exp)
+                           : sig * s->curve_low;
+    case TONEMAP_CLIP:
+        return av_clipf(sig * s->curve_mul, 0, 1.0f);
+    case TONEMAP_HABLE:
+        return hable(sig) / s->curve_mul;
+    case TONEMAP_REINHARD:
+        return sig / (sig + (float)s->param) * s->curve_mul;
+    case TONEMAP_MOBIUS:
+        return sig <= (float)s->param ? sig :
+               s->curve_mul * (sig + s->curve_a) / (sig + s->curve_b);
+    }
+}
+
+static void update_lut(TonemapContext *s, double peak)
+{
+    int i;
+
+    if (s->lut_peak == peak)
+        return;
+
+    for (i = 0; i <= LUT_SIZE; i++)
+        s->lut[i] = tonemap_curve(s, av_int2float((LUT_BASE + i) << LUT_SHIFT),
+                                  s->tonemap);
+    s->lut_peak = peak;
+}
+
+#define MIX(x,y,a) (x) * (1 - (a)) + (y) * (a)
+static av_always_inline void tonemap_line(const TonemapContext *s,
+                                          float *r_out, float *b_out, float *g_out,
+                                          const float *r_in, const float *b_in,
+                                          const float *g_in, int w,
+                                          enum TonemapAlgorithm algo, int desat)
+{
+    const float cr = desat ? s->coeffs->cr : 0;
+    const float cg = desat ? s->coeffs->cg : 0;
+    const float cb = desat ? s->coeffs->cb : 0;
+    const float desat_f = s->desat;
+    const float *lut    = s->use_lut ? s->lut : NULL;
+    int x;
+
+    for (x = 0; x < w; x++) {
+        float r = r_in[x], g = g_in[x], bl = b_in[x];
+        float sig, sig_orig;
+
+        /* desaturate to prevent unnatural colors */
+        if (desat) {
+            float luma = cr * r + cg * g + cb * bl;
+            float overbright = FFMAX(luma - desat_f, 1e-6f) / FFMAX(luma, 1e-6f);
+            r  = MIX(r,  luma, overbright);
+            g  = MIX(g,  luma, overbright);
+            bl = MIX(bl, luma, overbright);
+        }
+
+        /* pick the brightest component, reducing the value range as necessary
+         * to keep the entire signal in range and preventing discoloration due to
+         * out-of-bounds clipping */
+        sig = FFMAX(FFMAX3(r, g, bl), 1e-6f);
+        sig_orig = sig;
+
+        if (lut && sig < (float)(1 << LUT_MAX_EXP)) {
+            /* interpolate linearly within the segment of the signal */
+            const unsigned bits = av_float2int(sig);
+            const int i = (bits >> LUT_SHIFT) - LUT_BASE;
+            const float f = (bits & ((1 << LUT_SHIFT) - 1)) * (1.0f / (1 << LUT_SHIFT));
+            sig = lut[i] + f * (lut[i + 1] - lut[i]);
+        } else {
+            sig = tonemap_curve(s, sig, algo);
+        }
+
+        /* apply the computed scale factor to the color,
+         * linearly to prevent discoloration */
+        r_out[x] = r  * (sig / sig_orig);
+        g_out[x] = g  * (sig / sig_orig);
+        b_out[x] = bl * (sig / sig_orig);
+    }
+}
+
+#define DEFINE_TONEMAP_LINE(name, algo)                                              \
+static void tonemap_line_##name(const TonemapContext *s,                             \
+                                float *r_out, float *b_out, float *g_out,            \
+                                const float *r_in, const float *b_in,                \
+                                const float *g_in, int w)                            \
+{                                                                                    \
+    if (s->desat > 0)                                                                \
+        tonemap_line(s, r_out, b_out, g_out, r_in, b_in, g_in, w, algo, 1);          \
+    else                                                                             \
+        tonemap_line(s, r_out, b_out, g_out, r_in, b_in, g_in, w, algo, 0);          \
+}
 
-    /* apply the computed scale factor to the color,
-     * linearly to prevent discoloration */
-    *r_out *= sig / sig_orig;
-    *g_out *= sig / sig_orig;
-    *b_out *= sig / sig_orig;
+DEFINE_TONEMAP_LINE(none,     TONEMAP_NONE)
+DEFINE_TONEMAP_LINE(linear,   TONEMAP_LINEAR)
+DEFINE_TONEMAP_LINE(gamma,    TONEMAP_GAMMA)
+DEFINE_TONEMAP_LINE(clip,     TONEMAP_CLIP)
+DEFINE_TONEMAP_LINE(reinhard, TONEMAP_REINHARD)
+DEFINE_TONEMAP_LINE(hable,    TONEMAP_HABLE)
+DEFINE_TONEMAP_LINE(mobius,   TONEMAP_MOBIUS)
+
+typedef void (*tonemap_line_func)(const TonemapContext *s,
+                                  float *r_out, float *b_out, float *g_out,
+                                  const float *r_in, const float *b_in,
+                                  const float *g_in, int w);
+
+static const tonemap_line_func tonemap_line_funcs[TONEMAP_MAX] = {
+    [TONEMAP_NONE]     = tonemap_line_none,
+    [TONEMAP_LINEAR]   = tonemap_line_linear,
+    [TONEMAP_GAMMA]    = tonemap_line_gamma,
+    [TONEMAP_CLIP]     = tonemap_line_clip,
+    [TONEMAP_REINHARD] = tonemap_line_reinhard,
+    [TONEMAP_HABLE]    = tonemap_line_hable,
+    [TONEMAP_MOBIUS]   = tonemap_line_mobius,
+};
+
+static int tonemap_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    TonemapContext *s = ctx->priv;
+    ThreadData *td = arg;
+    const AVFrame *in = td->in;
+    AVFrame *out = td->out;
+    const int slice_start = (out->height *  jobnr   ) / nb_jobs;
+    const int slice_end   = (out->height * (jobnr+1)) / nb_jobs;
+    const tonemap_line_func line = tonemap_line_funcs[s->tonemap];
+    int y;
+
+    for (y = slice_start; y < slice_end; y++)
+        line(s,
+             (float *)(out->data[0] + y * out->linesize[0]),
+             (float *)(out->data[1] + y * out->linesize[1]),
+             (float *)(out->data[2] + y * out->linesize[2]),
+             (const float *)(in->data[0] + y * in->linesize[0]),
+             (const float *)(in->data[1] + y * in->linesize[1]),
+             (const float *)(in->data[2] + y * in->linesize[2]),
+             out->width);
+
+    return 0;
 }
 
 static int filter_frame(AVFilterLink *link, AVFrame *in)
 {
-    TonemapContext *s = link->dst->priv;
-    AVFilterLink *outlink = link->dst->outputs[0];
+    AVFilterContext *ctx = link->dst;
+    TonemapContext *s = ctx->priv;
+    AVFilterLink *outlink = ctx->outputs[0];
+    ThreadData td;
     AVFrame *out;
     const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(link->format);
     const AVPixFmtDescriptor *odesc = av_pix_fmt_desc_get(outlink->format);
@@ -277,9 +408,13 @@ static int filter_frame(AVFilterLink *link, AVFrame *in)
     }
 
     /* do the tone map */
-    for (y = 0; y < out->height; y++)
-        for (x = 0; x < out->width; x++)
-            tonemap(s, out, in, desc, x, y, peak);
+    update_curve(s, peak);
+    if (s->use_lut)
+        update_lut(s, peak);
+    td.in  = in;
+    td.out = out;
+    ctx->internal->execute(ctx, tonemap_slice, &td, NULL,
+                           FFMIN(out->height, ff_filter_get_nb_threads(ctx)));
 
     /* copy/generate alpha if needed */
     if (desc->flags & AV_PIX_FMT_FLAG_ALPHA && odesc->flags & AV_PIX_FMT_FLAG_ALPHA) {
@@ -314,6 +449,7 @@ static const AVOption tonemap_options[] = {
     { "param",        "tonemap parameter", OFFSET(param), AV_OPT_TYPE_DOUBLE, {.dbl = NAN}, DBL_MIN, DBL_MAX, FLAGS },
     { "desat",        "desaturation strength", OFFSET(desat), AV_OPT_TYPE_DOUBLE, {.dbl = 2}, 0, DBL_MAX, FLAGS },
     { "peak",         "signal peak override", OFFSET(peak), AV_OPT_TYPE_DOUBLE, {.dbl = 0}, 0, DBL_MAX, FLAGS },
+    { "lut",          "look up the curve in a table", OFFSET(use_lut), AV_OPT_TYPE_BOOL, {.i64 = 0}, 0, 1, FLAGS },
     { NULL }
 };
 
@@ -351,4 +487,5 @@ AVFilter ff_vf_tonemap = {
     .priv_class      = &tonemap_class,
     .inputs          = tonemap_inputs,
     .outputs         = tonemap_outputs,
+    .flags           = AVFILTER_FLAG_SLICE_THREADS,
 };
@@ -47,33 +47,93 @@
 #include "libavutil/pixdesc.h"
 #include "unsharp.h"
 
-static void apply_unsharp(      uint8_t *dst, int dst_stride,
-                          const uint8_t *src, int src_stride,
-                          int width, int height, UnsharpFilterParam *fp)
+typedef struct ThreadData {
+    UnsharpFilterParam *fp;
+    uint8_t       *dst;
+    const uint8_t *src;
+    int dst_stride;
+    int src_stride;
+    int width;
+    int height;
+} ThreadData;
+
+static void vertical_c(uint32_t *line, uint32_t *sc, int sc_stride,
+                       int steps, int w)
 {
-    uint32_t **sc = fp->sc;
-    uint32_t sr[MAX_MATRIX_SIZE - 1], tmp1, tmp2;
+    uint32_t tmp1, tmp2;
+    int x, z;
+
+    for (z = 0; z < steps * 2; z += 2) {
+        uint32_t *sc0 = sc + z * sc_stride, *sc1 = sc0 + sc_stride;
+
+        for (x = 0; x < w; x++) {
+            tmp1 = line[x];
+            tmp2 = sc0[x] + tmp1; sc0[x] = tmp1;
+            tmp1 = sc1[x] + tmp2; sc1[x] = tmp2;
+            line[x] = tmp1;
+        }
+    }
+}
 
+static void output_c(uint8_t *dst, const uint8_t *src, const uint32_t *blur,
+                     int w, int amount, int scalebits, int halfscale)
+{
     int32_t res;
+    int x;
+
+    for (x = 0; x < w; x++) {
+        res = (int32_t)src[x] + ((((int32_t)src[x] - (int32_t)((blur[x] + halfscale) >> scalebits)) * amount) >> 16);
+        dst[x] = av_clip_uint8(res);
+    }
+}
+
+av_cold void ff_unsharp_init_dsp(UnsharpDSPContext *dsp)
+{
+    dsp->vertical = vertical_c;
+    dsp->output   = output_c;
+
+    if (ARCH_X86)
+        ff_unsharp_init_dsp_x86(dsp);
+}
+
+static int unsharp_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    ThreadData *td = arg;
+    UnsharpFilterParam *fp = td->fp;
+    const UnsharpContext *s = ctx->priv;
+    uint32_t sr[MAX_MATRIX_SIZE - 1], tmp1, tmp2;
+
     int x, y, z;
-    const uint8_t *src2 = NULL;  //silence a warning
+    const uint8_t *src2;
     const int amount = fp->amount;
     const int steps_x = fp->steps_x;
     const int steps_y = fp->steps_y;
     const int scalebits = fp->scalebits;
     const int32_t halfscale = fp->halfscale;
+    const int width  = td->width;
+    const int height = td->height;
+    const int width8 = width & ~7;
+    const int sc_width = width + 2 * steps_x;
+    const int slice_start = (height *  jobnr     ) / nb_jobs;
+    const int slice_end   = (height * (jobnr + 1)) / nb_jobs;
+    /* 2 * steps_y state lines followed by the line being filtered */
+    uint32_t *sc   = fp->sc + jobnr * (2 * steps_y + 1) * sc_width;
+    uint32_t *line = sc + 2 * steps_y * sc_width;
 
     if (!amount) {
-        av_image_copy_plane(dst, dst_stride, src, src_stride, width, height);
-        return;
+        av_image_copy_plane(td->dst + slice_start * td->dst_stride, td->dst_stride,
+                            td->src + slice_start * td->src_stride, td->src_stride,
+                            width, slice_end - slice_start);
+        return 0;
     }
 
-    for (y = 0; y < 2 * steps_y; y++)
-        memset(sc[y], 0, sizeof(sc[y][0]) * (width + 2 * steps_x));
+    memset(sc, 0, sizeof(*sc) * 2 * steps_y * sc_width);
 
-    for (y = -steps_y; y < height + steps_y; y++) {
-        if (y < height)
-            src2 = src;
+    /* y is the output row; the state machine lags 2 * steps_y rows behind
+     * the input, so starting that many rows above the slice makes every
+     * output row independent of where the slice begins. */
+    for (y = slice_start - 2 * steps_y; y < slice_end; y++) {
+        src2 = td->src + av_clip(y + steps_y, 0, height - 1) * td->src_stride;
 
         memset(sr, 0, sizeof(sr[0]) * (2 * steps_x - 1));
         for (x = -steps_x; x < width + steps_x; x++) {
@@ -82,23 +142,25 @@ static void apply_unsharp(      uint8_t *dst, int dst_stride,
                 tmp2 = sr[z + 0] + tmp1; sr[z + 0] = tmp1;
                 tmp1 = sr[z + 1] + tmp2; sr[z + 1] = tmp2;
             }
-            for (z = 0; z < steps_y * 2; z += 2) {
-                tmp2 = sc[z + 0][x + steps_x] + tmp1; sc[z + 0][x + steps_x] = tmp1;
-                tmp1 = sc[z + 1][x + steps_x] + tmp2; sc[z + 1][x + steps_x] = tmp2;
-            }
-            if (x >= steps_x && y >= steps_y) {
-                const uint8_t *srx = src - steps_y * src_stride + x - steps_x;
-                uint8_t *dsx       = dst - steps_y * dst_stride + x - steps_x;
-
-                res = (int32_t)*srx + ((((int32_t) * srx - (int32_t)((tmp1 + halfscale) >> scalebits)) * amount) >> 16);
-                *dsx = av_clip_uint8(res);
-            }
+            line[x + steps_x] = tmp1;
         }
-        if (y >= 0) {
-            dst += dst_stride;
-            src += src_stride;
+
+        /* columns are independent, only the ones that are output matter */
+        s->dsp.vertical(line + 2 * steps_x, sc + 2 * steps_x, sc_width, steps_y, width8);
+        vertical_c(line + 2 * steps_x + width8, sc + 2 * steps_x + width8,
+                   sc_width, steps_y, width - width8);
+
+        if (y >= slice_start) {
+            const uint8_t *srx = td->src + y * td->src_stride;
+            uint8_t *dsx       = td->dst + y * td->dst_stride;
+            const uint32_t *blur = line + 2 * steps_x;
+
+            s->dsp.output(dsx, srx, blur, width8, amount, scalebits, halfscale);
+            output_c(dsx + width8, srx + width8, blur + width8,
+                     width - width8, amount, scalebits, halfscale);
         }
     }
+    return 0;
 }
 
 static int apply_unsharp_c(AVFilterContext *ctx, AVFrame *in, AVFrame *out)
@@ -107,6 +169,8 @@ static int apply_unsharp_c(AVFilterContext *ctx, AVFrame *in, AVFrame *out)
     UnsharpContext *s = ctx->priv;
     int i, plane_w[3], plane_h[3];
     UnsharpFilterParam *fp[3];
+    ThreadData td;
+
     plane_w[0] = inlink->w;
     plane_w[1] = plane_w[2] = AV_CEIL_RSHIFT(inlink->w, s->hsub);
     plane_h[0] = inlink->h;
@@ -114,7 +178,15 @@ static int apply_unsharp_c(AVFilterContext *ctx, AVFrame *in, AVFrame *out)
     fp[0] = &s->luma;
     fp[1] = fp[2] = &s->chroma;
     for (i = 0; i < 3; i++) {
-        apply_unsharp(out->data[i], out->linesize[i], in->data[i], in->linesize[i], plane_w[i], plane_h[i], fp[i]);
+        td.fp = fp[i];
+        td.dst = out->data[i];
+        td.src = in->data[i];
+        td.width = plane_w[i];
+        td.height = plane_h[i];
+        td.dst_stride = out->linesize[i];
+        td.src_stride = in->linesize[i];
+        ctx->internal->execute(ctx, unsharp_slice, &td, NULL,
+                               FFMIN(plane_h[i], s->nb_threads));
     }
     return 0;
 }
@@ -143,6 +215,7 @@ static av_cold int init(AVFilterContext *ctx)
         return AVERROR(EINVAL);
     }
     s->apply_unsharp = apply_unsharp_c;
+    ff_unsharp_init_dsp(&s->dsp);
     return 0;
 }
 
@@ -162,7 +235,7 @@ static int query_formats(AVFilterContext *ctx)
 
 static int init_filter_param(AVFilterContext *ctx, UnsharpFilterParam *fp, const char *effect_type, int width)
 {
-    int z;
+    UnsharpContext *s = ctx->priv;
     const char *effect = fp->amount == 0 ? "none" : fp->amount < 0 ? "blur" : "sharpen";
 
     if  (!(fp->msize_x & fp->msize_y & 1)) {
@@ -175,10 +248,10 @@ static int init_filter_param(AVFilterContext *ctx, UnsharpFilterParam *fp, const
     av_log(ctx, AV_LOG_VERBOSE, "effect:%s type:%s msize_x:%d msize_y:%d amount:%0.2f\n",
            effect, effect_type, fp->msize_x, fp->msize_y, fp->amount / 65535.0);
 
-    for (z = 0; z < 2 * fp->steps_y; z++)
-        if (!(fp->sc[z] = av_malloc_array(width + 2 * fp->steps_x,
-                                          sizeof(*(fp->sc[z])))))
-            return AVERROR(ENOMEM);
+    fp->sc = av_malloc_array((2 * fp->steps_y + 1) * s->nb_threads,
+                             (width + 2 * fp->steps_x) * sizeof(*fp->sc));
+    if (!fp->sc)
+        return AVERROR(ENOMEM);
 
     return 0;
 }
@@ -191,6 +264,7 @@ static int config_props(AVFilterLink *link)
 
     s->hsub = desc->log2_chroma_w;
     s->vsub = desc->log2_chroma_h;
+    s->nb_threads = ff_filter_get_nb_threads(link->dst);
 
     ret = init_filter_param(link->dst, &s->luma,   "luma",   link->w);
     if (ret < 0)
@@ -204,10 +278,7 @@ static int config_props(AVFilterLink *link)
 
 static void free_filter_param(UnsharpFilterParam *fp)
 {
-    int z;
-
-    for (z = 0; z < 2 * fp->steps_y; z++)
-        av_freep(&fp->sc[z]);
+    av_freep(&fp->sc);
 }
 
 static av_cold void uninit(AVFilterContext *ctx)
@@ -294,5 +365,5 @@ AVFilter ff_vf_unsharp = {
     .query_formats = query_formats,
     .inputs        = avfilter_vf_unsharp_inputs,
     .outputs       = avfilter_vf_unsharp_outputs,
-    .flags         = AVFILTER_FLAG_SUPPORT_TIMELINE_GENERIC,
+    .flags         = AVFILTER_FLAG_SUPPORT_TIMELINE_GENERIC | AVFILTER_FLAG_SLICE_THREADS,
 };
@@ -27,6 +27,7 @@
 #include "avfilter.h"
 #include "formats.h"
 #include "internal.h"
+#include "vectorscope.h"
 #include "video.h"
 
 enum VectorscopeMode {
@@ -66,8 +67,11 @@ typedef struct VectorscopeContext {
     int cs;
     uint8_t *peak_memory;
     uint8_t **peak;
+    uint32_t *maps;     ///< per-thread hit counts of the 8-bit scope
+    int nb_threads;
+    VectorscopeDSPContext dsp;
 
-    void (*vectorscope)(struct VectorscopeContext *s,
+    void (*vectorscope)(AVFilterContext *ctx,
                         AVFrame *in, AVFrame *out, int pd);
     void (*graticulef)(struct VectorscopeContext *s, AVFrame *out,
                        int X, int Y, int D, int P);
@@ -270,6 +274,15 @@ static int config_output(AVFilterLink *outlink)
     for (i = 0; i < s->size; i++)
         s->peak[i] = s->peak_memory + s->size * i;
 
+    av_freep(&s->maps);
+    if (s->size == 256) {
+        s->nb_threads = ff_filter_get_nb_threads(outlink->src);
+        s->maps = av_malloc_array(s->nb_threads, VECTORSCOPE_MAP_SIZE * sizeof(*s->maps));
+        if (!s->maps)
+            return AVERROR(ENOMEM);
+        ff_vectorscope_init_dsp(&s->dsp);
+    }
+
     return 0;
 }
 
@@ -397,8 +410,9 @@ static void envelope(VectorscopeContext *s, AVFrame *out)
     }
 }
 
-static void vectorscope16(VectorscopeContext *s, AVFrame *in, AVFrame *out, int pd)
+static void vectorscope16(AVFilterContext *ctx, AVFrame *in, AVFrame *out, int pd)
 {
+    VectorscopeContext *s = ctx->priv;
     const uint16_t * const *src = (const uint16_t * const *)in->data;
     const int slinesizex = in->linesize[s->x] / 2;
     const int slinesizey = in->linesize[s->y] / 2;
@@ -595,164 +609,220 @@ static void vectorscope16(VectorscopeContext *s, AVFrame *in, AVFrame *out, int
     }
 }
 
-static void vectorscope8(VectorscopeContext *s, AVFrame *in, AVFrame *out, int pd)
+typedef struct ThreadData {
+    AVFrame *in, *out;
+    int nb_maps;
+} ThreadData;
+
+/* Every job scans a band of the input and records its hits in its own map:
+ * the number of times a point is hit, or for color4 the largest z + 1.
+ * All modes give the same result whatever the order of the hits, so the
+ * maps can be merged afterwards. */
+static int accumulate8(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
 {
+    VectorscopeContext *s = ctx->priv;
+    ThreadData *td = arg;
+    AVFrame *in = td->in;
     const uint8_t * const *src = (const uint8_t * const *)in->data;
     const int slinesizex = in->linesize[s->x];
     const int slinesizey = in->linesize[s->y];
-    const int slinesized = in->linesize[pd];
-    const int dlinesize = out->linesize[0];
-    const int intensity = s->intensity;
-    const int px = s->x, py = s->y;
-    const int h = s->planeheight[py];
+    const int slinesized = in->linesize[s->pd];
+    const int px = s->x, py = s->y, pd = s->pd;
+    const int h = s->mode == COLOR4 ? in->height : s->planeheight[py];
     const int w = s->planewidth[px];
+    const int slice_start = (h *  jobnr     ) / nb_jobs;
+    const int slice_end   = (h * (jobnr + 1)) / nb_jobs;
     const uint8_t *spx = src[px];
     const uint8_t *spy = src[py];
     const uint8_t *spd = src[pd];
     const int hsub = s->hsub;
     const int vsub = s->vsub;
-    uint8_t **dst = out->data;
-    uint8_t *dpx = dst[px];
-    uint8_t *dpy = dst[py];
-    uint8_t *dpd = dst[pd];
     const int tmin = s->tmin;
     const int tmax = s->tmax;
-    int i, j, k;
+    uint32_t *map = s->maps + jobnr * VECTORSCOPE_MAP_SIZE;
+    int i, j;
 
-    for (k = 0; k < 4 && dst[k]; k++)
-        for (i = 0; i < out->height ; i++)
-            memset(dst[k] + i * out->linesize[k],
-                   (s->mode == COLOR || s->mode == COLOR5) && k == s->pd ? 0 : s->bg_color[k], out->width);
+    memset(map, 0, VECTORSCOPE_MAP_SIZE * sizeof(*map));
 
-    switch (s->mode) {
-    case COLOR5:
-    case COLOR:
-    case GRAY:
-        if (s->is_yuv) {
-            for (i = 0; i < h; i++) {
-                const int iwx = i * slinesizex;
-                const int iwy = i * slinesizey;
-                const int iwd = i * slinesized;
-                for (j = 0; j < w; j++) {
-                    const int x = spx[iwx + j];
-                    const int y = spy[iwy + j];
-                    const int z = spd[iwd + j];
-                    const int pos = y * dlinesize + x;
+    if (s->mode == COLOR4) {
+        for (i = slice_start; i < slice_end; i++) {
+            const int iwx = (i >> vsub) * slinesizex;
+            const int iwy = (i >> vsub) * slinesizey;
+            const int iwd = i * slinesized;
+            for (j = 0; j < in->width; j++) {
+                const int x = spx[iwx + (j >> hsub)];
+                const int y = spy[iwy + (j >> hsub)];
+                const int z = spd[iwd + j];
+                const int pos = (y << 8) + x;
 
-                    if (z < tmin || z > tmax)
-                        continue;
+                if (z < tmin || z > tmax)
+                    continue;
 
-                    dpd[pos] = FFMIN(dpd[pos] + intensity, 255);
-                }
+                map[pos] = FFMAX(z + 1, map[pos]);
             }
-        } else {
-            for (i = 0; i < h; i++) {
-                const int iwx = i * slinesizex;
-                const int iwy = i * slinesizey;
-                const int iwd = i * slinesized;
-                for (j = 0; j < w; j++) {
-                    const int x = spx[iwx + j];
-                    const int y = spy[iwy + j];
-                    const int z = spd[iwd + j];
-                    const int pos = y * dlinesize + x;
+        }
+    } else {
+        for (i = slice_start; i < slice_end; i++) {
+            const int iwx = i * slinesizex;
+            const int iwy = i * slinesizey;
+            const int iwd = i * slinesized;
+            for (j = 0; j < w; j++) {
+                const int x = spx[iwx + j];
+                const int y = spy[iwy + j];
+                const int z = spd[iwd + j];
 
-                    if (z < tmin || z > tmax)
-                        continue;
+                if (z < tmin || z > tmax)
+                    continue;
 
-                    dst[0][pos] = FFMIN(dst[0][pos] + intensity, 255);
-                    dst[1][pos] = FFMIN(dst[1][pos] + intensity, 255);
-                    dst[2][pos] = FFMIN(dst[2][pos] + intensity, 255);
-                }
+                map[(y << 8) + x]++;
             }
         }
-        break;
-    case COLOR2:
-        if (s->is_yuv) {
-            for (i = 0; i < h; i++) {
-                const int iw1 = i * slinesizex;
-                const int iw2 = i * slinesizey;
-                const int iwd = i * slinesized;
-                for (j = 0; j < w; j++) {
-                    const int x = spx[iw1 + j];
-                    const int y = spy[iw2 + j];
-                    const int z = spd[iwd + j];
-                    const int pos = y * dlinesize + x;
+    }
 
-                    if (z < tmin || z > tmax)
-                        continue;
+    return 0;
+}
 
-                    if (!dpd[pos])
-                        dpd[pos] = FFABS(128 - x) + FFABS(128 - y);
-                    dpx[pos] = x;
-                    dpy[pos] = y;
-                }
-            }
-        } else {
-            for (i = 0; i < h; i++) {
-                const int iw1 = i * slinesizex;
-                const int iw2 = i * slinesizey;
-                const int iwd = i * slinesized;
-                for (j = 0; j < w; j++) {
-                    const int x = spx[iw1 + j];
-                    const int y = spy[iw2 + j];
-                    const int z = spd[iwd + j];
-                    const int pos = y * dlinesize + x;
+static void sum_maps_c(uint32_t *dst, const uint32_t *maps, int nb_maps)
+{
+    int j, k;
 
-                    if (z < tmin || z > tmax)
-                        continue;
+    memcpy(dst, maps, 256 * sizeof(*dst));
+    for (k = 1; k < nb_maps; k++)
+        for (j = 0; j < 256; j++)
+            dst[j] += maps[k * VECTORSCOPE_MAP_SIZE + j];
+}
 
-                    if (!dpd[pos])
-                        dpd[pos] = FFMIN(x + y, 255);
-                    dpx[pos] = x;
-                    dpy[pos] = y;
-                }
-            }
-        }
-        break;
-    case COLOR3:
-        for (i = 0; i < h; i++) {
-            const int iw1 = i * slinesizex;
-            const int iw2 = i * slinesizey;
-            const int iwd = i * slinesized;
-            for (j = 0; j < w; j++) {
-                const int x = spx[iw1 + j];
-                const int y = spy[iw2 + j];
-                const int z = spd[iwd + j];
-                const int pos = y * dlinesize + x;
+static void max_maps_c(uint32_t *dst, const uint32_t *maps, int nb_maps)
+{
+    int j, k;
 
-                if (z < tmin || z > tmax)
-                    continue;
+    memcpy(dst, maps, 256 * sizeof(*dst));
+    for (k = 1; k < nb_maps; k++)
+        for (j = 0; j < 256; j++)
+            dst[j] = FFMAX(dst[j], maps[k * VECTORSCOPE_MAP_SIZE + j]);
+}
 
-                dpd[pos] = FFMIN(255, dpd[pos] + intensity);
-                dpx[pos] = x;
-                dpy[pos] = y;
+/* no hits leave a pixel alone, so whole rows can be done at once */
+static void add_hits_c(uint8_t *dst, const uint32_t *hits, int intensity)
+{
+    int j;
+
+    for (j = 0; j < 256; j++)
+        dst[j] = FFMIN(dst[j] + (int)FFMIN(hits[j], 256) * intensity, 255);
+}
+
+av_cold void ff_vectorscope_init_dsp(VectorscopeDSPContext *dsp)
+{
+    dsp->sum_maps = sum_maps_c;
+    dsp->max_maps = max_maps_c;
+    dsp->add_hits = add_hits_c;
+
+    if (ARCH_X86)
+        ff_vectorscope_init_dsp_x86(dsp);
+}
+
+/* every job merges the maps for a band of the output and draws it */
+static int draw8(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    VectorscopeContext *s = ctx->priv;
+    ThreadData *td = arg;
+    AVFrame *out = td->out;
+    const int dlinesize = out->linesize[0];
+    const int intensity = s->intensity;
+    const int slice_start = (256 *  jobnr     ) / nb_jobs;
+    const int slice_end   = (256 * (jobnr + 1)) / nb_jobs;
+    uint8_t **dst = out->data;
+    uint8_t *dpx = dst[s->x];
+    uint8_t *dpy = dst[s->y];
+    uint8_t *dpd = dst[s->pd];
+    LOCAL_ALIGNED_32(uint32_t, hits, [256]);
+    int i, j;
+
+    for (i = slice_start; i < slice_end; i++) {
+        const uint32_t *maps = s->maps + (i << 8);
+        const int row = i * dlinesize;
+
+        if (s->mode == COLOR4)
+            s->dsp.max_maps(hits, maps, td->nb_maps);
+        else
+            s->dsp.sum_maps(hits, maps, td->nb_maps);
+
+        switch (s->mode) {
+        case COLOR5:
+        case COLOR:
+        case GRAY:
+            if (s->is_yuv) {
+                s->dsp.add_hits(dpd + row, hits, intensity);
+            } else {
+                s->dsp.add_hits(dst[0] + row, hits, intensity);
+                s->dsp.add_hits(dst[1] + row, hits, intensity);
+                s->dsp.add_hits(dst[2] + row, hits, intensity);
             }
-        }
-        break;
-    case COLOR4:
-        for (i = 0; i < in->height; i++) {
-            const int iwx = (i >> vsub) * slinesizex;
-            const int iwy = (i >> vsub) * slinesizey;
-            const int iwd = i * slinesized;
-            for (j = 0; j < in->width; j++) {
-                const int x = spx[iwx + (j >> hsub)];
-                const int y = spy[iwy + (j >> hsub)];
-                const int z = spd[iwd + j];
-                const int pos = y * dlinesize + x;
+            break;
+        case COLOR2:
+            for (j = 0; j < 256; j++) {
+                const int pos = row + j;
 
-                if (z < tmin || z > tmax)
+                if (!hits[j])
                     continue;
+                if (!dpd[pos])
+                    dpd[pos] = s->is_yuv ? FFABS(128 - j) + FFABS(128 - i) : FFMIN(j + i, 255);
+                dpx[pos] = j;
+                dpy[pos] = i;
+            }
+            break;
+        case COLOR3:
+            s->dsp.add_hits(dpd + row, hits, intensity);
+            for (j = 0; j < 256; j++) {
+                if (!hits[j])
+                    continue;
+                dpx[row + j] = j;
+                dpy[row + j] = i;
+            }
+            break;
+        case COLOR4:
+            for (j = 0; j < 256; j++) {
+                const int pos = row + j;
 
-                dpd[pos] = FFMAX(z, dpd[pos]);
-                dpx[pos] = x;
-                dpy[pos] = y;
+                if (!hits[j])
+                    continue;
+                dpd[pos] = FFMAX(hits[j] - 1, dpd[pos]);
+                dpx[pos] = j;
+                dpy[pos] = i;
             }
+            break;
+        default:
+            av_assert0(0);
         }
-        break;
-    default:
-        av_assert0(0);
     }
 
+    return 0;
+}
+
+static void vectorscope8(AVFilterContext *ctx, AVFrame *in, AVFrame *out, int pd)
+{
+    VectorscopeContext *s = ctx->priv;
+    const int dlinesize = out->linesize[0];
+    const int px = s->x, py = s->y;
+    const int h = s->mode == COLOR4 ? in->height : s->planeheight[py];
+    uint8_t **dst = out->data;
+    uint8_t *dpx = dst[px];
+    uint8_t *dpy = dst[py];
+    uint8_t *dpd = dst[pd];
+    ThreadData td;
+    int i, j, k;
+
+    for (k = 0; k < 4 && dst[k]; k++)
+        for (i = 0; i < out->height ; i++)
+            memset(dst[k] + i * out->linesize[k],
+                   (s->mode == COLOR || s->mode == COLOR5) && k == s->pd ? 0 : s->bg_color[k], out->width);
+
+    td.in      = in;
+    td.out     = out;
+    td.nb_maps = FFMIN(h, s->nb_threads);
+    ctx->internal->execute(ctx, accumulate8, &td, NULL, td.nb_maps);
+    ctx->internal->execute(ctx, draw8, &td, NULL, s->nb_threads);
+
     envelope(s, out);
 
     if (dst[3]) {
@@ -1230,7 +1300,7 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *in)
     }
     av_frame_copy_props(out, in);
 
-    s->vectorscope(s, in, out, s->pd);
+    s->vectorscope(ctx, in, out, s->pd);
     s->graticulef(s, out, s->x, s->y, s->pd, s->cs);
 
     for (plane = 0; plane < 4; plane++) {
@@ -1326,6 +1396,7 @@ static av_cold void uninit(AVFilterContext *ctx)
 
     av_freep(&s->peak);
     av_freep(&s->peak_memory);
+    av_freep(&s->maps);
 }
 
 static const AVFilterPad inputs[] = {
@@ -1356,4 +1427,5 @@ AVFilter ff_vf_vectorscope = {
     .uninit        = uninit,
     .inputs        = inputs,
     .outputs       = outputs,
+    .flags         = AVFILTER_FLAG_SLICE_THREADS,
 };
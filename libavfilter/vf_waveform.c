@@ -92,11 +92,13 @@ typedef struct WaveformContext {
     int            shift_w[4], shift_h[4];
     GraticuleLines *glines;
     int            nb_glines;
+    int            nb_envelopes;
     void (*waveform)(struct WaveformContext *s,
                      AVFrame *in, AVFrame *out,
                      int component, int intensity,
                      int offset_y, int offset_x,
-                     int column, int mirror);
+                     int column, int mirror,
+                     int jobnr, int nb_jobs);
     void (*graticulef)(struct WaveformContext *s, AVFrame *out);
     const AVPixFmtDescriptor *desc;
     const AVPixFmtDescriptor *odesc;
@@ -603,6 +605,15 @@ static void envelope(WaveformContext *s, AVFrame *out, int plane, int component,
     }
 }
 
+/* number of times a source line pointer stepped with the
+ * "!shift_h || (y & shift_h)" rule below has moved before row y */
+static av_always_inline int src_line(int y, int shift_h)
+{
+    if (!shift_h)
+        return y;
+    return y / (2 * shift_h) * shift_h + FFMAX(y % (2 * shift_h) - shift_h, 0);
+}
+
 static void update16(uint16_t *target, int max, int intensity, int limit)
 {
     if (*target <= max)
@@ -623,7 +634,8 @@ static av_always_inline void lowpass16(WaveformContext *s,
                                        AVFrame *in, AVFrame *out,
                                        int component, int intensity,
                                        int offset_y, int offset_x,
-                                       int column, int mirror)
+                                       int column, int mirror,
+                                       int jobnr, int nb_jobs)
 {
     const int plane = s->desc->comp[component].plane;
     const int shift_w = s->shift_w[component];
@@ -635,6 +647,8 @@ static av_always_inline void lowpass16(WaveformContext *s,
     const int max = limit - intensity;
     const int src_h = AV_CEIL_RSHIFT(in->height, shift_h);
     const int src_w = AV_CEIL_RSHIFT(in->width, shift_w);
+    const int slice_start = ((column ? src_w : src_h) *  jobnr     ) / nb_jobs;
+    const int slice_end   = ((column ? src_w : src_h) * (jobnr + 1)) / nb_jobs;
     const uint16_t *src_data = (const uint16_t *)in->data[plane];
     uint16_t *dst_data = (uint16_t *)out->data[plane] + offset_y * dst_linesize + offset_x;
     uint16_t * const dst_bottom_line = dst_data + dst_linesize * (s->size - 1);
@@ -646,11 +660,16 @@ static av_always_inline void lowpass16(WaveformContext *s,
     if (!column && mirror)
         dst_data += s->size;
 
-    for (y = 0; y < src_h; y++) {
-        const uint16_t *src_data_end = src_data + src_w;
-        uint16_t *dst = dst_line;
+    if (!column) {
+        src_data += slice_start * src_linesize;
+        dst_data += slice_start * dst_linesize * step;
+    }
 
-        for (p = src_data; p < src_data_end; p++) {
+    for (y = column ? 0 : slice_start; y < (column ? src_h : slice_end); y++) {
+        const uint16_t *src_data_end = src_data + (column ? slice_end : src_w);
+        uint16_t *dst = dst_line + (column ? slice_start * step : 0);
+
+        for (p = src_data + (column ? slice_start : 0); p < src_data_end; p++) {
             uint16_t *target;
             int i = 0, v = FFMIN(*p, limit);
 
@@ -674,8 +693,6 @@ static av_always_inline void lowpass16(WaveformContext *s,
         src_data += src_linesize;
         dst_data += dst_linesize * step;
     }
-
-    envelope16(s, out, plane, plane, column ? offset_x : offset_y);
 }
 
 #define LOWPASS16_FUNC(name, column, mirror)               \
@@ -683,10 +700,12 @@ static void lowpass16_##name(WaveformContext *s,           \
                              AVFrame *in, AVFrame *out,    \
                              int component, int intensity, \
                              int offset_y, int offset_x,   \
-                             int unused1, int unused2)     \
+                             int unused1, int unused2,     \
+                             int jobnr, int nb_jobs)       \
 {                                                          \
     lowpass16(s, in, out, component, intensity,            \
-              offset_y, offset_x, column, mirror);         \
+              offset_y, offset_x, column, mirror,          \
+              jobnr, nb_jobs);                             \
 }
 
 LOWPASS16_FUNC(column_mirror, 1, 1)
@@ -698,7 +717,8 @@ static av_always_inline void lowpass(WaveformContext *s,
                                      AVFrame *in, AVFrame *out,
                                      int component, int intensity,
                                      int offset_y, int offset_x,
-                                     int column, int mirror)
+                                     int column, int mirror,
+                                     int jobnr, int nb_jobs)
 {
     const int plane = s->desc->comp[component].plane;
     const int shift_w = s->shift_w[component];
@@ -709,6 +729,8 @@ static av_always_inline void lowpass(WaveformContext *s,
     const int max = 255 - intensity;
     const int src_h = AV_CEIL_RSHIFT(in->height, shift_h);
     const int src_w = AV_CEIL_RSHIFT(in->width, shift_w);
+    const int slice_start = ((column ? src_w : src_h) *  jobnr     ) / nb_jobs;
+    const int slice_end   = ((column ? src_w : src_h) * (jobnr + 1)) / nb_jobs;
     const uint8_t *src_data = in->data[plane];
     uint8_t *dst_data = out->data[plane] + offset_y * dst_linesize + offset_x;
     uint8_t * const dst_bottom_line = dst_data + dst_linesize * (s->size - 1);
@@ -720,11 +742,16 @@ static av_always_inline void lowpass(WaveformContext *s,
     if (!column && mirror)
         dst_data += s->size;
 
-    for (y = 0; y < src_h; y++) {
-        const uint8_t *src_data_end = src_data + src_w;
-        uint8_t *dst = dst_line;
+    if (!column) {
+        src_data += slice_start * src_linesize;
+        dst_data += slice_start * dst_linesize * step;
+    }
+
+    for (y = column ? 0 : slice_start; y < (column ? src_h : slice_end); y++) {
+        const uint8_t *src_data_end = src_data + (column ? slice_end : src_w);
+        uint8_t *dst = dst_line + (column ? slice_start * step : 0);
 
-        for (p = src_data; p < src_data_end; p++) {
+        for (p = src_data + (column ? slice_start : 0); p < src_data_end; p++) {
             uint8_t *target;
             if (column) {
                 target = dst + dst_signed_linesize * *p;
@@ -744,15 +771,18 @@ static av_always_inline void lowpass(WaveformContext *s,
         dst_data += dst_linesize * step;
     }
 
+    /* the last slice also covers whatever the output has beyond the
+     * subsampled source */
     if (column && step > 1) {
         const int dst_w = s->display == PARADE ? out->width / s->acomp : out->width;
         const int dst_h = 256;
+        const int end = jobnr == nb_jobs - 1 ? dst_w : FFMIN(slice_end * step, dst_w);
         uint8_t *dst;
         int x, z;
 
         dst = out->data[plane] + offset_y * dst_linesize + offset_x;
         for (y = 0; y < dst_h; y++) {
-            for (x = 0; x < dst_w; x+=step) {
+            for (x = slice_start * step; x < end; x+=step) {
                 for (z = 1; z < step; z++) {
                     dst[x + z] = dst[x];
                 }
@@ -762,18 +792,17 @@ static av_always_inline void lowpass(WaveformContext *s,
     } else if (step > 1) {
         const int dst_h = s->display == PARADE ? out->height / s->acomp : out->height;
         const int dst_w = 256;
+        const int end = jobnr == nb_jobs - 1 ? dst_h : FFMIN(slice_end * step, dst_h);
         uint8_t *dst;
         int z;
 
-        dst = out->data[plane] + offset_y * dst_linesize + offset_x;
-        for (y = 0; y < dst_h; y+=step) {
+        dst = out->data[plane] + (offset_y + slice_start * step) * dst_linesize + offset_x;
+        for (y = slice_start * step; y < end; y+=step) {
             for (z = 1; z < step; z++)
                 memcpy(dst + dst_linesize * z, dst, dst_w);
             dst += dst_linesize * step;
         }
     }
-
-    envelope(s, out, plane, plane, column ? offset_x : offset_y);
 }
 
 #define LOWPASS_FUNC(name, column, mirror)               \
@@ -781,10 +810,12 @@ static void lowpass_##name(WaveformContext *s,           \
                            AVFrame *in, AVFrame *out,    \
                            int component, int intensity, \
                            int offset_y, int offset_x,   \
-                           int unused1, int unused2)     \
+                           int unused1, int unused2,     \
+                           int jobnr, int nb_jobs)       \
 {                                                        \
     lowpass(s, in, out, component, intensity,            \
-            offset_y, offset_x, column, mirror);         \
+            offset_y, offset_x, column, mirror,          \
+            jobnr, nb_jobs);                             \
 }
 
 LOWPASS_FUNC(column_mirror, 1, 1)
@@ -796,7 +827,8 @@ static av_always_inline void flat16(WaveformContext *s,
                                     AVFrame *in, AVFrame *out,
                                     int component, int intensity,
                                     int offset_y, int offset_x,
-                                    int column, int mirror)
+                                    int column, int mirror,
+                                    int jobnr, int nb_jobs)
 {
     const int plane = s->desc->comp[component].plane;
     const int c0_linesize = in->linesize[ plane + 0 ] / 2;
@@ -815,13 +847,15 @@ static av_always_inline void flat16(WaveformContext *s,
     const int mid = s->max / 2;
     const int src_h = in->height;
     const int src_w = in->width;
+    const int slice_start = ((column ? src_w : src_h) *  jobnr     ) / nb_jobs;
+    const int slice_end   = ((column ? src_w : src_h) * (jobnr + 1)) / nb_jobs;
     int x, y;
 
     if (column) {
         const int d0_signed_linesize = d0_linesize * (mirror == 1 ? -1 : 1);
         const int d1_signed_linesize = d1_linesize * (mirror == 1 ? -1 : 1);
 
-        for (x = 0; x < src_w; x++) {
+        for (x = slice_start; x < slice_end; x++) {
             const uint16_t *c0_data = (uint16_t *)in->data[plane + 0];
             const uint16_t *c1_data = (uint16_t *)in->data[(plane + 1) % s->ncomp];
             const uint16_t *c2_data = (uint16_t *)in->data[(plane + 2) % s->ncomp];
@@ -866,7 +900,13 @@ static av_always_inline void flat16(WaveformContext *s,
             d1_data += s->size - 1;
         }
 
-        for (y = 0; y < src_h; y++) {
+        c0_data += src_line(slice_start, c0_shift_h) * c0_linesize;
+        c1_data += src_line(slice_start, c1_shift_h) * c1_linesize;
+        c2_data += src_line(slice_start, c2_shift_h) * c2_linesize;
+        d0_data += slice_start * d0_linesize;
+        d1_data += slice_start * d1_linesize;
+
+        for (y = slice_start; y < slice_end; y++) {
             for (x = 0; x < src_w; x++) {
                 const int c0 = FFMIN(c0_data[x >> c0_shift_w], limit) + s->max;
                 const int c1 = FFMIN(FFABS(c1_data[x >> c1_shift_w] - mid) + FFABS(c2_data[x >> c2_shift_w] - mid), limit);
@@ -899,16 +939,14 @@ static av_always_inline void flat16(WaveformContext *s,
             d1_data += d1_linesize;
         }
     }
-
-    envelope16(s, out, plane, plane, column ? offset_x : offset_y);
-    envelope16(s, out, plane, (plane + 1) % s->ncomp, column ? offset_x : offset_y);
 }
 
 static av_always_inline void flat(WaveformContext *s,
                                   AVFrame *in, AVFrame *out,
                                   int component, int intensity,
                                   int offset_y, int offset_x,
-                                  int column, int mirror)
+                                  int column, int mirror,
+                                  int jobnr, int nb_jobs)
 {
     const int plane = s->desc->comp[component].plane;
     const int c0_linesize = in->linesize[ plane + 0 ];
@@ -925,13 +963,15 @@ static av_always_inline void flat(WaveformContext *s,
     const int max = 255 - intensity;
     const int src_h = in->height;
     const int src_w = in->width;
+    const int slice_start = ((column ? src_w : src_h) *  jobnr     ) / nb_jobs;
+    const int slice_end   = ((column ? src_w : src_h) * (jobnr + 1)) / nb_jobs;
     int x, y;
 
     if (column) {
         const int d0_signed_linesize = d0_linesize * (mirror == 1 ? -1 : 1);
         const int d1_signed_linesize = d1_linesize * (mirror == 1 ? -1 : 1);
 
-        for (x = 0; x < src_w; x++) {
+        for (x = slice_start; x < slice_end; x++) {
             const uint8_t *c0_data = in->data[plane + 0];
             const uint8_t *c1_data = in->data[(plane + 1) % s->ncomp];
             const uint8_t *c2_data = in->data[(plane + 2) % s->ncomp];
@@ -976,7 +1016,13 @@ static av_always_inline void flat(WaveformContext *s,
             d1_data += s->size - 1;
         }
 
-        for (y = 0; y < src_h; y++) {
+        c0_data += src_line(slice_start, c0_shift_h) * c0_linesize;
+        c1_data += src_line(slice_start, c1_shift_h) * c1_linesize;
+        c2_data += src_line(slice_start, c2_shift_h) * c2_linesize;
+        d0_data += slice_start * d0_linesize;
+        d1_data += slice_start * d1_linesize;
+
+        for (y = slice_start; y < slice_end; y++) {
             for (x = 0; x < src_w; x++) {
                 int c0 = c0_data[x >> c0_shift_w] + 256;
                 const int c1 = FFABS(c1_data[x >> c1_shift_w] - 128) + FFABS(c2_data[x >> c2_shift_w] - 128);
@@ -1009,16 +1055,14 @@ static av_always_inline void flat(WaveformContext *s,
             d1_data += d1_linesize;
         }
     }
-
-    envelope(s, out, plane, plane, column ? offset_x : offset_y);
-    envelope(s, out, plane, (plane + 1) % s->ncomp, column ? offset_x : offset_y);
 }
 
 static av_always_inline void aflat16(WaveformContext *s,
                                      AVFrame *in, AVFrame *out,
                                      int component, int intensity,
                                      int offset_y, int offset_x,
-                                     int column, int mirror)
+                                     int column, int mirror,
+                                     int jobnr, int nb_jobs)
 {
     const int plane = s->desc->comp[component].plane;
     const int c0_linesize = in->linesize[ plane + 0 ] / 2;
@@ -1038,6 +1082,8 @@ static av_always_inline void aflat16(WaveformContext *s,
     const int mid = s->max / 2;
     const int src_h = in->height;
     const int src_w = in->width;
+    const int slice_start = ((column ? src_w : src_h) *  jobnr     ) / nb_jobs;
+    const int slice_end   = ((column ? src_w : src_h) * (jobnr + 1)) / nb_jobs;
     int x, y;
 
     if (column) {
@@ -1045,7 +1091,7 @@ static av_always_inline void aflat16(WaveformContext *s,
         const int d1_signed_linesize = d1_linesize * (mirror == 1 ? -1 : 1);
         const int d2_signed_linesize = d2_linesize * (mirror == 1 ? -1 : 1);
 
-        for (x = 0; x < src_w; x++) {
+        for (x = slice_start; x < slice_end; x++) {
             const uint16_t *c0_data = (uint16_t *)in->data[plane + 0];
             const uint16_t *c1_data = (uint16_t *)in->data[(plane + 1) % s->ncomp];
             const uint16_t *c2_data = (uint16_t *)in->data[(plane + 2) % s->ncomp];
@@ -1099,7 +1145,14 @@ static av_always_inline void aflat16(WaveformContext *s,
             d2_data += s->size - 1;
         }
 
-        for (y = 0; y < src_h; y++) {
+        c0_data += src_line(slice_start, c0_shift_h) * c0_linesize;
+        c1_data += src_line(slice_start, c1_shift_h) * c1_linesize;
+        c2_data += src_line(slice_start, c2_shift_h) * c2_linesize;
+        d0_data += slice_start * d0_linesize;
+        d1_data += slice_start * d1_linesize;
+        d2_data += slice_start * d2_linesize;
+
+        for (y = slice_start; y < slice_end; y++) {
             for (x = 0; x < src_w; x++) {
                 const int c0 = FFMIN(c0_data[x >> c0_shift_w], limit) + mid;
                 const int c1 = FFMIN(c1_data[x >> c1_shift_w], limit) - mid;
@@ -1134,17 +1187,14 @@ static av_always_inline void aflat16(WaveformContext *s,
             d2_data += d2_linesize;
         }
     }
-
-    envelope16(s, out, plane, (plane + 0) % s->ncomp, column ? offset_x : offset_y);
-    envelope16(s, out, plane, (plane + 1) % s->ncomp, column ? offset_x : offset_y);
-    envelope16(s, out, plane, (plane + 2) % s->ncomp, column ? offset_x : offset_y);
 }
 
 static av_always_inline void aflat(WaveformContext *s,
                                    AVFrame *in, AVFrame *out,
                                    int component, int intensity,
                                    int offset_y, int offset_x,
-                                   int column, int mirror)
+                                   int column, int mirror,
+                                   int jobnr, int nb_jobs)
 {
     const int plane = s->desc->comp[component].plane;
     const int c0_linesize = in->linesize[ plane + 0 ];
@@ -1162,6 +1212,8 @@ static av_always_inline void aflat(WaveformContext *s,
     const int max = 255 - intensity;
     const int src_h = in->height;
     const int src_w = in->width;
+    const int slice_start = ((column ? src_w : src_h) *  jobnr     ) / nb_jobs;
+    const int slice_end   = ((column ? src_w : src_h) * (jobnr + 1)) / nb_jobs;
     int x, y;
 
     if (column) {
@@ -1169,7 +1221,7 @@ static av_always_inline void aflat(WaveformContext *s,
         const int d1_signed_linesize = d1_linesize * (mirror == 1 ? -1 : 1);
         const int d2_signed_linesize = d2_linesize * (mirror == 1 ? -1 : 1);
 
-        for (x = 0; x < src_w; x++) {
+        for (x = slice_start; x < slice_end; x++) {
             const uint8_t *c0_data = in->data[plane + 0];
             const uint8_t *c1_data = in->data[(plane + 1) % s->ncomp];
             const uint8_t *c2_data = in->data[(plane + 2) % s->ncomp];
@@ -1223,7 +1275,14 @@ static av_always_inline void aflat(WaveformContext *s,
             d2_data += s->size - 1;
         }
 
-        for (y = 0; y < src_h; y++) {
+        c0_data += src_line(slice_start, c0_shift_h) * c0_linesize;
+        c1_data += src_line(slice_start, c1_shift_h) * c1_linesize;
+        c2_data += src_line(slice_start, c2_shift_h) * c2_linesize;
+        d0_data += slice_start * d0_linesize;
+        d1_data += slice_start * d1_linesize;
+        d2_data += slice_start * d2_linesize;
+
+        for (y = slice_start; y < slice_end; y++) {
             for (x = 0; x < src_w; x++) {
                 const int c0 = c0_data[x >> c0_shift_w] + 128;
                 const int c1 = c1_data[x >> c1_shift_w] - 128;
@@ -1258,17 +1317,14 @@ static av_always_inline void aflat(WaveformContext *s,
             d2_data += d2_linesize;
         }
     }
-
-    envelope(s, out, plane, (plane + 0) % s->ncomp, column ? offset_x : offset_y);
-    envelope(s, out, plane, (plane + 1) % s->ncomp, column ? offset_x : offset_y);
-    envelope(s, out, plane, (plane + 2) % s->ncomp, column ? offset_x : offset_y);
 }
 
 static av_always_inline void chroma16(WaveformContext *s,
                                       AVFrame *in, AVFrame *out,
                                       int component, int intensity,
                                       int offset_y, int offset_x,
-                                      int column, int mirror)
+                                      int column, int mirror,
+                                      int jobnr, int nb_jobs)
 {
     const int plane = s->desc->comp[component].plane;
     const int c0_linesize = in->linesize[(plane + 1) % s->ncomp] / 2;
@@ -1283,12 +1339,14 @@ static av_always_inline void chroma16(WaveformContext *s,
     const int c1_shift_h = s->shift_h[(component + 2) % s->ncomp];
     const int src_h = in->height;
     const int src_w = in->width;
+    const int slice_start = ((column ? src_w : src_h) *  jobnr     ) / nb_jobs;
+    const int slice_end   = ((column ? src_w : src_h) * (jobnr + 1)) / nb_jobs;
     int x, y;
 
     if (column) {
         const int dst_signed_linesize = dst_linesize * (mirror == 1 ? -1 : 1);
 
-        for (x = 0; x < src_w; x++) {
+        for (x = slice_start; x < slice_end; x++) {
             const uint16_t *c0_data = (uint16_t *)in->data[(plane + 1) % s->ncomp];
             const uint16_t *c1_data = (uint16_t *)in->data[(plane + 2) % s->ncomp];
             uint16_t *dst_data = (uint16_t *)out->data[plane] + offset_y * dst_linesize + offset_x;
@@ -1317,7 +1375,11 @@ static av_always_inline void chroma16(WaveformContext *s,
 
         if (mirror)
             dst_data += s->size - 1;
-        for (y = 0; y < src_h; y++) {
+        c0_data += src_line(slice_start, c0_shift_h) * c0_linesize;
+        c1_data += src_line(slice_start, c1_shift_h) * c1_linesize;
+        dst_data += slice_start * dst_linesize;
+
+        for (y = slice_start; y < slice_end; y++) {
             for (x = 0; x < src_w; x++) {
                 const int sum = FFMIN(FFABS(c0_data[x >> c0_shift_w] - mid) + FFABS(c1_data[x >> c1_shift_w] - mid - 1), limit);
                 uint16_t *target;
@@ -1338,15 +1400,14 @@ static av_always_inline void chroma16(WaveformContext *s,
             dst_data += dst_linesize;
         }
     }
-
-    envelope16(s, out, plane, plane, column ? offset_x : offset_y);
 }
 
 static av_always_inline void chroma(WaveformContext *s,
                                     AVFrame *in, AVFrame *out,
                                     int component, int intensity,
                                     int offset_y, int offset_x,
-                                    int column, int mirror)
+                                    int column, int mirror,
+                                    int jobnr, int nb_jobs)
 {
     const int plane = s->desc->comp[component].plane;
     const int c0_linesize = in->linesize[(plane + 1) % s->ncomp];
@@ -1359,12 +1420,14 @@ static av_always_inline void chroma(WaveformContext *s,
     const int c1_shift_h = s->shift_h[(component + 2) % s->ncomp];
     const int src_h = in->height;
     const int src_w = in->width;
+    const int slice_start = ((column ? src_w : src_h) *  jobnr     ) / nb_jobs;
+    const int slice_end   = ((column ? src_w : src_h) * (jobnr + 1)) / nb_jobs;
     int x, y;
 
     if (column) {
         const int dst_signed_linesize = dst_linesize * (mirror == 1 ? -1 : 1);
 
-        for (x = 0; x < src_w; x++) {
+        for (x = slice_start; x < slice_end; x++) {
             const uint8_t *c0_data = in->data[(plane + 1) % s->ncomp];
             const uint8_t *c1_data = in->data[(plane + 2) % s->ncomp];
             uint8_t *dst_data = out->data[plane] + offset_y * dst_linesize + offset_x;
@@ -1393,7 +1456,11 @@ static av_always_inline void chroma(WaveformContext *s,
 
         if (mirror)
             dst_data += s->size - 1;
-        for (y = 0; y < src_h; y++) {
+        c0_data += src_line(slice_start, c0_shift_h) * c0_linesize;
+        c1_data += src_line(slice_start, c1_shift_h) * c1_linesize;
+        dst_data += slice_start * dst_linesize;
+
+        for (y = slice_start; y < slice_end; y++) {
             for (x = 0; x < src_w; x++) {
                 const int sum = FFABS(c0_data[x >> c0_shift_w] - 128) + FFABS(c1_data[x >> c1_shift_w] - 127);
                 uint8_t *target;
@@ -1414,15 +1481,14 @@ static av_always_inline void chroma(WaveformContext *s,
             dst_data += dst_linesize;
         }
     }
-
-    envelope(s, out, plane, plane, column ? offset_x : offset_y);
 }
 
 static av_always_inline void color16(WaveformContext *s,
                                      AVFrame *in, AVFrame *out,
                                      int component, int intensity,
                                      int offset_y, int offset_x,
-                                     int column, int mirror)
+                                     int column, int mirror,
+                                     int jobnr, int nb_jobs)
 {
     const int plane = s->desc->comp[component].plane;
     const int limit = s->max - 1;
@@ -1443,6 +1509,8 @@ static av_always_inline void color16(WaveformContext *s,
     const int c2_shift_h = s->shift_h[(component + 2) % s->ncomp];
     const int src_h = in->height;
     const int src_w = in->width;
+    const int slice_start = ((column ? src_w : src_h) *  jobnr     ) / nb_jobs;
+    const int slice_end   = ((column ? src_w : src_h) * (jobnr + 1)) / nb_jobs;
     int x, y;
 
     if (column) {
@@ -1460,7 +1528,7 @@ static av_always_inline void color16(WaveformContext *s,
         uint16_t * const d2 = (mirror ? d2_bottom_line : d2_data);
 
         for (y = 0; y < src_h; y++) {
-            for (x = 0; x < src_w; x++) {
+            for (x = slice_start; x < slice_end; x++) {
                 const int c0 = FFMIN(c0_data[x >> c0_shift_w], limit);
                 const int c1 = c1_data[x >> c1_shift_w];
                 const int c2 = c2_data[x >> c2_shift_w];
@@ -1491,7 +1559,14 @@ static av_always_inline void color16(WaveformContext *s,
             d2_data += s->size - 1;
         }
 
-        for (y = 0; y < src_h; y++) {
+        c0_data += src_line(slice_start, c0_shift_h) * c0_linesize;
+        c1_data += src_line(slice_start, c1_shift_h) * c1_linesize;
+        c2_data += src_line(slice_start, c2_shift_h) * c2_linesize;
+        d0_data += slice_start * d0_linesize;
+        d1_data += slice_start * d1_linesize;
+        d2_data += slice_start * d2_linesize;
+
+        for (y = slice_start; y < slice_end; y++) {
             for (x = 0; x < src_w; x++) {
                 const int c0 = FFMIN(c0_data[x >> c0_shift_w], limit);
                 const int c1 = c1_data[x >> c1_shift_w];
@@ -1519,15 +1594,14 @@ static av_always_inline void color16(WaveformContext *s,
             d2_data += d2_linesize;
         }
     }
-
-    envelope16(s, out, plane, plane, column ? offset_x : offset_y);
 }
 
 static av_always_inline void color(WaveformContext *s,
                                    AVFrame *in, AVFrame *out,
                                    int component, int intensity,
                                    int offset_y, int offset_x,
-                                   int column, int mirror)
+                                   int column, int mirror,
+                                   int jobnr, int nb_jobs)
 {
     const int plane = s->desc->comp[component].plane;
     const uint8_t *c0_data = in->data[plane + 0];
@@ -1547,6 +1621,8 @@ static av_always_inline void color(WaveformContext *s,
     const int c2_shift_h = s->shift_h[(component + 2) % s->ncomp];
     const int src_h = in->height;
     const int src_w = in->width;
+    const int slice_start = ((column ? src_w : src_h) *  jobnr     ) / nb_jobs;
+    const int slice_end   = ((column ? src_w : src_h) * (jobnr + 1)) / nb_jobs;
     int x, y;
 
     if (s->mode) {
@@ -1564,7 +1640,7 @@ static av_always_inline void color(WaveformContext *s,
         uint8_t * const d2 = (mirror ? d2_bottom_line : d2_data);
 
         for (y = 0; y < src_h; y++) {
-            for (x = 0; x < src_w; x++) {
+            for (x = slice_start; x < slice_end; x++) {
                 const int c0 = c0_data[x >> c0_shift_w];
                 const int c1 = c1_data[x >> c1_shift_w];
                 const int c2 = c2_data[x >> c2_shift_w];
@@ -1595,7 +1671,14 @@ static av_always_inline void color(WaveformContext *s,
             d2_data += s->size - 1;
         }
 
-        for (y = 0; y < src_h; y++) {
+        c0_data += src_line(slice_start, c0_shift_h) * c0_linesize;
+        c1_data += src_line(slice_start, c1_shift_h) * c1_linesize;
+        c2_data += src_line(slice_start, c2_shift_h) * c2_linesize;
+        d0_data += slice_start * d0_linesize;
+        d1_data += slice_start * d1_linesize;
+        d2_data += slice_start * d2_linesize;
+
+        for (y = slice_start; y < slice_end; y++) {
             for (x = 0; x < src_w; x++) {
                 const int c0 = c0_data[x >> c0_shift_w];
                 const int c1 = c1_data[x >> c1_shift_w];
@@ -1623,15 +1706,14 @@ static av_always_inline void color(WaveformContext *s,
             d2_data += d2_linesize;
         }
     }
-
-    envelope(s, out, plane, plane, column ? offset_x : offset_y);
 }
 
 static av_always_inline void acolor16(WaveformContext *s,
                                       AVFrame *in, AVFrame *out,
                                       int component, int intensity,
                                       int offset_y, int offset_x,
-                                      int column, int mirror)
+                                      int column, int mirror,
+                                      int jobnr, int nb_jobs)
 {
     const int plane = s->desc->comp[component].plane;
     const int limit = s->max - 1;
@@ -1653,6 +1735,8 @@ static av_always_inline void acolor16(WaveformContext *s,
     const int c2_shift_h = s->shift_h[(component + 2) % s->ncomp];
     const int src_h = in->height;
     const int src_w = in->width;
+    const int slice_start = ((column ? src_w : src_h) *  jobnr     ) / nb_jobs;
+    const int slice_end   = ((column ? src_w : src_h) * (jobnr + 1)) / nb_jobs;
     int x, y;
 
     if (s->mode) {
@@ -1670,7 +1754,7 @@ static av_always_inline void acolor16(WaveformContext *s,
         uint16_t * const d2 = (mirror ? d2_bottom_line : d2_data);
 
         for (y = 0; y < src_h; y++) {
-            for (x = 0; x < src_w; x++) {
+            for (x = slice_start; x < slice_end; x++) {
                 const int c0 = FFMIN(c0_data[x >> c0_shift_w], limit);
                 const int c1 = c1_data[x >> c1_shift_w];
                 const int c2 = c2_data[x >> c2_shift_w];
@@ -1701,7 +1785,14 @@ static av_always_inline void acolor16(WaveformContext *s,
             d2_data += s->size - 1;
         }
 
-        for (y = 0; y < src_h; y++) {
+        c0_data += src_line(slice_start, c0_shift_h) * c0_linesize;
+        c1_data += src_line(slice_start, c1_shift_h) * c1_linesize;
+        c2_data += src_line(slice_start, c2_shift_h) * c2_linesize;
+        d0_data += slice_start * d0_linesize;
+        d1_data += slice_start * d1_linesize;
+        d2_data += slice_start * d2_linesize;
+
+        for (y = slice_start; y < slice_end; y++) {
             for (x = 0; x < src_w; x++) {
                 const int c0 = FFMIN(c0_data[x >> c0_shift_w], limit);
                 const int c1 = c1_data[x >> c1_shift_w];
@@ -1729,15 +1820,14 @@ static av_always_inline void acolor16(WaveformContext *s,
             d2_data += d2_linesize;
         }
     }
-
-    envelope16(s, out, plane, plane, column ? offset_x : offset_y);
 }
 
 static av_always_inline void acolor(WaveformContext *s,
                                     AVFrame *in, AVFrame *out,
                                     int component, int intensity,
                                     int offset_y, int offset_x,
-                                    int column, int mirror)
+                                    int column, int mirror,
+                                    int jobnr, int nb_jobs)
 {
     const int plane = s->desc->comp[component].plane;
     const uint8_t *c0_data = in->data[plane + 0];
@@ -1758,6 +1848,8 @@ static av_always_inline void acolor(WaveformContext *s,
     const int max = 255 - intensity;
     const int src_h = in->height;
     const int src_w = in->width;
+    const int slice_start = ((column ? src_w : src_h) *  jobnr     ) / nb_jobs;
+    const int slice_end   = ((column ? src_w : src_h) * (jobnr + 1)) / nb_jobs;
     int x, y;
 
     if (s->mode) {
@@ -1775,7 +1867,7 @@ static av_always_inline void acolor(WaveformContext *s,
         uint8_t * const d2 = (mirror ? d2_bottom_line : d2_data);
 
         for (y = 0; y < src_h; y++) {
-            for (x = 0; x < src_w; x++) {
+            for (x = slice_start; x < slice_end; x++) {
                 const int c0 = c0_data[x >> c0_shift_w];
                 const int c1 = c1_data[x >> c1_shift_w];
                 const int c2 = c2_data[x >> c2_shift_w];
@@ -1806,7 +1898,14 @@ static av_always_inline void acolor(WaveformContext *s,
             d2_data += s->size - 1;
         }
 
-        for (y = 0; y < src_h; y++) {
+        c0_data += src_line(slice_start, c0_shift_h) * c0_linesize;
+        c1_data += src_line(slice_start, c1_shift_h) * c1_linesize;
+        c2_data += src_line(slice_start, c2_shift_h) * c2_linesize;
+        d0_data += slice_start * d0_linesize;
+        d1_data += slice_start * d1_linesize;
+        d2_data += slice_start * d2_linesize;
+
+        for (y = slice_start; y < slice_end; y++) {
             for (x = 0; x < src_w; x++) {
                 const int c0 = c0_data[x >> c0_shift_w];
                 const int c1 = c1_data[x >> c1_shift_w];
@@ -1834,8 +1933,6 @@ static av_always_inline void acolor(WaveformContext *s,
             d2_data += d2_linesize;
         }
     }
-
-    envelope(s, out, plane, plane, column ? offset_x : offset_y);
 }
 
 static const uint8_t black_yuva_color[4] = { 0, 127, 127, 255 };
@@ -2486,6 +2583,13 @@ static int config_input(AVFilterLink *inlink)
     default:    s->size = 256;     break;
     }
 
+    /* number of planes, starting at the displayed one, each filter draws to */
+    switch (s->filter) {
+    case AFLAT: s->nb_envelopes = 3; break;
+    case FLAT:  s->nb_envelopes = 2; break;
+    default:    s->nb_envelopes = 1; break;
+    }
+
     switch (s->filter | ((s->bits > 8) << 4) |
             (s->mode << 8) | (s->mirror << 12)) {
     case 0x1100: s->waveform = lowpass_column_mirror; break;
@@ -2748,6 +2852,24 @@ static int config_output(AVFilterLink *outlink)
     return 0;
 }
 
+typedef struct ThreadData {
+    AVFrame *in, *out;
+    int component;
+    int offset_y, offset_x;
+} ThreadData;
+
+/* column mode slices the input by columns and row mode by rows, so every
+ * job draws to its own part of the output */
+static int waveform_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    WaveformContext *s = ctx->priv;
+    ThreadData *td = arg;
+
+    s->waveform(s, td->in, td->out, td->component, s->intensity,
+                td->offset_y, td->offset_x, s->mode, s->mirror, jobnr, nb_jobs);
+    return 0;
+}
+
 static int filter_frame(AVFilterLink *inlink, AVFrame *in)
 {
     AVFilterContext *ctx  = inlink->dst;
@@ -2784,8 +2906,10 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *in)
 
     for (k = 0, i = 0; k < s->ncomp; k++) {
         if ((1 << k) & s->pcomp) {
+            ThreadData td;
             int offset_y;
             int offset_x;
+            int plane;
 
             if (s->display == PARADE) {
                 offset_x = s->mode ? i++ * inlink->w : 0;
@@ -2794,7 +2918,21 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *in)
                 offset_y = s->mode ? i++ * s->size * !!s->display : 0;
                 offset_x = s->mode ? 0 : i++ * s->size * !!s->display;
             }
-            s->waveform(s, in, out, k, s->intensity, offset_y, offset_x, s->mode, s->mirror);
+            td.in        = in;
+            td.out       = out;
+            td.component = k;
+            td.offset_y  = offset_y;
+            td.offset_x  = offset_x;
+            ctx->internal->execute(ctx, waveform_slice, &td, NULL,
+                                   ff_filter_get_nb_threads(ctx));
+
+            plane = s->desc->comp[k].plane;
+            for (j = 0; j < s->nb_envelopes; j++) {
+                if (s->bits > 8)
+                    envelope16(s, out, plane, (plane + j) % s->ncomp, s->mode ? offset_x : offset_y);
+                else
+                    envelope(s, out, plane, (plane + j) % s->ncomp, s->mode ? offset_x : offset_y);
+            }
         }
     }
     s->graticulef(s, out);
@@ -2838,4 +2976,5 @@ AVFilter ff_vf_waveform = {
     .uninit        = uninit,
     .inputs        = inputs,
     .outputs       = outputs,
+    .flags         = AVFILTER_FLAG_SLICE_THREADS,
 };
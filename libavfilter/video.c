@@ -28,6 +28,7 @@
 #include "libavutil/hwcontext.h"
 #include "libavutil/imgutils.h"
 #include "libavutil/mem.h"
+#include "libavutil/pixdesc.h"
 
 #include "avfilter.h"
 #include "internal.h"
@@ -110,3 +111,39 @@ AVFrame *ff_get_video_buffer(AVFilterLink *link, int w, int h)
 
     return ret;
 }
+
+typedef struct CopyThreadData {
+    AVFrame *dst;
+    const AVFrame *src;
+} CopyThreadData;
+
+static int copy_video_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    CopyThreadData *td = arg;
+
+    av_image_copy_slice(td->dst->data, td->dst->linesize,
+                        (const uint8_t **)td->src->data, td->src->linesize,
+                        td->src->format, td->src->width, td->src->height,
+                        jobnr, nb_jobs);
+    return 0;
+}
+
+int ff_copy_video_frame(AVFilterContext *ctx, AVFrame *dst, const AVFrame *src)
+{
+    CopyThreadData td = { dst, src };
+    int i, size, nb_jobs;
+
+    if (dst->format != src->format || src->format < 0 ||
+        dst->width < src->width || dst->height < src->height)
+        return AVERROR(EINVAL);
+    for (i = 0; i < av_pix_fmt_count_planes(dst->format); i++)
+        if (!dst->data[i] || !src->data[i])
+            return AVERROR(EINVAL);
+
+    /* at least 1 MiB per job, so that the threads do not cost more than they
+     * save on small frames */
+    size = av_image_get_buffer_size(src->format, src->width, src->height, 1);
+    nb_jobs = av_clip(size >> 20, 1, FFMIN(ff_filter_get_nb_threads(ctx), src->height));
+
+    return ctx->internal->execute(ctx, copy_video_slice, &td, NULL, nb_jobs);
+}
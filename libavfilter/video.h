@@ -38,4 +38,14 @@ AVFrame *ff_null_get_video_buffer(AVFilterLink *link, int w, int h);
  */
 AVFrame *ff_get_video_buffer(AVFilterLink *link, int w, int h);
 
+/**
+ * Copy the video data of src to dst, like av_frame_copy() does. Large frames
+ * are copied in slices run on the slice threads of the filter, if it has
+ * slice threading enabled.
+ *
+ * @param ctx the filter context doing the copy
+ * @return 0 on success, a negative AVERROR on error
+ */
+int ff_copy_video_frame(AVFilterContext *ctx, AVFrame *dst, const AVFrame *src);
+
 #endif /* AVFILTER_VIDEO_H */
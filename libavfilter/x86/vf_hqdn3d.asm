@@ -45,9 +45,9 @@ SECTION .text
 
 %macro HQDN3D_ROW 1 ; bitdepth
 %if ARCH_X86_64
-cglobal hqdn3d_row_%1_x86, 7,10,0, src, dst, lineant, frameant, width, spatial, temporal, pixelant, t0, t1
+cglobal hqdn3d_row_%1_x86, 8,10,0, src, dst, lineant, frameant, width, spatial, temporal, pixelant, t0, t1
 %else
-cglobal hqdn3d_row_%1_x86, 7,7,0, src, dst, lineant, frameant, width, spatial, temporal
+cglobal hqdn3d_row_%1_x86, 8,8,0, src, dst, lineant, frameant, width, spatial, temporal, pixelant
 %endif
     %assign bytedepth (%1+7)>>3
     %assign lut_bits 4+4*(%1/16)
@@ -69,18 +69,21 @@ cglobal hqdn3d_row_%1_x86, 7,7,0, src, dst, lineant, frameant, width, spatial, t
     %define pixelantq r1
     %define pixelantd r1d
     DECLARE_REG_TMP 2,3
+    mov    pixelantd, pixelantm
+%else
+    mov    pixelantd, pixelantd
 %endif
-    LOAD   pixelantd, xq, %1
+    jmp .pixel
 ALIGN 16
 .loop:
     movifnidn srcq, srcmp
-    LOAD      t0d, xq+1, %1 ; skip on the last iteration to avoid overread
-.loop2:
+    LOAD      t0d, xq, %1
+    LOWPASS   pixelant, t0, spatial
+.pixel:
     movifnidn lineantq, lineantmp
     movzx     t1d, word [lineantq+xq*2]
     LOWPASS   t1, pixelant, spatial
     mov       [lineantq+xq*2], t1w
-    LOWPASS   pixelant, t0, spatial
     movifnidn frameantq, frameantmp
     movzx     t0d, word [frameantq+xq*2]
     LOWPASS   t0, t1, temporal
@@ -95,9 +98,9 @@ ALIGN 16
     mov    [dstq+xq*2], t0w
 %endif
     inc    xq
-    jl .loop
-    je .loop2
-    REP_RET
+    jle .loop
+    mov    eax, pixelantd
+    RET
 %endmacro ; HQDN3D_ROW
 
 HQDN3D_ROW 8
@@ -0,0 +1,158 @@
+;*****************************************************************************
+;* x86-optimized functions for nnedi filter
+;*
+;* This file is part of FFmpeg.
+;*
+;* FFmpeg is free software; you can redistribute it and/or modify
+;* it under the terms of the GNU General Public License as published by
+;* the Free Software Foundation; either version 2 of the License, or
+;* (at your option) any later version.
+;*
+;* FFmpeg is distributed in the hope that it will be useful,
+;* but WITHOUT ANY WARRANTY; without even the implied warranty of
+;* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+;* GNU General Public License for more details.
+;*
+;* You should have received a copy of the GNU General Public License along
+;* with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+;* 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+;******************************************************************************
+
+%include "libavutil/x86/x86util.asm"
+
+SECTION_RODATA
+
+ps_1:        times 4 dd 1.0
+ps_abs_mask: times 4 dd 0x7fffffff
+
+SECTION .text
+
+;------------------------------------------------------------------------------
+; void ff_nnedi_dot_prod(const float *data, const float *weights, float *vals,
+;                        int n, int len, const float *scale)
+;------------------------------------------------------------------------------
+
+%macro DOT_PROD 0
+cglobal nnedi_dot_prod, 6, 7, 4, data, weights, vals, n, len, bias, off
+    VBROADCASTSS m3, [biasq]
+    shl        lend, 2
+    mov        offd, nd
+    imul       offd, lend
+    lea       biasq, [weightsq + offq]
+    add       dataq, lenq
+    add    weightsq, lenq
+.loop_n:
+    mov        offq, lenq
+    neg        offq
+    xorps        m0, m0
+%if mmsize == 32
+    test       lend, 16
+    jz .loop
+    movups      xm1, [dataq + offq]
+    mulps       xm0, xm1, [weightsq + offq]
+    add        offq, 16
+    jz .reduce
+%endif
+.loop:
+    movups       m1, [dataq + offq]
+%if cpuflag(fma3)
+    fmaddps      m0, m1, [weightsq + offq], m0
+%else
+    movups       m2, [weightsq + offq]
+    mulps        m1, m2
+    addps        m0, m1
+%endif
+    add        offq, mmsize
+    jl .loop
+.reduce:
+%if mmsize == 32
+    vextractf128 xm1, m0, 1
+    addps       xm0, xm1
+%endif
+    movhlps     xm1, xm0
+    addps       xm0, xm1
+    movss       xm1, xm0
+    shufps      xm0, xm0, 1
+    addss       xm0, xm1
+    mulss       xm0, xm3
+    addss       xm0, [biasq]
+    movss    [valsq], xm0
+    add    weightsq, lenq
+    add       valsq, 4
+    add       biasq, 4
+    dec          nd
+    jg .loop_n
+    RET
+%endmacro
+
+INIT_XMM sse
+DOT_PROD
+%if HAVE_FMA3_EXTERNAL
+INIT_YMM fma3
+DOT_PROD
+%endif
+
+;------------------------------------------------------------------------------
+; void ff_nnedi_dot_prods(const int16_t *data, const int16_t *weights,
+;                         int32_t *sums, int n, int len)
+;------------------------------------------------------------------------------
+
+%macro DOT_PRODS 0
+cglobal nnedi_dot_prods, 5, 6, 3, data, weights, sums, n, len, off
+    add        lend, lend
+    add       dataq, lenq
+    add    weightsq, lenq
+.loop_n:
+    mov        offq, lenq
+    neg        offq
+    pxor         m0, m0
+.loop:
+    movu         m1, [dataq + offq]
+    movu         m2, [weightsq + offq]
+    pmaddwd      m1, m2
+    paddd        m0, m1
+    add        offq, mmsize
+    jl .loop
+%if mmsize == 32
+    vextracti128 xm1, m0, 1
+    paddd       xm0, xm1
+%endif
+    pshufd      xm1, xm0, q0032
+    paddd       xm0, xm1
+    pshufd      xm1, xm0, q0001
+    paddd       xm0, xm1
+    movd     [sumsq], xm0
+    add    weightsq, lenq
+    add       sumsq, 4
+    dec          nd
+    jg .loop_n
+    RET
+%endmacro
+
+INIT_XMM sse2
+DOT_PRODS
+%if HAVE_AVX2_EXTERNAL
+INIT_YMM avx2
+DOT_PRODS
+%endif
+
+;------------------------------------------------------------------------------
+; void ff_nnedi_elliott(float *data, int n)
+;------------------------------------------------------------------------------
+
+INIT_XMM sse
+cglobal nnedi_elliott, 2, 2, 4, data, n
+    movaps       m2, [ps_abs_mask]
+    movaps       m3, [ps_1]
+    shl          nd, 2
+    add       dataq, nq
+    neg          nq
+.loop:
+    movups       m0, [dataq + nq]
+    andps        m1, m0, m2
+    addps        m1, m3
+    divps        m0, m1
+    movups [dataq + nq], m0
+    add          nq, mmsize
+    jl .loop
+    RET
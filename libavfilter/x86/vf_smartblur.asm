@@ -0,0 +1,106 @@
+;*****************************************************************************
+;* x86-optimized functions for smartblur filter
+;*
+;* This file is part of FFmpeg.
+;*
+;* FFmpeg is free software; you can redistribute it and/or modify
+;* it under the terms of the GNU General Public License as published by
+;* the Free Software Foundation; either version 2 of the License, or
+;* (at your option) any later version.
+;*
+;* FFmpeg is distributed in the hope that it will be useful,
+;* but WITHOUT ANY WARRANTY; without even the implied warranty of
+;* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+;* GNU General Public License for more details.
+;*
+;* You should have received a copy of the GNU General Public License along
+;* with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+;* 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+;******************************************************************************
+
+%include "libavutil/x86/x86util.asm"
+
+SECTION .text
+
+; in: m0 = src, m1 = filtered, m6 = t, m7 = 2 * t
+; out: m3 = |src - filtered| <= t, m5 = |src - filtered| <= 2 * t,
+;      m4 = m%1 + min(m%2, t) - min(m%3, t)
+; with m2 = src - filtered and m3 = filtered - src saturated, only one of
+; which is nonzero, so m4 is m%1 moved by t where the difference exceeds t
+%macro THRESHOLD_MASKS 3
+    mova             m2, m0
+    psubusb          m2, m1
+    mova             m3, m1
+    psubusb          m3, m0
+    mova             m4, m%2
+    mova             m5, m%3
+    pminub           m4, m6
+    pminub           m5, m6
+    paddusb          m4, m%1
+    psubusb          m4, m5
+    por              m2, m3
+    mova             m3, m2
+    mova             m5, m2
+    pminub           m3, m6
+    pminub           m5, m7
+    pcmpeqb          m3, m2
+    pcmpeqb          m5, m2
+%endmacro
+
+;------------------------------------------------------------------------------
+; void ff_smartblur_threshold(uint8_t *dst, const uint8_t *src, int w,
+;                             int threshold)
+;------------------------------------------------------------------------------
+
+INIT_XMM sse2
+cglobal smartblur_threshold, 4, 4, 8, dst, src, w, threshold
+    test             wd, wd
+    jle .end
+    test     thresholdd, thresholdd
+    jg .positive
+    neg      thresholdd
+    SPLATB_REG       m6, threshold, m7
+    mova             m7, m6
+    paddusb          m7, m6
+.loop_negative:
+    movu             m0, [srcq]
+    movu             m1, [dstq]
+    ; filtered moves away from src by t where |src - filtered| is in (t, 2t]
+    ; and src is kept where it is at most t
+    THRESHOLD_MASKS   1, 2, 3
+    pand             m4, m5
+    pandn            m5, m1
+    por              m4, m5
+    pand             m0, m3
+    pandn            m3, m4
+    por              m0, m3
+    movu         [dstq], m0
+    add            dstq, mmsize
+    add            srcq, mmsize
+    sub              wd, mmsize
+    jg .loop_negative
+    RET
+
+.positive:
+    SPLATB_REG       m6, threshold, m7
+    mova             m7, m6
+    paddusb          m7, m6
+.loop_positive:
+    movu             m0, [srcq]
+    movu             m1, [dstq]
+    ; src moves towards filtered by t where |src - filtered| is in (t, 2t],
+    ; filtered is kept where it is at most t
+    THRESHOLD_MASKS   0, 3, 2
+    pand             m4, m5
+    pandn            m5, m0
+    por              m4, m5
+    pand             m1, m3
+    pandn            m3, m4
+    por              m1, m3
+    movu         [dstq], m1
+    add            dstq, mmsize
+    add            srcq, mmsize
+    sub              wd, mmsize
+    jg .loop_positive
+.end:
+    RET
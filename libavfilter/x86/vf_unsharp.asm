@@ -0,0 +1,110 @@
+;*****************************************************************************
+;* x86-optimized functions for unsharp filter
+;*
+;* This file is part of FFmpeg.
+;*
+;* FFmpeg is free software; you can redistribute it and/or
+;* modify it under the terms of the GNU Lesser General Public
+;* License as published by the Free Software Foundation; either
+;* version 2.1 of the License, or (at your option) any later version.
+;*
+;* FFmpeg is distributed in the hope that it will be useful,
+;* but WITHOUT ANY WARRANTY; without even the implied warranty of
+;* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+;* Lesser General Public License for more details.
+;*
+;* You should have received a copy of the GNU Lesser General Public
+;* License along with FFmpeg; if not, write to the Free Software
+;* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+;*****************************************************************************
+
+%include "libavutil/x86/x86util.asm"
+
+SECTION .text
+
+;------------------------------------------------------------------------------
+; void ff_unsharp_vertical(uint32_t *line, uint32_t *sc, int sc_stride,
+;                          int steps, int w)
+;------------------------------------------------------------------------------
+
+%macro VERTICAL 0
+cglobal unsharp_vertical, 5, 7, 3, line, sc, stride, steps, w, ptr, cnt
+    movsxdifnidn strideq, strided
+    shl        strideq, 2
+    test             wd, wd
+    jle .end
+.loop_x:
+    movu             m0, [lineq]
+    mov            ptrq, scq
+    mov            cntd, stepsd
+.loop_z:
+    movu             m1, [ptrq]
+    movu             m2, [ptrq + strideq]
+    paddd            m1, m0
+    movu         [ptrq], m0
+    paddd            m2, m1
+    movu [ptrq + strideq], m1
+    mova             m0, m2
+    lea            ptrq, [ptrq + 2 * strideq]
+    dec            cntd
+    jg .loop_z
+    movu        [lineq], m0
+    add           lineq, mmsize
+    add             scq, mmsize
+    sub              wd, mmsize / 4
+    jg .loop_x
+.end:
+    RET
+%endmacro
+
+INIT_XMM sse2
+VERTICAL
+
+%if HAVE_AVX2_EXTERNAL
+INIT_YMM avx2
+VERTICAL
+%endif
+
+;------------------------------------------------------------------------------
+; void ff_unsharp_output(uint8_t *dst, const uint8_t *src, const uint32_t *blur,
+;                        int w, int amount, int scalebits, int halfscale)
+;------------------------------------------------------------------------------
+
+INIT_XMM sse4
+cglobal unsharp_output, 7, 7, 8, dst, src, blur, w, amount, scalebits, halfscale
+    movd             m4, amountd
+    movd             m5, scalebitsd
+    movd             m6, halfscaled
+    pshufd           m4, m4, 0
+    pshufd           m6, m6, 0
+    test             wd, wd
+    jle .end
+.loop:
+    pmovzxbd         m0, [srcq]
+    pmovzxbd         m1, [srcq + 4]
+    movu             m2, [blurq]
+    movu             m3, [blurq + mmsize]
+    paddd            m2, m6
+    paddd            m3, m6
+    psrld            m2, m5
+    psrld            m3, m5
+    mova             m7, m0
+    psubd            m7, m2
+    pmulld           m7, m4
+    psrad            m7, 16
+    paddd            m0, m7
+    mova             m7, m1
+    psubd            m7, m3
+    pmulld           m7, m4
+    psrad            m7, 16
+    paddd            m1, m7
+    packssdw         m0, m1
+    packuswb         m0, m0
+    movq         [dstq], m0
+    add            dstq, 8
+    add            srcq, 8
+    add           blurq, 2 * mmsize
+    sub              wd, 8
+    jg .loop
+.end:
+    RET
@@ -0,0 +1,44 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "libavutil/attributes.h"
+#include "libavutil/cpu.h"
+#include "libavutil/x86/cpu.h"
+#include "libavfilter/unsharp.h"
+
+void ff_unsharp_vertical_sse2(uint32_t *line, uint32_t *sc, int sc_stride,
+                              int steps, int w);
+void ff_unsharp_vertical_avx2(uint32_t *line, uint32_t *sc, int sc_stride,
+                              int steps, int w);
+void ff_unsharp_output_sse4(uint8_t *dst, const uint8_t *src, const uint32_t *blur,
+                            int w, int amount, int scalebits, int halfscale);
+
+av_cold void ff_unsharp_init_dsp_x86(UnsharpDSPContext *dsp)
+{
+    int cpu_flags = av_get_cpu_flags();
+
+    if (EXTERNAL_SSE2(cpu_flags)) {
+        dsp->vertical = ff_unsharp_vertical_sse2;
+    }
+    if (EXTERNAL_SSE4(cpu_flags)) {
+        dsp->output = ff_unsharp_output_sse4;
+    }
+    if (EXTERNAL_AVX2_FAST(cpu_flags)) {
+        dsp->vertical = ff_unsharp_vertical_avx2;
+    }
+}
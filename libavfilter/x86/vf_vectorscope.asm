@@ -0,0 +1,113 @@
+;*****************************************************************************
+;* x86-optimized functions for vectorscope filter
+;*
+;* This file is part of FFmpeg.
+;*
+;* FFmpeg is free software; you can redistribute it and/or
+;* modify it under the terms of the GNU Lesser General Public
+;* License as published by the Free Software Foundation; either
+;* version 2.1 of the License, or (at your option) any later version.
+;*
+;* FFmpeg is distributed in the hope that it will be useful,
+;* but WITHOUT ANY WARRANTY; without even the implied warranty of
+;* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+;* Lesser General Public License for more details.
+;*
+;* You should have received a copy of the GNU Lesser General Public
+;* License along with FFmpeg; if not, write to the Free Software
+;* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+;*****************************************************************************
+
+%include "libavutil/x86/x86util.asm"
+
+SECTION_RODATA
+
+pd_256: times 4 dd 256
+pw_255: times 8 dw 255
+
+SECTION .text
+
+%define MAP_SIZE (256 * 256 * 4)
+
+;------------------------------------------------------------------------------
+; void ff_vectorscope_sum_maps(uint32_t *dst, const uint32_t *maps, int nb_maps)
+; void ff_vectorscope_max_maps(uint32_t *dst, const uint32_t *maps, int nb_maps)
+;------------------------------------------------------------------------------
+
+%macro MERGE_MAPS 2 ; name, op
+cglobal vectorscope_%1_maps, 3, 6, 4, dst, maps, nb, x, ptr, cnt
+    xor              xd, xd
+.loop_x:
+    lea            ptrq, [mapsq + xq]
+    movu             m0, [ptrq]
+    movu             m1, [ptrq + mmsize]
+    mov            cntd, nbd
+    jmp .next
+.loop_k:
+    movu             m2, [ptrq]
+    movu             m3, [ptrq + mmsize]
+    %2               m0, m2
+    %2               m1, m3
+.next:
+    add            ptrq, MAP_SIZE
+    dec            cntd
+    jg .loop_k
+    movu    [dstq + xq], m0
+    movu [dstq + xq + mmsize], m1
+    add              xd, 2 * mmsize
+    cmp              xd, 256 * 4
+    jl .loop_x
+    RET
+%endmacro
+
+INIT_XMM sse2
+MERGE_MAPS sum, paddd
+INIT_XMM sse4
+MERGE_MAPS max, pmaxud
+
+%if HAVE_AVX2_EXTERNAL
+INIT_YMM avx2
+MERGE_MAPS sum, paddd
+MERGE_MAPS max, pmaxud
+%endif
+
+;------------------------------------------------------------------------------
+; void ff_vectorscope_add_hits(uint8_t *dst, const uint32_t *hits, int intensity)
+;------------------------------------------------------------------------------
+
+INIT_XMM sse4
+cglobal vectorscope_add_hits, 3, 4, 8, dst, hits, intensity, x
+    movd             m4, intensityd
+    SPLATW           m4, m4
+    mova             m5, [pd_256]
+    mova             m6, [pw_255]
+    pxor             m7, m7
+    xor              xd, xd
+.loop:
+    movu             m0, [hitsq + 4 * xq]
+    movu             m1, [hitsq + 4 * xq + 16]
+    movu             m2, [hitsq + 4 * xq + 32]
+    movu             m3, [hitsq + 4 * xq + 48]
+    pminud           m0, m5
+    pminud           m1, m5
+    pminud           m2, m5
+    pminud           m3, m5
+    packusdw         m0, m1
+    packusdw         m2, m3
+    ; at most 256 * 255, and the pixel adds at most 255 more
+    pmullw           m0, m4
+    pmullw           m2, m4
+    pminuw           m0, m6
+    pminuw           m2, m6
+    movu             m1, [dstq + xq]
+    mova             m3, m1
+    punpcklbw        m1, m7
+    punpckhbw        m3, m7
+    paddw            m0, m1
+    paddw            m2, m3
+    packuswb         m0, m2
+    movu    [dstq + xq], m0
+    add              xd, mmsize
+    cmp              xd, 256
+    jl .loop
+    RET
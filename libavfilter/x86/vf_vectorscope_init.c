@@ -0,0 +1,45 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "libavutil/attributes.h"
+#include "libavutil/cpu.h"
+#include "libavutil/x86/cpu.h"
+#include "libavfilter/vectorscope.h"
+
+void ff_vectorscope_sum_maps_sse2(uint32_t *dst, const uint32_t *maps, int nb_maps);
+void ff_vectorscope_sum_maps_avx2(uint32_t *dst, const uint32_t *maps, int nb_maps);
+void ff_vectorscope_max_maps_sse4(uint32_t *dst, const uint32_t *maps, int nb_maps);
+void ff_vectorscope_max_maps_avx2(uint32_t *dst, const uint32_t *maps, int nb_maps);
+void ff_vectorscope_add_hits_sse4(uint8_t *dst, const uint32_t *hits, int intensity);
+
+av_cold void ff_vectorscope_init_dsp_x86(VectorscopeDSPContext *dsp)
+{
+    int cpu_flags = av_get_cpu_flags();
+
+    if (EXTERNAL_SSE2(cpu_flags)) {
+        dsp->sum_maps = ff_vectorscope_sum_maps_sse2;
+    }
+    if (EXTERNAL_SSE4(cpu_flags)) {
+        dsp->max_maps = ff_vectorscope_max_maps_sse4;
+        dsp->add_hits = ff_vectorscope_add_hits_sse4;
+    }
+    if (EXTERNAL_AVX2_FAST(cpu_flags)) {
+        dsp->sum_maps = ff_vectorscope_sum_maps_avx2;
+        dsp->max_maps = ff_vectorscope_max_maps_avx2;
+    }
+}
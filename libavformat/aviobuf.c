@@ -25,6 +25,7 @@
 #include "libavutil/intreadwrite.h"
 #include "libavutil/log.h"
 #include "libavutil/opt.h"
+#include "libavutil/trace.h"
 #include "libavutil/avassert.h"
 #include "avformat.h"
 #include "avio.h"
@@ -151,6 +152,7 @@ void avio_context_free(AVIOContext **ps)
 static void writeout(AVIOContext *s, const uint8_t *data, int len)
 {
     if (!s->error) {
+        int64_t trace_start = av_trace_begin();
         int ret = 0;
         if (s->write_data_type)
             ret = s->write_data_type(s->opaque, (uint8_t *)data,
@@ -159,6 +161,7 @@ static void writeout(AVIOContext *s, const uint8_t *data, int len)
                                      s->last_time);
         else if (s->write_packet)
             ret = s->write_packet(s->opaque, (uint8_t *)data, len);
+        av_trace_end("io", "write", trace_start);
         if (ret < 0) {
             s->error = ret;
         } else {
@@ -526,11 +529,14 @@ void avio_write_marker(AVIOContext *s, int64_t time, enum AVIODataMarkerType typ
 
 static int read_packet_wrapper(AVIOContext *s, uint8_t *buf, int size)
 {
+    int64_t trace_start;
     int ret;
 
     if (!s->read_packet)
         return AVERROR(EINVAL);
+    trace_start = av_trace_begin();
     ret = s->read_packet(s->opaque, buf, size);
+    av_trace_end("io", "read", trace_start);
 #if FF_API_OLD_AVIO_EOF_0
     if (!ret && !s->max_packet_size) {
         av_log(NULL, AV_LOG_WARNING, "Invalid return value 0 for stream protocol\n");
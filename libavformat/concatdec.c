@@ -18,6 +18,8 @@
  * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
  */
 
+#include <stdatomic.h>
+
 #include "libavutil/avassert.h"
 #include "libavutil/avstring.h"
 #include "libavutil/intreadwrite.h"
@@ -28,11 +30,23 @@
 #include "internal.h"
 #include "url.h"
 
+#if HAVE_PTHREADS
+#include <pthread.h>
+#endif
+
+#define MAX_PREFETCH 64
+
 typedef enum ConcatMatchMode {
     MATCH_ONE_TO_ONE,
     MATCH_EXACT_ID,
 } ConcatMatchMode;
 
+typedef enum PrefetchState {
+    PREFETCH_NONE,      ///< not opened by the prefetch thread
+    PREFETCH_BUSY,      ///< being opened by the prefetch thread
+    PREFETCH_DONE,      ///< opened and probed, waiting to be used
+} PrefetchState;
+
 typedef struct ConcatStream {
     AVBSFContext *bsf;
     int out_stream_index;
@@ -50,6 +64,9 @@ typedef struct {
     int64_t outpoint;
     AVDictionary *metadata;
     int nb_streams;
+    PrefetchState prefetch_state;
+    AVFormatContext *prefetch_avf;
+    int prefetch_ret;
 } ConcatFile;
 
 typedef struct {
@@ -64,6 +81,16 @@ typedef struct {
     ConcatMatchMode stream_match_mode;
     unsigned auto_convert;
     int segment_time_metadata;
+    int prefetch;
+#if HAVE_PTHREADS
+    AVFormatContext *parent;
+    pthread_t prefetch_thread;
+    pthread_mutex_t prefetch_mutex;
+    pthread_cond_t prefetch_cond;
+    int prefetch_thread_inited;
+    unsigned prefetch_base;     ///< index of the file being read, protected by prefetch_mutex
+    atomic_int prefetch_abort;
+#endif
 } ConcatContext;
 
 static int concat_probe(AVProbeData *probe)
@@ -313,29 +340,183 @@ static int match_streams(AVFormatContext *avf)
     return 0;
 }
 
-static int open_file(AVFormatContext *avf, unsigned fileno)
+/**
+ * Open and probe the given url into a new format context, inheriting the
+ * flags and whitelists of the concat demuxer.
+ */
+static int open_input(AVFormatContext *avf, AVFormatContext **ps, const char *url,
+                      const AVIOInterruptCB *interrupt_callback)
 {
-    ConcatContext *cat = avf->priv_data;
-    ConcatFile *file = &cat->files[fileno];
+    AVFormatContext *s = avformat_alloc_context();
     int ret;
 
-    if (cat->avf)
-        avformat_close_input(&cat->avf);
-
-    cat->avf = avformat_alloc_context();
-    if (!cat->avf)
+    if (!s)
         return AVERROR(ENOMEM);
 
-    cat->avf->flags |= avf->flags & ~AVFMT_FLAG_CUSTOM_IO;
-    cat->avf->interrupt_callback = avf->interrupt_callback;
+    s->flags |= avf->flags & ~AVFMT_FLAG_CUSTOM_IO;
+    s->interrupt_callback = *interrupt_callback;
 
-    if ((ret = ff_copy_whiteblacklists(cat->avf, avf)) < 0)
+    if ((ret = ff_copy_whiteblacklists(s, avf)) < 0) {
+        avformat_free_context(s);
         return ret;
+    }
 
-    if ((ret = avformat_open_input(&cat->avf, file->url, NULL, NULL)) < 0 ||
-        (ret = avformat_find_stream_info(cat->avf, NULL)) < 0) {
-        av_log(avf, AV_LOG_ERROR, "Impossible to open '%s'\n", file->url);
+    if ((ret = avformat_open_input(&s, url, NULL, NULL)) < 0 ||
+        (ret = avformat_find_stream_info(s, NULL)) < 0) {
+        avformat_close_input(&s);
+        return ret;
+    }
+    *ps = s;
+    return 0;
+}
+
+#if HAVE_PTHREADS
+static int prefetch_interrupt_cb(void *opaque)
+{
+    ConcatContext *cat = opaque;
+
+    return atomic_load(&cat->prefetch_abort) ||
+           ff_check_interrupt(&cat->parent->interrupt_callback);
+}
+
+/**
+ * Keep the files following the one being read opened and probed, at most
+ * cat->prefetch of them at a time.
+ */
+static void *prefetch_thread(void *arg)
+{
+    AVFormatContext *avf = arg;
+    ConcatContext *cat = avf->priv_data;
+    const AVIOInterruptCB cb = { prefetch_interrupt_cb, cat };
+
+    pthread_mutex_lock(&cat->prefetch_mutex);
+    while (!atomic_load(&cat->prefetch_abort)) {
+        unsigned i, end = FFMIN(cat->prefetch_base + cat->prefetch + 1, cat->nb_files);
+        ConcatFile *file = NULL;
+        AVFormatContext *s = NULL;
+
+        for (i = cat->prefetch_base + 1; i < end; i++) {
+            if (cat->files[i].prefetch_state == PREFETCH_NONE) {
+                file = &cat->files[i];
+                break;
+            }
+        }
+        if (!file) {
+            pthread_cond_wait(&cat->prefetch_cond, &cat->prefetch_mutex);
+            continue;
+        }
+
+        file->prefetch_state = PREFETCH_BUSY;
+        pthread_mutex_unlock(&cat->prefetch_mutex);
+        file->prefetch_ret = open_input(avf, &s, file->url, &cb);
+        pthread_mutex_lock(&cat->prefetch_mutex);
+        file->prefetch_avf   = s;
+        file->prefetch_state = PREFETCH_DONE;
+        pthread_cond_broadcast(&cat->prefetch_cond);
+    }
+    pthread_mutex_unlock(&cat->prefetch_mutex);
+    return NULL;
+}
+
+static int prefetch_start(AVFormatContext *avf)
+{
+    ConcatContext *cat = avf->priv_data;
+    int ret;
+
+    cat->parent = avf;
+    atomic_init(&cat->prefetch_abort, 0);
+    if ((ret = pthread_mutex_init(&cat->prefetch_mutex, NULL))) {
+        av_log(avf, AV_LOG_ERROR, "pthread_mutex_init failed : %s\n", strerror(ret));
+        return AVERROR(ret);
+    }
+    if ((ret = pthread_cond_init(&cat->prefetch_cond, NULL))) {
+        av_log(avf, AV_LOG_ERROR, "pthread_cond_init failed : %s\n", strerror(ret));
+        pthread_mutex_destroy(&cat->prefetch_mutex);
+        return AVERROR(ret);
+    }
+    if ((ret = pthread_create(&cat->prefetch_thread, NULL, prefetch_thread, avf))) {
+        av_log(avf, AV_LOG_ERROR, "pthread_create failed : %s\n", strerror(ret));
+        pthread_cond_destroy(&cat->prefetch_cond);
+        pthread_mutex_destroy(&cat->prefetch_mutex);
+        return AVERROR(ret);
+    }
+    cat->prefetch_thread_inited = 1;
+    return 0;
+}
+
+static void prefetch_stop(AVFormatContext *avf)
+{
+    ConcatContext *cat = avf->priv_data;
+
+    if (!cat->prefetch_thread_inited)
+        return;
+    pthread_mutex_lock(&cat->prefetch_mutex);
+    atomic_store(&cat->prefetch_abort, 1);
+    pthread_cond_broadcast(&cat->prefetch_cond);
+    pthread_mutex_unlock(&cat->prefetch_mutex);
+    pthread_join(cat->prefetch_thread, NULL);
+    pthread_cond_destroy(&cat->prefetch_cond);
+    pthread_mutex_destroy(&cat->prefetch_mutex);
+    cat->prefetch_thread_inited = 0;
+}
+
+/**
+ * Move the prefetch window to start at fileno and take the context of that
+ * file if the prefetch thread opened it. Prefetched files outside of the new
+ * window are closed. Returns 1 if *ps was set, 0 if the file was not
+ * prefetched, or the error the prefetch thread got opening it.
+ */
+static int prefetch_get(AVFormatContext *avf, unsigned fileno, AVFormatContext **ps)
+{
+    ConcatContext *cat = avf->priv_data;
+    ConcatFile *file = &cat->files[fileno];
+    unsigned i;
+    int ret = 0;
+
+    pthread_mutex_lock(&cat->prefetch_mutex);
+    while (file->prefetch_state == PREFETCH_BUSY)
+        pthread_cond_wait(&cat->prefetch_cond, &cat->prefetch_mutex);
+    if (file->prefetch_state == PREFETCH_DONE) {
+        ret = file->prefetch_ret;
+        if (ret >= 0) {
+            *ps = file->prefetch_avf;
+            (*ps)->interrupt_callback = avf->interrupt_callback;
+            ret = 1;
+        }
+        file->prefetch_avf   = NULL;
+        file->prefetch_state = PREFETCH_NONE;
+    }
+    for (i = 0; i < cat->nb_files; i++) {
+        if (cat->files[i].prefetch_state == PREFETCH_DONE &&
+            (i < fileno || i > fileno + cat->prefetch)) {
+            avformat_close_input(&cat->files[i].prefetch_avf);
+            cat->files[i].prefetch_state = PREFETCH_NONE;
+        }
+    }
+    cat->prefetch_base = fileno;
+    pthread_cond_broadcast(&cat->prefetch_cond);
+    pthread_mutex_unlock(&cat->prefetch_mutex);
+    return ret;
+}
+#endif
+
+static int open_file(AVFormatContext *avf, unsigned fileno)
+{
+    ConcatContext *cat = avf->priv_data;
+    ConcatFile *file = &cat->files[fileno];
+    int ret = 0;
+
+    if (cat->avf)
         avformat_close_input(&cat->avf);
+
+#if HAVE_PTHREADS
+    if (cat->prefetch_thread_inited)
+        ret = prefetch_get(avf, fileno, &cat->avf);
+#endif
+    if (!ret)
+        ret = open_input(avf, &cat->avf, file->url, &avf->interrupt_callback);
+    if (ret < 0) {
+        av_log(avf, AV_LOG_ERROR, "Impossible to open '%s'\n", file->url);
         return ret;
     }
     cat->cur_file = file;
@@ -368,7 +549,11 @@ static int concat_read_close(AVFormatContext *avf)
     ConcatContext *cat = avf->priv_data;
     unsigned i, j;
 
+#if HAVE_PTHREADS
+    prefetch_stop(avf);
+#endif
     for (i = 0; i < cat->nb_files; i++) {
+        avformat_close_input(&cat->files[i].prefetch_avf);
         av_freep(&cat->files[i].url);
         for (j = 0; j < cat->files[i].nb_streams; j++) {
             if (cat->files[i].streams[j].bsf)
@@ -497,6 +682,13 @@ static int concat_read_header(AVFormatContext *avf)
 
     cat->stream_match_mode = avf->nb_streams ? MATCH_EXACT_ID :
                                                MATCH_ONE_TO_ONE;
+#if HAVE_PTHREADS
+    if (cat->prefetch && cat->nb_files > 1 && (ret = prefetch_start(avf)) < 0)
+        goto fail;
+#else
+    if (cat->prefetch)
+        av_log(avf, AV_LOG_WARNING, "prefetch requires threading support, ignoring\n");
+#endif
     if ((ret = open_file(avf, 0)) < 0)
         goto fail;
     return 0;
@@ -756,6 +948,8 @@ static const AVOption options[] = {
       OFFSET(auto_convert), AV_OPT_TYPE_BOOL, {.i64 = 1}, 0, 1, DEC },
     { "segment_time_metadata", "output file segment start time and duration as packet metadata",
       OFFSET(segment_time_metadata), AV_OPT_TYPE_BOOL, {.i64 = 0}, 0, 1, DEC },
+    { "prefetch", "number of next files to open and probe in a background thread",
+      OFFSET(prefetch), AV_OPT_TYPE_INT, {.i64 = 0}, 0, MAX_PREFETCH, DEC },
     { NULL }
 };
 
@@ -78,6 +78,8 @@ typedef struct OutputStream {
     int64_t last_dts;
     int bit_rate;
     char bandwidth_str[64];
+    int chunks_len;     ///< bytes of the current segment already written in streaming mode
+    char chunks_file[1024];
 
     char codec_str[100];
 } OutputStream;
@@ -107,6 +109,7 @@ typedef struct DASHContext {
     const char *user_agent;
     int hls_playlist;
     int http_persistent;
+    int streaming;
     int master_playlist_created;
     AVIOContext *mpd_out;
     AVIOContext *m3u8_out;
@@ -950,7 +953,10 @@ static int dash_init(AVFormatContext *s)
         os->init_start_pos = 0;
 
         if (!strcmp(os->format_name, "mp4")) {
-            av_dict_set(&opts, "movflags", "frag_custom+dash+delay_moov", 0);
+            if (c->streaming)
+                av_dict_set(&opts, "movflags", "frag_custom+dash+delay_moov+frag_every_frame+skip_trailer", 0);
+            else
+                av_dict_set(&opts, "movflags", "frag_custom+dash+delay_moov", 0);
         } else {
             av_dict_set_int(&opts, "cluster_time_limit", c->min_seg_duration / 1000, 0);
             av_dict_set_int(&opts, "cluster_size_limit", 5 * 1024 * 1024, 0); // set a large cluster size limit
@@ -1112,13 +1118,86 @@ static int update_stream_extradata(AVFormatContext *s, OutputStream *os,
     return 0;
 }
 
+/**
+ * Return the size of the ftyp and moov atoms at the start of buf, or 0 if
+ * the moov atom has not been written yet.
+ */
+static int find_init_size(const uint8_t *buf, int size)
+{
+    int pos = 0;
+
+    while (size - pos >= 8) {
+        uint32_t atom_size = AV_RB32(buf + pos);
+        uint32_t tag       = AV_RL32(buf + pos + 4);
+        if (atom_size < 8 || atom_size > size - pos)
+            break;
+        pos += atom_size;
+        if (tag == MKTAG('m','o','o','v'))
+            return pos;
+    }
+    return 0;
+}
+
+/**
+ * In streaming mode, write out the chunks the mp4 muxer produced so far:
+ * the init segment once the moov has been written, then each moof/mdat pair
+ * to the current media segment, opening it along with its first chunk.
+ */
+static int write_chunks(AVFormatContext *s, OutputStream *os, int stream)
+{
+    DASHContext *c = s->priv_data;
+    uint8_t *buf;
+    int ret, size, init_size = 0;
+
+    size = avio_close_dyn_buf(os->ctx->pb, &buf);
+    os->ctx->pb = NULL;
+    if ((ret = avio_open_dyn_buf(&os->ctx->pb)) < 0)
+        goto end;
+
+    if (!os->init_range_length && size) {
+        init_size = find_init_size(buf, size);
+        if (!init_size) {
+            avio_write(os->ctx->pb, buf, size);
+            goto end;
+        }
+        avio_write(os->out, buf, init_size);
+        os->pos = os->init_range_length = init_size;
+        if (!c->single_file)
+            ff_format_io_close(s, &os->out);
+    }
+
+    if (size > init_size) {
+        if (!c->single_file && !os->chunks_len) {
+            AVDictionary *opts = NULL;
+            char full_path[1024];
+
+            ff_dash_fill_tmpl_params(os->chunks_file, sizeof(os->chunks_file), c->media_seg_name, stream, os->segment_index, os->bit_rate, os->start_pts);
+            snprintf(full_path, sizeof(full_path), "%s%s", c->dirname, os->chunks_file);
+            set_http_options(&opts, c);
+            ret = dashenc_io_open(s, &os->out, full_path, &opts);
+            av_dict_free(&opts);
+            if (ret < 0)
+                goto end;
+            write_styp(os->out);
+            os->chunks_len = 24;
+        }
+        avio_write(os->out, buf + init_size, size - init_size);
+        avio_flush(os->out);
+        os->chunks_len += size - init_size;
+    }
+
+end:
+    av_free(buf);
+    return ret;
+}
+
 static int dash_flush(AVFormatContext *s, int final, int stream)
 {
     DASHContext *c = s->priv_data;
     int i, ret = 0;
 
     const char *proto = avio_find_protocol_name(s->filename);
-    int use_rename = proto && !strcmp(proto, "file");
+    int use_rename = proto && !strcmp(proto, "file") && !c->streaming;
 
     int cur_flush_segment_index = 0;
     if (stream >= 0)
@@ -1149,7 +1228,12 @@ static int dash_flush(AVFormatContext *s, int final, int stream)
             flush_init_segment(s, os);
         }
 
-        if (!c->single_file) {
+        if (!c->single_file && os->chunks_len) {
+            // streaming mode, the segment was opened with its first chunk
+            av_strlcpy(filename, os->chunks_file, sizeof(filename));
+            snprintf(full_path, sizeof(full_path), "%s%s", c->dirname, filename);
+            av_strlcpy(temp_path, full_path, sizeof(temp_path));
+        } else if (!c->single_file) {
             AVDictionary *opts = NULL;
             ff_dash_fill_tmpl_params(filename, sizeof(filename), c->media_seg_name, i, os->segment_index, os->bit_rate, os->start_pts);
             snprintf(full_path, sizeof(full_path), "%s%s", c->dirname, filename);
@@ -1169,6 +1253,8 @@ static int dash_flush(AVFormatContext *s, int final, int stream)
         if (ret < 0)
             break;
         os->packets_written = 0;
+        range_length += os->chunks_len;
+        os->chunks_len = 0;
 
         if (c->single_file) {
             find_index_range(s, full_path, os->pos, &index_length);
@@ -1296,7 +1382,12 @@ static int dash_write_packet(AVFormatContext *s, AVPacket *pkt)
     else
         os->max_pts = FFMAX(os->max_pts, pkt->pts + pkt->duration);
     os->packets_written++;
-    return ff_write_chained(os->ctx, 0, pkt, s, 0);
+    if ((ret = ff_write_chained(os->ctx, 0, pkt, s, 0)) < 0)
+        return ret;
+
+    if (c->streaming && !strcmp(os->format_name, "mp4"))
+        return write_chunks(s, os, pkt->stream_index);
+    return 0;
 }
 
 static int dash_write_trailer(AVFormatContext *s)
@@ -1372,6 +1463,7 @@ static const AVOption options[] = {
     { "http_user_agent", "override User-Agent field in HTTP header", OFFSET(user_agent), AV_OPT_TYPE_STRING, {.str = NULL}, 0, 0, E},
     { "http_persistent", "Use persistent HTTP connections", OFFSET(http_persistent), AV_OPT_TYPE_BOOL, {.i64 = 0 }, 0, 1, E },
     { "hls_playlist", "Generate HLS playlist files(master.m3u8, media_%d.m3u8)", OFFSET(hls_playlist), AV_OPT_TYPE_BOOL, { .i64 = 0 }, 0, 1, E },
+    { "streaming", "Write each frame to the segment as a CMAF chunk as soon as it is complete", OFFSET(streaming), AV_OPT_TYPE_BOOL, { .i64 = 0 }, 0, 1, E },
     { NULL },
 };
 
@@ -38,6 +38,68 @@ enum PatternType {
     PT_DEFAULT
 };
 
+/**
+ * A file read or write executed by an ImgIOPool worker.
+ */
+typedef struct ImgIOJob {
+    int number;             ///< image number in the sequence
+    char filename[1024];    ///< file to read or write
+    char target[1024];      ///< if not empty, name to rename filename to once written
+    AVPacket pkt;           ///< data read, or data to write
+    int ret;                ///< result of the job
+} ImgIOJob;
+
+/**
+ * Pool of threads executing file reads or writes of an image sequence in
+ * the background, delivering their results in submission order.
+ */
+typedef struct ImgIOPool ImgIOPool;
+
+typedef int (ImgIOFunc)(AVFormatContext *s, ImgIOPool *p, ImgIOJob *job);
+
+/**
+ * Start nb_threads workers executing func on the submitted jobs, with at
+ * most queue_size jobs in flight.
+ */
+int ff_img_io_pool_init(ImgIOPool **pp, AVFormatContext *s, int nb_threads,
+                        int queue_size, ImgIOFunc *func);
+
+/**
+ * Stop the workers, drop the jobs not released yet and free the pool.
+ */
+void ff_img_io_pool_free(ImgIOPool **pp);
+
+/**
+ * Get the next job to fill in, or NULL if queue_size jobs are in flight.
+ * The job is only executed once ff_img_io_pool_submit() is called.
+ */
+ImgIOJob *ff_img_io_pool_get_free(ImgIOPool *p);
+
+void ff_img_io_pool_submit(ImgIOPool *p);
+
+/**
+ * Wait for the oldest job in flight to complete and return it, or return
+ * NULL if no job is in flight. The job stays owned by the caller until
+ * ff_img_io_pool_release() is called.
+ */
+ImgIOJob *ff_img_io_pool_wait(ImgIOPool *p);
+
+void ff_img_io_pool_release(ImgIOPool *p);
+
+/**
+ * Return the number of jobs in flight.
+ */
+int ff_img_io_pool_count(ImgIOPool *p);
+
+/**
+ * Open or close a file from a job. The io_open() and io_close() callbacks
+ * are not required to be thread-safe, so the pool runs them one at a time;
+ * only the reads and writes themselves run in parallel.
+ */
+int ff_img_io_open(ImgIOPool *p, AVIOContext **pb, const char *url, int flags);
+
+void ff_img_io_close(ImgIOPool *p, AVIOContext **pb);
+
 typedef struct VideoDemuxData {
     const AVClass *class;  /**< Class for private options. */
     int img_first;
@@ -61,6 +123,10 @@ typedef struct VideoDemuxData {
     int start_number_range;
     int frame_size;
     int ts_from_file;
+    int io_threads;
+    int io_queue_size;
+    ImgIOPool *io_pool;
+    int io_next;            /**< next image number to submit to io_pool */
 } VideoDemuxData;
 
 typedef struct IdStrMap {
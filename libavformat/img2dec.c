@@ -177,6 +177,79 @@ static int img_read_probe(AVProbeData *p)
     return 0;
 }
 
+static int get_filename(VideoDemuxData *s, char *buf, int buf_size, int number)
+{
+    if (s->pattern_type == PT_NONE) {
+        av_strlcpy(buf, s->path, buf_size);
+    } else if (s->use_glob) {
+#if HAVE_GLOB
+        av_strlcpy(buf, s->globstate.gl_pathv[number], buf_size);
+#endif
+    } else if (av_get_frame_filename(buf, buf_size, s->path, number) < 0 &&
+               number > 1) {
+        return AVERROR(EIO);
+    }
+    return 0;
+}
+
+static int set_file_timestamp(AVFormatContext *s1, AVPacket *pkt, const char *filename)
+{
+    VideoDemuxData *s = s1->priv_data;
+    struct stat img_stat;
+
+    if (stat(filename, &img_stat))
+        return AVERROR(EIO);
+    pkt->pts = (int64_t)img_stat.st_mtime;
+#if HAVE_STRUCT_STAT_ST_MTIM_TV_NSEC
+    if (s->ts_from_file == 2)
+        pkt->pts = 1000000000*pkt->pts + img_stat.st_mtim.tv_nsec;
+#endif
+    av_add_index_entry(s1->streams[0], s->img_number, pkt->pts, 0, 0, AVINDEX_KEYFRAME);
+    return 0;
+}
+
+static int read_file_job(AVFormatContext *s1, ImgIOPool *p, ImgIOJob *job)
+{
+    AVIOContext *pb;
+    int64_t size;
+    int ret;
+
+    if (ff_img_io_open(p, &pb, job->filename, AVIO_FLAG_READ) < 0) {
+        av_log(s1, AV_LOG_ERROR, "Could not open file : %s\n", job->filename);
+        return AVERROR(EIO);
+    }
+    size = avio_size(pb);
+    if (size < 0 || size > INT_MAX - AV_INPUT_BUFFER_PADDING_SIZE) {
+        ret = size < 0 ? size : AVERROR(ERANGE);
+    } else if ((ret = av_new_packet(&job->pkt, size)) >= 0) {
+        ret = avio_read(pb, job->pkt.data, size);
+        if (ret >= 0)
+            job->pkt.size = ret;
+        if (!ret)
+            ret = AVERROR_EOF;
+    }
+    ff_img_io_close(p, &pb);
+    return ret;
+}
+
+/**
+ * Keep the I/O pool filled with the files following the one to read next.
+ */
+static void fill_io_pool(VideoDemuxData *s)
+{
+    ImgIOJob *job;
+
+    while ((s->io_next <= s->img_last || s->loop) &&
+           (job = ff_img_io_pool_get_free(s->io_pool))) {
+        if (s->io_next > s->img_last)
+            s->io_next = s->img_first;
+        job->number = s->io_next++;
+        if (get_filename(s, job->filename, sizeof(job->filename), job->number) < 0)
+            job->filename[0] = 0;
+        ff_img_io_pool_submit(s->io_pool);
+    }
+}
+
 int ff_img_read_header(AVFormatContext *s1)
 {
     VideoDemuxData *s = s1->priv_data;
@@ -367,6 +440,64 @@ int ff_img_read_header(AVFormatContext *s1)
         pix_fmt != AV_PIX_FMT_NONE)
         st->codecpar->format = pix_fmt;
 
+    /* the codec must be known, files are not probed when read ahead, and
+     * the files are read whole */
+    if (s->io_threads && !s->is_pipe && !s->split_planes && !s1->pb &&
+        !s->frame_size && st->codecpar->codec_id != AV_CODEC_ID_NONE) {
+        int ret = ff_img_io_pool_init(&s->io_pool, s1, s->io_threads,
+                                      s->io_queue_size ? s->io_queue_size : 2 * s->io_threads,
+                                      read_file_job);
+        if (ret < 0) {
+            av_log(s1, AV_LOG_WARNING, "Could not start I/O threads, reading synchronously\n");
+        } else {
+            s->io_next = s->img_number;
+            fill_io_pool(s);
+        }
+    }
+
+    return 0;
+}
+
+static int read_packet_from_pool(AVFormatContext *s1, AVPacket *pkt)
+{
+    VideoDemuxData *s = s1->priv_data;
+    AVCodecParameters *par = s1->streams[0]->codecpar;
+    ImgIOJob *job;
+    int ret;
+
+    job = ff_img_io_pool_wait(s->io_pool);
+    if (!job || job->number != s->img_number) {
+        // seeked, drop the files read ahead
+        while (ff_img_io_pool_wait(s->io_pool))
+            ff_img_io_pool_release(s->io_pool);
+        s->io_next = s->img_number;
+        fill_io_pool(s);
+        job = ff_img_io_pool_wait(s->io_pool);
+    }
+    if (!job->filename[0]) {
+        ret = AVERROR(EIO);
+    } else if ((ret = job->ret) >= 0) {
+        av_packet_move_ref(pkt, &job->pkt);
+        if (s->ts_from_file)
+            ret = set_file_timestamp(s1, pkt, job->filename);
+    }
+    ff_img_io_pool_release(s->io_pool);
+    fill_io_pool(s);
+    if (ret < 0) {
+        av_packet_unref(pkt);
+        return ret;
+    }
+
+    if (par->codec_id == AV_CODEC_ID_RAWVIDEO && !par->width)
+        infer_size(&par->width, &par->height, pkt->size);
+    pkt->stream_index = 0;
+    pkt->flags       |= AV_PKT_FLAG_KEY;
+    if (!s->ts_from_file)
+        pkt->pts = s->pts;
+
+    s->img_count++;
+    s->img_number++;
+    s->pts++;
     return 0;
 }
 
@@ -387,18 +518,10 @@ int ff_img_read_packet(AVFormatContext *s1, AVPacket *pkt)
         }
         if (s->img_number > s->img_last)
             return AVERROR_EOF;
-        if (s->pattern_type == PT_NONE) {
-            av_strlcpy(filename_bytes, s->path, sizeof(filename_bytes));
-        } else if (s->use_glob) {
-#if HAVE_GLOB
-            filename = s->globstate.gl_pathv[s->img_number];
-#endif
-        } else {
-        if (av_get_frame_filename(filename_bytes, sizeof(filename_bytes),
-                                  s->path,
-                                  s->img_number) < 0 && s->img_number > 1)
+        if (s->io_pool)
+            return read_packet_from_pool(s1, pkt);
+        if (get_filename(s, filename_bytes, sizeof(filename_bytes), s->img_number) < 0)
             return AVERROR(EIO);
-        }
         for (i = 0; i < 3; i++) {
             if (s1->pb &&
                 !strcmp(filename_bytes, s->path) &&
@@ -464,17 +587,8 @@ int ff_img_read_packet(AVFormatContext *s1, AVPacket *pkt)
     pkt->stream_index = 0;
     pkt->flags       |= AV_PKT_FLAG_KEY;
     if (s->ts_from_file) {
-        struct stat img_stat;
-        if (stat(filename, &img_stat)) {
-            res = AVERROR(EIO);
+        if ((res = set_file_timestamp(s1, pkt, filename)) < 0)
             goto fail;
-        }
-        pkt->pts = (int64_t)img_stat.st_mtime;
-#if HAVE_STRUCT_STAT_ST_MTIM_TV_NSEC
-        if (s->ts_from_file == 2)
-            pkt->pts = 1000000000*pkt->pts + img_stat.st_mtim.tv_nsec;
-#endif
-        av_add_index_entry(s1->streams[0], s->img_number, pkt->pts, 0, 0, AVINDEX_KEYFRAME);
     } else if (!s->is_pipe) {
         pkt->pts      = s->pts;
     }
@@ -530,8 +644,9 @@ fail:
 
 static int img_read_close(struct AVFormatContext* s1)
 {
-#if HAVE_GLOB
     VideoDemuxData *s = s1->priv_data;
+    ff_img_io_pool_free(&s->io_pool);
+#if HAVE_GLOB
     if (s->use_glob) {
         globfree(&s->globstate);
     }
@@ -580,6 +695,8 @@ const AVOption ff_img_options[] = {
     { "none", "none",                   0, AV_OPT_TYPE_CONST,    {.i64 = 0   }, 0, 2,       DEC, "ts_type" },
     { "sec",  "second precision",       0, AV_OPT_TYPE_CONST,    {.i64 = 1   }, 0, 2,       DEC, "ts_type" },
     { "ns",   "nano second precision",  0, AV_OPT_TYPE_CONST,    {.i64 = 2   }, 0, 2,       DEC, "ts_type" },
+    { "io_threads",    "set number of threads reading files ahead", OFFSET(io_threads), AV_OPT_TYPE_INT, {.i64 = 0 }, 0, 64, DEC },
+    { "io_queue_size", "set maximum number of files read ahead (default 2 * io_threads)", OFFSET(io_queue_size), AV_OPT_TYPE_INT, {.i64 = 0 }, 0, 1024, DEC },
     { NULL },
 };
 
@@ -45,8 +45,29 @@ typedef struct VideoMuxData {
     int frame_pts;
     const char *muxer;
     int use_rename;
+    int io_threads;
+    int io_queue_size;
+    ImgIOPool *io_pool;
 } VideoMuxData;
 
+static int write_file_job(AVFormatContext *s, ImgIOPool *p, ImgIOJob *job)
+{
+    AVIOContext *pb;
+    int ret;
+
+    if (ff_img_io_open(p, &pb, job->filename, AVIO_FLAG_WRITE) < 0) {
+        av_log(s, AV_LOG_ERROR, "Could not open file : %s\n", job->filename);
+        return AVERROR(EIO);
+    }
+    avio_write(pb, job->pkt.data, job->pkt.size);
+    avio_flush(pb);
+    ret = pb->error;
+    ff_img_io_close(p, &pb);
+    if (ret >= 0 && job->target[0])
+        ret = ff_rename(job->filename, job->target, s);
+    return ret;
+}
+
 static int write_header(AVFormatContext *s)
 {
     VideoMuxData *img = s->priv_data;
@@ -75,6 +96,53 @@ static int write_header(AVFormatContext *s)
                              && desc->nb_components >= 3;
     }
 
+    /* with update, the same file is rewritten and writes must stay in order */
+    if (img->io_threads && !img->is_pipe && !img->split_planes && !img->muxer &&
+        !img->update) {
+        int ret = ff_img_io_pool_init(&img->io_pool, s, img->io_threads,
+                                      img->io_queue_size ? img->io_queue_size : 2 * img->io_threads,
+                                      write_file_job);
+        if (ret < 0)
+            av_log(s, AV_LOG_WARNING, "Could not start I/O threads, writing synchronously\n");
+    }
+
+    return 0;
+}
+
+/**
+ * Release the oldest write in flight, returning its result.
+ */
+static int release_write(VideoMuxData *img)
+{
+    ImgIOJob *job = ff_img_io_pool_wait(img->io_pool);
+    int ret = job->ret;
+
+    ff_img_io_pool_release(img->io_pool);
+    return ret;
+}
+
+static int write_packet_to_pool(AVFormatContext *s, AVPacket *pkt, const char *filename)
+{
+    VideoMuxData *img = s->priv_data;
+    ImgIOJob *job;
+    int ret;
+
+    while (!(job = ff_img_io_pool_get_free(img->io_pool)))
+        if ((ret = release_write(img)) < 0)
+            return ret;
+
+    if (img->use_rename) {
+        snprintf(job->filename, sizeof(job->filename), "%s.tmp", filename);
+        av_strlcpy(job->target, filename, sizeof(job->target));
+    } else {
+        av_strlcpy(job->filename, filename, sizeof(job->filename));
+        job->target[0] = 0;
+    }
+    if ((ret = av_packet_ref(&job->pkt, pkt)) < 0)
+        return ret;
+    ff_img_io_pool_submit(img->io_pool);
+
+    img->img_number++;
     return 0;
 }
 
@@ -114,6 +182,8 @@ static int write_packet(AVFormatContext *s, AVPacket *pkt)
                    img->img_number, img->path);
             return AVERROR(EINVAL);
         }
+        if (img->io_pool)
+            return write_packet_to_pool(s, pkt, filename);
         for (i = 0; i < 4; i++) {
             snprintf(img->tmp[i], sizeof(img->tmp[i]), "%s.tmp", filename);
             av_strlcpy(img->target[i], filename, sizeof(img->target[i]));
@@ -195,6 +265,27 @@ static int write_packet(AVFormatContext *s, AVPacket *pkt)
     return 0;
 }
 
+static int write_trailer(AVFormatContext *s)
+{
+    VideoMuxData *img = s->priv_data;
+    int ret = 0;
+
+    if (img->io_pool) {
+        while (ff_img_io_pool_count(img->io_pool)) {
+            int err = release_write(img);
+            if (ret >= 0)
+                ret = err;
+        }
+    }
+    return ret;
+}
+
+static void deinit(AVFormatContext *s)
+{
+    VideoMuxData *img = s->priv_data;
+    ff_img_io_pool_free(&img->io_pool);
+}
+
 static int query_codec(enum AVCodecID id, int std_compliance)
 {
     int i;
@@ -214,6 +305,8 @@ static const AVOption muxoptions[] = {
     { "strftime",     "use strftime for filename", OFFSET(use_strftime),  AV_OPT_TYPE_BOOL, { .i64 = 0 }, 0, 1, ENC },
     { "frame_pts",    "use current frame pts for filename", OFFSET(frame_pts),  AV_OPT_TYPE_BOOL, { .i64 = 0 }, 0, 1, ENC },
     { "atomic_writing", "write files atomically (using temporary files and renames)", OFFSET(use_rename), AV_OPT_TYPE_BOOL, { .i64 = 0 }, 0, 1, ENC },
+    { "io_threads",   "set number of threads writing files", OFFSET(io_threads), AV_OPT_TYPE_INT, { .i64 = 0 }, 0, 64, ENC },
+    { "io_queue_size", "set maximum number of writes in flight (default 2 * io_threads)", OFFSET(io_queue_size), AV_OPT_TYPE_INT, { .i64 = 0 }, 0, 1024, ENC },
     { NULL },
 };
 
@@ -235,6 +328,8 @@ AVOutputFormat ff_image2_muxer = {
     .video_codec    = AV_CODEC_ID_MJPEG,
     .write_header   = write_header,
     .write_packet   = write_packet,
+    .write_trailer  = write_trailer,
+    .deinit         = deinit,
     .query_codec    = query_codec,
     .flags          = AVFMT_NOTIMESTAMPS | AVFMT_NODIMENSIONS | AVFMT_NOFILE,
     .priv_class     = &img2mux_class,
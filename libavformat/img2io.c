@@ -0,0 +1,315 @@
+/*
+ * Image sequence I/O worker pool
+ *
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "config.h"
+
+#if HAVE_PTHREADS
+#include <pthread.h>
+#endif
+
+#include "libavutil/avassert.h"
+#include "libavutil/mem.h"
+#include "libavutil/time.h"
+#include "img2.h"
+#include "internal.h"
+
+#if HAVE_PTHREADS
+
+enum ImgIOJobState {
+    JOB_FREE,
+    JOB_PENDING,
+    JOB_RUNNING,
+    JOB_DONE,
+};
+
+struct ImgIOPool {
+    AVFormatContext *s;
+    ImgIOFunc *func;
+
+    ImgIOJob *jobs;
+    int *state;
+    int nb_jobs;
+    int head;           ///< oldest job, the next one to be delivered
+    int count;          ///< number of submitted jobs not released yet
+
+    pthread_t *threads;
+    int nb_threads;
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    int exit;
+
+    pthread_mutex_t io_mutex;   ///< serializes the io_open()/io_close() calls
+
+    /* statistics */
+    int64_t nb_delivered;
+    int64_t nb_stalls;
+    int64_t stall_time;
+    int64_t depth_sum;
+};
+
+static void *worker(void *arg)
+{
+    ImgIOPool *p = arg;
+
+    pthread_mutex_lock(&p->mutex);
+    while (!p->exit) {
+        int i, idx = -1;
+
+        for (i = 0; i < p->count; i++) {
+            int j = (p->head + i) % p->nb_jobs;
+            if (p->state[j] == JOB_PENDING) {
+                idx = j;
+                break;
+            }
+        }
+        if (idx < 0) {
+            pthread_cond_wait(&p->cond, &p->mutex);
+            continue;
+        }
+
+        p->state[idx] = JOB_RUNNING;
+        pthread_mutex_unlock(&p->mutex);
+        p->jobs[idx].ret = p->func(p->s, p, &p->jobs[idx]);
+        pthread_mutex_lock(&p->mutex);
+        p->state[idx] = JOB_DONE;
+        pthread_cond_broadcast(&p->cond);
+    }
+    pthread_mutex_unlock(&p->mutex);
+    return NULL;
+}
+
+int ff_img_io_pool_init(ImgIOPool **pp, AVFormatContext *s, int nb_threads,
+                        int queue_size, ImgIOFunc *func)
+{
+    ImgIOPool *p;
+    int i, ret;
+
+    av_assert0(nb_threads > 0);
+
+    p = av_mallocz(sizeof(*p));
+    if (!p)
+        return AVERROR(ENOMEM);
+    p->s       = s;
+    p->func    = func;
+    p->nb_jobs = FFMAX(queue_size, nb_threads);
+    p->jobs    = av_mallocz_array(p->nb_jobs, sizeof(*p->jobs));
+    p->state   = av_mallocz_array(p->nb_jobs, sizeof(*p->state));
+    p->threads = av_mallocz_array(nb_threads, sizeof(*p->threads));
+    if (!p->jobs || !p->state || !p->threads) {
+        ret = AVERROR(ENOMEM);
+        goto fail;
+    }
+    for (i = 0; i < p->nb_jobs; i++)
+        av_init_packet(&p->jobs[i].pkt);
+
+    if ((ret = pthread_mutex_init(&p->mutex, NULL))) {
+        ret = AVERROR(ret);
+        goto fail;
+    }
+    if ((ret = pthread_cond_init(&p->cond, NULL))) {
+        pthread_mutex_destroy(&p->mutex);
+        ret = AVERROR(ret);
+        goto fail;
+    }
+    if ((ret = pthread_mutex_init(&p->io_mutex, NULL))) {
+        pthread_cond_destroy(&p->cond);
+        pthread_mutex_destroy(&p->mutex);
+        ret = AVERROR(ret);
+        goto fail;
+    }
+    for (; p->nb_threads < nb_threads; p->nb_threads++) {
+        if ((ret = pthread_create(&p->threads[p->nb_threads], NULL, worker, p))) {
+            av_log(s, AV_LOG_ERROR, "pthread_create failed : %s\n", strerror(ret));
+            ff_img_io_pool_free(&p);
+            return AVERROR(ret);
+        }
+    }
+
+    *pp = p;
+    return 0;
+
+fail:
+    av_freep(&p->jobs);
+    av_freep(&p->state);
+    av_freep(&p->threads);
+    av_freep(&p);
+    return ret;
+}
+
+void ff_img_io_pool_free(ImgIOPool **pp)
+{
+    ImgIOPool *p = *pp;
+    int i;
+
+    if (!p)
+        return;
+
+    pthread_mutex_lock(&p->mutex);
+    p->exit = 1;
+    pthread_cond_broadcast(&p->cond);
+    pthread_mutex_unlock(&p->mutex);
+    for (i = 0; i < p->nb_threads; i++)
+        pthread_join(p->threads[i], NULL);
+    pthread_cond_destroy(&p->cond);
+    pthread_mutex_destroy(&p->mutex);
+    pthread_mutex_destroy(&p->io_mutex);
+
+    if (p->nb_delivered)
+        av_log(p->s, AV_LOG_VERBOSE,
+               "I/O pool: %"PRId64" files, average queue depth %.2f, "
+               "%"PRId64" stalls, %.3f s stalled\n",
+               p->nb_delivered, (double)p->depth_sum / p->nb_delivered,
+               p->nb_stalls, p->stall_time / 1000000.0);
+
+    for (i = 0; i < p->nb_jobs; i++)
+        av_packet_unref(&p->jobs[i].pkt);
+    av_freep(&p->jobs);
+    av_freep(&p->state);
+    av_freep(&p->threads);
+    av_freep(pp);
+}
+
+ImgIOJob *ff_img_io_pool_get_free(ImgIOPool *p)
+{
+    ImgIOJob *job = NULL;
+
+    pthread_mutex_lock(&p->mutex);
+    if (p->count < p->nb_jobs) {
+        job = &p->jobs[(p->head + p->count) % p->nb_jobs];
+        av_packet_unref(&job->pkt);
+        job->ret = 0;
+    }
+    pthread_mutex_unlock(&p->mutex);
+    return job;
+}
+
+void ff_img_io_pool_submit(ImgIOPool *p)
+{
+    pthread_mutex_lock(&p->mutex);
+    av_assert0(p->count < p->nb_jobs);
+    p->state[(p->head + p->count++) % p->nb_jobs] = JOB_PENDING;
+    pthread_cond_signal(&p->cond);
+    pthread_mutex_unlock(&p->mutex);
+}
+
+ImgIOJob *ff_img_io_pool_wait(ImgIOPool *p)
+{
+    ImgIOJob *job = NULL;
+
+    pthread_mutex_lock(&p->mutex);
+    if (p->count) {
+        if (p->state[p->head] != JOB_DONE) {
+            int64_t t = av_gettime_relative();
+            while (p->state[p->head] != JOB_DONE)
+                pthread_cond_wait(&p->cond, &p->mutex);
+            p->stall_time += av_gettime_relative() - t;
+            p->nb_stalls++;
+        }
+        p->depth_sum += p->count;
+        p->nb_delivered++;
+        job = &p->jobs[p->head];
+    }
+    pthread_mutex_unlock(&p->mutex);
+    return job;
+}
+
+void ff_img_io_pool_release(ImgIOPool *p)
+{
+    pthread_mutex_lock(&p->mutex);
+    av_assert0(p->count && p->state[p->head] == JOB_DONE);
+    av_packet_unref(&p->jobs[p->head].pkt);
+    p->state[p->head] = JOB_FREE;
+    p->head = (p->head + 1) % p->nb_jobs;
+    p->count--;
+    pthread_mutex_unlock(&p->mutex);
+}
+
+int ff_img_io_pool_count(ImgIOPool *p)
+{
+    int count;
+
+    pthread_mutex_lock(&p->mutex);
+    count = p->count;
+    pthread_mutex_unlock(&p->mutex);
+    return count;
+}
+
+int ff_img_io_open(ImgIOPool *p, AVIOContext **pb, const char *url, int flags)
+{
+    int ret;
+
+    pthread_mutex_lock(&p->io_mutex);
+    ret = p->s->io_open(p->s, pb, url, flags, NULL);
+    pthread_mutex_unlock(&p->io_mutex);
+    return ret;
+}
+
+void ff_img_io_close(ImgIOPool *p, AVIOContext **pb)
+{
+    pthread_mutex_lock(&p->io_mutex);
+    ff_format_io_close(p->s, pb);
+    pthread_mutex_unlock(&p->io_mutex);
+}
+
+#else
+
+int ff_img_io_pool_init(ImgIOPool **pp, AVFormatContext *s, int nb_threads,
+                        int queue_size, ImgIOFunc *func)
+{
+    return AVERROR(ENOSYS);
+}
+
+void ff_img_io_pool_free(ImgIOPool **pp)
+{
+}
+
+ImgIOJob *ff_img_io_pool_get_free(ImgIOPool *p)
+{
+    return NULL;
+}
+
+void ff_img_io_pool_submit(ImgIOPool *p)
+{
+}
+
+ImgIOJob *ff_img_io_pool_wait(ImgIOPool *p)
+{
+    return NULL;
+}
+
+void ff_img_io_pool_release(ImgIOPool *p)
+{
+}
+
+int ff_img_io_pool_count(ImgIOPool *p)
+{
+    return 0;
+}
+
+int ff_img_io_open(ImgIOPool *p, AVIOContext **pb, const char *url, int flags)
+{
+    return AVERROR(ENOSYS);
+}
+
+void ff_img_io_close(ImgIOPool *p, AVIOContext **pb)
+{
+}
+
+#endif /* HAVE_PTHREADS */
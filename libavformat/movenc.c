@@ -78,6 +78,8 @@ static const AVOption options[] = {
     { "use_metadata_tags", "Use mdta atom for metadata.", 0, AV_OPT_TYPE_CONST, {.i64 = FF_MOV_FLAG_USE_MDTA}, INT_MIN, INT_MAX, AV_OPT_FLAG_ENCODING_PARAM, "movflags" },
     { "skip_trailer", "Skip writing the mfra/tfra/mfro trailer for fragmented files", 0, AV_OPT_TYPE_CONST, {.i64 = FF_MOV_FLAG_SKIP_TRAILER}, INT_MIN, INT_MAX, AV_OPT_FLAG_ENCODING_PARAM, "movflags" },
     { "negative_cts_offsets", "Use negative CTS offsets (reducing the need for edit lists)", 0, AV_OPT_TYPE_CONST, {.i64 = FF_MOV_FLAG_NEGATIVE_CTS_OFFSETS}, INT_MIN, INT_MAX, AV_OPT_FLAG_ENCODING_PARAM, "movflags" },
+    { "reserve_moov", "Reserve estimated space for the moov atom at the beginning of the file", 0, AV_OPT_TYPE_CONST, {.i64 = FF_MOV_FLAG_RESERVE_MOOV}, INT_MIN, INT_MAX, AV_OPT_FLAG_ENCODING_PARAM, "movflags" },
+    { "frag_every_frame", "Fragment at every frame, writing CMAF chunks", 0, AV_OPT_TYPE_CONST, {.i64 = FF_MOV_FLAG_FRAG_EVERY_FRAME}, INT_MIN, INT_MAX, AV_OPT_FLAG_ENCODING_PARAM, "movflags" },
     FF_RTP_FLAG_OPTS(MOVMuxContext, rtp_flags),
     { "skip_iods", "Skip writing iods atom.", offsetof(MOVMuxContext, iods_skip), AV_OPT_TYPE_BOOL, {.i64 = 1}, 0, 1, AV_OPT_FLAG_ENCODING_PARAM},
     { "iods_audio_profile", "iods audio profile atom.", offsetof(MOVMuxContext, iods_audio_profile), AV_OPT_TYPE_INT, {.i64 = -1}, -1, 255, AV_OPT_FLAG_ENCODING_PARAM},
@@ -4470,7 +4472,9 @@ static int mov_write_moof_tag(AVIOContext *pb, MOVMuxContext *mov, int tracks,
     mov_write_moof_tag_internal(avio_buf, mov, tracks, 0);
     moof_size = ffio_close_null_buf(avio_buf);
 
-    if (mov->flags & FF_MOV_FLAG_DASH && !(mov->flags & FF_MOV_FLAG_GLOBAL_SIDX))
+    /* chunks are plain moof+mdat pairs, only index whole fragments */
+    if (mov->flags & FF_MOV_FLAG_DASH &&
+        !(mov->flags & (FF_MOV_FLAG_GLOBAL_SIDX | FF_MOV_FLAG_FRAG_EVERY_FRAME)))
         mov_write_sidx_tags(pb, mov, tracks, moof_size + 8 + mdat_size);
 
     if (mov->flags & FF_MOV_FLAG_GLOBAL_SIDX ||
@@ -5432,7 +5436,8 @@ static int mov_write_single_packet(AVFormatContext *s, AVPacket *pkt)
              (mov->max_fragment_size && mov->mdat_size + size >= mov->max_fragment_size) ||
              (mov->flags & FF_MOV_FLAG_FRAG_KEYFRAME &&
               par->codec_type == AVMEDIA_TYPE_VIDEO &&
-              trk->entry && pkt->flags & AV_PKT_FLAG_KEY)) {
+              trk->entry && pkt->flags & AV_PKT_FLAG_KEY) ||
+             (mov->flags & FF_MOV_FLAG_FRAG_EVERY_FRAME && trk->entry)) {
             if (frag_duration >= mov->min_fragment_duration) {
                 // Set the duration of this track to line up with the next
                 // sample in this track. This avoids relying on AVPacket
@@ -5448,7 +5453,16 @@ static int mov_write_single_packet(AVFormatContext *s, AVPacket *pkt)
             }
         }
 
-        return ff_mov_write_packet(s, pkt);
+        if ((ret = ff_mov_write_packet(s, pkt)) < 0)
+            return ret;
+
+        // When the duration of the frame is known, its chunk can be
+        // written out right away instead of when the next frame arrives.
+        if (mov->flags & FF_MOV_FLAG_FRAG_EVERY_FRAME && pkt->duration > 0) {
+            trk->end_reliable = 1;
+            return mov_auto_flush_fragment(s, 0);
+        }
+        return 0;
 }
 
 static int mov_write_subtitle_end_packet(AVFormatContext *s,
@@ -5845,6 +5859,71 @@ static int mov_create_dvd_sub_decoder_specific_info(MOVTrack *track,
     return 0;
 }
 
+/*
+ * Estimate an upper bound of the final moov size from the stream parameters
+ * and the duration hints set by the caller, so that it can be reserved at the
+ * beginning of the file. The sample tables are assumed to need one entry per
+ * sample in every table and one chunk per sample. Returns 0 if the duration
+ * of any stream is unknown.
+ */
+static int mov_estimate_moov_size(AVFormatContext *s)
+{
+    MOVMuxContext *mov = s->priv_data;
+    AVDictionaryEntry *t = NULL;
+    int64_t size = 4096; /* ftyp-independent fixed atoms: mvhd, iods, udta */
+    int i;
+
+    if (mov->flags & FF_MOV_FLAG_RTP_HINT)
+        return 0;
+
+    while ((t = av_dict_get(s->metadata, "", t, AV_DICT_IGNORE_SUFFIX)))
+        size += strlen(t->key) + strlen(t->value) + 32;
+    size += s->nb_chapters * 256;
+
+    for (i = 0; i < s->nb_streams; i++) {
+        AVStream *st = s->streams[i];
+        AVCodecParameters *par = st->codecpar;
+        int64_t duration = st->duration > 0 ?
+            av_rescale_q(st->duration, st->time_base, AV_TIME_BASE_Q) : s->duration;
+        int64_t nb_samples;
+        int entry_size = 4 + 8; /* stsz, co64 */
+
+        if (duration <= 0 || duration == AV_NOPTS_VALUE)
+            return 0;
+
+        switch (par->codec_type) {
+        case AVMEDIA_TYPE_VIDEO: {
+            AVRational rate = st->avg_frame_rate;
+            if (rate.num <= 0 || rate.den <= 0)
+                rate = av_inv_q(st->time_base);
+            nb_samples  = av_rescale(duration, rate.num, (int64_t)rate.den * AV_TIME_BASE);
+            entry_size += 8 + 8 + 4; /* stts, ctts, stss */
+            break;
+        }
+        case AVMEDIA_TYPE_AUDIO: {
+            int frame_size = par->frame_size > 0 ? par->frame_size : 1024;
+            if (par->sample_rate <= 0)
+                return 0;
+            nb_samples  = av_rescale(duration, par->sample_rate, (int64_t)frame_size * AV_TIME_BASE);
+            entry_size += 8; /* stts */
+            break;
+        }
+        default:
+            /* subtitles and data, assume at most ten samples per second */
+            nb_samples  = av_rescale(duration, 10, AV_TIME_BASE);
+            entry_size += 8;
+            break;
+        }
+
+        /* trak, tkhd, mdia, minf, stsd with extradata, edts, tref, udta */
+        size += 2048 + par->extradata_size + (nb_samples + 1) * entry_size;
+        if (size > INT_MAX)
+            return 0;
+    }
+
+    return size;
+}
+
 static int mov_init(AVFormatContext *s)
 {
     MOVMuxContext *mov = s->priv_data;
@@ -5874,7 +5953,8 @@ static int mov_init(AVFormatContext *s)
     if (mov->max_fragment_duration || mov->max_fragment_size ||
         mov->flags & (FF_MOV_FLAG_EMPTY_MOOV |
                       FF_MOV_FLAG_FRAG_KEYFRAME |
-                      FF_MOV_FLAG_FRAG_CUSTOM))
+                      FF_MOV_FLAG_FRAG_CUSTOM |
+                      FF_MOV_FLAG_FRAG_EVERY_FRAME))
         mov->flags |= FF_MOV_FLAG_FRAGMENT;
 
     /* Set other implicit flags immediately */
@@ -5890,7 +5970,18 @@ static int mov_init(AVFormatContext *s)
         s->flags &= ~AVFMT_FLAG_AUTO_BSF;
     }
 
-    if (mov->flags & FF_MOV_FLAG_FASTSTART) {
+    if (mov->flags & FF_MOV_FLAG_RESERVE_MOOV && !mov->reserved_moov_size &&
+        !(mov->flags & FF_MOV_FLAG_FRAGMENT)) {
+        mov->reserved_moov_size = mov_estimate_moov_size(s);
+        if (mov->reserved_moov_size)
+            av_log(s, AV_LOG_VERBOSE, "Reserving %d bytes for the moov atom\n",
+                   mov->reserved_moov_size);
+        else
+            av_log(s, AV_LOG_WARNING, "Unable to estimate the moov size, "
+                   "stream durations are unknown\n");
+    }
+
+    if (mov->flags & FF_MOV_FLAG_FASTSTART && mov->reserved_moov_size < 8) {
         mov->reserved_moov_size = -1;
     }
 
@@ -6226,19 +6317,23 @@ static int mov_write_header(AVFormatContext *s)
 
     if (mov->reserved_moov_size){
         mov->reserved_header_pos = avio_tell(pb);
-        if (mov->reserved_moov_size > 0)
+        if (mov->reserved_moov_size >= 8) {
+            /* keep the file valid until the moov replaces this placeholder */
+            avio_wb32(pb, mov->reserved_moov_size);
+            ffio_wfourcc(pb, "free");
+            ffio_fill(pb, 0, mov->reserved_moov_size - 8);
+        } else if (mov->reserved_moov_size > 0)
             avio_skip(pb, mov->reserved_moov_size);
     }
 
     if (mov->flags & FF_MOV_FLAG_FRAGMENT) {
         /* If no fragmentation options have been set, set a default. */
         if (!(mov->flags & (FF_MOV_FLAG_FRAG_KEYFRAME |
-                            FF_MOV_FLAG_FRAG_CUSTOM)) &&
+                            FF_MOV_FLAG_FRAG_CUSTOM |
+                            FF_MOV_FLAG_FRAG_EVERY_FRAME)) &&
             !mov->max_fragment_duration && !mov->max_fragment_size)
             mov->flags |= FF_MOV_FLAG_FRAG_KEYFRAME;
     } else {
-        if (mov->flags & FF_MOV_FLAG_FASTSTART)
-            mov->reserved_header_pos = avio_tell(pb);
         mov_write_mdat_tag(pb, mov);
     }
 
@@ -6332,8 +6427,11 @@ static int get_sidx_size(AVFormatContext *s)
  * offset table can switch between stco (32-bit entries) to co64 (64-bit
  * entries) when the moov is moved to the beginning, so the size of the moov
  * would change. It also updates the chunk offset tables.
+ * If space was reserved for the moov but is too small, the moov reuses it and
+ * only the remaining part has to be inserted; *reused is set to the number of
+ * reserved bytes taken over.
  */
-static int compute_moov_size(AVFormatContext *s)
+static int compute_moov_size(AVFormatContext *s, int *reused)
 {
     int i, moov_size, moov_size2;
     MOVMuxContext *mov = s->priv_data;
@@ -6342,8 +6440,12 @@ static int compute_moov_size(AVFormatContext *s)
     if (moov_size < 0)
         return moov_size;
 
+    *reused = 0;
+    if (mov->reserved_moov_size > 0 && moov_size > mov->reserved_moov_size)
+        *reused = mov->reserved_moov_size;
+
     for (i = 0; i < mov->nb_streams; i++)
-        mov->tracks[i].data_offset += moov_size;
+        mov->tracks[i].data_offset += moov_size - *reused;
 
     moov_size2 = get_moov_size(s);
     if (moov_size2 < 0)
@@ -6375,7 +6477,7 @@ static int compute_sidx_size(AVFormatContext *s)
 
 static int shift_data(AVFormatContext *s)
 {
-    int ret = 0, moov_size;
+    int ret = 0, moov_size, reused = 0;
     MOVMuxContext *mov = s->priv_data;
     int64_t pos, pos_end = avio_tell(s->pb);
     uint8_t *buf, *read_buf[2];
@@ -6386,7 +6488,7 @@ static int shift_data(AVFormatContext *s)
     if (mov->flags & FF_MOV_FLAG_FRAGMENT)
         moov_size = compute_sidx_size(s);
     else
-        moov_size = compute_moov_size(s);
+        moov_size = compute_moov_size(s, &reused);
     if (moov_size < 0)
         return moov_size;
 
@@ -6412,8 +6514,10 @@ static int shift_data(AVFormatContext *s)
     pos_end = avio_tell(s->pb);
     avio_seek(s->pb, mov->reserved_header_pos + moov_size, SEEK_SET);
 
-    /* start reading at where the new moov will be placed */
-    avio_seek(read_pb, mov->reserved_header_pos, SEEK_SET);
+    /* start reading at where the new moov will be placed, past the part of
+     * the reserved space it takes over; the data is shifted by at most
+     * moov_size bytes, so reading it by chunks of moov_size is safe */
+    avio_seek(read_pb, mov->reserved_header_pos + reused, SEEK_SET);
     pos = avio_tell(read_pb);
 
 #define READ_BLOCK do {                                                             \
@@ -6445,7 +6549,7 @@ static int mov_write_trailer(AVFormatContext *s)
     AVIOContext *pb = s->pb;
     int res = 0;
     int i;
-    int64_t moov_pos;
+    int64_t moov_pos, size = 0;
 
     if (mov->need_rewrite_extradata) {
         for (i = 0; i < s->nb_streams; i++) {
@@ -6503,26 +6607,44 @@ static int mov_write_trailer(AVFormatContext *s)
         }
         avio_seek(pb, mov->reserved_moov_size > 0 ? mov->reserved_header_pos : moov_pos, SEEK_SET);
 
-        if (mov->flags & FF_MOV_FLAG_FASTSTART) {
+        if (mov->reserved_moov_size > 0) {
+            if ((res = get_moov_size(s)) < 0)
+                return res;
+            size = mov->reserved_moov_size - res;
+        }
+
+        if (mov->flags & FF_MOV_FLAG_FASTSTART &&
+            (mov->reserved_moov_size <= 0 || (size && size < 8))) {
+            if (mov->reserved_moov_size > 0)
+                av_log(s, AV_LOG_INFO, "Reserved moov space is too small, %"PRId64" more bytes needed\n", 8 - size);
             av_log(s, AV_LOG_INFO, "Starting second pass: moving the moov atom to the beginning of the file\n");
+            avio_seek(pb, moov_pos, SEEK_SET);
             res = shift_data(s);
             if (res < 0)
                 return res;
             avio_seek(pb, mov->reserved_header_pos, SEEK_SET);
             if ((res = mov_write_moov_tag(pb, mov, s)) < 0)
                 return res;
-        } else if (mov->reserved_moov_size > 0) {
-            int64_t size;
+        } else if (mov->reserved_moov_size > 0 && size && size < 8 &&
+                   mov->flags & FF_MOV_FLAG_RESERVE_MOOV) {
+            /* the reserved space is left as a free atom */
+            av_log(s, AV_LOG_WARNING, "Reserved moov space is too small, %"PRId64" more bytes needed, "
+                   "writing the moov atom at the end of the file\n", 8 - size);
+            avio_seek(pb, moov_pos, SEEK_SET);
             if ((res = mov_write_moov_tag(pb, mov, s)) < 0)
                 return res;
-            size = mov->reserved_moov_size - (avio_tell(pb) - mov->reserved_header_pos);
-            if (size < 8){
+        } else if (mov->reserved_moov_size > 0) {
+            if (size && size < 8){
                 av_log(s, AV_LOG_ERROR, "reserved_moov_size is too small, needed %"PRId64" additional\n", 8-size);
                 return AVERROR(EINVAL);
             }
-            avio_wb32(pb, size);
-            ffio_wfourcc(pb, "free");
-            ffio_fill(pb, 0, size - 8);
+            if ((res = mov_write_moov_tag(pb, mov, s)) < 0)
+                return res;
+            if (size) {
+                avio_wb32(pb, size);
+                ffio_wfourcc(pb, "free");
+                ffio_fill(pb, 0, size - 8);
+            }
             avio_seek(pb, moov_pos, SEEK_SET);
         } else {
             if ((res = mov_write_moov_tag(pb, mov, s)) < 0)
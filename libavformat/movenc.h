@@ -245,6 +245,8 @@ typedef struct MOVMuxContext {
 #define FF_MOV_FLAG_USE_MDTA              (1 << 17)
 #define FF_MOV_FLAG_SKIP_TRAILER          (1 << 18)
 #define FF_MOV_FLAG_NEGATIVE_CTS_OFFSETS  (1 << 19)
+#define FF_MOV_FLAG_RESERVE_MOOV          (1 << 20)
+#define FF_MOV_FLAG_FRAG_EVERY_FRAME      (1 << 21)
 
 int ff_mov_write_packet(AVFormatContext *s, AVPacket *pkt);
 
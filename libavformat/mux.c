@@ -36,6 +36,7 @@
 #include "libavutil/mathematics.h"
 #include "libavutil/parseutils.h"
 #include "libavutil/time.h"
+#include "libavutil/trace.h"
 #include "riff.h"
 #include "audiointerleave.h"
 #include "url.h"
@@ -654,6 +655,7 @@ FF_ENABLE_DEPRECATION_WARNINGS
  */
 static int write_packet(AVFormatContext *s, AVPacket *pkt)
 {
+    int64_t trace_start;
     int ret;
     int64_t pts_backup, dts_backup;
 
@@ -719,6 +721,7 @@ static int write_packet(AVFormatContext *s, AVPacket *pkt)
         }
     }
 
+    trace_start = av_trace_begin();
     if ((pkt->flags & AV_PKT_FLAG_UNCODED_FRAME)) {
         AVFrame *frame = (AVFrame *)pkt->data;
         av_assert0(pkt->size == UNCODED_FRAME_PACKET_SIZE);
@@ -727,6 +730,7 @@ static int write_packet(AVFormatContext *s, AVPacket *pkt)
     } else {
         ret = s->oformat->write_packet(s, pkt);
     }
+    av_trace_end("mux", s->oformat->name, trace_start);
 
     if (s->pb && ret >= 0) {
         flush_if_needed(s);
@@ -787,6 +787,26 @@ int main(int argc, char **argv)
     finish();
     close_out();
 
+    // Write low latency chunks, one moof+mdat pair per frame, with the
+    // fragment of each frame written out as soon as the frame is muxed.
+    init_out("frag-every-frame");
+    av_dict_set(&opts, "movflags", "frag_every_frame+empty_moov", 0);
+    init(0, 0);
+    mux_frames(4, 0);
+    finish();
+    close_out();
+
+    // Without packet durations, the fragment of each frame is written out
+    // when the next frame of the track arrives.
+    clear_duration = 1;
+    init_out("frag-every-frame-noduration");
+    av_dict_set(&opts, "movflags", "frag_every_frame+empty_moov", 0);
+    init(0, 0);
+    mux_frames(4, 0);
+    finish();
+    close_out();
+    clear_duration = 0;
+
     av_free(md5);
 
     return check_faults > 0 ? 1 : 0;
@@ -0,0 +1,98 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "libavformat/avformat.h"
+#include "libavformat/url.h"
+
+#define NB_PACKETS 64
+#define PKT_SIZE   188
+
+/* Send NB_PACKETS datagrams over loopback and check that they all arrive
+ * intact and in order. */
+static int test(const char *rx_opts, const char *tx_opts)
+{
+    URLContext *rx = NULL, *tx = NULL;
+    uint8_t buf[PKT_SIZE * 2];
+    char url[256];
+    int i, j, ret, received = 0;
+
+    /* fail instead of hanging if a datagram gets lost */
+    snprintf(url, sizeof(url), "udp://127.0.0.1:0?timeout=2000000&buffer_size=262144&%s", rx_opts);
+    ret = ffurl_open_whitelist(&rx, url, AVIO_FLAG_READ, NULL, NULL,
+                               NULL, NULL, NULL);
+    if (ret < 0)
+        goto end;
+
+    snprintf(url, sizeof(url), "udp://127.0.0.1:%d?pkt_size=%d&%s",
+             ff_udp_get_local_port(rx), PKT_SIZE, tx_opts);
+    ret = ffurl_open_whitelist(&tx, url, AVIO_FLAG_WRITE, NULL, NULL,
+                               NULL, NULL, NULL);
+    if (ret < 0)
+        goto end;
+
+    for (i = 0; i < NB_PACKETS; i++) {
+        for (j = 0; j < PKT_SIZE; j++)
+            buf[j] = i + j;
+        ret = ffurl_write(tx, buf, PKT_SIZE);
+        if (ret < 0)
+            goto end;
+    }
+    /* closing waits for the sending thread to drain its fifo */
+    ffurl_closep(&tx);
+
+    for (i = 0; i < NB_PACKETS; i++) {
+        ret = ffurl_read(rx, buf, sizeof(buf));
+        if (ret < 0)
+            goto end;
+        if (ret != PKT_SIZE) {
+            printf("packet %d: size %d\n", i, ret);
+            continue;
+        }
+        for (j = 0; j < PKT_SIZE; j++)
+            if (buf[j] != (uint8_t)(i + j))
+                break;
+        if (j < PKT_SIZE)
+            printf("packet %d: mismatch at byte %d\n", i, j);
+        else
+            received++;
+    }
+    ret = 0;
+
+end:
+    printf("rx %s, tx %s: %d/%d packets received in order\n",
+           rx_opts, tx_opts, received, NB_PACKETS);
+    if (ret < 0)
+        printf("error: %s\n", av_err2str(ret));
+    ffurl_closep(&tx);
+    ffurl_closep(&rx);
+    return ret;
+}
+
+int main(void)
+{
+    int ret = 0;
+
+    ret |= test("fifo_size=1024",               "fifo_size=1024&bitrate=8000000");
+    ret |= test("fifo_size=1024&batch_size=16", "fifo_size=1024&batch_size=16");
+    ret |= test("fifo_size=1024&batch_size=16", "fifo_size=1024&batch_size=16&bitrate=8000000&burst_bits=12032");
+
+    return !!ret;
+}
@@ -26,6 +26,7 @@
 
 #define _DEFAULT_SOURCE
 #define _BSD_SOURCE     /* Needed for using struct ip_mreq with recent glibc */
+#define _GNU_SOURCE     /* Needed for recvmmsg/sendmmsg and struct mmsghdr */
 
 #include "avformat.h"
 #include "avio_internal.h"
@@ -72,6 +73,10 @@
 #define UDP_TX_BUF_SIZE 32768
 #define UDP_MAX_PKT_SIZE 65536
 #define UDP_HEADER_SIZE 8
+/* one batch slot holds a 4 byte length prefix followed by the datagram,
+ * laid out like UDPContext.tmp so it can be moved to/from the fifo as is */
+#define UDP_BATCH_SLOT_SIZE (UDP_MAX_PKT_SIZE + 4)
+#define UDP_MAX_BATCH_SIZE 1024
 
 typedef struct UDPContext {
     const AVClass *class;
@@ -96,6 +101,12 @@ typedef struct UDPContext {
     int64_t bitrate; /* number of bits to send per second */
     int64_t burst_bits;
     int close_req;
+    int batch_size;
+#if HAVE_RECVMMSG || HAVE_SENDMMSG
+    struct mmsghdr *msgs;
+    struct iovec *iovs;
+    uint8_t *batch_buf;
+#endif
 #if HAVE_PTHREAD_CANCEL
     pthread_t circular_buffer_thread;
     pthread_mutex_t mutex;
@@ -129,6 +140,7 @@ static const AVOption options[] = {
     { "ttl",            "Time to live (multicast only)",                   OFFSET(ttl),            AV_OPT_TYPE_INT,    { .i64 = 16 },     0, INT_MAX, E },
     { "connect",        "set if connect() should be called on socket",     OFFSET(is_connected),   AV_OPT_TYPE_BOOL,   { .i64 =  0 },     0, 1,       .flags = D|E },
     { "fifo_size",      "set the UDP receiving circular buffer size, expressed as a number of packets with size of 188 bytes", OFFSET(circular_buffer_size), AV_OPT_TYPE_INT, {.i64 = 7*4096}, 0, INT_MAX, D },
+    { "batch_size",     "Max number of datagrams moved per recvmmsg/sendmmsg call", OFFSET(batch_size), AV_OPT_TYPE_INT, { .i64 = 1 },     1, UDP_MAX_BATCH_SIZE, .flags = D|E },
     { "overrun_nonfatal", "survive in case of UDP receiving circular buffer overrun", OFFSET(overrun_nonfatal), AV_OPT_TYPE_BOOL, {.i64 = 0}, 0, 1,    D },
     { "timeout",        "set raise error timeout (only in read mode)",     OFFSET(timeout),        AV_OPT_TYPE_INT,    { .i64 = 0 },      0, INT_MAX, D },
     { "sources",        "Source list",                                     OFFSET(sources),        AV_OPT_TYPE_STRING, { .str = NULL },               .flags = D|E },
@@ -491,7 +503,84 @@ static int udp_get_file_handle(URLContext *h)
     return s->udp_fd;
 }
 
+static void udp_batch_free(UDPContext *s)
+{
+#if HAVE_RECVMMSG || HAVE_SENDMMSG
+    av_freep(&s->msgs);
+    av_freep(&s->iovs);
+    av_freep(&s->batch_buf);
+#endif
+}
+
 #if HAVE_PTHREAD_CANCEL
+static int udp_batch_alloc(URLContext *h, int is_output)
+{
+    UDPContext *s = h->priv_data;
+#if HAVE_RECVMMSG || HAVE_SENDMMSG
+    int i;
+#endif
+
+    if (s->batch_size <= 1)
+        return 0;
+
+#if HAVE_RECVMMSG || HAVE_SENDMMSG
+    if (is_output ? HAVE_SENDMMSG : HAVE_RECVMMSG) {
+        s->msgs      = av_mallocz_array(s->batch_size, sizeof(*s->msgs));
+        s->iovs      = av_mallocz_array(s->batch_size, sizeof(*s->iovs));
+        s->batch_buf = av_malloc_array(s->batch_size, UDP_BATCH_SLOT_SIZE);
+        if (!s->msgs || !s->iovs || !s->batch_buf)
+            return AVERROR(ENOMEM);
+
+        for (i = 0; i < s->batch_size; i++) {
+            s->iovs[i].iov_base           = s->batch_buf + i * UDP_BATCH_SLOT_SIZE + 4;
+            s->iovs[i].iov_len            = UDP_BATCH_SLOT_SIZE - 4;
+            s->msgs[i].msg_hdr.msg_iov    = &s->iovs[i];
+            s->msgs[i].msg_hdr.msg_iovlen = 1;
+        }
+        return 0;
+    }
+#endif
+
+    av_log(h, AV_LOG_WARNING,
+           "'batch_size' option was set but it is not supported on this build "
+           "(recvmmsg/sendmmsg support is required)\n");
+    s->batch_size = 1;
+    return 0;
+}
+
+/**
+ * Receive up to batch_size datagrams with a single system call.
+ * On success, *pkts points to the first length prefixed slot, slots are
+ * UDP_BATCH_SLOT_SIZE bytes apart and the datagram lengths are not yet
+ * written into the slot headers.
+ * @return number of datagrams received or a negative errno value
+ */
+static int udp_recv_batch(UDPContext *s, uint8_t **pkts, int *lens)
+{
+    int ret;
+
+#if HAVE_RECVMMSG
+    if (s->msgs) {
+        int i;
+
+        ret = recvmmsg(s->udp_fd, s->msgs, s->batch_size, MSG_WAITFORONE, NULL);
+        if (ret < 0)
+            return ff_neterrno();
+        for (i = 0; i < ret; i++)
+            lens[i] = s->msgs[i].msg_len;
+        *pkts = s->batch_buf;
+        return ret;
+    }
+#endif
+
+    ret = recv(s->udp_fd, s->tmp+4, sizeof(s->tmp)-4, 0);
+    if (ret < 0)
+        return ff_neterrno();
+    lens[0] = ret;
+    *pkts = s->tmp;
+    return 1;
+}
+
 static void *circular_buffer_task_rx( void *_URLContext)
 {
     URLContext *h = _URLContext;
@@ -506,40 +595,47 @@ static void *circular_buffer_task_rx( void *_URLContext)
         goto end;
     }
     while(1) {
-        int len;
+        int nb_pkts, i;
+        int lens[UDP_MAX_BATCH_SIZE];
+        uint8_t *pkts;
 
         pthread_mutex_unlock(&s->mutex);
         /* Blocking operations are always cancellation points;
            see "General Information" / "Thread Cancelation Overview"
            in Single Unix. */
         pthread_setcancelstate(PTHREAD_CANCEL_ENABLE, &old_cancelstate);
-        len = recv(s->udp_fd, s->tmp+4, sizeof(s->tmp)-4, 0);
+        nb_pkts = udp_recv_batch(s, &pkts, lens);
         pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, &old_cancelstate);
         pthread_mutex_lock(&s->mutex);
-        if (len < 0) {
-            if (ff_neterrno() != AVERROR(EAGAIN) && ff_neterrno() != AVERROR(EINTR)) {
-                s->circular_buffer_error = ff_neterrno();
+        if (nb_pkts < 0) {
+            if (nb_pkts != AVERROR(EAGAIN) && nb_pkts != AVERROR(EINTR)) {
+                s->circular_buffer_error = nb_pkts;
                 goto end;
             }
             continue;
         }
-        AV_WL32(s->tmp, len);
-
-        if(av_fifo_space(s->fifo) < len + 4) {
-            /* No Space left */
-            if (s->overrun_nonfatal) {
-                av_log(h, AV_LOG_WARNING, "Circular buffer overrun. "
-                        "Surviving due to overrun_nonfatal option\n");
-                continue;
-            } else {
-                av_log(h, AV_LOG_ERROR, "Circular buffer overrun. "
-                        "To avoid, increase fifo_size URL option. "
-                        "To survive in such case, use overrun_nonfatal option\n");
-                s->circular_buffer_error = AVERROR(EIO);
-                goto end;
+        for (i = 0; i < nb_pkts; i++) {
+            uint8_t *pkt = pkts + i * UDP_BATCH_SLOT_SIZE;
+            int len = lens[i];
+
+            AV_WL32(pkt, len);
+
+            if(av_fifo_space(s->fifo) < len + 4) {
+                /* No Space left */
+                if (s->overrun_nonfatal) {
+                    av_log(h, AV_LOG_WARNING, "Circular buffer overrun. "
+                            "Surviving due to overrun_nonfatal option\n");
+                    continue;
+                } else {
+                    av_log(h, AV_LOG_ERROR, "Circular buffer overrun. "
+                            "To avoid, increase fifo_size URL option. "
+                            "To survive in such case, use overrun_nonfatal option\n");
+                    s->circular_buffer_error = AVERROR(EIO);
+                    goto end;
+                }
             }
+            av_fifo_generic_write(s->fifo, pkt, len+4, NULL);
         }
-        av_fifo_generic_write(s->fifo, s->tmp, len+4, NULL);
         pthread_cond_signal(&s->cond);
     }
 
@@ -549,6 +645,47 @@ end:
     return NULL;
 }
 
+/**
+ * Check whether no more datagrams should be added to the current tx batch.
+ * When pacing, a batch never grows beyond burst_bits, so the default
+ * burst_bits of 0 keeps sending one datagram at a time.
+ */
+static int udp_tx_batch_full(UDPContext *s, int nb_pkts, int size)
+{
+    uint8_t tmp[4];
+
+    if (nb_pkts >= s->batch_size || av_fifo_size(s->fifo) < 4)
+        return 1;
+    if (!s->bitrate)
+        return 0;
+    av_fifo_generic_peek(s->fifo, tmp, 4, NULL);
+    return (int64_t)(size + AV_RL32(tmp)) * 8 > s->burst_bits;
+}
+
+#if HAVE_SENDMMSG
+static int udp_send_batch(UDPContext *s, int nb_pkts)
+{
+    int i, sent = 0;
+
+    for (i = 0; i < nb_pkts; i++) {
+        s->msgs[i].msg_hdr.msg_name    = s->is_connected ? NULL : &s->dest_addr;
+        s->msgs[i].msg_hdr.msg_namelen = s->is_connected ? 0    : s->dest_addr_len;
+    }
+
+    while (sent < nb_pkts) {
+        int ret = sendmmsg(s->udp_fd, s->msgs + sent, nb_pkts - sent, 0);
+        if (ret < 0) {
+            ret = ff_neterrno();
+            if (ret != AVERROR(EAGAIN) && ret != AVERROR(EINTR))
+                return ret;
+            continue;
+        }
+        sent += ret;
+    }
+    return 0;
+}
+#endif
+
 static void *circular_buffer_task_tx( void *_URLContext)
 {
     URLContext *h = _URLContext;
@@ -558,7 +695,8 @@ static void *circular_buffer_task_tx( void *_URLContext)
     int64_t start_timestamp = av_gettime_relative();
     int64_t sent_bits = 0;
     int64_t burst_interval = s->bitrate ? (s->burst_bits * 1000000 / s->bitrate) : 0;
-    int64_t max_delay = s->bitrate ?  ((int64_t)h->max_packet_size * 8 * 1000000 / s->bitrate + 1) : 0;
+    int64_t max_burst = FFMAX((int64_t)h->max_packet_size * 8, s->batch_size > 1 ? s->burst_bits : 0);
+    int64_t max_delay = s->bitrate ?  (max_burst * 1000000 / s->bitrate + 1) : 0;
 
     pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, &old_cancelstate);
     pthread_mutex_lock(&s->mutex);
@@ -570,7 +708,7 @@ static void *circular_buffer_task_tx( void *_URLContext)
     }
 
     for(;;) {
-        int len;
+        int len, nb_pkts = 0, size = 0;
         const uint8_t *p;
         uint8_t tmp[4];
         int64_t timestamp;
@@ -586,14 +724,28 @@ static void *circular_buffer_task_tx( void *_URLContext)
             len=av_fifo_size(s->fifo);
         }
 
-        av_fifo_generic_read(s->fifo, tmp, 4, NULL);
-        len=AV_RL32(tmp);
+        do {
+            uint8_t *pkt = s->tmp;
 
-        av_assert0(len >= 0);
-        av_assert0(len <= sizeof(s->tmp));
+            av_fifo_generic_read(s->fifo, tmp, 4, NULL);
+            len=AV_RL32(tmp);
 
-        av_fifo_generic_read(s->fifo, s->tmp, len, NULL);
+            av_assert0(len >= 0);
+            av_assert0(len <= sizeof(s->tmp));
 
+#if HAVE_SENDMMSG
+            if (s->msgs) {
+                pkt = s->iovs[nb_pkts].iov_base;
+                s->iovs[nb_pkts].iov_len = len;
+            }
+#endif
+            av_fifo_generic_read(s->fifo, pkt, len, NULL);
+            size += len;
+            nb_pkts++;
+        } while (!udp_tx_batch_full(s, nb_pkts, size));
+
+        /* wake up udp_write() if it waits for fifo space */
+        pthread_cond_signal(&s->cond);
         pthread_mutex_unlock(&s->mutex);
         pthread_setcancelstate(PTHREAD_CANCEL_ENABLE, &old_cancelstate);
 
@@ -613,10 +765,24 @@ static void *circular_buffer_task_tx( void *_URLContext)
                     sent_bits = 0;
                 }
             }
-            sent_bits += len * 8;
+            sent_bits += size * 8;
             target_timestamp = start_timestamp + sent_bits * 1000000 / s->bitrate;
         }
 
+#if HAVE_SENDMMSG
+        if (s->msgs) {
+            int ret = udp_send_batch(s, nb_pkts);
+            if (ret < 0) {
+                pthread_mutex_lock(&s->mutex);
+                s->circular_buffer_error = ret;
+                pthread_cond_signal(&s->cond);
+                pthread_mutex_unlock(&s->mutex);
+                return NULL;
+            }
+            len = 0;
+        }
+#endif
+
         p = s->tmp;
         while (len) {
             int ret;
@@ -635,6 +801,7 @@ static void *circular_buffer_task_tx( void *_URLContext)
                 if (ret != AVERROR(EAGAIN) && ret != AVERROR(EINTR)) {
                     pthread_mutex_lock(&s->mutex);
                     s->circular_buffer_error = ret;
+                    pthread_cond_signal(&s->cond);
                     pthread_mutex_unlock(&s->mutex);
                     return NULL;
                 }
@@ -769,6 +936,9 @@ static int udp_open(URLContext *h, const char *uri, int flags)
         if (av_find_info_tag(buf, sizeof(buf), "burst_bits", p)) {
             s->burst_bits = strtoll(buf, NULL, 10);
         }
+        if (av_find_info_tag(buf, sizeof(buf), "batch_size", p)) {
+            s->batch_size = av_clip(strtol(buf, NULL, 10), 1, UDP_MAX_BATCH_SIZE);
+        }
         if (av_find_info_tag(buf, sizeof(buf), "localaddr", p)) {
             av_strlcpy(localaddr, buf, sizeof(localaddr));
         }
@@ -952,6 +1122,7 @@ static int udp_open(URLContext *h, const char *uri, int flags)
       Create thread in case of:
       1. Input and circular_buffer_size is set
       2. Output and bitrate and circular_buffer_size is set
+      3. Output and batch_size and circular_buffer_size is set
     */
 
     if (is_output && s->bitrate && !s->circular_buffer_size) {
@@ -959,9 +1130,13 @@ static int udp_open(URLContext *h, const char *uri, int flags)
         av_log(h, AV_LOG_WARNING,"'bitrate' option was set but 'circular_buffer_size' is not, but required\n");
     }
 
-    if ((!is_output && s->circular_buffer_size) || (is_output && s->bitrate && s->circular_buffer_size)) {
+    if ((!is_output && s->circular_buffer_size) ||
+        (is_output && (s->bitrate || s->batch_size > 1) && s->circular_buffer_size)) {
         int ret;
 
+        if (udp_batch_alloc(h, is_output) < 0)
+            goto fail;
+
         /* start the task going */
         s->fifo = av_fifo_alloc(s->circular_buffer_size);
         ret = pthread_mutex_init(&s->mutex, NULL);
@@ -994,6 +1169,7 @@ static int udp_open(URLContext *h, const char *uri, int flags)
     if (udp_fd >= 0)
         closesocket(udp_fd);
     av_fifo_freep(&s->fifo);
+    udp_batch_free(s);
     for (i = 0; i < num_include_sources; i++)
         av_freep(&include_sources[i]);
     for (i = 0; i < num_exclude_sources; i++)
@@ -1091,10 +1267,27 @@ static int udp_write(URLContext *h, const uint8_t *buf, int size)
             return err;
         }
 
-        if(av_fifo_space(s->fifo) < size + 4) {
-            /* What about a partial packet tx ? */
+        if (size > UDP_MAX_PKT_SIZE) {
             pthread_mutex_unlock(&s->mutex);
-            return AVERROR(ENOMEM);
+            return AVERROR(EINVAL);
+        }
+
+        while (av_fifo_space(s->fifo) < size + 4) {
+            /* When pacing, the fifo is expected to absorb the input rate
+               variations and overflowing it is an error. Otherwise the
+               thread drains it as fast as the socket allows, wait for it. */
+            if (s->bitrate || (h->flags & AVIO_FLAG_NONBLOCK) ||
+                av_fifo_size(s->fifo) == 0) {
+                /* What about a partial packet tx ? */
+                pthread_mutex_unlock(&s->mutex);
+                return AVERROR(ENOMEM);
+            }
+            pthread_cond_wait(&s->cond, &s->mutex);
+            if (s->circular_buffer_error < 0) {
+                int err = s->circular_buffer_error;
+                pthread_mutex_unlock(&s->mutex);
+                return err;
+            }
         }
         AV_WL32(tmp, size);
         av_fifo_generic_write(s->fifo, tmp, 4, NULL); /* size of packet */
@@ -1151,6 +1344,7 @@ static int udp_close(URLContext *h)
 #endif
     closesocket(s->udp_fd);
     av_fifo_freep(&s->fifo);
+    udp_batch_free(s);
     return 0;
 }
 
@@ -36,6 +36,7 @@
 #include "libavutil/time.h"
 #include "libavutil/time_internal.h"
 #include "libavutil/timestamp.h"
+#include "libavutil/trace.h"
 
 #include "libavcodec/bytestream.h"
 #include "libavcodec/internal.h"
@@ -821,6 +822,7 @@ int ff_read_packet(AVFormatContext *s, AVPacket *pkt)
 
     for (;;) {
         AVPacketList *pktl = s->internal->raw_packet_buffer;
+        int64_t trace_start;
 
         if (pktl) {
             *pkt = pktl->pkt;
@@ -839,7 +841,9 @@ int ff_read_packet(AVFormatContext *s, AVPacket *pkt)
         pkt->data = NULL;
         pkt->size = 0;
         av_init_packet(pkt);
+        trace_start = av_trace_begin();
         ret = s->iformat->read_packet(s, pkt);
+        av_trace_end("demux", s->iformat->name, trace_start);
         if (ret < 0) {
             /* Some demuxers return FFERROR_REDO when they consume
                data and discard it (ignored streams, junk, extradata).
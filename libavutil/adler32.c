@@ -34,6 +34,9 @@
 #include "adler32.h"
 #include "common.h"
 #include "intreadwrite.h"
+#if ARCH_X86
+#include "x86/adler32.h"
+#endif
 
 #define BASE 65521L /* largest prime smaller than 65536 */
 
@@ -44,8 +47,13 @@
 unsigned long av_adler32_update(unsigned long adler, const uint8_t * buf,
                                 unsigned int len)
 {
-    unsigned long s1 = adler & 0xffff;
-    unsigned long s2 = adler >> 16;
+    unsigned long s1, s2;
+
+#if ARCH_X86
+    adler = ff_adler32_update_x86(adler, &buf, &len);
+#endif
+    s1 = adler & 0xffff;
+    s2 = adler >> 16;
 
     while (len > 0) {
 #if HAVE_FAST_64BIT && HAVE_FAST_UNALIGNED && !CONFIG_SMALL
@@ -25,6 +25,9 @@
 #include "bswap.h"
 #include "common.h"
 #include "crc.h"
+#if ARCH_X86
+#include "x86/crc.h"
+#endif
 
 #if CONFIG_HARDCODED_TABLES
 static const AVCRC av_crc_table[AV_CRC_MAX][257] = {
@@ -368,6 +371,13 @@ uint32_t av_crc(const AVCRC *ctx, uint32_t crc,
 {
     const uint8_t *end = buffer + length;
 
+#if ARCH_X86
+    if (ctx >= av_crc_table[0] && ctx < av_crc_table[AV_CRC_MAX]) {
+        AVCRCId crc_id = (ctx - av_crc_table[0]) / FF_ARRAY_ELEMS(av_crc_table[0]);
+        if (ctx == av_crc_table[crc_id])
+            buffer += ff_crc_x86(crc_id, &crc, buffer, length);
+    }
+#endif
 #if !CONFIG_SMALL
     if (!ctx[256]) {
         while (((intptr_t) buffer & 3) && buffer < end)
@@ -27,11 +27,118 @@
 #include "time_internal.h"
 #include "bprint.h"
 
+/* dictionaries with at least that many entries get a hash index */
+#define INDEX_MIN_COUNT 16
+
+typedef struct IndexSlot {
+    unsigned hash;
+    unsigned pos;               ///< index of the entry + 1, 0 for an empty slot
+} IndexSlot;
+
 struct AVDictionary {
     int count;
     AVDictionaryEntry *elems;
+
+    /**
+     * Open addressing hash table with linear probing over the entries,
+     * hashed case-insensitively so that it serves all exact key lookups.
+     * It is only maintained for large dictionaries and may be NULL.
+     */
+    IndexSlot *index;
+    unsigned index_mask;
 };
 
+static unsigned hash_key(const char *key)
+{
+    unsigned hash = 0x811c9dc5;
+
+    while (*key)
+        hash = (hash ^ (uint8_t)av_toupper(*key++)) * 0x01000193;
+    return hash;
+}
+
+static int key_matches(const char *s, const char *key, int flags)
+{
+    if (flags & AV_DICT_MATCH_CASE)
+        return !strcmp(s, key);
+    return !av_strcasecmp(s, key);
+}
+
+static void index_insert(AVDictionary *m, unsigned hash, unsigned pos)
+{
+    unsigned i = hash & m->index_mask;
+
+    while (m->index[i].pos)
+        i = (i + 1) & m->index_mask;
+    m->index[i].hash = hash;
+    m->index[i].pos  = pos + 1;
+}
+
+static unsigned index_find_slot(const AVDictionary *m, unsigned hash, unsigned pos)
+{
+    unsigned i = hash & m->index_mask;
+
+    while (m->index[i].pos != pos + 1)
+        i = (i + 1) & m->index_mask;
+    return i;
+}
+
+/**
+ * Allocate an index for the current entries, large enough for them and as
+ * many new ones. The index is dropped if that fails; lookups are then done
+ * by scanning the entries until it can be rebuilt.
+ */
+static void index_rebuild(AVDictionary *m)
+{
+    unsigned size = 2 * INDEX_MIN_COUNT, i;
+
+    while (size < 4U * m->count)
+        size <<= 1;
+
+    av_freep(&m->index);
+    m->index = av_mallocz_array(size, sizeof(*m->index));
+    if (!m->index)
+        return;
+    m->index_mask = size - 1;
+    for (i = 0; i < m->count; i++)
+        index_insert(m, hash_key(m->elems[i].key), i);
+}
+
+static void index_add(AVDictionary *m, unsigned pos)
+{
+    if (m->index && 2 * (pos + 1) <= m->index_mask)
+        index_insert(m, hash_key(m->elems[pos].key), pos);
+    else if (m->count >= INDEX_MIN_COUNT)
+        index_rebuild(m);
+}
+
+/**
+ * Remove the entry at pos from the index and move the entry at last to pos,
+ * like the caller does with the entries themselves.
+ */
+static void index_remove(AVDictionary *m, unsigned pos, unsigned last)
+{
+    unsigned i, j;
+
+    if (!m->index)
+        return;
+
+    /* backward shift deletion: move later entries of the probe sequence
+     * into the hole unless that would put them before their home slot */
+    i = index_find_slot(m, hash_key(m->elems[pos].key), pos);
+    for (j = (i + 1) & m->index_mask; m->index[j].pos; j = (j + 1) & m->index_mask) {
+        unsigned home = m->index[j].hash & m->index_mask;
+        if (((j - home) & m->index_mask) >= ((j - i) & m->index_mask)) {
+            m->index[i] = m->index[j];
+            i = j;
+        }
+    }
+    m->index[i].pos = 0;
+
+    if (pos != last)
+        m->index[index_find_slot(m, hash_key(m->elems[last].key), last)].pos = pos + 1;
+}
+
 int av_dict_count(const AVDictionary *m)
 {
     return m ? m->count : 0;
@@ -50,6 +157,20 @@ AVDictionaryEntry *av_dict_get(const AVDictionary *m, const char *key,
     else
         i = 0;
 
+    if (m->index && !(flags & AV_DICT_IGNORE_SUFFIX)) {
+        unsigned hash = hash_key(key), first = m->count;
+
+        /* entries with the same key are in the same probe sequence, in no
+         * particular order */
+        for (j = hash & m->index_mask; m->index[j].pos; j = (j + 1) & m->index_mask) {
+            unsigned pos = m->index[j].pos - 1;
+            if (m->index[j].hash == hash && pos >= i && pos < first &&
+                key_matches(m->elems[pos].key, key, flags))
+                first = pos;
+        }
+        return first < m->count ? &m->elems[first] : NULL;
+    }
+
     for (; i < m->count; i++) {
         const char *s = m->elems[i].key;
         if (flags & AV_DICT_MATCH_CASE)
@@ -100,6 +221,7 @@ int av_dict_set(AVDictionary **pm, const char *key, const char *value,
             oldval = tag->value;
         else
             av_free(tag->value);
+        index_remove(m, tag - m->elems, m->count - 1);
         av_free(tag->key);
         *tag = m->elems[--m->count];
     } else if (copy_value) {
@@ -124,11 +246,13 @@ int av_dict_set(AVDictionary **pm, const char *key, const char *value,
             av_freep(&copy_value);
         }
         m->count++;
+        index_add(m, m->count - 1);
     } else {
         av_freep(&copy_key);
     }
     if (!m->count) {
         av_freep(&m->elems);
+        av_freep(&m->index);
         av_freep(pm);
     }
 
@@ -137,6 +261,7 @@ int av_dict_set(AVDictionary **pm, const char *key, const char *value,
 err_out:
     if (m && !m->count) {
         av_freep(&m->elems);
+        av_freep(&m->index);
         av_freep(pm);
     }
     av_free(copy_key);
@@ -210,6 +335,7 @@ void av_dict_free(AVDictionary **pm)
             av_freep(&m->elems[m->count].value);
         }
         av_freep(&m->elems);
+        av_freep(&m->index);
     }
     av_freep(pm);
 }
@@ -173,8 +173,30 @@ struct AVExpr {
     } a;
     struct AVExpr *param[3];
     double *var;
+
+    /* only set on the root node */
+    struct ExprInsn *insn;      ///< compiled form, NULL if the expression has side effects
+    int nb_insn;
+    int nb_regs;
+    int nb_consts;              ///< highest constant index used + 1
 };
 
+/**
+ * Instruction of the compiled form of an expression, evaluated over a block
+ * of points at once. The operands are read from registers reg, reg + 1 and
+ * reg + 2 and the result is written to register reg.
+ */
+typedef struct ExprInsn {
+    int type;
+    int reg;
+    int nb_params;
+    double value;
+    int const_index;
+    double (*func0)(double);
+    double (*func1)(void *, double);
+    double (*func2)(void *, double, double);
+} ExprInsn;
+
 static double etime(double v)
 {
     return av_gettime() * 0.000001;
@@ -338,6 +360,7 @@ void av_expr_free(AVExpr *e)
     av_expr_free(e->param[1]);
     av_expr_free(e->param[2]);
     av_freep(&e->var);
+    av_freep(&e->insn);
     av_freep(&e);
 }
 
@@ -676,6 +699,126 @@ static int verify_expr(AVExpr *e)
     }
 }
 
+static int has_side_effects(const AVExpr *e)
+{
+    int i;
+
+    if (!e)
+        return 0;
+    switch (e->type) {
+    case e_ld:
+    case e_st:
+    case e_random:
+    case e_while:
+    case e_taylor:
+    case e_root:
+    case e_print:
+        return 1;
+    }
+    for (i = 0; i < 3; i++)
+        if (has_side_effects(e->param[i]))
+            return 1;
+    return 0;
+}
+
+/**
+ * Replace the subexpressions which only depend on numbers by their value.
+ */
+static void fold_constants(AVExpr *e)
+{
+    Parser p = { 0 };
+    int i;
+
+    for (i = 0; i < 3; i++)
+        if (e->param[i])
+            fold_constants(e->param[i]);
+    for (i = 0; i < 3; i++)
+        if (e->param[i] && e->param[i]->type != e_value)
+            return;
+
+    switch (e->type) {
+    case e_value:
+    case e_const:
+    case e_func1:
+    case e_func2:
+        return;
+    case e_func0:
+        if (e->a.func0 == etime)
+            return;
+        break;
+    default:
+        if (has_side_effects(e))
+            return;
+    }
+
+    p.class  = &eval_class;
+    e->value = eval_expr(&p, e);
+    e->type  = e_value;
+    for (i = 0; i < 3; i++) {
+        av_expr_free(e->param[i]);
+        e->param[i] = NULL;
+    }
+}
+
+#define BLOCK_SIZE 64
+#define MAX_REGS   32
+
+static int count_insn(const AVExpr *e, int *nb_consts)
+{
+    if (!e)
+        return 0;
+    if (e->type == e_const)
+        *nb_consts = FFMAX(*nb_consts, e->a.const_index + 1);
+    return 1 + count_insn(e->param[0], nb_consts)
+             + count_insn(e->param[1], nb_consts)
+             + count_insn(e->param[2], nb_consts);
+}
+
+static void compile_expr(AVExpr *root, const AVExpr *e, int reg)
+{
+    ExprInsn *insn;
+    int i, nb_params = 0;
+
+    for (i = 0; i < 3 && e->param[i]; i++) {
+        compile_expr(root, e->param[i], reg + i);
+        nb_params++;
+    }
+
+    insn = &root->insn[root->nb_insn++];
+    insn->type      = e->type;
+    insn->reg       = reg;
+    insn->nb_params = nb_params;
+    insn->value     = e->value;
+    switch (e->type) {
+    case e_const: insn->const_index = e->a.const_index; break;
+    case e_func0: insn->func0       = e->a.func0;       break;
+    case e_func1: insn->func1       = e->a.func1;       break;
+    case e_func2: insn->func2       = e->a.func2;       break;
+    }
+    root->nb_regs = FFMAX(root->nb_regs, reg + FFMAX(nb_params, 1));
+}
+
+static int compile(AVExpr *e)
+{
+    int nb_insn = count_insn(e, &e->nb_consts);
+
+    if (has_side_effects(e))
+        return 0;
+
+    e->insn = av_malloc_array(nb_insn, sizeof(*e->insn));
+    if (!e->insn)
+        return AVERROR(ENOMEM);
+    compile_expr(e, e, 0);
+
+    /* the registers live on the stack of av_expr_eval_array(), leave deeply
+     * nested expressions to the tree walk */
+    if (e->nb_regs > MAX_REGS) {
+        av_freep(&e->insn);
+        e->nb_insn = e->nb_regs = 0;
+    }
+    return 0;
+}
+
 int av_expr_parse(AVExpr **expr, const char *s,
                   const char * const *const_names,
                   const char * const *func1_names, double (* const *funcs1)(void *, double),
@@ -718,6 +861,9 @@ int av_expr_parse(AVExpr **expr, const char *s,
         ret = AVERROR(EINVAL);
         goto end;
     }
+    fold_constants(e);
+    if ((ret = compile(e)) < 0)
+        goto end;
     e->var= av_mallocz(sizeof(double) *VARS);
     if (!e->var) {
         ret = AVERROR(ENOMEM);
@@ -741,6 +887,158 @@ double av_expr_eval(AVExpr *e, const double *const_values, void *opaque)
     return eval_expr(&p, e);
 }
 
+#define UNARY(op)                                       \
+    for (j = 0; j < n; j++) {                           \
+        double x = d[j];                                \
+        d[j] = op;                                      \
+    }
+
+#define BINARY(op)                                      \
+    for (j = 0; j < n; j++) {                           \
+        double x = d[j], y = s1[j];                     \
+        d[j] = op;                                      \
+    }
+
+static void eval_block(const AVExpr *e, double *regs, int n, int offset,
+                       const double *const_values,
+                       const double * const *const_arrays, void *opaque)
+{
+    int i, j;
+
+    for (i = 0; i < e->nb_insn; i++) {
+        const ExprInsn *insn = &e->insn[i];
+        const double v = insn->value;
+        double *d = regs + insn->reg * BLOCK_SIZE;
+        const double *s1 = d + BLOCK_SIZE;
+        const double *s2 = d + BLOCK_SIZE * 2;
+
+        switch (insn->type) {
+        case e_value:
+            for (j = 0; j < n; j++)
+                d[j] = v;
+            break;
+        case e_const:
+            if (const_arrays && const_arrays[insn->const_index]) {
+                const double *src = const_arrays[insn->const_index] + offset;
+                for (j = 0; j < n; j++)
+                    d[j] = v * src[j];
+            } else {
+                const double c = v * const_values[insn->const_index];
+                for (j = 0; j < n; j++)
+                    d[j] = c;
+            }
+            break;
+        case e_func0:  UNARY(v * insn->func0(x));                    break;
+        case e_func1:  UNARY(v * insn->func1(opaque, x));            break;
+        case e_func2:  BINARY(v * insn->func2(opaque, x, y));        break;
+        case e_squish: UNARY(1/(1+exp(4*x)));                        break;
+        case e_gauss:  UNARY(exp(-x*x/2)/sqrt(2*M_PI));              break;
+        case e_isnan:  UNARY(v * !!isnan(x));                        break;
+        case e_isinf:  UNARY(v * !!isinf(x));                        break;
+        case e_floor:  UNARY(v * floor(x));                          break;
+        case e_ceil:   UNARY(v * ceil (x));                          break;
+        case e_trunc:  UNARY(v * trunc(x));                          break;
+        case e_round:  UNARY(v * round(x));                          break;
+        case e_sqrt:   UNARY(v * sqrt (x));                          break;
+        case e_not:    UNARY(v * (x == 0));                          break;
+        case e_if:
+            for (j = 0; j < n; j++)
+                d[j] = v * (d[j] ? s1[j] : insn->nb_params > 2 ? s2[j] : 0);
+            break;
+        case e_ifnot:
+            for (j = 0; j < n; j++)
+                d[j] = v * (!d[j] ? s1[j] : insn->nb_params > 2 ? s2[j] : 0);
+            break;
+        case e_clip:
+            for (j = 0; j < n; j++) {
+                double x = d[j], min = s1[j], max = s2[j];
+                if (isnan(min) || isnan(max) || isnan(x) || min > max)
+                    d[j] = NAN;
+                else
+                    d[j] = v * av_clipd(x, min, max);
+            }
+            break;
+        case e_between:
+            for (j = 0; j < n; j++)
+                d[j] = v * (d[j] >= s1[j] && d[j] <= s2[j]);
+            break;
+        case e_lerp:
+            for (j = 0; j < n; j++)
+                d[j] = d[j] + (s1[j] - d[j]) * s2[j];
+            break;
+        case e_mod:    BINARY(v * (x - floor((!CONFIG_FTRAPV || y) ? x / y : x * INFINITY) * y)); break;
+        case e_gcd:    BINARY(v * av_gcd(x, y));                      break;
+        case e_max:    BINARY(v * (x >  y ?   x : y));                break;
+        case e_min:    BINARY(v * (x <  y ?   x : y));                break;
+        case e_eq:     BINARY(v * (x == y ? 1.0 : 0.0));              break;
+        case e_gt:     BINARY(v * (x >  y ? 1.0 : 0.0));              break;
+        case e_gte:    BINARY(v * (x >= y ? 1.0 : 0.0));              break;
+        case e_lt:     BINARY(v * (x <  y ? 1.0 : 0.0));              break;
+        case e_lte:    BINARY(v * (x <= y ? 1.0 : 0.0));              break;
+        case e_pow:    BINARY(v * pow(x, y));                         break;
+        case e_mul:    BINARY(v * (x * y));                           break;
+        case e_div:    BINARY(v * ((!CONFIG_FTRAPV || y) ? (x / y) : x * INFINITY)); break;
+        case e_add:    BINARY(v * (x + y));                           break;
+        case e_last:
+            for (j = 0; j < n; j++)
+                d[j] = v * s1[j];
+            break;
+        case e_hypot:  BINARY(v * hypot(x, y));                       break;
+        case e_atan2:  BINARY(v * atan2(x, y));                       break;
+        case e_bitand: BINARY(isnan(x) || isnan(y) ? NAN : v * ((long int)x & (long int)y)); break;
+        case e_bitor:  BINARY(isnan(x) || isnan(y) ? NAN : v * ((long int)x | (long int)y)); break;
+        default:
+            for (j = 0; j < n; j++)
+                d[j] = NAN;
+        }
+    }
+}
+
+int av_expr_eval_array(AVExpr *e, double *res, int nb_values,
+                       const double *const_values,
+                       const double * const *const_arrays, void *opaque)
+{
+    /* not part of the AVExpr, as the same expression may be evaluated from
+     * several threads at once */
+    double regs[MAX_REGS * BLOCK_SIZE];
+    int i, j;
+
+    if (!e->insn) {
+        /* evaluate the points in order so that variables behave as with
+         * av_expr_eval() */
+        Parser p = { 0 };
+        double *buf = regs;
+
+        if (e->nb_consts > FF_ARRAY_ELEMS(regs)) {
+            buf = av_malloc_array(e->nb_consts, sizeof(*buf));
+            if (!buf)
+                return AVERROR(ENOMEM);
+        }
+        if (e->nb_consts)
+            memcpy(buf, const_values, e->nb_consts * sizeof(*buf));
+        p.var          = e->var;
+        p.const_values = buf;
+        p.opaque       = opaque;
+
+        for (i = 0; i < nb_values; i++) {
+            for (j = 0; const_arrays && j < e->nb_consts; j++)
+                if (const_arrays[j])
+                    buf[j] = const_arrays[j][i];
+            res[i] = eval_expr(&p, e);
+        }
+        if (buf != regs)
+            av_free(buf);
+    } else {
+        for (i = 0; i < nb_values; i += BLOCK_SIZE) {
+            const int n = FFMIN(nb_values - i, BLOCK_SIZE);
+            eval_block(e, regs, n, i, const_values, const_arrays, opaque);
+            memcpy(res + i, regs, n * sizeof(*res));
+        }
+    }
+
+    return 0;
+}
+
 int av_expr_parse_and_eval(double *d, const char *s,
                            const char * const *const_names, const double *const_values,
                            const char * const *func1_names, double (* const *funcs1)(void *, double),
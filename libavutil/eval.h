@@ -86,6 +86,34 @@ int av_expr_parse(AVExpr **expr, const char *s,
  */
 double av_expr_eval(AVExpr *e, const double *const_values, void *opaque);
 
+/**
+ * Evaluate a previously parsed expression for a series of points, each
+ * with its own values for some of the constants.
+ *
+ * This is equivalent to calling av_expr_eval() nb_values times, but
+ * evaluates each operation over blocks of points, which is much faster
+ * for expressions evaluated per pixel or per sample. Expressions which
+ * use variables or print() are evaluated point by point.
+ *
+ * The functions passed to av_expr_parse() may be called in a different
+ * order than with av_expr_eval(), including for the branch of if() and
+ * ifnot() which is not taken, and must not depend on const_values.
+ *
+ * @param res array of nb_values results
+ * @param nb_values number of points to evaluate
+ * @param const_values a zero terminated array of values for the identifiers
+ *                     from av_expr_parse() const_names, shared by all points
+ * @param const_arrays NULL, or an array of the same size as const_values;
+ *                     each non NULL element is an array of nb_values values
+ *                     of the corresponding constant, one for each point,
+ *                     which override the value in const_values
+ * @param opaque a pointer which will be passed to all functions from funcs1 and funcs2
+ * @return 0 on success, a negative AVERROR code on failure
+ */
+int av_expr_eval_array(AVExpr *e, double *res, int nb_values,
+                       const double *const_values,
+                       const double * const *const_arrays, void *opaque);
+
 /**
  * Free a parsed expression previously created with av_expr_parse().
  */
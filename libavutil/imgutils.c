@@ -320,6 +320,29 @@ static void image_copy_plane(uint8_t       *dst, ptrdiff_t dst_linesize,
     }
 }
 
+/* Planes larger than this do not fit in the last level cache of most CPUs
+ * along with the rest of the working set: write them with non-temporal
+ * stores, so that copying them does not evict everything else. */
+#define STREAM_COPY_MIN_SIZE (4 << 20)
+
+static void image_copy_plane_stream(uint8_t       *dst, ptrdiff_t dst_linesize,
+                                    const uint8_t *src, ptrdiff_t src_linesize,
+                                    ptrdiff_t bytewidth, int height)
+{
+    int ret = -1;
+
+    if (!dst || !src)
+        return;
+
+#if ARCH_X86
+    ret = ff_image_copy_plane_stream_x86(dst, dst_linesize, src, src_linesize,
+                                         bytewidth, height);
+#endif
+
+    if (ret < 0)
+        image_copy_plane(dst, dst_linesize, src, src_linesize, bytewidth, height);
+}
+
 static void image_copy_plane_uc_from(uint8_t       *dst, ptrdiff_t dst_linesize,
                                      const uint8_t *src, ptrdiff_t src_linesize,
                                      ptrdiff_t bytewidth, int height)
@@ -339,12 +362,18 @@ void av_image_copy_plane(uint8_t       *dst, int dst_linesize,
                          const uint8_t *src, int src_linesize,
                          int bytewidth, int height)
 {
-    image_copy_plane(dst, dst_linesize, src, src_linesize, bytewidth, height);
+    if ((int64_t)bytewidth * height >= STREAM_COPY_MIN_SIZE)
+        image_copy_plane_stream(dst, dst_linesize, src, src_linesize, bytewidth, height);
+    else
+        image_copy_plane(dst, dst_linesize, src, src_linesize, bytewidth, height);
 }
 
+/* Copy the rows of the image from y0 to y1 excluded, y0 being a multiple of
+ * the vertical chroma subsampling factor. */
 static void image_copy(uint8_t *dst_data[4], const ptrdiff_t dst_linesizes[4],
                        const uint8_t *src_data[4], const ptrdiff_t src_linesizes[4],
                        enum AVPixelFormat pix_fmt, int width, int height,
+                       int y0, int y1,
                        void (*copy_plane)(uint8_t *, ptrdiff_t, const uint8_t *,
                                           ptrdiff_t, ptrdiff_t, int))
 {
@@ -355,11 +384,15 @@ static void image_copy(uint8_t *dst_data[4], const ptrdiff_t dst_linesizes[4],
 
     if (desc->flags & AV_PIX_FMT_FLAG_PAL ||
         desc->flags & AV_PIX_FMT_FLAG_PSEUDOPAL) {
-        copy_plane(dst_data[0], dst_linesizes[0],
-                   src_data[0], src_linesizes[0],
-                   width, height);
+        if (copy_plane == image_copy_plane &&
+            (int64_t)width * height >= STREAM_COPY_MIN_SIZE)
+            copy_plane = image_copy_plane_stream;
+        copy_plane(dst_data[0] + y0 * dst_linesizes[0], dst_linesizes[0],
+                   src_data[0] + y0 * src_linesizes[0], src_linesizes[0],
+                   width, y1 - y0);
         /* copy the palette */
-        memcpy(dst_data[1], src_data[1], 4*256);
+        if (!y0)
+            memcpy(dst_data[1], src_data[1], 4*256);
     } else {
         int i, planes_nb = 0;
 
@@ -367,18 +400,26 @@ static void image_copy(uint8_t *dst_data[4], const ptrdiff_t dst_linesizes[4],
             planes_nb = FFMAX(planes_nb, desc->comp[i].plane + 1);
 
         for (i = 0; i < planes_nb; i++) {
-            int h = height;
+            void (*copy)(uint8_t *, ptrdiff_t, const uint8_t *,
+                         ptrdiff_t, ptrdiff_t, int) = copy_plane;
+            int h = height, start = y0, end = y1;
             ptrdiff_t bwidth = av_image_get_linesize(pix_fmt, width, i);
             if (bwidth < 0) {
                 av_log(NULL, AV_LOG_ERROR, "av_image_get_linesize failed\n");
                 return;
             }
             if (i == 1 || i == 2) {
-                h = AV_CEIL_RSHIFT(height, desc->log2_chroma_h);
+                h     = AV_CEIL_RSHIFT(height, desc->log2_chroma_h);
+                start = y0 >> desc->log2_chroma_h;
+                end   = y1 == height ? h : y1 >> desc->log2_chroma_h;
             }
-            copy_plane(dst_data[i], dst_linesizes[i],
-                       src_data[i], src_linesizes[i],
-                       bwidth, h);
+            if (copy == image_copy_plane && bwidth * h >= STREAM_COPY_MIN_SIZE)
+                copy = image_copy_plane_stream;
+            if (!dst_data[i] || !src_data[i])
+                continue;
+            copy(dst_data[i] + start * dst_linesizes[i], dst_linesizes[i],
+                 src_data[i] + start * src_linesizes[i], src_linesizes[i],
+                 bwidth, end - start);
         }
     }
 }
@@ -396,7 +437,37 @@ void av_image_copy(uint8_t *dst_data[4], int dst_linesizes[4],
     }
 
     image_copy(dst_data, dst_linesizes1, src_data, src_linesizes1, pix_fmt,
-               width, height, image_copy_plane);
+               width, height, 0, height, image_copy_plane);
+}
+
+void av_image_copy_slice(uint8_t *dst_data[4], const int dst_linesizes[4],
+                         const uint8_t *src_data[4], const int src_linesizes[4],
+                         enum AVPixelFormat pix_fmt, int width, int height,
+                         int slice, int nb_slices)
+{
+    const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(pix_fmt);
+    ptrdiff_t dst_linesizes1[4], src_linesizes1[4];
+    int align, y0, y1, i;
+
+    if (!desc || slice < 0 || slice >= nb_slices)
+        return;
+
+    for (i = 0; i < 4; i++) {
+        dst_linesizes1[i] = dst_linesizes[i];
+        src_linesizes1[i] = src_linesizes[i];
+    }
+
+    /* keep the slices on chroma row boundaries */
+    align = 1 << desc->log2_chroma_h;
+    y0 = (int64_t)height *  slice      / nb_slices & ~(align - 1);
+    y1 = (int64_t)height * (slice + 1) / nb_slices & ~(align - 1);
+    if (slice == nb_slices - 1)
+        y1 = height;
+    if (y0 >= y1)
+        return;
+
+    image_copy(dst_data, dst_linesizes1, src_data, src_linesizes1, pix_fmt,
+               width, height, y0, y1, image_copy_plane);
 }
 
 void av_image_copy_uc_from(uint8_t *dst_data[4], const ptrdiff_t dst_linesizes[4],
@@ -404,7 +475,7 @@ void av_image_copy_uc_from(uint8_t *dst_data[4], const ptrdiff_t dst_linesizes[4
                            enum AVPixelFormat pix_fmt, int width, int height)
 {
     image_copy(dst_data, dst_linesizes, src_data, src_linesizes, pix_fmt,
-               width, height, image_copy_plane_uc_from);
+               width, height, 0, height, image_copy_plane_uc_from);
 }
 
 int av_image_fill_arrays(uint8_t *dst_data[4], int dst_linesize[4],
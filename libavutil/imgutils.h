@@ -120,6 +120,26 @@ void av_image_copy(uint8_t *dst_data[4], int dst_linesizes[4],
                    const uint8_t *src_data[4], const int src_linesizes[4],
                    enum AVPixelFormat pix_fmt, int width, int height);
 
+/**
+ * Copy one horizontal slice of the image in src_data to dst_data.
+ *
+ * The image is split in nb_slices slices of about the same height, on
+ * chroma row boundaries. Calling this function for each slice from 0 to
+ * nb_slices - 1, e.g. from the slice threading callbacks of a filter or a
+ * codec, copies the whole image as av_image_copy() does.
+ *
+ * @param dst_linesizes linesizes for the image in dst_data
+ * @param src_linesizes linesizes for the image in src_data
+ * @param width         width of the whole image
+ * @param height        height of the whole image
+ * @param slice         index of the slice to copy
+ * @param nb_slices     number of slices
+ */
+void av_image_copy_slice(uint8_t *dst_data[4], const int dst_linesizes[4],
+                         const uint8_t *src_data[4], const int src_linesizes[4],
+                         enum AVPixelFormat pix_fmt, int width, int height,
+                         int slice, int nb_slices);
+
 /**
  * Copy image data located in uncacheable (e.g. GPU mapped) memory. Where
  * available, this function will use special functionality for reading from such
@@ -26,5 +26,19 @@ int ff_image_copy_plane_uc_from_x86(uint8_t       *dst, ptrdiff_t dst_linesize,
                                     const uint8_t *src, ptrdiff_t src_linesize,
                                     ptrdiff_t bytewidth, int height);
 
+typedef void (*ff_image_copy_plane_fn)(uint8_t       *dst, ptrdiff_t dst_linesize,
+                                       const uint8_t *src, ptrdiff_t src_linesize,
+                                       ptrdiff_t bytewidth, int height);
+
+/**
+ * Get the function copying a plane with non-temporal stores for the current
+ * cpu flags, or NULL if the cpu does not support any. bytewidth must be a
+ * non-zero multiple of 64, dst and dst_linesize must be aligned on 16 bytes.
+ */
+ff_image_copy_plane_fn ff_image_get_copy_plane_stream_x86(void);
+
+int ff_image_copy_plane_stream_x86(uint8_t       *dst, ptrdiff_t dst_linesize,
+                                   const uint8_t *src, ptrdiff_t src_linesize,
+                                   ptrdiff_t bytewidth, int height);
 
 #endif /* AVUTIL_IMGUTILS_INTERNAL_H */
@@ -33,6 +33,7 @@
 #include <io.h>
 #endif
 #include <stdarg.h>
+#include <stdatomic.h>
 #include <stdlib.h>
 #include "avutil.h"
 #include "bprint.h"
@@ -40,6 +41,7 @@
 #include "internal.h"
 #include "log.h"
 #include "thread.h"
+#include "time.h"
 
 static AVMutex mutex = AV_MUTEX_INITIALIZER;
 
@@ -53,6 +55,7 @@ static AVMutex mutex = AV_MUTEX_INITIALIZER;
 
 static int av_log_level = AV_LOG_INFO;
 static int flags;
+static atomic_int print_prefix = ATOMIC_VAR_INIT(1);
 
 #define NB_LEVELS 8
 #if defined(_WIN32) && HAVE_SETCONSOLETEXTATTRIBUTE
@@ -297,60 +300,314 @@ int av_log_format_line2(void *ptr, int level, const char *fmt, va_list vl,
     return ret;
 }
 
-void av_log_default_callback(void* ptr, int level, const char* fmt, va_list vl)
+/* must be called with mutex locked */
+static void print_parts(char *part[4], const char *line, int level, unsigned tint,
+                        const int type[2], int prefix)
 {
-    static int print_prefix = 1;
     static int count;
     static char prev[LINE_SZ];
-    AVBPrint part[4];
-    char line[LINE_SZ];
     static int is_atty;
-    int type[2];
-    unsigned tint = 0;
-
-    if (level >= 0) {
-        tint = level & 0xff00;
-        level &= 0xff;
-    }
-
-    if (level > av_log_level)
-        return;
-    ff_mutex_lock(&mutex);
-
-    format_line(ptr, level, fmt, vl, part, &print_prefix, type);
-    snprintf(line, sizeof(line), "%s%s%s%s", part[0].str, part[1].str, part[2].str, part[3].str);
 
 #if HAVE_ISATTY
     if (!is_atty)
         is_atty = isatty(2) ? 1 : -1;
 #endif
 
-    if (print_prefix && (flags & AV_LOG_SKIP_REPEATED) && !strcmp(line, prev) &&
+    if (prefix && (flags & AV_LOG_SKIP_REPEATED) && !strcmp(line, prev) &&
         *line && line[strlen(line) - 1] != '\r'){
         count++;
         if (is_atty == 1)
             fprintf(stderr, "    Last message repeated %d times\r", count);
-        goto end;
+        return;
     }
     if (count > 0) {
         fprintf(stderr, "    Last message repeated %d times\n", count);
         count = 0;
     }
     strcpy(prev, line);
-    sanitize(part[0].str);
-    colored_fputs(type[0], 0, part[0].str);
-    sanitize(part[1].str);
-    colored_fputs(type[1], 0, part[1].str);
-    sanitize(part[2].str);
-    colored_fputs(av_clip(level >> 3, 0, NB_LEVELS - 1), tint >> 8, part[2].str);
-    sanitize(part[3].str);
-    colored_fputs(av_clip(level >> 3, 0, NB_LEVELS - 1), tint >> 8, part[3].str);
+    sanitize(part[0]);
+    colored_fputs(type[0], 0, part[0]);
+    sanitize(part[1]);
+    colored_fputs(type[1], 0, part[1]);
+    sanitize(part[2]);
+    colored_fputs(av_clip(level >> 3, 0, NB_LEVELS - 1), tint >> 8, part[2]);
+    sanitize(part[3]);
+    colored_fputs(av_clip(level >> 3, 0, NB_LEVELS - 1), tint >> 8, part[3]);
+}
+
+#if HAVE_THREADS
+/* number of messages the queue can hold, a power of two */
+#define QUEUE_SIZE 256
+
+typedef struct LogMessage {
+    /* position of the message in the queue + 1 when it is ready to be
+     * printed, position + QUEUE_SIZE when the slot is free */
+    atomic_uint seq;
+    int level;
+    unsigned tint;
+    int type[2];
+    int print_prefix;
+    /* the 4 parts of the message separated by NULs, in buf if they fit */
+    char *text;
+    char buf[LINE_SZ];
+} LogMessage;
+
+/**
+ * Bounded multi-producer queue of formatted messages, printed by the logging
+ * thread in order. Posting a message only takes a compare-and-swap, the
+ * mutex is only used to wake the logging thread up when it went to sleep.
+ */
+typedef struct LogQueue {
+    LogMessage *msgs;
+    atomic_uint tail;
+    unsigned head;
+    atomic_uint nb_dropped;
+    atomic_int sleeping;
+    atomic_int finished;
+    pthread_t thread;
+    pthread_mutex_t wake_mutex;
+    pthread_cond_t wake_cond;
+} LogQueue;
+
+static LogQueue *queue;
+
+static int queue_post(LogQueue *q, AVBPrint part[4], int level, unsigned tint,
+                      const int type[2], int prefix)
+{
+    unsigned pos = atomic_load_explicit(&q->tail, memory_order_relaxed);
+    size_t len[4], size;
+    LogMessage *msg;
+    char *text;
+    int i;
+
+    while (1) {
+        int diff;
+
+        msg  = &q->msgs[pos & (QUEUE_SIZE - 1)];
+        diff = atomic_load_explicit(&msg->seq, memory_order_acquire) - pos;
+        if (!diff) {
+            if (atomic_compare_exchange_weak_explicit(&q->tail, &pos, pos + 1,
+                                                      memory_order_relaxed,
+                                                      memory_order_relaxed))
+                break;
+        } else if (diff < 0) {
+            return AVERROR(EAGAIN);
+        } else {
+            pos = atomic_load_explicit(&q->tail, memory_order_relaxed);
+        }
+    }
+
+    for (i = 0, size = 0; i < 4; i++)
+        size += (len[i] = strlen(part[i].str)) + 1;
+    text = size <= sizeof(msg->buf) ? msg->buf : av_malloc(size);
+    if (text) {
+        char *p = text;
+        for (i = 0; i < 4; i++) {
+            memcpy(p, part[i].str, len[i] + 1);
+            p += len[i] + 1;
+        }
+    } else {
+        /* post an empty message, the slot is already taken */
+        text = msg->buf;
+        memset(text, 0, 4);
+    }
+    msg->text         = text;
+    msg->level        = level;
+    msg->tint         = tint;
+    msg->type[0]      = type[0];
+    msg->type[1]      = type[1];
+    msg->print_prefix = prefix;
+
+    /* sequentially consistent with the check of sleeping, see log_thread() */
+    atomic_store(&msg->seq, pos + 1);
+    if (atomic_load(&q->sleeping)) {
+        pthread_mutex_lock(&q->wake_mutex);
+        pthread_cond_signal(&q->wake_cond);
+        pthread_mutex_unlock(&q->wake_mutex);
+    }
+    return 0;
+}
+
+static void print_dropped(LogQueue *q)
+{
+    unsigned nb_dropped = atomic_exchange(&q->nb_dropped, 0);
+
+    if (nb_dropped)
+        fprintf(stderr, "    %u log messages dropped\n", nb_dropped);
+}
+
+static void print_message(LogMessage *msg)
+{
+    char line[LINE_SZ];
+    char *part[4];
+    int i;
+
+    part[0] = msg->text;
+    for (i = 1; i < 4; i++)
+        part[i] = part[i - 1] + strlen(part[i - 1]) + 1;
+    snprintf(line, sizeof(line), "%s%s%s%s", part[0], part[1], part[2], part[3]);
+    print_parts(part, line, msg->level, msg->tint, msg->type, msg->print_prefix);
+}
+
+static void *attribute_align_arg log_thread(void *arg)
+{
+    LogQueue *q = arg;
+
+    while (1) {
+        LogMessage *msg = &q->msgs[q->head & (QUEUE_SIZE - 1)];
+
+        if (atomic_load_explicit(&msg->seq, memory_order_acquire) != q->head + 1) {
+            if (atomic_load(&q->finished))
+                break;
+            /* either the poster sees sleeping set and signals, or this
+             * thread sees the message before waiting */
+            pthread_mutex_lock(&q->wake_mutex);
+            atomic_store(&q->sleeping, 1);
+            while (atomic_load(&msg->seq) != q->head + 1 && !atomic_load(&q->finished))
+                pthread_cond_wait(&q->wake_cond, &q->wake_mutex);
+            atomic_store(&q->sleeping, 0);
+            pthread_mutex_unlock(&q->wake_mutex);
+            continue;
+        }
+
+        ff_mutex_lock(&mutex);
+        print_dropped(q);
+        print_message(msg);
+        ff_mutex_unlock(&mutex);
+
+        if (msg->text != msg->buf)
+            av_free(msg->text);
+        atomic_store_explicit(&msg->seq, q->head + QUEUE_SIZE, memory_order_release);
+        q->head++;
+    }
+
+    ff_mutex_lock(&mutex);
+    print_dropped(q);
+    ff_mutex_unlock(&mutex);
+    return NULL;
+}
+
+static int start_async(void)
+{
+    LogQueue *q;
+    int i, ret;
+
+    q = av_mallocz(sizeof(*q));
+    if (!q)
+        return AVERROR(ENOMEM);
+    q->msgs = av_malloc_array(QUEUE_SIZE, sizeof(*q->msgs));
+    if (!q->msgs) {
+        av_free(q);
+        return AVERROR(ENOMEM);
+    }
+    for (i = 0; i < QUEUE_SIZE; i++)
+        atomic_init(&q->msgs[i].seq, i);
+    atomic_init(&q->tail, 0);
+    atomic_init(&q->nb_dropped, 0);
+    atomic_init(&q->sleeping, 0);
+    atomic_init(&q->finished, 0);
+
+    if ((ret = pthread_mutex_init(&q->wake_mutex, NULL))) {
+        av_free(q->msgs);
+        av_free(q);
+        return AVERROR(ret);
+    }
+    if ((ret = pthread_cond_init(&q->wake_cond, NULL))) {
+        pthread_mutex_destroy(&q->wake_mutex);
+        av_free(q->msgs);
+        av_free(q);
+        return AVERROR(ret);
+    }
+    if ((ret = pthread_create(&q->thread, NULL, log_thread, q))) {
+        pthread_cond_destroy(&q->wake_cond);
+        pthread_mutex_destroy(&q->wake_mutex);
+        av_free(q->msgs);
+        av_free(q);
+        return AVERROR(ret);
+    }
+
+    queue = q;
+    return 0;
+}
+
+static void stop_async(void)
+{
+    LogQueue *q = queue;
+
+    atomic_store(&q->finished, 1);
+    pthread_mutex_lock(&q->wake_mutex);
+    pthread_cond_signal(&q->wake_cond);
+    pthread_mutex_unlock(&q->wake_mutex);
+    pthread_join(q->thread, NULL);
+
+    pthread_cond_destroy(&q->wake_cond);
+    pthread_mutex_destroy(&q->wake_mutex);
+    av_free(q->msgs);
+    av_freep(&queue);
+}
+
+static void log_async(void *ptr, int level, unsigned tint, const char *fmt, va_list vl)
+{
+    AVBPrint part[4];
+    int type[2];
+    int prefix = atomic_load(&print_prefix);
+
+    format_line(ptr, level, fmt, vl, part, &prefix, type);
+    atomic_store(&print_prefix, prefix);
+
+    /* errors are never dropped, the caller waits for the logging thread */
+    while (queue_post(queue, part, level, tint, type, prefix) < 0) {
+        if (level > AV_LOG_ERROR) {
+            atomic_fetch_add(&queue->nb_dropped, 1);
+            break;
+        }
+        av_usleep(1000);
+    }
+    av_bprint_finalize(part+3, NULL);
+}
+#endif
+
+void av_log_default_callback(void* ptr, int level, const char* fmt, va_list vl)
+{
+    AVBPrint part[4];
+    char *parts[4];
+    char line[LINE_SZ];
+    int type[2];
+    unsigned tint = 0;
+    int prefix;
+
+    if (level >= 0) {
+        tint = level & 0xff00;
+        level &= 0xff;
+    }
+
+    if (level > av_log_level)
+        return;
+
+#if HAVE_THREADS
+    if (flags & AV_LOG_ASYNC) {
+        log_async(ptr, level, tint, fmt, vl);
+        return;
+    }
+#endif
+
+    ff_mutex_lock(&mutex);
+
+    prefix = atomic_load_explicit(&print_prefix, memory_order_relaxed);
+    format_line(ptr, level, fmt, vl, part, &prefix, type);
+    atomic_store_explicit(&print_prefix, prefix, memory_order_relaxed);
+    snprintf(line, sizeof(line), "%s%s%s%s", part[0].str, part[1].str, part[2].str, part[3].str);
+
+    parts[0] = part[0].str;
+    parts[1] = part[1].str;
+    parts[2] = part[2].str;
+    parts[3] = part[3].str;
+    print_parts(parts, line, level, tint, type, prefix);
 
 #if CONFIG_VALGRIND_BACKTRACE
     if (level <= BACKTRACE_LOGLEVEL)
         VALGRIND_PRINTF_BACKTRACE("%s", "");
 #endif
-end:
     av_bprint_finalize(part+3, NULL);
     ff_mutex_unlock(&mutex);
 }
@@ -389,6 +646,16 @@ void av_log_set_level(int level)
 
 void av_log_set_flags(int arg)
 {
+#if HAVE_THREADS
+    if ((arg ^ flags) & AV_LOG_ASYNC) {
+        if (!(arg & AV_LOG_ASYNC))
+            stop_async();
+        else if (start_async() < 0)
+            arg &= ~AV_LOG_ASYNC;
+    }
+#else
+    arg &= ~AV_LOG_ASYNC;
+#endif
     flags = arg;
 }
 
@@ -352,6 +352,21 @@ int av_log_format_line2(void *ptr, int level, const char *fmt, va_list vl,
  */
 #define AV_LOG_PRINT_LEVEL 2
 
+/**
+ * Print the messages of the default callback from a separate thread.
+ *
+ * The messages are still formatted by the calling thread, but then posted
+ * to a lock-free queue instead of being written while holding a global
+ * lock, so that threads logging at a high rate do not wait for each other
+ * or for the terminal. When the queue is full, messages less severe than
+ * AV_LOG_ERROR are dropped and counted, errors wait for room in the queue.
+ *
+ * Clearing the flag waits for the queued messages to be printed; it must
+ * be done before exiting the program. The flag must not be changed while
+ * other threads may be logging. It is ignored without thread support.
+ */
+#define AV_LOG_ASYNC 4
+
 void av_log_set_flags(int arg);
 int av_log_get_flags(void);
 
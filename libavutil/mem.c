@@ -24,17 +24,25 @@
  * default memory allocator for libavutil
  */
 
+#define _DEFAULT_SOURCE
 #define _XOPEN_SOURCE 600
 
 #include "config.h"
 
 #include <limits.h>
+#include <stdatomic.h>
 #include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 #if HAVE_MALLOC_H
 #include <malloc.h>
 #endif
+#if HAVE_MMAP
+#include <sys/mman.h>
+#endif
+#if HAVE_PTHREADS
+#include <pthread.h>
+#endif
 
 #include "avassert.h"
 #include "avutil.h"
@@ -74,14 +82,297 @@ void av_max_alloc(size_t max){
     max_alloc_size = max;
 }
 
+#if defined(MAP_ANON) && !defined(MAP_ANONYMOUS)
+#define MAP_ANONYMOUS MAP_ANON
+#endif
+#ifndef MAP_NORESERVE
+#define MAP_NORESERVE 0
+#endif
+
+#if HAVE_MMAP && HAVE_PTHREADS && defined(MAP_ANONYMOUS)
+#define SLAB_SUPPORTED 1
+#else
+#define SLAB_SUPPORTED 0
+#endif
+
+#if HAVE_MMAP && HAVE_POSIX_MEMALIGN && defined(MADV_HUGEPAGE)
+#define HUGE_PAGES_SUPPORTED 1
+#else
+#define HUGE_PAGES_SUPPORTED 0
+#endif
+
+#define SUPPORTED_FLAGS ((SLAB_SUPPORTED       ? AV_MEM_FLAG_SLAB       : 0) | \
+                         (HUGE_PAGES_SUPPORTED ? AV_MEM_FLAG_HUGE_PAGES : 0) | \
+                         AV_MEM_FLAG_COUNTERS)
+
+static atomic_int mem_flags;
+static atomic_uint_least64_t mem_counters[AV_MEM_COUNTER_NB];
+
+static inline void count(int flags, enum AVMemCounter counter)
+{
+    if (flags & AV_MEM_FLAG_COUNTERS)
+        atomic_fetch_add_explicit(&mem_counters[counter], 1, memory_order_relaxed);
+}
+
+#if SLAB_SUPPORTED
+/* The slab blocks are carved out of chunks of a single reserved address
+ * range, so that av_realloc() and av_free() recognize them with a range check
+ * and find their size class in a table indexed by chunk. Each thread keeps a
+ * magazine of free blocks per class, exchanged in batches with the depot of
+ * the class, which is shared by all threads and protected by a mutex. */
+
+#define SLAB_RANGE_SIZE ((size_t)1 << (sizeof(void *) > 4 ? 30 : 26))
+#define SLAB_CHUNK_BITS 16
+#define SLAB_NB_CHUNKS  (SLAB_RANGE_SIZE >> SLAB_CHUNK_BITS)
+#define SLAB_MAX_SIZE   1024
+#define SLAB_NB_CLASSES 10
+#define MAGAZINE_SIZE   64
+
+static const uint16_t slab_min_sizes[SLAB_NB_CLASSES] = {
+    32, 64, 96, 128, 192, 256, 384, 512, 768, 1024,
+};
+
+typedef struct SlabDepot {
+    pthread_mutex_t lock;
+    void *free_list;        ///< free blocks, linked through their first bytes
+} SlabDepot;
+
+typedef struct SlabMagazines {
+    int   nb_blocks[SLAB_NB_CLASSES];
+    void *blocks[SLAB_NB_CLASSES][MAGAZINE_SIZE];
+} SlabMagazines;
+
+static pthread_once_t slab_once = PTHREAD_ONCE_INIT;
+static pthread_key_t  slab_key;
+static atomic_uintptr_t slab_base;
+static atomic_size_t  slab_nb_chunks;
+static SlabDepot      slab_depots[SLAB_NB_CLASSES];
+static size_t         slab_sizes[SLAB_NB_CLASSES];
+static uint8_t        slab_size_classes[SLAB_MAX_SIZE >> 5];
+static uint8_t        slab_chunk_classes[SLAB_NB_CHUNKS];
+
+static void slab_push(int cls, void *first, void *last)
+{
+    SlabDepot *depot = &slab_depots[cls];
+
+    pthread_mutex_lock(&depot->lock);
+    memcpy(last, &depot->free_list, sizeof(void *));
+    depot->free_list = first;
+    pthread_mutex_unlock(&depot->lock);
+}
+
+static void slab_flush(SlabMagazines *mags, int cls, int nb)
+{
+    void **blocks = &mags->blocks[cls][mags->nb_blocks[cls] - nb];
+    int i;
+
+    for (i = 0; i < nb - 1; i++)
+        memcpy(blocks[i], &blocks[i + 1], sizeof(void *));
+    slab_push(cls, blocks[0], blocks[nb - 1]);
+    mags->nb_blocks[cls] -= nb;
+}
+
+static void slab_free_magazines(void *arg)
+{
+    SlabMagazines *mags = arg;
+    int cls;
+
+    for (cls = 0; cls < SLAB_NB_CLASSES; cls++)
+        if (mags->nb_blocks[cls])
+            slab_flush(mags, cls, mags->nb_blocks[cls]);
+    free(mags);
+}
+
+static void slab_init(void)
+{
+    void *base;
+    int cls, i;
+
+    for (cls = 0, i = 0; cls < SLAB_NB_CLASSES; cls++) {
+        slab_sizes[cls] = FFALIGN(slab_min_sizes[cls], ALIGN);
+        for (; i < FF_ARRAY_ELEMS(slab_size_classes) && (i + 1) << 5 <= slab_sizes[cls]; i++)
+            slab_size_classes[i] = cls;
+        if (pthread_mutex_init(&slab_depots[cls].lock, NULL))
+            return;
+    }
+    if (pthread_key_create(&slab_key, slab_free_magazines))
+        return;
+
+    base = mmap(NULL, SLAB_RANGE_SIZE, PROT_READ | PROT_WRITE,
+                MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (base == MAP_FAILED)
+        return;
+    atomic_store_explicit(&slab_base, (uintptr_t)base, memory_order_release);
+}
+
+/* Return the class of a slab block, -1 for other blocks. */
+static inline int slab_class(void *ptr)
+{
+    uintptr_t base = atomic_load_explicit(&slab_base, memory_order_relaxed);
+
+    if (!base || (uintptr_t)ptr - base >= SLAB_RANGE_SIZE)
+        return -1;
+    return slab_chunk_classes[((uintptr_t)ptr - base) >> SLAB_CHUNK_BITS];
+}
+
+/* Fill half of an empty magazine from the depot, carving a new chunk if the
+ * depot is empty too. */
+static int slab_refill(SlabMagazines *mags, int cls)
+{
+    SlabDepot *depot = &slab_depots[cls];
+    void **blocks = mags->blocks[cls];
+    int nb = 0;
+
+    pthread_mutex_lock(&depot->lock);
+    if (!depot->free_list) {
+        uint8_t *base = (uint8_t *)atomic_load_explicit(&slab_base, memory_order_relaxed);
+        size_t chunk  = atomic_fetch_add_explicit(&slab_nb_chunks, 1, memory_order_relaxed);
+        size_t size   = slab_sizes[cls];
+        uint8_t *p, *end;
+
+        if (chunk >= SLAB_NB_CHUNKS) {
+            pthread_mutex_unlock(&depot->lock);
+            return AVERROR(ENOMEM);
+        }
+        slab_chunk_classes[chunk] = cls;
+        p   = base + (chunk << SLAB_CHUNK_BITS);
+        end = p + ((1 << SLAB_CHUNK_BITS) / size - 1) * size;
+        for (; p < end; p += size)
+            memcpy(p, &(void *){ p + size }, sizeof(void *));
+        memcpy(end, &(void *){ NULL }, sizeof(void *));
+        depot->free_list = base + (chunk << SLAB_CHUNK_BITS);
+    }
+    while (depot->free_list && nb < MAGAZINE_SIZE / 2) {
+        blocks[nb] = depot->free_list;
+        memcpy(&depot->free_list, blocks[nb++], sizeof(void *));
+    }
+    pthread_mutex_unlock(&depot->lock);
+
+    mags->nb_blocks[cls] = nb;
+    return 0;
+}
+
+static void *slab_alloc(size_t size, int flags)
+{
+    SlabMagazines *mags;
+    int cls;
+
+    pthread_once(&slab_once, slab_init);
+    if (!atomic_load_explicit(&slab_base, memory_order_relaxed))
+        return NULL;
+
+    mags = pthread_getspecific(slab_key);
+    if (!mags) {
+        mags = malloc(sizeof(*mags));
+        if (!mags)
+            return NULL;
+        memset(mags->nb_blocks, 0, sizeof(mags->nb_blocks));
+        if (pthread_setspecific(slab_key, mags)) {
+            free(mags);
+            return NULL;
+        }
+    }
+
+    cls = slab_size_classes[(size - 1) >> 5];
+    if (!mags->nb_blocks[cls] && slab_refill(mags, cls) < 0)
+        return NULL;
+    count(flags, AV_MEM_COUNTER_SLAB_ALLOCS);
+    return mags->blocks[cls][--mags->nb_blocks[cls]];
+}
+
+static void slab_free(void *ptr, int cls)
+{
+    SlabMagazines *mags = pthread_getspecific(slab_key);
+
+    /* Threads which never allocate from the slabs do not get magazines. */
+    if (!mags) {
+        slab_push(cls, ptr, ptr);
+        return;
+    }
+    if (mags->nb_blocks[cls] == MAGAZINE_SIZE)
+        slab_flush(mags, cls, MAGAZINE_SIZE / 2);
+    mags->blocks[cls][mags->nb_blocks[cls]++] = ptr;
+}
+
+static void *slab_realloc(void *ptr, int cls, size_t size, int flags)
+{
+    size_t old_size = slab_sizes[cls];
+    void *new_ptr = NULL;
+
+    if (size <= old_size && (!cls || size > slab_sizes[cls - 1]))
+        return ptr;
+    if (size && size <= SLAB_MAX_SIZE && flags & AV_MEM_FLAG_SLAB)
+        new_ptr = slab_alloc(size, flags);
+    if (!new_ptr)
+        new_ptr = malloc(size + !size);
+    if (!new_ptr)
+        return NULL;
+    memcpy(new_ptr, ptr, FFMIN(size, old_size));
+    slab_free(ptr, cls);
+    return new_ptr;
+}
+#endif /* SLAB_SUPPORTED */
+
+#if HUGE_PAGES_SUPPORTED
+#define HUGE_PAGE_SIZE (2 << 20)
+
+static void *huge_alloc(size_t size, int flags)
+{
+    void *ptr;
+
+    if (posix_memalign(&ptr, HUGE_PAGE_SIZE, size))
+        return NULL;
+    /* This is only a hint, failing is harmless. */
+    madvise(ptr, size, MADV_HUGEPAGE);
+    count(flags, AV_MEM_COUNTER_HUGE_ALLOCS);
+    return ptr;
+}
+#endif
+
+void av_mem_set_flags(int flags)
+{
+#if SLAB_SUPPORTED
+    if (flags & AV_MEM_FLAG_SLAB) {
+        pthread_once(&slab_once, slab_init);
+        if (!atomic_load_explicit(&slab_base, memory_order_relaxed))
+            flags &= ~AV_MEM_FLAG_SLAB;
+    }
+#endif
+    atomic_store_explicit(&mem_flags, flags & SUPPORTED_FLAGS, memory_order_relaxed);
+}
+
+int av_mem_get_flags(void)
+{
+    return atomic_load_explicit(&mem_flags, memory_order_relaxed);
+}
+
+uint64_t av_mem_get_counter(enum AVMemCounter counter)
+{
+    if ((unsigned)counter >= AV_MEM_COUNTER_NB)
+        return 0;
+    return atomic_load_explicit(&mem_counters[counter], memory_order_relaxed);
+}
+
 void *av_malloc(size_t size)
 {
     void *ptr = NULL;
+    int flags = atomic_load_explicit(&mem_flags, memory_order_relaxed);
 
     /* let's disallow possibly ambiguous cases */
     if (size > (max_alloc_size - 32))
         return NULL;
 
+#if SLAB_SUPPORTED
+    if (flags & AV_MEM_FLAG_SLAB && size && size <= SLAB_MAX_SIZE)
+        ptr = slab_alloc(size, flags);
+#endif
+#if HUGE_PAGES_SUPPORTED
+    if (flags & AV_MEM_FLAG_HUGE_PAGES && size >= HUGE_PAGE_SIZE)
+        ptr = huge_alloc(size, flags);
+#endif
+    if (ptr)
+        goto end;
+
 #if HAVE_POSIX_MEMALIGN
     if (size) //OS X on SDK 10.6 has a broken posix_memalign implementation
     if (posix_memalign(&ptr, ALIGN, size))
@@ -124,7 +415,11 @@ void *av_malloc(size_t size)
     if(!ptr && !size) {
         size = 1;
         ptr= av_malloc(1);
+        return ptr;
     }
+end:
+    if (ptr)
+        count(flags, AV_MEM_COUNTER_ALLOCS);
 #if CONFIG_MEMORY_POISONING
     if (ptr)
         memset(ptr, FF_MEMORY_POISON, size);
@@ -134,10 +429,24 @@ void *av_malloc(size_t size)
 
 void *av_realloc(void *ptr, size_t size)
 {
+    int flags = atomic_load_explicit(&mem_flags, memory_order_relaxed);
+#if SLAB_SUPPORTED
+    int cls;
+#endif
+
     /* let's disallow possibly ambiguous cases */
     if (size > (max_alloc_size - 32))
         return NULL;
 
+    count(flags, ptr ? AV_MEM_COUNTER_REALLOCS : AV_MEM_COUNTER_ALLOCS);
+#if SLAB_SUPPORTED
+    if (!ptr && flags & AV_MEM_FLAG_SLAB && size && size <= SLAB_MAX_SIZE &&
+        (ptr = slab_alloc(size, flags)))
+        return ptr;
+    if ((cls = slab_class(ptr)) >= 0)
+        return slab_realloc(ptr, cls, size, flags);
+#endif
+
 #if HAVE_ALIGNED_MALLOC
     return _aligned_realloc(ptr, size + !size, ALIGN);
 #else
@@ -217,6 +526,20 @@ int av_reallocp_array(void *ptr, size_t nmemb, size_t size)
 
 void av_free(void *ptr)
 {
+#if SLAB_SUPPORTED
+    int cls;
+#endif
+
+    if (ptr)
+        count(atomic_load_explicit(&mem_flags, memory_order_relaxed),
+              AV_MEM_COUNTER_FREES);
+#if SLAB_SUPPORTED
+    if ((cls = slab_class(ptr)) >= 0) {
+        slab_free(ptr, cls);
+        return;
+    }
+#endif
+
 #if HAVE_ALIGNED_MALLOC
     _aligned_free(ptr);
 #else
@@ -692,6 +692,66 @@ static inline int av_size_mult(size_t a, size_t b, size_t *r)
  */
 void av_max_alloc(size_t max);
 
+/**
+ * Serve small blocks from size-class slab caches instead of the system
+ * allocator.
+ *
+ * Blocks of up to 1024 bytes are carved out of a reserved address range and
+ * recycled through per-thread caches, which makes the many small allocations
+ * done for each frame and packet (side data, metadata, the structures
+ * themselves) cheap and lock-free in the common case. The memory of freed
+ * blocks is kept for reuse and never returned to the system.
+ *
+ * Only available on systems with mmap() and POSIX threads, ignored elsewhere.
+ */
+#define AV_MEM_FLAG_SLAB       (1 << 0)
+/**
+ * Align blocks of 2 MiB and more on a 2 MiB boundary and ask the system to
+ * back them with transparent huge pages. This reduces TLB misses when
+ * processing large frames. Only available on Linux, ignored elsewhere.
+ */
+#define AV_MEM_FLAG_HUGE_PAGES (1 << 1)
+/**
+ * Count allocations, see av_mem_get_counter().
+ */
+#define AV_MEM_FLAG_COUNTERS   (1 << 2)
+
+/**
+ * Set the flags controlling the behaviour of the @ref lavu_mem_funcs
+ * "heap management functions".
+ *
+ * The flags may be changed at any time: blocks allocated with any set of
+ * flags may be reallocated and freed with any other. As before, blocks must
+ * only be reallocated and freed with the functions of this file.
+ *
+ * @param flags a combination of AV_MEM_FLAG_*
+ */
+void av_mem_set_flags(int flags);
+
+/**
+ * @return the flags set with av_mem_set_flags(), without the ones not
+ *         supported on this system
+ */
+int av_mem_get_flags(void);
+
+enum AVMemCounter {
+    AV_MEM_COUNTER_ALLOCS,      ///< blocks allocated, including reallocations of NULL
+    AV_MEM_COUNTER_REALLOCS,    ///< blocks reallocated
+    AV_MEM_COUNTER_FREES,       ///< blocks freed, excluding NULL
+    AV_MEM_COUNTER_SLAB_ALLOCS, ///< blocks allocated from the slab caches
+    AV_MEM_COUNTER_HUGE_ALLOCS, ///< blocks allocated with huge pages
+    AV_MEM_COUNTER_NB           ///< Not part of ABI
+};
+
+/**
+ * Get the value of an allocation counter. Counters are only incremented
+ * while AV_MEM_FLAG_COUNTERS is set.
+ *
+ * @param counter the counter to read
+ * @return the number of operations counted since the start of the process
+ */
+uint64_t av_mem_get_counter(enum AVMemCounter counter);
+
 /**
  * @}
  * @}
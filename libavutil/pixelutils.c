@@ -51,12 +51,14 @@ DECLARE_BLOCK_FUNCTIONS(2)
 DECLARE_BLOCK_FUNCTIONS(4)
 DECLARE_BLOCK_FUNCTIONS(8)
 DECLARE_BLOCK_FUNCTIONS(16)
+DECLARE_BLOCK_FUNCTIONS(32)
 
 static const av_pixelutils_sad_fn sad_c[] = {
     block_sad_2x2_c,
     block_sad_4x4_c,
     block_sad_8x8_c,
     block_sad_16x16_c,
+    block_sad_32x32_c,
 };
 
 #endif /* CONFIG_PIXELUTILS */
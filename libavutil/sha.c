@@ -23,12 +23,17 @@
 
 #include <string.h>
 
+#include "config.h"
 #include "attributes.h"
 #include "avutil.h"
 #include "bswap.h"
 #include "sha.h"
 #include "intreadwrite.h"
 #include "mem.h"
+#include "sha_internal.h"
+#if ARCH_X86
+#include "x86/sha.h"
+#endif
 
 /** hash context */
 typedef struct AVSHA {
@@ -37,7 +42,7 @@ typedef struct AVSHA {
     uint8_t  buffer[64];  ///< 512-bit buffer of input values used in hash updating
     uint32_t state[8];    ///< current hash value
     /** function used to update hash for 512-bit input block */
-    void     (*transform)(uint32_t *state, const uint8_t buffer[64]);
+    ff_sha_transform_fn transform;
 } AVSHA;
 
 const int av_sha_size = sizeof(AVSHA);
@@ -269,6 +274,26 @@ static void sha256_transform(uint32_t *state, const uint8_t buffer[64])
     state[7] += h;
 }
 
+ff_sha_transform_fn ff_sha_get_transform(int bits)
+{
+    ff_sha_transform_fn transform;
+
+    switch (bits) {
+    case 160:
+        transform = sha1_transform;
+        break;
+    case 224:
+    case 256:
+        transform = sha256_transform;
+        break;
+    default:
+        return NULL;
+    }
+#if ARCH_X86
+    ff_sha_init_x86(&transform, bits);
+#endif
+    return transform;
+}
 
 av_cold int av_sha_init(AVSHA *ctx, int bits)
 {
@@ -280,7 +305,6 @@ av_cold int av_sha_init(AVSHA *ctx, int bits)
         ctx->state[2] = 0x98BADCFE;
         ctx->state[3] = 0x10325476;
         ctx->state[4] = 0xC3D2E1F0;
-        ctx->transform = sha1_transform;
         break;
     case 224: // SHA-224
         ctx->state[0] = 0xC1059ED8;
@@ -291,7 +315,6 @@ av_cold int av_sha_init(AVSHA *ctx, int bits)
         ctx->state[5] = 0x68581511;
         ctx->state[6] = 0x64F98FA7;
         ctx->state[7] = 0xBEFA4FA4;
-        ctx->transform = sha256_transform;
         break;
     case 256: // SHA-256
         ctx->state[0] = 0x6A09E667;
@@ -302,11 +325,11 @@ av_cold int av_sha_init(AVSHA *ctx, int bits)
         ctx->state[5] = 0x9B05688C;
         ctx->state[6] = 0x1F83D9AB;
         ctx->state[7] = 0x5BE0CD19;
-        ctx->transform = sha256_transform;
         break;
     default:
         return AVERROR(EINVAL);
     }
+    ctx->transform = ff_sha_get_transform(bits);
     ctx->count = 0;
     return 0;
 }
@@ -0,0 +1,35 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef AVUTIL_SHA_INTERNAL_H
+#define AVUTIL_SHA_INTERNAL_H
+
+#include <stdint.h>
+
+typedef void (*ff_sha_transform_fn)(uint32_t *state, const uint8_t buffer[64]);
+
+/**
+ * Get the function transforming the state of a SHA-1 or SHA-2 hash with a
+ * 64 bytes block, for the current cpu flags.
+ *
+ * @param bits number of bits of the digest
+ * @return the function, NULL if bits is not supported
+ */
+ff_sha_transform_fn ff_sha_get_transform(int bits);
+
+#endif /* AVUTIL_SHA_INTERNAL_H */
@@ -17,91 +17,266 @@
  */
 
 #include <stdatomic.h>
+#include <stdint.h>
 #include "slicethread.h"
+#include "threadpool_internal.h"
+#include "cpu.h"
 #include "mem.h"
 #include "thread.h"
+#include "trace.h"
 #include "avassert.h"
 
 #if HAVE_PTHREADS || HAVE_W32THREADS || HAVE_OS2THREADS
 
+/* Number of times a thread polls for new work or for the end of an execute
+ * call before it goes to sleep on a condition variable. This avoids the
+ * sleep/wakeup round trip when execute is called many times in a row. */
+#define SPIN_COUNT 1000
+
 typedef struct WorkerContext {
     AVSliceThread   *ctx;
     pthread_mutex_t mutex;
     pthread_cond_t  cond;
     pthread_t       thread;
-    int             done;
+    atomic_uint     work;           ///< bumped by execute when this worker takes part
+    atomic_int      sleeping;       ///< set while waiting on cond
 } WorkerContext;
 
+/* range of jobs owned by one thread, first job in the high 32 bits and the
+ * end in the low 32 bits, so that both can be updated with a single CAS */
+typedef struct JobRange {
+    atomic_uint_least64_t range;
+    uint8_t padding[64 - sizeof(atomic_uint_least64_t)];
+} JobRange;
+
 struct AVSliceThread {
     WorkerContext   *workers;
+    JobRange        *ranges;
     int             nb_threads;
     int             nb_active_threads;
     int             nb_jobs;
+    int             flags;
+    int             spin_count;
+    unsigned        generation;
 
     atomic_uint     first_job;
     atomic_uint     current_job;
+    atomic_int      nb_running;
     pthread_mutex_t done_mutex;
     pthread_cond_t  done_cond;
-    int             done;
+    atomic_int      done;
+    atomic_int      waiting;
     int             finished;
 
     void            *priv;
     void            (*worker_func)(void *priv, int jobnr, int threadnr, int nb_jobs, int nb_threads);
     void            (*main_func)(void *priv);
+
+    AVThreadPool    *pool;
+    ThreadPoolTask  task;
 };
 
+static av_always_inline void cpu_relax(void)
+{
+#if ARCH_X86 && HAVE_INLINE_ASM
+    __asm__ volatile ("pause" ::: "memory");
+#endif
+}
+
+static int range_pop(JobRange *r, unsigned *jobnr)
+{
+    uint_least64_t v = atomic_load_explicit(&r->range, memory_order_relaxed);
+
+    do {
+        if ((v >> 32) >= (uint32_t)v)
+            return 0;
+    } while (!atomic_compare_exchange_weak_explicit(&r->range, &v, v + (UINT64_C(1) << 32),
+                                                    memory_order_relaxed, memory_order_relaxed));
+    *jobnr = v >> 32;
+    return 1;
+}
+
+/* take the upper half of the jobs left in victim, run the first of them
+ * and keep the others in the own range, which is empty at this point */
+static int range_steal(JobRange *own, JobRange *victim, unsigned *jobnr)
+{
+    uint_least64_t v = atomic_load_explicit(&victim->range, memory_order_relaxed);
+    unsigned first, end, split;
+
+    do {
+        first = v >> 32;
+        end   = v;
+        if (first >= end)
+            return 0;
+        split = end - (end - first + 1) / 2;
+    } while (!atomic_compare_exchange_weak_explicit(&victim->range, &v,
+                                                    (uint_least64_t)first << 32 | split,
+                                                    memory_order_relaxed, memory_order_relaxed));
+
+    atomic_store_explicit(&own->range, (uint_least64_t)(split + 1) << 32 | end,
+                          memory_order_relaxed);
+    *jobnr = split;
+    return 1;
+}
+
+static void run_unordered_jobs(AVSliceThread *ctx, unsigned threadnr)
+{
+    unsigned nb_jobs           = ctx->nb_jobs;
+    unsigned nb_active_threads = ctx->nb_active_threads;
+    JobRange *own = &ctx->ranges[threadnr];
+    unsigned jobnr, i;
+
+    while (1) {
+        if (!range_pop(own, &jobnr)) {
+            for (i = 1; i < nb_active_threads; i++)
+                if (range_steal(own, &ctx->ranges[(threadnr + i) % nb_active_threads], &jobnr))
+                    break;
+            if (i == nb_active_threads)
+                return;
+        }
+        ctx->worker_func(ctx->priv, jobnr, threadnr, nb_jobs, nb_active_threads);
+    }
+}
+
+/* returns 1 for the last thread to finish */
 static int run_jobs(AVSliceThread *ctx)
 {
     unsigned nb_jobs    = ctx->nb_jobs;
     unsigned nb_active_threads = ctx->nb_active_threads;
     unsigned first_job    = atomic_fetch_add_explicit(&ctx->first_job, 1, memory_order_acq_rel);
     unsigned current_job  = first_job;
+    int64_t trace_start   = av_trace_begin();
+
+    if (ctx->flags & AVPRIV_SLICETHREAD_FLAG_UNORDERED) {
+        run_unordered_jobs(ctx, first_job);
+    } else {
+        do {
+            ctx->worker_func(ctx->priv, current_job, first_job, nb_jobs, nb_active_threads);
+        } while ((current_job = atomic_fetch_add_explicit(&ctx->current_job, 1, memory_order_acq_rel)) < nb_jobs);
+    }
+    av_trace_end("thread", "slice jobs", trace_start);
 
-    do {
-        ctx->worker_func(ctx->priv, current_job, first_job, nb_jobs, nb_active_threads);
-    } while ((current_job = atomic_fetch_add_explicit(&ctx->current_job, 1, memory_order_acq_rel)) < nb_jobs);
+    return atomic_fetch_sub_explicit(&ctx->nb_running, 1, memory_order_acq_rel) == 1;
+}
 
-    return current_job == nb_jobs + nb_active_threads - 1;
+/* The flag/waiting pairs below use sequentially consistent accesses: either
+ * the setter sees the waiter asleep and signals it under the mutex, or the
+ * waiter sees the flag before going to sleep. */
+static void signal_done(AVSliceThread *ctx)
+{
+    atomic_store(&ctx->done, 1);
+    if (atomic_load(&ctx->waiting)) {
+        pthread_mutex_lock(&ctx->done_mutex);
+        pthread_cond_signal(&ctx->done_cond);
+        pthread_mutex_unlock(&ctx->done_mutex);
+    }
 }
 
-static void *attribute_align_arg thread_worker(void *v)
+static void wait_done(AVSliceThread *ctx)
+{
+    int i;
+
+    for (i = 0; i < ctx->spin_count; i++) {
+        if (atomic_load_explicit(&ctx->done, memory_order_acquire))
+            break;
+        cpu_relax();
+    }
+
+    if (!atomic_load(&ctx->done)) {
+        pthread_mutex_lock(&ctx->done_mutex);
+        atomic_store(&ctx->waiting, 1);
+        while (!atomic_load(&ctx->done))
+            pthread_cond_wait(&ctx->done_cond, &ctx->done_mutex);
+        atomic_store(&ctx->waiting, 0);
+        pthread_mutex_unlock(&ctx->done_mutex);
+    }
+    atomic_store_explicit(&ctx->done, 0, memory_order_relaxed);
+}
+
+static void wake_worker(WorkerContext *w, unsigned work)
+{
+    atomic_store(&w->work, work);
+    if (atomic_load(&w->sleeping)) {
+        pthread_mutex_lock(&w->mutex);
+        pthread_cond_signal(&w->cond);
+        pthread_mutex_unlock(&w->mutex);
+    }
+}
+
+static unsigned wait_work(WorkerContext *w, unsigned seen)
 {
-    WorkerContext *w = v;
     AVSliceThread *ctx = w->ctx;
+    unsigned work;
+    int i;
+
+    for (i = 0; i < ctx->spin_count; i++) {
+        if ((work = atomic_load_explicit(&w->work, memory_order_acquire)) != seen)
+            return work;
+        cpu_relax();
+    }
 
     pthread_mutex_lock(&w->mutex);
-    pthread_cond_signal(&w->cond);
+    atomic_store(&w->sleeping, 1);
+    while ((work = atomic_load(&w->work)) == seen)
+        pthread_cond_wait(&w->cond, &w->mutex);
+    atomic_store(&w->sleeping, 0);
+    pthread_mutex_unlock(&w->mutex);
 
-    while (1) {
-        w->done = 1;
-        while (w->done)
-            pthread_cond_wait(&w->cond, &w->mutex);
+    return work;
+}
+
+/* With a shared pool, the threads taking part are not known in advance, so
+ * each one claims a thread number first and then takes jobs until none are
+ * left. Completion is tracked by the pool, see execute_pool(). */
+static void run_pool_jobs(AVSliceThread *ctx)
+{
+    unsigned nb_jobs           = ctx->nb_jobs;
+    unsigned nb_active_threads = ctx->nb_active_threads;
+    unsigned threadnr = atomic_fetch_add_explicit(&ctx->first_job, 1, memory_order_relaxed);
+    unsigned jobnr;
+    int64_t trace_start;
 
-        if (ctx->finished) {
-            pthread_mutex_unlock(&w->mutex);
+    if (threadnr >= nb_active_threads)
+        return;
+
+    trace_start = av_trace_begin();
+    while ((jobnr = atomic_fetch_add_explicit(&ctx->current_job, 1, memory_order_acq_rel)) < nb_jobs)
+        ctx->worker_func(ctx->priv, jobnr, threadnr, nb_jobs, nb_active_threads);
+    av_trace_end("thread", "slice jobs", trace_start);
+}
+
+static void pool_worker(void *priv)
+{
+    run_pool_jobs(priv);
+}
+
+static void *attribute_align_arg thread_worker(void *v)
+{
+    WorkerContext *w = v;
+    AVSliceThread *ctx = w->ctx;
+    unsigned work = 0;
+
+    while (1) {
+        work = wait_work(w, work);
+        if (ctx->finished)
             return NULL;
-        }
 
-        if (run_jobs(ctx)) {
-            pthread_mutex_lock(&ctx->done_mutex);
-            ctx->done = 1;
-            pthread_cond_signal(&ctx->done_cond);
-            pthread_mutex_unlock(&ctx->done_mutex);
-        }
+        if (run_jobs(ctx))
+            signal_done(ctx);
     }
 }
 
-int avpriv_slicethread_create(AVSliceThread **pctx, void *priv,
-                              void (*worker_func)(void *priv, int jobnr, int threadnr, int nb_jobs, int nb_threads),
-                              void (*main_func)(void *priv),
-                              int nb_threads)
+static int create_threads(AVSliceThread **pctx, void *priv,
+                          void (*worker_func)(void *priv, int jobnr, int threadnr, int nb_jobs, int nb_threads),
+                          void (*main_func)(void *priv),
+                          int nb_threads, int flags)
 {
     AVSliceThread *ctx;
+    int nb_cpus = av_cpu_count();
     int nb_workers, i;
 
     av_assert0(nb_threads >= 0);
     if (!nb_threads) {
-        int nb_cpus = av_cpu_count();
         if (nb_cpus > 1)
             nb_threads = nb_cpus + 1;
         else
@@ -121,79 +296,157 @@ int avpriv_slicethread_create(AVSliceThread **pctx, void *priv,
         return AVERROR(ENOMEM);
     }
 
+    if ((flags & AVPRIV_SLICETHREAD_FLAG_UNORDERED) &&
+        !(ctx->ranges = av_calloc(nb_threads, sizeof(*ctx->ranges)))) {
+        av_freep(&ctx->workers);
+        av_freep(pctx);
+        return AVERROR(ENOMEM);
+    }
+
     ctx->priv        = priv;
     ctx->worker_func = worker_func;
     ctx->main_func   = main_func;
     ctx->nb_threads  = nb_threads;
     ctx->nb_active_threads = 0;
     ctx->nb_jobs     = 0;
+    ctx->flags       = flags;
     ctx->finished    = 0;
+    /* spinning only pays off if the waited for threads can run meanwhile */
+    ctx->spin_count  = nb_cpus > 1 ? SPIN_COUNT : 0;
 
     atomic_init(&ctx->first_job, 0);
     atomic_init(&ctx->current_job, 0);
+    atomic_init(&ctx->nb_running, 0);
+    atomic_init(&ctx->done, 0);
+    atomic_init(&ctx->waiting, 0);
     pthread_mutex_init(&ctx->done_mutex, NULL);
     pthread_cond_init(&ctx->done_cond, NULL);
-    ctx->done        = 0;
 
     for (i = 0; i < nb_workers; i++) {
         WorkerContext *w = &ctx->workers[i];
         int ret;
         w->ctx = ctx;
+        atomic_init(&w->work, 0);
+        atomic_init(&w->sleeping, 0);
         pthread_mutex_init(&w->mutex, NULL);
         pthread_cond_init(&w->cond, NULL);
-        pthread_mutex_lock(&w->mutex);
-        w->done = 0;
 
         if (ret = pthread_create(&w->thread, NULL, thread_worker, w)) {
             ctx->nb_threads = main_func ? i : i + 1;
-            pthread_mutex_unlock(&w->mutex);
             pthread_cond_destroy(&w->cond);
             pthread_mutex_destroy(&w->mutex);
             avpriv_slicethread_free(pctx);
             return AVERROR(ret);
         }
-
-        while (!w->done)
-            pthread_cond_wait(&w->cond, &w->mutex);
-        pthread_mutex_unlock(&w->mutex);
     }
 
     return nb_threads;
 }
 
+int avpriv_slicethread_create_pool(AVSliceThread **pctx, AVThreadPool *pool,
+                                   const void *owner, void *priv,
+                                   void (*worker_func)(void *priv, int jobnr, int threadnr, int nb_jobs, int nb_threads),
+                                   void (*main_func)(void *priv),
+                                   int nb_threads, int flags)
+{
+    AVSliceThread *ctx;
+
+    /* main_func may wait for jobs that a busy pool would not start */
+    if (!pool || main_func)
+        return create_threads(pctx, priv, worker_func, main_func, nb_threads, flags);
+
+    av_assert0(nb_threads >= 0);
+    if (!nb_threads)
+        nb_threads = av_thread_pool_get_nb_threads(pool) + 1;
+
+    *pctx = ctx = av_mallocz(sizeof(*ctx));
+    if (!ctx)
+        return AVERROR(ENOMEM);
+
+    ctx->priv        = priv;
+    ctx->worker_func = worker_func;
+    ctx->nb_threads  = nb_threads;
+    ctx->pool        = pool;
+    ctx->task.func   = pool_worker;
+    ctx->task.priv   = ctx;
+    ctx->task.owner  = owner;
+    ff_thread_pool_add_task(pool, &ctx->task);
+
+    atomic_init(&ctx->first_job, 0);
+    atomic_init(&ctx->current_job, 0);
+
+    return nb_threads;
+}
+
+int avpriv_slicethread_create(AVSliceThread **pctx, void *priv,
+                              void (*worker_func)(void *priv, int jobnr, int threadnr, int nb_jobs, int nb_threads),
+                              void (*main_func)(void *priv),
+                              int nb_threads)
+{
+    return create_threads(pctx, priv, worker_func, main_func, nb_threads, 0);
+}
+
+static void execute_pool(AVSliceThread *ctx, int nb_jobs)
+{
+    int nb_helpers;
+
+    ctx->nb_jobs           = nb_jobs;
+    ctx->nb_active_threads = FFMIN(nb_jobs, ctx->nb_threads);
+    atomic_store_explicit(&ctx->first_job, 0, memory_order_relaxed);
+    atomic_store_explicit(&ctx->current_job, 0, memory_order_relaxed);
+    nb_helpers             = ctx->nb_active_threads - 1;
+
+    if (nb_helpers)
+        ff_thread_pool_submit(ctx->pool, &ctx->task, nb_helpers);
+
+    /* the caller runs whatever jobs the pool has not picked up yet,
+     * afterwards all jobs are done once no pool thread runs any more */
+    run_pool_jobs(ctx);
+
+    if (nb_helpers)
+        ff_thread_pool_wait(ctx->pool, &ctx->task);
+}
+
 void avpriv_slicethread_execute(AVSliceThread *ctx, int nb_jobs, int execute_main)
 {
     int nb_workers, i, is_last = 0;
 
     av_assert0(nb_jobs > 0);
+    if (ctx->pool) {
+        execute_pool(ctx, nb_jobs);
+        return;
+    }
+
     ctx->nb_jobs           = nb_jobs;
     ctx->nb_active_threads = FFMIN(nb_jobs, ctx->nb_threads);
     atomic_store_explicit(&ctx->first_job, 0, memory_order_relaxed);
     atomic_store_explicit(&ctx->current_job, ctx->nb_active_threads, memory_order_relaxed);
+    atomic_store_explicit(&ctx->nb_running, ctx->nb_active_threads, memory_order_relaxed);
     nb_workers             = ctx->nb_active_threads;
     if (!ctx->main_func || !execute_main)
         nb_workers--;
 
-    for (i = 0; i < nb_workers; i++) {
-        WorkerContext *w = &ctx->workers[i];
-        pthread_mutex_lock(&w->mutex);
-        w->done = 0;
-        pthread_cond_signal(&w->cond);
-        pthread_mutex_unlock(&w->mutex);
+    /* hand out contiguous chunks of jobs, threads running out of work steal
+     * from the others */
+    if (ctx->flags & AVPRIV_SLICETHREAD_FLAG_UNORDERED) {
+        for (i = 0; i < ctx->nb_active_threads; i++) {
+            uint_least64_t first = (uint_least64_t)nb_jobs *  i      / ctx->nb_active_threads;
+            uint_least64_t end   = (uint_least64_t)nb_jobs * (i + 1) / ctx->nb_active_threads;
+            atomic_store_explicit(&ctx->ranges[i].range, first << 32 | end, memory_order_relaxed);
+        }
     }
 
+    ctx->generation++;
+    for (i = 0; i < nb_workers; i++)
+        wake_worker(&ctx->workers[i], ctx->generation);
+
     if (ctx->main_func && execute_main)
         ctx->main_func(ctx->priv);
     else
         is_last = run_jobs(ctx);
 
-    if (!is_last) {
-        pthread_mutex_lock(&ctx->done_mutex);
-        while (!ctx->done)
-            pthread_cond_wait(&ctx->done_cond, &ctx->done_mutex);
-        ctx->done = 0;
-        pthread_mutex_unlock(&ctx->done_mutex);
-    }
+    if (!is_last)
+        wait_done(ctx);
 }
 
 void avpriv_slicethread_free(AVSliceThread **pctx)
@@ -205,18 +458,20 @@ void avpriv_slicethread_free(AVSliceThread **pctx)
         return;
 
     ctx = *pctx;
+    if (ctx->pool) {
+        ff_thread_pool_remove_task(ctx->pool, &ctx->task);
+        av_freep(pctx);
+        return;
+    }
+
     nb_workers = ctx->nb_threads;
     if (!ctx->main_func)
         nb_workers--;
 
     ctx->finished = 1;
-    for (i = 0; i < nb_workers; i++) {
-        WorkerContext *w = &ctx->workers[i];
-        pthread_mutex_lock(&w->mutex);
-        w->done = 0;
-        pthread_cond_signal(&w->cond);
-        pthread_mutex_unlock(&w->mutex);
-    }
+    ctx->generation++;
+    for (i = 0; i < nb_workers; i++)
+        wake_worker(&ctx->workers[i], ctx->generation);
 
     for (i = 0; i < nb_workers; i++) {
         WorkerContext *w = &ctx->workers[i];
@@ -227,6 +482,7 @@ void avpriv_slicethread_free(AVSliceThread **pctx)
 
     pthread_cond_destroy(&ctx->done_cond);
     pthread_mutex_destroy(&ctx->done_mutex);
+    av_freep(&ctx->ranges);
     av_freep(&ctx->workers);
     av_freep(pctx);
 }
@@ -242,6 +498,16 @@ int avpriv_slicethread_create(AVSliceThread **pctx, void *priv,
     return AVERROR(EINVAL);
 }
 
+int avpriv_slicethread_create_pool(AVSliceThread **pctx, AVThreadPool *pool,
+                                   const void *owner, void *priv,
+                                   void (*worker_func)(void *priv, int jobnr, int threadnr, int nb_jobs, int nb_threads),
+                                   void (*main_func)(void *priv),
+                                   int nb_threads, int flags)
+{
+    *pctx = NULL;
+    return AVERROR(EINVAL);
+}
+
 void avpriv_slicethread_execute(AVSliceThread *ctx, int nb_jobs, int execute_main)
 {
     av_assert0(0);
@@ -19,8 +19,18 @@
 #ifndef AVUTIL_SLICETHREAD_H
 #define AVUTIL_SLICETHREAD_H
 
+#include "threadpool.h"
+
 typedef struct AVSliceThread AVSliceThread;
 
+/**
+ * The jobs do not depend on each other and may be started in any order.
+ * This lets each thread take a contiguous chunk of the jobs and steal from
+ * the others when it runs out, instead of all threads taking one job at a
+ * time in ascending order from a shared counter.
+ */
+#define AVPRIV_SLICETHREAD_FLAG_UNORDERED (1 << 0)
+
 /**
  * Create slice threading context.
  * @param pctx slice threading context returned here
@@ -35,6 +45,25 @@ int avpriv_slicethread_create(AVSliceThread **pctx, void *priv,
                               void (*main_func)(void *priv),
                               int nb_threads);
 
+/**
+ * Create slice threading context running its jobs on a shared thread pool.
+ * The calling thread of avpriv_slicethread_execute() always takes part.
+ * Contexts with a main_func fall back to avpriv_slicethread_create(), as
+ * main_func may wait for jobs that a busy pool would not start.
+ * @param pool thread pool, falls back to avpriv_slicethread_create() if NULL
+ * @param owner context the work of the pool threads is accounted to, see
+ *              av_thread_pool_get_stats()
+ * @param nb_threads maximum number of threads executing jobs at once,
+ *                   including the caller, 0 for the pool size + 1
+ * @param flags combination of AVPRIV_SLICETHREAD_FLAG_*, only used without pool
+ * @see avpriv_slicethread_create() for the other parameters
+ */
+int avpriv_slicethread_create_pool(AVSliceThread **pctx, AVThreadPool *pool,
+                                   const void *owner, void *priv,
+                                   void (*worker_func)(void *priv, int jobnr, int threadnr, int nb_jobs, int nb_threads),
+                                   void (*main_func)(void *priv),
+                                   int nb_threads, int flags);
+
 /**
  * Execute slice threading.
  * @param ctx slice threading context
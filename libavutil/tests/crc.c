@@ -18,10 +18,92 @@
 
 #include <stdint.h>
 #include <stdio.h>
+#include <string.h>
 
+#include "libavutil/common.h"
+#include "libavutil/cpu.h"
 #include "libavutil/crc.h"
+#include "libavutil/time.h"
 
-int main(void)
+static const struct {
+    AVCRCId id;
+    const char *name;
+} crcs[] = {
+    { AV_CRC_8_ATM,      "AV_CRC_8_ATM"      },
+    { AV_CRC_16_ANSI,    "AV_CRC_16_ANSI"    },
+    { AV_CRC_16_CCITT,   "AV_CRC_16_CCITT"   },
+    { AV_CRC_24_IEEE,    "AV_CRC_24_IEEE"    },
+    { AV_CRC_32_IEEE,    "AV_CRC_32_IEEE"    },
+    { AV_CRC_32_IEEE_LE, "AV_CRC_32_IEEE_LE" },
+    { AV_CRC_16_ANSI_LE, "AV_CRC_16_ANSI_LE" },
+};
+
+static volatile uint32_t sink;
+
+static double bench_crc(const AVCRC *ctx, const uint8_t *buf, int size)
+{
+    int64_t t0 = av_gettime_relative(), t;
+    int64_t bytes = 0;
+
+    do {
+        sink = av_crc(ctx, 0, buf, size);
+        bytes += size;
+    } while ((t = av_gettime_relative() - t0) < 200000);
+
+    return bytes / (double)t;
+}
+
+/* check the code selected for this cpu against the plain C code */
+static int check_cpu(const uint8_t *buf, int size)
+{
+    int cpu_flags = av_get_cpu_flags();
+    int i, len, offset, errors = 0;
+
+    for (i = 0; i < FF_ARRAY_ELEMS(crcs); i++) {
+        const AVCRC *ctx = av_crc_get_table(crcs[i].id);
+        for (len = 0; len <= size - 16; len += len < 160 ? 1 : 97) {
+            for (offset = 0; offset < 16; offset += 5) {
+                uint32_t crc = len * 0x9E3779B9U, ref, opt;
+                av_force_cpu_flags(0);
+                ref = av_crc(ctx, crc, buf + offset, len);
+                av_force_cpu_flags(cpu_flags);
+                opt = av_crc(ctx, crc, buf + offset, len);
+                if (ref != opt) {
+                    printf("%s len %d: %X != %X\n", crcs[i].name, len, opt, ref);
+                    errors++;
+                }
+            }
+        }
+    }
+    return errors;
+}
+
+/* throughput of the plain C code and of the code selected for this cpu */
+static void bench(void)
+{
+    static const int sizes[] = { 64, 1024, 65536 };
+    static uint8_t buf[65536];
+    int cpu_flags = av_get_cpu_flags();
+    int i, j;
+
+    for (i = 0; i < sizeof(buf); i++)
+        buf[i] = i * 7 + (i >> 8);
+
+    printf("%-18s %7s %12s %12s\n", "table", "size", "MB/s (C)", "MB/s (cpu)");
+    for (i = 0; i < FF_ARRAY_ELEMS(crcs); i++) {
+        const AVCRC *ctx = av_crc_get_table(crcs[i].id);
+        for (j = 0; j < FF_ARRAY_ELEMS(sizes); j++) {
+            double c, opt;
+            av_force_cpu_flags(0);
+            c = bench_crc(ctx, buf, sizes[j]);
+            av_force_cpu_flags(cpu_flags);
+            opt = bench_crc(ctx, buf, sizes[j]);
+            printf("%-18s %7d %12.1f %12.1f\n", crcs[i].name, sizes[j], c, opt);
+        }
+    }
+}
+
+int main(int argc, char **argv)
 {
     uint8_t buf[1999];
     int i;
@@ -35,6 +117,11 @@ int main(void)
     };
     const AVCRC *ctx;
 
+    if (argc > 1 && !strcmp(argv[1], "-t")) {
+        bench();
+        return 0;
+    }
+
     for (i = 0; i < sizeof(buf); i++)
         buf[i] = i + i * i;
 
@@ -42,5 +129,5 @@ int main(void)
         ctx = av_crc_get_table(p[i][0]);
         printf("crc %08X = %X\n", p[i][1], av_crc(ctx, 0, buf, sizeof(buf)));
     }
-    return 0;
+    return !!check_cpu(buf, sizeof(buf));
 }
@@ -19,6 +19,7 @@
  */
 
 #include "libavutil/dict.c"
+#include "libavutil/time.h"
 
 static void print_dict(const AVDictionary *m)
 {
@@ -49,12 +50,116 @@ static void test_separators(const AVDictionary *m, const char pair, const char v
     av_dict_free(&dict);
 }
 
-int main(void)
+/* av_dict_get() without the index */
+static AVDictionaryEntry *scan_get(const AVDictionary *m, const char *key,
+                                   const AVDictionaryEntry *prev, int flags)
+{
+    int i = prev ? prev - m->elems + 1 : 0;
+
+    for (; i < av_dict_count(m); i++)
+        if (key_matches(m->elems[i].key, key, flags))
+            return &m->elems[i];
+    return NULL;
+}
+
+static int check_lookups(const AVDictionary *m, const char *key)
+{
+    static const int flags[] = { 0, AV_DICT_MATCH_CASE };
+    int i, errors = 0;
+
+    for (i = 0; i < FF_ARRAY_ELEMS(flags); i++) {
+        AVDictionaryEntry *e = NULL, *ref = NULL;
+        do {
+            e   = av_dict_get(m, key, e, flags[i]);
+            ref = scan_get(m, key, ref, flags[i]);
+            errors += e != ref;
+        } while (e && ref);
+    }
+    return errors;
+}
+
+static void test_large(void)
+{
+    static const int flags[] = { 0, AV_DICT_MULTIKEY, AV_DICT_DONT_OVERWRITE,
+                                 AV_DICT_APPEND, AV_DICT_MATCH_CASE };
+    AVDictionary *dict = NULL;
+    unsigned seed = 1;
+    int i, j, max_count = 0, errors = 0;
+    char key[16];
+
+    for (i = 0; i < 20000; i++) {
+        seed = seed * 1664525 + 1013904223;
+        snprintf(key, sizeof(key), seed >> 31 ? "Key%u" : "key%u", (seed >> 8) % 300);
+        if ((seed >> 4) % 8)
+            av_dict_set(&dict, key, "v", flags[(seed >> 24) % FF_ARRAY_ELEMS(flags)]);
+        else
+            av_dict_set(&dict, key, NULL, (seed >> 2) & AV_DICT_MATCH_CASE);
+        max_count = FFMAX(max_count, av_dict_count(dict));
+
+        errors += check_lookups(dict, key);
+        if (!(i % 1000))
+            for (j = 0; j < 310; j++) {
+                snprintf(key, sizeof(key), j & 1 ? "Key%d" : "KEY%d", j);
+                errors += check_lookups(dict, key);
+            }
+    }
+    printf("%d entries at most, %d errors\n", max_count, errors);
+    av_dict_free(&dict);
+}
+
+static AVDictionaryEntry *volatile sink;
+
+static void bench(void)
+{
+    static const int counts[] = { 8, 64, 512, 4096 };
+    int i, j, k;
+    char key[16];
+
+    printf("%8s %12s %12s %12s\n", "entries", "ns/set", "ns/get", "ns/get scan");
+    for (i = 0; i < FF_ARRAY_ELEMS(counts); i++) {
+        int n = counts[i], runs = FFMAX(1, 200000 / (n * n / 16 + n));
+        AVDictionary *dict = NULL;
+        int64_t t0, t1, t2, t3;
+
+        t0 = av_gettime_relative();
+        for (k = 0; k < runs; k++) {
+            av_dict_free(&dict);
+            for (j = 0; j < n; j++) {
+                snprintf(key, sizeof(key), "key%d", j);
+                av_dict_set(&dict, key, "value", 0);
+            }
+        }
+        t1 = av_gettime_relative();
+        for (k = 0; k < runs; k++)
+            for (j = 0; j < n; j++) {
+                snprintf(key, sizeof(key), "KEY%d", j);
+                sink = av_dict_get(dict, key, NULL, 0);
+            }
+        t2 = av_gettime_relative();
+        for (k = 0; k < runs; k++)
+            for (j = 0; j < n; j++) {
+                snprintf(key, sizeof(key), "KEY%d", j);
+                sink = scan_get(dict, key, NULL, 0);
+            }
+        t3 = av_gettime_relative();
+        printf("%8d %12.1f %12.1f %12.1f\n", n,
+               1000.0 * (t1 - t0) / (runs * n), 1000.0 * (t2 - t1) / (runs * n),
+               1000.0 * (t3 - t2) / (runs * n));
+        av_dict_free(&dict);
+    }
+}
+
+int main(int argc, char **argv)
 {
     AVDictionary *dict = NULL;
     AVDictionaryEntry *e;
     char *buffer = NULL;
 
+    if (argc > 1 && !strcmp(argv[1], "-t")) {
+        bench();
+        return 0;
+    }
+
     printf("Testing av_dict_get_string() and av_dict_parse_string()\n");
     av_dict_get_string(dict, &buffer, '=', ',');
     printf("%s\n", buffer);
@@ -132,5 +237,8 @@ int main(void)
     printf("%s\n", e->value);
     av_dict_free(&dict);
 
+    printf("\nTesting large dictionaries\n");
+    test_large();
+
     return 0;
 }
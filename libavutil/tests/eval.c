@@ -16,6 +16,7 @@
  * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
  */
 
+#include "libavutil/time.h"
 #include "libavutil/timer.h"
 
 #include <math.h>
@@ -140,6 +141,31 @@ int main(int argc, char **argv)
         "clip(0, 0/0, 1)",
         NULL
     };
+    static const char *const array_exprs[] = {
+        "PI*2+E-1/PI",
+        "-PI+3*(E-PI)^2",
+        "if(gt(PI,1), PI, -PI)",
+        "ifnot(PI, 1, E)*max(PI,E)/min(PI,E)",
+        "if(lt(PI,0), 1) + if(gte(E,PI), 2) + eq(PI,E) + lte(PI,E)",
+        "clip(PI, -1, E)",
+        "mod(PI, E)",
+        "pow(PI, 2)-sqrt(abs(E))",
+        "between(PI, -1, 2)",
+        "lerp(PI, E, 0.25)",
+        "squish(PI)+gauss(E)",
+        "floor(PI)+ceil(E)+round(PI/2)+trunc(E/2)",
+        "isnan(sqrt(PI))+isinf(1/E)+not(PI)",
+        "bitor(PI*4, 3)+bitand(E*4, 12)+gcd(abs(PI)*4+1, 6)",
+        "hypot(PI,E)+atan2(PI,E)+sin(PI)*cos(E)+exp(PI/4)",
+        /* too many registers for the compiled form */
+        "PI-(E-(PI-(E-(PI-(E-(PI-(E-(PI-(E-(PI-(E-(PI-(E-(PI-(E-(PI-(E-(PI-(E-("
+        "PI-(E-(PI-(E-(PI-(E-(PI-(E-(PI-(E-(PI-(E-(PI-(E-(PI-(E-(PI-(E-(PI-(E-(PI"
+        "))))))))))))))))))))))))))))))))))))))))",
+        "PI;E;PI*E",
+        "st(0, PI); ld(0)+ld(1)",
+        "st(1, ld(1)+PI); ld(1)",
+        NULL
+    };
     int ret;
 
     for (expr = exprs; *expr; expr++) {
@@ -168,6 +194,44 @@ int main(int argc, char **argv)
     if (ret < 0)
         printf("av_expr_parse_and_eval failed\n");
 
+    for (expr = array_exprs; *expr; expr++) {
+        static double pi_values[150], e_values[150];
+        const double *const_arrays[] = { pi_values, NULL, NULL };
+        double res[150];
+        AVExpr *e = NULL, *e2 = NULL;
+        double values[3] = { 0 };
+
+        for (i = 0; i < 150; i++) {
+            pi_values[i] = (i % 13) * 0.75 - 3;
+            e_values[i]  = (i %  7) * 1.5  - 4;
+        }
+        const_arrays[1] = (expr - array_exprs) & 1 ? e_values : NULL;
+        values[1] = M_E;
+
+        /* separate instances, so that they do not share variables */
+        if (av_expr_parse(&e,  *expr, const_names, NULL, NULL, NULL, NULL, 0, NULL) < 0 ||
+            av_expr_parse(&e2, *expr, const_names, NULL, NULL, NULL, NULL, 0, NULL) < 0 ||
+            av_expr_eval_array(e2, res, 150, values, const_arrays, NULL) < 0) {
+            printf("array evaluation of '%s' failed\n", *expr);
+        } else {
+            for (i = 0; i < 150; i++) {
+                values[0] = pi_values[i];
+                if (const_arrays[1])
+                    values[1] = e_values[i];
+                d = av_expr_eval(e, values, NULL);
+                if (memcmp(&d, &res[i], sizeof(d)))
+                    break;
+            }
+            if (i < 150)
+                printf("array evaluation of '%s': mismatch at %d, %f != %f\n",
+                       *expr, i, res[i], d);
+            else
+                printf("array evaluation of '%s': ok\n", *expr);
+        }
+        av_expr_free(e);
+        av_expr_free(e2);
+    }
+
     if (argc > 1 && !strcmp(argv[1], "-t")) {
         for (i = 0; i < 1050; i++) {
             START_TIMER;
@@ -178,6 +242,34 @@ int main(int argc, char **argv)
                 printf("av_expr_parse_and_eval failed\n");
             STOP_TIMER("av_expr_parse_and_eval");
         }
+
+        for (expr = array_exprs; *expr; expr++) {
+            static double xs[1024], res[1024];
+            const double *const_arrays[] = { xs, NULL, NULL };
+            double values[3] = { 0, M_E, 0 };
+            AVExpr *e = NULL;
+            int64_t t, t2, t3;
+            int j;
+
+            if (av_expr_parse(&e, *expr, const_names, NULL, NULL, NULL, NULL, 0, NULL) < 0)
+                continue;
+            for (j = 0; j < 1024; j++)
+                xs[j] = j;
+            t = av_gettime_relative();
+            for (i = 0; i < 1000; i++) {
+                for (j = 0; j < 1024; j++) {
+                    values[0] = xs[j];
+                    res[j] = av_expr_eval(e, values, NULL);
+                }
+            }
+            t2 = av_gettime_relative();
+            for (i = 0; i < 1000; i++)
+                av_expr_eval_array(e, res, 1024, values, const_arrays, NULL);
+            t3 = av_gettime_relative();
+            printf("%6.2f ns/point, array %6.2f ns/point: %s\n",
+                   (t2 - t) / 1024.0, (t3 - t2) / 1024.0, *expr);
+            av_expr_free(e);
+        }
     }
 
     return 0;
@@ -17,13 +17,166 @@
  */
 
 #include "libavutil/imgutils.c"
+#include "libavutil/lfg.h"
+#include "libavutil/thread.h"
+#include "libavutil/time.h"
 
 #undef printf
 
-int main(void)
+static const enum AVPixelFormat copy_formats[] = {
+    AV_PIX_FMT_YUV420P, AV_PIX_FMT_YUV420P10LE, AV_PIX_FMT_YUV410P,
+    AV_PIX_FMT_YUVA420P, AV_PIX_FMT_NV12, AV_PIX_FMT_RGBA, AV_PIX_FMT_PAL8,
+};
+
+static int compare_images(uint8_t *data1[4], int linesize1[4],
+                          uint8_t *data2[4], int linesize2[4],
+                          enum AVPixelFormat pix_fmt, int w, int h)
+{
+    const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(pix_fmt);
+    int i, y;
+
+    for (i = 0; i < 4 && data1[i]; i++) {
+        int bw = av_image_get_linesize(pix_fmt, w, i);
+        int ph = i == 1 || i == 2 ? AV_CEIL_RSHIFT(h, desc->log2_chroma_h) : h;
+        if (desc->flags & AV_PIX_FMT_FLAG_PAL && i == 1) {
+            bw = 4 * 256;
+            ph = 1;
+        }
+        for (y = 0; y < ph; y++)
+            if (memcmp(data1[i] + y * linesize1[i], data2[i] + y * linesize2[i], bw))
+                return 1;
+    }
+    return 0;
+}
+
+static void test_copy_slice(void)
+{
+    static const int sizes[][2] = { { 37, 29 }, { 3000, 1500 } };
+    uint8_t *src[4], *dst[4], *ref[4];
+    int src_linesize[4], dst_linesize[4], ref_linesize[4];
+    int f, s, nb, i, size, errors = 0;
+    AVLFG lfg;
+
+    av_lfg_init(&lfg, 1);
+    printf("Testing av_image_copy_slice()\n");
+    for (f = 0; f < FF_ARRAY_ELEMS(copy_formats); f++) {
+        for (s = 0; s < FF_ARRAY_ELEMS(sizes); s++) {
+            enum AVPixelFormat pix_fmt = copy_formats[f];
+            int w = sizes[s][0], h = sizes[s][1];
+
+            if ((size = av_image_alloc(src, src_linesize, w, h, pix_fmt, 16)) < 0 ||
+                av_image_alloc(dst, dst_linesize, w, h, pix_fmt, 32) < 0 ||
+                av_image_alloc(ref, ref_linesize, w, h, pix_fmt, 64) < 0)
+                exit(1);
+            for (i = 0; i < size; i++)
+                src[0][i] = av_lfg_get(&lfg);
+
+            av_image_copy(ref, ref_linesize, (const uint8_t **)src, src_linesize,
+                          pix_fmt, w, h);
+            errors += compare_images(src, src_linesize, ref, ref_linesize, pix_fmt, w, h);
+            for (nb = 1; nb <= 7; nb++) {
+                memset(dst[0], 0, size);
+                for (i = nb - 1; i >= 0; i--)
+                    av_image_copy_slice(dst, dst_linesize, (const uint8_t **)src,
+                                        src_linesize, pix_fmt, w, h, i, nb);
+                errors += compare_images(ref, ref_linesize, dst, dst_linesize, pix_fmt, w, h);
+            }
+            av_freep(&src[0]);
+            av_freep(&dst[0]);
+            av_freep(&ref[0]);
+        }
+    }
+    printf("%d formats, %d errors\n", (int)FF_ARRAY_ELEMS(copy_formats), errors);
+}
+
+#if HAVE_THREADS
+typedef struct BenchThread {
+    pthread_t thread;
+    uint8_t **dst, **src;
+    int *dst_linesize, *src_linesize;
+    enum AVPixelFormat pix_fmt;
+    int w, h, slice, nb_slices, runs;
+} BenchThread;
+
+static void *bench_thread(void *arg)
+{
+    BenchThread *t = arg;
+    int i;
+
+    for (i = 0; i < t->runs; i++)
+        av_image_copy_slice(t->dst, t->dst_linesize, (const uint8_t **)t->src,
+                            t->src_linesize, t->pix_fmt, t->w, t->h,
+                            t->slice, t->nb_slices);
+    return NULL;
+}
+#endif
+
+static void bench(void)
+{
+    static const int sizes[][2] = {
+        { 720, 576 }, { 1920, 1080 }, { 3840, 2160 }, { 7680, 4320 },
+    };
+    static const enum AVPixelFormat formats[] = {
+        AV_PIX_FMT_YUV420P, AV_PIX_FMT_YUV420P10LE, AV_PIX_FMT_NV12, AV_PIX_FMT_RGBA,
+    };
+    uint8_t *src[4], *dst[4];
+    int src_linesize[4], dst_linesize[4];
+    int s, f, i, size;
+
+    for (s = 0; s < FF_ARRAY_ELEMS(sizes); s++) {
+        for (f = 0; f < FF_ARRAY_ELEMS(formats); f++) {
+            int w = sizes[s][0], h = sizes[s][1];
+            int runs = FFMAX(1, (1 << 30) / av_image_get_buffer_size(formats[f], w, h, 1));
+            int64_t t;
+
+            if ((size = av_image_alloc(src, src_linesize, w, h, formats[f], 64)) < 0 ||
+                av_image_alloc(dst, dst_linesize, w, h, formats[f], 64) < 0)
+                exit(1);
+            memset(src[0], 1, size);
+            memset(dst[0], 0, size);
+
+            t = av_gettime_relative();
+            for (i = 0; i < runs; i++)
+                av_image_copy(dst, dst_linesize, (const uint8_t **)src, src_linesize,
+                              formats[f], w, h);
+            t = av_gettime_relative() - t;
+            printf("%4dx%-4d %-12s %6.0f MB/s", w, h, av_get_pix_fmt_name(formats[f]),
+                   (double)size * runs / FFMAX(t, 1));
+#if HAVE_THREADS
+            {
+                BenchThread threads[4];
+
+                t = av_gettime_relative();
+                for (i = 0; i < FF_ARRAY_ELEMS(threads); i++) {
+                    threads[i] = (BenchThread){ 0, dst, src, dst_linesize, src_linesize,
+                                                formats[f], w, h, i, FF_ARRAY_ELEMS(threads),
+                                                runs };
+                    if (pthread_create(&threads[i].thread, NULL, bench_thread, &threads[i]))
+                        exit(1);
+                }
+                for (i = 0; i < FF_ARRAY_ELEMS(threads); i++)
+                    pthread_join(threads[i].thread, NULL);
+                t = av_gettime_relative() - t;
+                printf(", %6.0f MB/s with %d slice threads",
+                       (double)size * runs / FFMAX(t, 1), (int)FF_ARRAY_ELEMS(threads));
+            }
+#endif
+            printf("\n");
+            av_freep(&src[0]);
+            av_freep(&dst[0]);
+        }
+    }
+}
+
+int main(int argc, char **argv)
 {
     int64_t x, y;
 
+    if (argc > 1 && !strcmp(argv[1], "-t")) {
+        bench();
+        return 0;
+    }
+
     for (y = -1; y<UINT_MAX; y+= y/2 + 1) {
         for (x = -1; x<UINT_MAX; x+= x/2 + 1) {
             int ret = av_image_check_size(x, y, 0, NULL);
@@ -32,5 +185,7 @@ int main(void)
         printf("\n");
     }
 
+    test_copy_slice();
+
     return 0;
 }
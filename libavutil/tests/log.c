@@ -23,6 +23,8 @@
 
 #include <string.h>
 
+#include "libavutil/time.h"
+
 static int call_log_format_line2(const char *fmt, char *buffer, int buffer_size, ...)
 {
     va_list args;
@@ -34,10 +36,9 @@ static int call_log_format_line2(const char *fmt, char *buffer, int buffer_size,
     return ret;
 }
 
-int main(int argc, char **argv)
+static void test_colors(void)
 {
     int i;
-    av_log_set_level(AV_LOG_DEBUG);
     for (use_color=0; use_color<=256; use_color = 255*use_color+1) {
         av_log(NULL, AV_LOG_FATAL, "use_color: %d\n", use_color);
         for (i = AV_LOG_DEBUG; i>=AV_LOG_QUIET; i-=8) {
@@ -48,6 +49,150 @@ int main(int argc, char **argv)
         }
         av_log(NULL, AV_LOG_PANIC, "\n");
     }
+}
+
+#if HAVE_THREADS
+#define NB_THREADS  4
+#define NB_MESSAGES 20000
+
+static void *log_main(void *arg)
+{
+    int i;
+    for (i = 0; i < NB_MESSAGES; i++)
+        av_log(NULL, AV_LOG_VERBOSE, "thread %d message %d\n", (int)(intptr_t)arg, i);
+    return NULL;
+}
+
+/* time NB_THREADS threads logging NB_MESSAGES messages each */
+static int64_t log_threads(void)
+{
+    pthread_t threads[NB_THREADS];
+    int64_t t = av_gettime_relative();
+    int i;
+
+    for (i = 0; i < NB_THREADS; i++)
+        if (pthread_create(&threads[i], NULL, log_main, (void *)(intptr_t)i))
+            return -1;
+    for (i = 0; i < NB_THREADS; i++)
+        pthread_join(threads[i], NULL);
+    return av_gettime_relative() - t;
+}
+
+#define NB_ORDER_MESSAGES 3000
+
+/* some messages do not fit in the buffer of a queue slot, but are not
+ * truncated when printed */
+static void order_message(char *buf, int thread, int i)
+{
+    int len = snprintf(buf, LINE_SZ, "thread %d message %d ", thread, i);
+
+    if (!(i % 97)) {
+        memset(buf + len, '.', LINE_SZ - 3 - len);
+        len = LINE_SZ - 3;
+    }
+    memcpy(buf + len, "\n", 2);
+}
+
+static void *order_main(void *arg)
+{
+    char buf[LINE_SZ];
+    int i;
+
+    /* errors are never dropped */
+    for (i = 0; i < NB_ORDER_MESSAGES; i++) {
+        order_message(buf, (int)(intptr_t)arg, i);
+        av_log(NULL, AV_LOG_ERROR, "%s", buf);
+    }
+    return NULL;
+}
+
+/* check that the messages of concurrent threads logged asynchronously are
+ * printed complete and in the order of each thread */
+static int test_async_order(void)
+{
+    pthread_t threads[NB_THREADS];
+    int next[NB_THREADS] = { 0 };
+    char line[2 * LINE_SZ], expected[LINE_SZ];
+    FILE *out = tmpfile();
+    int i, saved, nb_lines = 0, errors = 0;
+
+    fflush(stderr);
+    if (!out || (saved = dup(2)) < 0 || dup2(fileno(out), 2) < 0) {
+        printf("could not redirect stderr\n");
+        return 1;
+    }
+    use_color = 0;
+    av_log_set_flags(AV_LOG_ASYNC);
+    for (i = 0; i < NB_THREADS; i++)
+        if (pthread_create(&threads[i], NULL, order_main, (void *)(intptr_t)i))
+            break;
+    while (i--)
+        pthread_join(threads[i], NULL);
+    av_log_set_flags(0);
+    fflush(stderr);
+    dup2(saved, 2);
+    close(saved);
+
+    rewind(out);
+    while (fgets(line, sizeof(line), out)) {
+        int thread, n;
+
+        nb_lines++;
+        if (sscanf(line, "thread %d message %d", &thread, &n) != 2 ||
+            thread < 0 || thread >= NB_THREADS || n != next[thread]) {
+            errors++;
+            continue;
+        }
+        order_message(expected, thread, next[thread]++);
+        errors += !!strcmp(line, expected);
+    }
+    fclose(out);
+
+    printf("async: %d threads x %d messages, %d lines, %d errors\n",
+           NB_THREADS, NB_ORDER_MESSAGES, nb_lines, errors);
+    return errors || nb_lines != NB_THREADS * NB_ORDER_MESSAGES;
+}
+
+static void bench(void)
+{
+    int64_t t_sync, t_async;
+
+    av_log_set_level(AV_LOG_VERBOSE);
+    av_log_set_flags(0);
+    t_sync = log_threads();
+    av_log_set_flags(AV_LOG_ASYNC);
+    t_async = log_threads();
+    av_log_set_flags(0);
+    av_log_set_level(AV_LOG_INFO);
+
+    av_log(NULL, AV_LOG_INFO, "%d threads x %d messages: %.1f ns/message "
+           "synchronous, %.1f ns/message asynchronous\n", NB_THREADS, NB_MESSAGES,
+           1000.0 * t_sync  / (NB_THREADS * NB_MESSAGES),
+           1000.0 * t_async / (NB_THREADS * NB_MESSAGES));
+}
+#endif
+
+int main(int argc, char **argv)
+{
+    int i;
+
+#if HAVE_THREADS
+    if (argc > 1 && !strcmp(argv[1], "-t")) {
+        bench();
+        return 0;
+    }
+#endif
+
+    av_log_set_level(AV_LOG_DEBUG);
+    test_colors();
+#if HAVE_THREADS
+    av_log_set_flags(AV_LOG_ASYNC);
+    for (i = 0; i < 10; i++)
+        av_log(NULL, AV_LOG_INFO, "async %d\n", i);
+    av_log_set_flags(0);
+    if (test_async_order())
+        return 1;
+#endif
     {
         int result;
         char buffer[4];
@@ -0,0 +1,220 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/*
+ * This test program allocates blocks from several threads with the slab
+ * caches enabled, frees them from other threads, and checks their contents,
+ * their alignment, reallocation and the allocation counters.
+ */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "libavutil/mem.h"
+#include "libavutil/thread.h"
+#include "libavutil/time.h"
+
+#define NB_THREADS 4
+#define NB_BLOCKS  4096
+
+static uint8_t *blocks[NB_THREADS][NB_BLOCKS];
+static int errors;
+
+static size_t block_size(int i)
+{
+    return i * 37 % 1100 + 1;
+}
+
+static void *alloc_blocks(void *arg)
+{
+    int t = (intptr_t)arg;
+    int i;
+
+    for (i = 0; i < NB_BLOCKS; i++) {
+        blocks[t][i] = i & 1 ? av_malloc(block_size(i)) : av_realloc(NULL, block_size(i));
+        if (blocks[t][i])
+            memset(blocks[t][i], t + i, block_size(i));
+    }
+    return NULL;
+}
+
+static void *free_blocks(void *arg)
+{
+    int t = (intptr_t)arg;
+    int i, j;
+
+    for (i = 0; i < NB_BLOCKS; i++) {
+        uint8_t *p = blocks[t][i];
+        if (!p || (i & 1 && (uintptr_t)p & 15)) {
+            fprintf(stderr, "block %d of thread %d: %p\n", i, t, p);
+            errors++;
+            continue;
+        }
+        for (j = 0; j < block_size(i); j++) {
+            if (p[j] != (uint8_t)(t + i)) {
+                fprintf(stderr, "block %d of thread %d corrupted\n", i, t);
+                errors++;
+                break;
+            }
+        }
+        av_free(p);
+    }
+    return NULL;
+}
+
+static void run_threads(void *(*func)(void *), int shift)
+{
+    pthread_t threads[NB_THREADS];
+    int i, ret;
+
+    for (i = 0; i < NB_THREADS; i++) {
+        if ((ret = pthread_create(&threads[i], NULL, func,
+                                  (void *)(intptr_t)((i + shift) % NB_THREADS)))) {
+            fprintf(stderr, "pthread_create failed: %s.\n", strerror(ret));
+            exit(1);
+        }
+    }
+    for (i = 0; i < NB_THREADS; i++)
+        pthread_join(threads[i], NULL);
+}
+
+static void test_realloc(void)
+{
+    uint8_t *p = NULL;
+    size_t size, prev;
+
+    /* Grow the block from the smallest slab class to the system allocator,
+     * checking that the byte set at each step is kept. */
+    for (size = 1; size <= 4096; size += size / 2 + 1) {
+        p = av_realloc(p, size);
+        if (!p) {
+            fprintf(stderr, "av_realloc(%d) failed\n", (int)size);
+            errors++;
+            return;
+        }
+        p[size - 1] = size;
+        for (prev = 1; prev < size; prev += prev / 2 + 1) {
+            if (p[prev - 1] != (uint8_t)prev) {
+                fprintf(stderr, "av_realloc(%d) lost the contents\n", (int)size);
+                errors++;
+                break;
+            }
+        }
+    }
+    av_free(p);
+}
+
+static void test_huge_pages(void)
+{
+    size_t size = 5 << 20;
+    uint8_t *p;
+
+    p = av_malloc(size);
+    if (!p || (uintptr_t)p & ((2 << 20) - 1)) {
+        fprintf(stderr, "huge allocation: %p\n", p);
+        errors++;
+        return;
+    }
+    memset(p, 1, size);
+    av_free(p);
+}
+
+static void *bench_thread(void *arg)
+{
+    void *p[32];
+    int i, j;
+
+    for (i = 0; i < 100000; i++) {
+        for (j = 0; j < FF_ARRAY_ELEMS(p); j++)
+            p[j] = av_malloc(16 + (i + j) * 24 % 640);
+        for (j = 0; j < FF_ARRAY_ELEMS(p); j++)
+            av_free(p[j]);
+    }
+    return NULL;
+}
+
+static void bench(void)
+{
+    int flags[2] = { 0, AV_MEM_FLAG_SLAB };
+    double ns[2];
+    int i;
+
+    for (i = 0; i < 2; i++) {
+        int64_t t;
+
+        av_mem_set_flags(flags[i]);
+        t = av_gettime_relative();
+        run_threads(bench_thread, 0);
+        ns[i] = (av_gettime_relative() - t) * 1000.0 / (NB_THREADS * 100000 * 32);
+    }
+    printf("%d threads: %.1f ns/block system allocator, %.1f ns/block slabs\n",
+           NB_THREADS, ns[0], ns[1]);
+}
+
+int main(int argc, char **argv)
+{
+    uint64_t allocs, frees, slab_allocs;
+    int slab;
+
+    if (argc > 1 && !strcmp(argv[1], "-t")) {
+        bench();
+        return 0;
+    }
+
+    av_mem_set_flags(AV_MEM_FLAG_SLAB | AV_MEM_FLAG_HUGE_PAGES | AV_MEM_FLAG_COUNTERS);
+    slab        = av_mem_get_flags() & AV_MEM_FLAG_SLAB;
+    allocs      = av_mem_get_counter(AV_MEM_COUNTER_ALLOCS);
+    frees       = av_mem_get_counter(AV_MEM_COUNTER_FREES);
+    slab_allocs = av_mem_get_counter(AV_MEM_COUNTER_SLAB_ALLOCS);
+
+    run_threads(alloc_blocks, 0);
+    run_threads(free_blocks, 1);
+    /* blocks allocated without the slabs and freed with them, and reverse */
+    av_mem_set_flags(AV_MEM_FLAG_COUNTERS);
+    run_threads(alloc_blocks, 0);
+    av_mem_set_flags(AV_MEM_FLAG_SLAB | AV_MEM_FLAG_HUGE_PAGES | AV_MEM_FLAG_COUNTERS);
+    run_threads(free_blocks, 1);
+    run_threads(alloc_blocks, 0);
+    av_mem_set_flags(AV_MEM_FLAG_COUNTERS);
+    run_threads(free_blocks, 1);
+
+    allocs = av_mem_get_counter(AV_MEM_COUNTER_ALLOCS) - allocs;
+    frees  = av_mem_get_counter(AV_MEM_COUNTER_FREES)  - frees;
+    if (allocs != 3 * NB_THREADS * NB_BLOCKS || frees != allocs) {
+        fprintf(stderr, "%"PRIu64" blocks allocated, %"PRIu64" freed\n", allocs, frees);
+        errors++;
+    }
+    slab_allocs = av_mem_get_counter(AV_MEM_COUNTER_SLAB_ALLOCS) - slab_allocs;
+    if (slab && !slab_allocs) {
+        fprintf(stderr, "no block allocated from the slabs\n");
+        errors++;
+    }
+
+    av_mem_set_flags(AV_MEM_FLAG_SLAB);
+    test_realloc();
+    av_mem_set_flags(0);
+    test_realloc();
+
+    av_mem_set_flags(AV_MEM_FLAG_HUGE_PAGES);
+    if (av_mem_get_flags() & AV_MEM_FLAG_HUGE_PAGES)
+        test_huge_pages();
+
+    return !!errors;
+}
@@ -17,11 +17,51 @@
  */
 
 #include <stdio.h>
+#include <string.h>
 
+#include "libavutil/cpu.h"
 #include "libavutil/mem.h"
 #include "libavutil/sha.h"
+#include "libavutil/time.h"
 
-int main(void)
+static double bench_sha(struct AVSHA *ctx, int bits, const uint8_t *buf, int size)
+{
+    int64_t t0 = av_gettime_relative(), t;
+    int64_t bytes = 0;
+    uint8_t digest[32];
+
+    av_sha_init(ctx, bits);
+    do {
+        av_sha_update(ctx, buf, size);
+        bytes += size;
+    } while ((t = av_gettime_relative() - t0) < 200000);
+    av_sha_final(ctx, digest);
+
+    return bytes / (double)t;
+}
+
+/* throughput of the plain C code and of the code selected for this cpu */
+static void bench(struct AVSHA *ctx, const int *lengths)
+{
+    static uint8_t buf[65536];
+    int cpu_flags = av_get_cpu_flags();
+    int i;
+
+    for (i = 0; i < sizeof(buf); i++)
+        buf[i] = i * 7 + (i >> 8);
+
+    printf("%-8s %12s %12s\n", "digest", "MB/s (C)", "MB/s (cpu)");
+    for (i = 0; i < 3; i++) {
+        double c, opt;
+        av_force_cpu_flags(0);
+        c = bench_sha(ctx, lengths[i], buf, sizeof(buf));
+        av_force_cpu_flags(cpu_flags);
+        opt = bench_sha(ctx, lengths[i], buf, sizeof(buf));
+        printf("SHA-%-4d %12.1f %12.1f\n", lengths[i], c, opt);
+    }
+}
+
+int main(int argc, char **argv)
 {
     int i, j, k;
     struct AVSHA *ctx;
@@ -32,6 +72,12 @@ int main(void)
     if (!ctx)
         return 1;
 
+    if (argc > 1 && !strcmp(argv[1], "-t")) {
+        bench(ctx, lengths);
+        av_free(ctx);
+        return 0;
+    }
+
     for (j = 0; j < 3; j++) {
         printf("Testing SHA-%d\n", lengths[j]);
         for (k = 0; k < 3; k++) {
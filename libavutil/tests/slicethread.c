@@ -0,0 +1,162 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/*
+ * Without arguments, this test program checks that every job is run exactly
+ * once with a valid thread number, for all job distribution modes.
+ * With -s, it measures the overhead of avpriv_slicethread_execute() against
+ * the size of the jobs instead.
+ */
+
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "libavutil/common.h"
+#include "libavutil/slicethread.h"
+#include "libavutil/time.h"
+
+#define MAX_JOBS 67
+
+typedef struct TestContext {
+    int nb_threads;
+    atomic_int runs[MAX_JOBS];
+    atomic_int errors;
+    int main_runs;
+    int work;
+} TestContext;
+
+static void worker_func(void *priv, int jobnr, int threadnr, int nb_jobs, int nb_threads)
+{
+    TestContext *c = priv;
+
+    if (threadnr < 0 || threadnr >= nb_threads || nb_threads > c->nb_threads ||
+        jobnr < 0 || jobnr >= nb_jobs)
+        atomic_fetch_add(&c->errors, 1);
+    else
+        atomic_fetch_add(&c->runs[jobnr], 1);
+}
+
+static void main_func(void *priv)
+{
+    TestContext *c = priv;
+    c->main_runs++;
+}
+
+static int check(int nb_threads, int flags, int use_main)
+{
+    TestContext c = { 0 };
+    AVSliceThread *thread;
+    int nb_jobs, i, ret, errors = 0;
+
+    ret = avpriv_slicethread_create_pool(&thread, NULL, NULL, &c, worker_func,
+                                         use_main ? main_func : NULL,
+                                         nb_threads, flags);
+    if (ret < 0) {
+        fprintf(stderr, "avpriv_slicethread_create_pool failed\n");
+        return 1;
+    }
+    c.nb_threads = ret;
+
+    for (nb_jobs = 1; nb_jobs <= MAX_JOBS; nb_jobs++) {
+        for (i = 0; i < MAX_JOBS; i++)
+            atomic_store(&c.runs[i], 0);
+        avpriv_slicethread_execute(thread, nb_jobs, nb_jobs & 1);
+        for (i = 0; i < MAX_JOBS; i++)
+            if (atomic_load(&c.runs[i]) != (i < nb_jobs))
+                errors++;
+    }
+    avpriv_slicethread_free(&thread);
+
+    errors += atomic_load(&c.errors);
+    if (c.main_runs != (use_main ? (MAX_JOBS + 1) / 2 : 0))
+        errors++;
+    if (errors)
+        fprintf(stderr, "%d threads, flags %d, main %d: %d errors\n",
+                nb_threads, flags, use_main, errors);
+    return !!errors;
+}
+
+static volatile unsigned sink;
+
+static void bench_func(void *priv, int jobnr, int threadnr, int nb_jobs, int nb_threads)
+{
+    TestContext *c = priv;
+    unsigned acc = jobnr;
+    int i;
+
+    for (i = 0; i < c->work; i++)
+        acc = acc * 1664525 + 1013904223;
+    sink = acc;
+}
+
+static void bench(int nb_threads, int flags)
+{
+    static const int works[] = { 0, 100, 1000, 10000, 100000 };
+    TestContext c = { 0 };
+    AVSliceThread *thread;
+    int w, i, nb_jobs;
+
+    c.nb_threads = avpriv_slicethread_create_pool(&thread, NULL, NULL, &c, bench_func,
+                                                  NULL, nb_threads, flags);
+    if (c.nb_threads < 0) {
+        fprintf(stderr, "avpriv_slicethread_create_pool failed\n");
+        return;
+    }
+    nb_jobs = 4 * c.nb_threads;
+
+    printf("%d threads, %d jobs per call, flags %d\n", c.nb_threads, nb_jobs, flags);
+    printf("%12s %14s %14s\n", "work/job", "us/execute", "us serial");
+    for (w = 0; w < FF_ARRAY_ELEMS(works); w++) {
+        int nb_calls = FFMAX(20, 2000000 / (works[w] * nb_jobs + 1000));
+        int64_t t0, t1, t2;
+
+        c.work = works[w];
+        t0 = av_gettime_relative();
+        for (i = 0; i < nb_calls; i++)
+            avpriv_slicethread_execute(thread, nb_jobs, 0);
+        t1 = av_gettime_relative();
+        for (i = 0; i < nb_calls * nb_jobs; i++)
+            bench_func(&c, i % nb_jobs, 0, nb_jobs, 1);
+        t2 = av_gettime_relative();
+        printf("%12d %14.2f %14.2f\n", works[w],
+               (t1 - t0) / (double)nb_calls, (t2 - t1) / (double)nb_calls);
+    }
+    avpriv_slicethread_free(&thread);
+}
+
+int main(int argc, char **argv)
+{
+    static const int flags[] = { 0, AVPRIV_SLICETHREAD_FLAG_UNORDERED };
+    int nb_threads, f, use_main, ret = 0;
+
+    if (argc > 1 && !strcmp(argv[1], "-s")) {
+        nb_threads = argc > 2 ? atoi(argv[2]) : 0;
+        for (f = 0; f < FF_ARRAY_ELEMS(flags); f++)
+            bench(nb_threads, flags[f]);
+        return 0;
+    }
+
+    for (nb_threads = 1; nb_threads <= 6; nb_threads++)
+        for (f = 0; f < FF_ARRAY_ELEMS(flags); f++)
+            for (use_main = 0; use_main <= 1; use_main++)
+                ret |= check(nb_threads, flags[f], use_main);
+
+    return ret;
+}
@@ -0,0 +1,258 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/*
+ * This test program runs several slice threading contexts sharing one
+ * thread pool from concurrent threads, and checks that every job is run
+ * exactly once with a valid thread number and within the thread limit of
+ * its context, and that the work of the pool threads is accounted to the
+ * right context. It also checks that a context whose main function waits
+ * for its jobs completes while all the pool threads are busy.
+ */
+
+#include <stdatomic.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "libavutil/error.h"
+#include "libavutil/slicethread.h"
+#include "libavutil/thread.h"
+#include "libavutil/threadpool.h"
+#include "libavutil/time.h"
+
+#define NB_CLIENTS   4
+#define NB_RUNS      300
+#define MAX_JOBS     37
+#define WAITER_JOBS  4
+#define TIMEOUT      10000000
+
+typedef struct Client {
+    AVSliceThread *thread;
+    int nb_threads;
+    atomic_int runs[MAX_JOBS];
+    atomic_int active;
+    atomic_int errors;
+    int main_runs;
+} Client;
+
+static void worker_func(void *priv, int jobnr, int threadnr, int nb_jobs, int nb_threads)
+{
+    Client *c = priv;
+    int active = atomic_fetch_add(&c->active, 1) + 1;
+
+    if (active > c->nb_threads || threadnr < 0 || threadnr >= nb_threads ||
+        nb_threads > c->nb_threads || jobnr >= nb_jobs)
+        atomic_fetch_add(&c->errors, 1);
+    atomic_fetch_add(&c->runs[jobnr], 1);
+    atomic_fetch_sub(&c->active, 1);
+}
+
+static void main_func(void *priv)
+{
+    Client *c = priv;
+    c->main_runs++;
+}
+
+static void *client_main(void *arg)
+{
+    Client *c = arg;
+    int i, j;
+
+    for (i = 0; i < NB_RUNS; i++) {
+        int nb_jobs = 1 + (i * 7 + c->nb_threads) % MAX_JOBS;
+
+        for (j = 0; j < MAX_JOBS; j++)
+            atomic_store(&c->runs[j], 0);
+        avpriv_slicethread_execute(c->thread, nb_jobs, i & 1);
+        for (j = 0; j < MAX_JOBS; j++)
+            if (atomic_load(&c->runs[j]) != (j < nb_jobs))
+                atomic_fetch_add(&c->errors, 1);
+    }
+    return NULL;
+}
+
+/* jobs keeping the pool threads busy until released */
+typedef struct Busy {
+    AVSliceThread *thread;
+    int nb_threads;
+    atomic_int active;
+    atomic_int release;
+} Busy;
+
+static void busy_worker(void *priv, int jobnr, int threadnr, int nb_jobs, int nb_threads)
+{
+    Busy *b = priv;
+
+    atomic_fetch_add(&b->active, 1);
+    while (!atomic_load(&b->release))
+        av_usleep(1000);
+}
+
+static void *busy_main(void *arg)
+{
+    Busy *b = arg;
+
+    avpriv_slicethread_execute(b->thread, b->nb_threads, 0);
+    return NULL;
+}
+
+/* a main function waiting for the jobs of its own execute call, like the
+ * VP9 loop filter does */
+typedef struct Waiter {
+    AVSliceThread *thread;
+    atomic_int done;
+    int timeout;
+} Waiter;
+
+static void waiter_worker(void *priv, int jobnr, int threadnr, int nb_jobs, int nb_threads)
+{
+    Waiter *w = priv;
+    atomic_fetch_add(&w->done, 1);
+}
+
+static void waiter_main(void *priv)
+{
+    Waiter *w = priv;
+    int64_t deadline = av_gettime_relative() + TIMEOUT;
+
+    while (atomic_load(&w->done) < WAITER_JOBS) {
+        if (av_gettime_relative() > deadline) {
+            w->timeout = 1;
+            return;
+        }
+        av_usleep(1000);
+    }
+}
+
+static int test_busy_pool(AVThreadPool *pool)
+{
+    static Busy b;
+    static Waiter w;
+    pthread_t thread;
+    int64_t deadline = av_gettime_relative() + TIMEOUT;
+    int ret, errors = 0;
+
+    ret = avpriv_slicethread_create_pool(&b.thread, pool, &b, &b, busy_worker,
+                                         NULL, 0, 0);
+    if (ret < 0)
+        return 1;
+    b.nb_threads = ret;
+    ret = avpriv_slicethread_create_pool(&w.thread, pool, &w, &w, waiter_worker,
+                                         waiter_main, 2, 0);
+    if (ret < 0)
+        return 1;
+
+    if ((ret = pthread_create(&thread, NULL, busy_main, &b))) {
+        fprintf(stderr, "pthread_create failed: %s.\n", strerror(ret));
+        return 1;
+    }
+    while (atomic_load(&b.active) < b.nb_threads && av_gettime_relative() < deadline)
+        av_usleep(1000);
+    if (atomic_load(&b.active) < b.nb_threads) {
+        fprintf(stderr, "busy pool: only %d of %d threads busy\n",
+                atomic_load(&b.active), b.nb_threads);
+        errors++;
+    }
+
+    avpriv_slicethread_execute(w.thread, WAITER_JOBS, 1);
+    if (w.timeout || atomic_load(&w.done) != WAITER_JOBS) {
+        fprintf(stderr, "busy pool: main function waited in vain, %d of %d jobs run\n",
+                atomic_load(&w.done), WAITER_JOBS);
+        errors++;
+    }
+
+    atomic_store(&b.release, 1);
+    pthread_join(thread, NULL);
+    avpriv_slicethread_free(&w.thread);
+    avpriv_slicethread_free(&b.thread);
+    return errors;
+}
+
+int main(void)
+{
+    static const int nb_threads[NB_CLIENTS] = { 2, 3, 0, 8 };
+    static Client clients[NB_CLIENTS];
+    pthread_t threads[NB_CLIENTS];
+    AVThreadPool *pool;
+    int i, ret, errors = 0;
+
+    if ((ret = av_thread_pool_alloc(&pool, 3)) < 0) {
+        fprintf(stderr, "av_thread_pool_alloc failed\n");
+        return 1;
+    }
+
+    for (i = 0; i < NB_CLIENTS; i++) {
+        Client *c = &clients[i];
+        ret = avpriv_slicethread_create_pool(&c->thread, pool, c, c, worker_func,
+                                             i & 1 ? main_func : NULL,
+                                             nb_threads[i], 0);
+        if (ret < 0) {
+            fprintf(stderr, "avpriv_slicethread_create_pool failed\n");
+            return 1;
+        }
+        c->nb_threads = ret;
+    }
+    if (clients[2].nb_threads != av_thread_pool_get_nb_threads(pool) + 1) {
+        fprintf(stderr, "wrong automatic thread count\n");
+        return 1;
+    }
+
+    for (i = 0; i < NB_CLIENTS; i++) {
+        if ((ret = pthread_create(&threads[i], NULL, client_main, &clients[i]))) {
+            fprintf(stderr, "pthread_create failed: %s.\n", strerror(ret));
+            return 1;
+        }
+    }
+
+    for (i = 0; i < NB_CLIENTS; i++) {
+        Client *c = &clients[i];
+        AVThreadPoolStats stats;
+
+        pthread_join(threads[i], NULL);
+        if (atomic_load(&c->errors) || c->main_runs != (i & 1 ? NB_RUNS / 2 : 0)) {
+            fprintf(stderr, "client %d: %d errors, %d main runs\n",
+                    i, atomic_load(&c->errors), c->main_runs);
+            errors++;
+        }
+        /* runs with more than one job hand some to the pool, which runs
+         * them on at most as many threads as the context has, while the
+         * contexts with a main function keep threads of their own */
+        if (i & 1) {
+            if (av_thread_pool_get_stats(pool, c, &stats) != AVERROR(ENOENT)) {
+                fprintf(stderr, "client %d: main function context on the pool\n", i);
+                errors++;
+            }
+        } else if (av_thread_pool_get_stats(pool, c, &stats) < 0 ||
+                   stats.nb_tasks <= 0 || stats.nb_tasks > NB_RUNS ||
+                   stats.nb_runs > stats.nb_tasks * c->nb_threads ||
+                   stats.busy_time < 0) {
+            fprintf(stderr, "client %d: wrong stats\n", i);
+            errors++;
+        }
+        avpriv_slicethread_free(&c->thread);
+        if (av_thread_pool_get_stats(pool, c, &stats) != AVERROR(ENOENT)) {
+            fprintf(stderr, "client %d: stats after free\n", i);
+            errors++;
+        }
+    }
+
+    errors += test_busy_pool(pool);
+
+    av_thread_pool_free(&pool);
+    return !!errors;
+}
@@ -0,0 +1,129 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/*
+ * This test program records zones from several threads and checks the
+ * counters printed by av_trace_report() and the number of events exported
+ * by av_trace_export_json().
+ */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "libavutil/bprint.h"
+#include "libavutil/log.h"
+#include "libavutil/thread.h"
+#include "libavutil/trace.h"
+
+#define NB_THREADS 4
+#define NB_RUNS    1000
+
+static uint64_t runs_a, runs_b;
+static int nb_zones;
+
+static void *thread_main(void *arg)
+{
+    int i;
+
+    for (i = 0; i < NB_RUNS; i++) {
+        int64_t t0 = av_trace_begin();
+        if (i & 1) {
+            int64_t t1 = av_trace_begin();
+            av_trace_end("test", "b", t1);
+        }
+        av_trace_end("test", "a", t0);
+    }
+    return NULL;
+}
+
+static void log_callback(void *avcl, int level, const char *fmt, va_list vl)
+{
+    char line[256], zone[64];
+    uint64_t runs;
+
+    vsnprintf(line, sizeof(line), fmt, vl);
+    if (sscanf(line, "%*f %"SCNu64" %*f %*f %63s", &runs, zone) != 2)
+        return;
+    nb_zones++;
+    if (!strcmp(zone, "test:a"))
+        runs_a = runs;
+    else if (!strcmp(zone, "test:b"))
+        runs_b = runs;
+}
+
+static int count_events(void)
+{
+    AVBPrint bp;
+    const char *p;
+    int nb = 0;
+
+    av_bprint_init(&bp, 0, AV_BPRINT_SIZE_UNLIMITED);
+    if (av_trace_export_json(&bp) < 0)
+        return -1;
+    for (p = bp.str; (p = strstr(p, "\"ph\":\"X\"")); p++)
+        nb++;
+    av_bprint_finalize(&bp, NULL);
+    return nb;
+}
+
+int main(void)
+{
+    pthread_t threads[NB_THREADS];
+    int i, ret, nb, errors = 0;
+
+    if (av_trace_begin()) {
+        fprintf(stderr, "tracing enabled by default\n");
+        errors++;
+    }
+
+    av_trace_set_flags(AV_TRACE_FLAG_EVENTS | AV_TRACE_FLAG_COUNTERS);
+    for (i = 0; i < NB_THREADS; i++) {
+        if ((ret = pthread_create(&threads[i], NULL, thread_main, NULL))) {
+            fprintf(stderr, "pthread_create failed: %s.\n", strerror(ret));
+            return 1;
+        }
+    }
+    for (i = 0; i < NB_THREADS; i++)
+        pthread_join(threads[i], NULL);
+    av_trace_set_flags(0);
+    thread_main(NULL);
+
+    av_log_set_callback(log_callback);
+    av_trace_report(NULL, AV_LOG_INFO);
+    if (nb_zones != 2 || runs_a != NB_THREADS * NB_RUNS ||
+        runs_b != NB_THREADS * NB_RUNS / 2) {
+        fprintf(stderr, "wrong counters: %d zones, %"PRIu64" and %"PRIu64" runs\n",
+                nb_zones, runs_a, runs_b);
+        errors++;
+    }
+
+    nb = count_events();
+    if (nb != NB_THREADS * NB_RUNS * 3 / 2) {
+        fprintf(stderr, "%d events exported\n", nb);
+        errors++;
+    }
+
+    av_trace_reset();
+    if ((nb = count_events())) {
+        fprintf(stderr, "%d events exported after reset\n", nb);
+        errors++;
+    }
+
+    return !!errors;
+}
@@ -0,0 +1,307 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "threadpool.h"
+#include "threadpool_internal.h"
+#include "avassert.h"
+#include "common.h"
+#include "cpu.h"
+#include "error.h"
+#include "mem.h"
+#include "thread.h"
+#include "time.h"
+
+#if HAVE_THREADS
+
+struct AVThreadPool {
+    pthread_t       *threads;
+    int             nb_threads;
+
+    pthread_mutex_t mutex;
+    pthread_cond_t  work_cond;
+    pthread_cond_t  idle_cond;
+    ThreadPoolTask  *first, *last;
+    ThreadPoolTask  *tasks;
+    int             finished;
+};
+
+static void queue_push(AVThreadPool *pool, ThreadPoolTask *task)
+{
+    task->next = NULL;
+    if (pool->last)
+        pool->last->next = task;
+    else
+        pool->first = task;
+    pool->last = task;
+}
+
+static ThreadPoolTask *queue_pop(AVThreadPool *pool)
+{
+    ThreadPoolTask *task = pool->first;
+
+    pool->first = task->next;
+    if (!pool->first)
+        pool->last = NULL;
+    return task;
+}
+
+static void *attribute_align_arg thread_worker(void *v)
+{
+    AVThreadPool *pool = v;
+
+    pthread_mutex_lock(&pool->mutex);
+    while (1) {
+        ThreadPoolTask *task;
+        int64_t start;
+
+        while (!pool->first && !pool->finished)
+            pthread_cond_wait(&pool->work_cond, &pool->mutex);
+        if (!pool->first)
+            break;
+
+        /* hand out one thread at a time and requeue the task at the end,
+         * so that the waiting tasks get the idle threads in turn */
+        task = queue_pop(pool);
+        if (--task->nb_pending)
+            queue_push(pool, task);
+        task->nb_running++;
+        task->stats.nb_runs++;
+        pthread_mutex_unlock(&pool->mutex);
+
+        start = av_gettime_relative();
+        task->func(task->priv);
+        start = av_gettime_relative() - start;
+
+        pthread_mutex_lock(&pool->mutex);
+        task->stats.busy_time += start;
+        if (!--task->nb_running && task->waiting)
+            pthread_cond_broadcast(&pool->idle_cond);
+    }
+    pthread_mutex_unlock(&pool->mutex);
+
+    return NULL;
+}
+
+void ff_thread_pool_submit(AVThreadPool *pool, ThreadPoolTask *task, int nb_threads)
+{
+    int i;
+
+    av_assert0(nb_threads > 0);
+
+    pthread_mutex_lock(&pool->mutex);
+    task->nb_pending = nb_threads;
+    task->nb_running = 0;
+    task->waiting    = 0;
+    task->stats.nb_tasks++;
+    queue_push(pool, task);
+    for (i = 0; i < FFMIN(nb_threads, pool->nb_threads); i++)
+        pthread_cond_signal(&pool->work_cond);
+    pthread_mutex_unlock(&pool->mutex);
+}
+
+void ff_thread_pool_wait(AVThreadPool *pool, ThreadPoolTask *task)
+{
+    pthread_mutex_lock(&pool->mutex);
+    if (task->nb_pending) {
+        ThreadPoolTask **p = &pool->first, *prev = NULL;
+
+        while (*p != task) {
+            prev = *p;
+            p    = &(*p)->next;
+        }
+        *p = task->next;
+        if (pool->last == task)
+            pool->last = prev;
+        task->nb_pending = 0;
+    }
+
+    task->waiting = 1;
+    while (task->nb_running)
+        pthread_cond_wait(&pool->idle_cond, &pool->mutex);
+    task->waiting = 0;
+    pthread_mutex_unlock(&pool->mutex);
+}
+
+void ff_thread_pool_add_task(AVThreadPool *pool, ThreadPoolTask *task)
+{
+    memset(&task->stats, 0, sizeof(task->stats));
+
+    pthread_mutex_lock(&pool->mutex);
+    task->next_task = pool->tasks;
+    pool->tasks     = task;
+    pthread_mutex_unlock(&pool->mutex);
+}
+
+void ff_thread_pool_remove_task(AVThreadPool *pool, ThreadPoolTask *task)
+{
+    ThreadPoolTask **p;
+
+    pthread_mutex_lock(&pool->mutex);
+    for (p = &pool->tasks; *p; p = &(*p)->next_task) {
+        if (*p == task) {
+            *p = task->next_task;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&pool->mutex);
+}
+
+int av_thread_pool_alloc(AVThreadPool **ppool, int nb_threads)
+{
+    AVThreadPool *pool;
+    int i, ret;
+
+    av_assert0(nb_threads >= 0);
+    if (!nb_threads)
+        nb_threads = av_cpu_count();
+
+    *ppool = pool = av_mallocz(sizeof(*pool));
+    if (!pool)
+        return AVERROR(ENOMEM);
+
+    pool->threads = av_calloc(nb_threads, sizeof(*pool->threads));
+    if (!pool->threads) {
+        av_freep(ppool);
+        return AVERROR(ENOMEM);
+    }
+
+    if ((ret = pthread_mutex_init(&pool->mutex, NULL)))
+        goto fail;
+    if ((ret = pthread_cond_init(&pool->work_cond, NULL))) {
+        pthread_mutex_destroy(&pool->mutex);
+        goto fail;
+    }
+    if ((ret = pthread_cond_init(&pool->idle_cond, NULL))) {
+        pthread_cond_destroy(&pool->work_cond);
+        pthread_mutex_destroy(&pool->mutex);
+        goto fail;
+    }
+
+    for (i = 0; i < nb_threads; i++) {
+        if (ret = pthread_create(&pool->threads[i], NULL, thread_worker, pool)) {
+            pool->nb_threads = i;
+            av_thread_pool_free(ppool);
+            return AVERROR(ret);
+        }
+    }
+    pool->nb_threads = nb_threads;
+
+    return 0;
+
+fail:
+    av_freep(&pool->threads);
+    av_freep(ppool);
+    return AVERROR(ret);
+}
+
+void av_thread_pool_free(AVThreadPool **ppool)
+{
+    AVThreadPool *pool = *ppool;
+    int i;
+
+    if (!pool)
+        return;
+
+    pthread_mutex_lock(&pool->mutex);
+    av_assert0(!pool->first && !pool->tasks);
+    pool->finished = 1;
+    pthread_cond_broadcast(&pool->work_cond);
+    pthread_mutex_unlock(&pool->mutex);
+
+    for (i = 0; i < pool->nb_threads; i++)
+        pthread_join(pool->threads[i], NULL);
+
+    pthread_cond_destroy(&pool->idle_cond);
+    pthread_cond_destroy(&pool->work_cond);
+    pthread_mutex_destroy(&pool->mutex);
+    av_freep(&pool->threads);
+    av_freep(ppool);
+}
+
+int av_thread_pool_get_nb_threads(const AVThreadPool *pool)
+{
+    return pool->nb_threads;
+}
+
+int av_thread_pool_get_stats(AVThreadPool *pool, const void *owner,
+                             AVThreadPoolStats *stats)
+{
+    const ThreadPoolTask *task;
+    int found = 0;
+
+    memset(stats, 0, sizeof(*stats));
+
+    pthread_mutex_lock(&pool->mutex);
+    for (task = pool->tasks; task; task = task->next_task) {
+        if (task->owner != owner)
+            continue;
+        stats->nb_tasks  += task->stats.nb_tasks;
+        stats->nb_runs   += task->stats.nb_runs;
+        stats->busy_time += task->stats.busy_time;
+        found = 1;
+    }
+    pthread_mutex_unlock(&pool->mutex);
+
+    return found ? 0 : AVERROR(ENOENT);
+}
+
+#else /* HAVE_THREADS */
+
+void ff_thread_pool_submit(AVThreadPool *pool, ThreadPoolTask *task, int nb_threads)
+{
+    av_assert0(0);
+}
+
+void ff_thread_pool_wait(AVThreadPool *pool, ThreadPoolTask *task)
+{
+    av_assert0(0);
+}
+
+void ff_thread_pool_add_task(AVThreadPool *pool, ThreadPoolTask *task)
+{
+    av_assert0(0);
+}
+
+void ff_thread_pool_remove_task(AVThreadPool *pool, ThreadPoolTask *task)
+{
+    av_assert0(0);
+}
+
+int av_thread_pool_alloc(AVThreadPool **ppool, int nb_threads)
+{
+    *ppool = NULL;
+    return AVERROR(ENOSYS);
+}
+
+void av_thread_pool_free(AVThreadPool **ppool)
+{
+    av_assert0(!*ppool);
+}
+
+int av_thread_pool_get_nb_threads(const AVThreadPool *pool)
+{
+    return 0;
+}
+
+int av_thread_pool_get_stats(AVThreadPool *pool, const void *owner,
+                             AVThreadPoolStats *stats)
+{
+    return AVERROR(ENOSYS);
+}
+
+#endif /* HAVE_THREADS */
@@ -0,0 +1,89 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef AVUTIL_THREADPOOL_H
+#define AVUTIL_THREADPOOL_H
+
+#include <stdint.h>
+
+/**
+ * @file
+ * Shared worker pool
+ *
+ * A thread pool can be attached to any number of codec contexts (see
+ * AVCodecContext.thread_pool) and filter graphs (see
+ * avfilter_graph_set_thread_pool()). Their slice threading jobs are then
+ * executed by the threads of the pool instead of threads of their own, which
+ * bounds the total number of threads of a process running many of them at
+ * once. The calling thread of each context always takes part in executing its
+ * own jobs, so a context makes progress even when the pool is busy.
+ * Decoders whose calling thread waits for the jobs it started, like the VP9
+ * loop filter, keep threads of their own, as a busy pool would not run those
+ * jobs.
+ *
+ * Idle pool threads are handed out to the waiting contexts in turn, and each
+ * context never gets more threads at a time than its own thread count.
+ */
+
+typedef struct AVThreadPool AVThreadPool;
+
+/**
+ * Work done by the pool threads for one owner.
+ */
+typedef struct AVThreadPoolStats {
+    int64_t nb_tasks;   ///< number of times the owner handed jobs to the pool
+    int64_t nb_runs;    ///< number of times a pool thread ran jobs of the owner
+    int64_t busy_time;  ///< time pool threads spent running jobs of the owner, in microseconds
+} AVThreadPoolStats;
+
+/**
+ * Allocate a thread pool and start its threads.
+ *
+ * @param ppool      pointer to the thread pool
+ * @param nb_threads number of threads in the pool, 0 for automatic (the
+ *                   number of logical cpus)
+ * @return  >=0 for success; <0 for error, in particular AVERROR(ENOSYS) if
+ *          lavu was built without thread support
+ */
+int av_thread_pool_alloc(AVThreadPool **ppool, int nb_threads);
+
+/**
+ * Stop the threads of a pool and free it.
+ *
+ * All contexts using the pool must have been freed before.
+ */
+void av_thread_pool_free(AVThreadPool **ppool);
+
+/**
+ * @return the number of threads of the pool
+ */
+int av_thread_pool_get_nb_threads(const AVThreadPool *pool);
+
+/**
+ * Get the work done by the pool threads for an owner, summed over its slice
+ * threading contexts that are currently using the pool. The jobs an owner
+ * runs on its calling thread are not included.
+ *
+ * @param owner the AVCodecContext or AVFilterGraph the pool is attached to
+ * @param stats filled with the statistics of owner
+ * @return 0 on success, AVERROR(ENOENT) if owner does not use the pool
+ */
+int av_thread_pool_get_stats(AVThreadPool *pool, const void *owner,
+                             AVThreadPoolStats *stats);
+
+#endif /* AVUTIL_THREADPOOL_H */
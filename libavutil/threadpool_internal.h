@@ -0,0 +1,63 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef AVUTIL_THREADPOOL_INTERNAL_H
+#define AVUTIL_THREADPOOL_INTERNAL_H
+
+#include "threadpool.h"
+
+/**
+ * A task to be run by up to a given number of pool threads at once.
+ * The fields after owner are private to the pool.
+ */
+typedef struct ThreadPoolTask {
+    void (*func)(void *priv);
+    void *priv;
+    const void *owner;  ///< context the work is accounted to
+
+    struct ThreadPoolTask *next;
+    struct ThreadPoolTask *next_task;   ///< next task added to the pool
+    int nb_pending;     ///< pool threads still to be handed out
+    int nb_running;     ///< pool threads currently running func
+    int waiting;        ///< a thread waits for nb_running to drop to zero
+    AVThreadPoolStats stats;
+} ThreadPoolTask;
+
+/**
+ * Make a task known to the pool, so that its work is accounted to its owner.
+ */
+void ff_thread_pool_add_task(AVThreadPool *pool, ThreadPoolTask *task);
+
+/**
+ * Remove a task added with ff_thread_pool_add_task(). It must not be queued.
+ */
+void ff_thread_pool_remove_task(AVThreadPool *pool, ThreadPoolTask *task);
+
+/**
+ * Queue a task so that it is run by nb_threads pool threads, each of which
+ * calls task->func once.
+ */
+void ff_thread_pool_submit(AVThreadPool *pool, ThreadPoolTask *task, int nb_threads);
+
+/**
+ * Dequeue a task if some of its threads are still pending and wait until
+ * all pool threads that started running it have returned.
+ */
+void ff_thread_pool_wait(AVThreadPool *pool, ThreadPoolTask *task);
+
+#endif /* AVUTIL_THREADPOOL_INTERNAL_H */
@@ -21,6 +21,9 @@
 /**
  * @file
  * high precision timer, useful to profile code
+ *
+ * These macros are meant for temporary local instrumentation. For zones
+ * traced at runtime and exported, see trace.h.
  */
 
 #ifndef AVUTIL_TIMER_H
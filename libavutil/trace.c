@@ -0,0 +1,415 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "config.h"
+
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "common.h"
+#include "error.h"
+#include "log.h"
+#include "mem.h"
+#include "thread.h"
+#include "time.h"
+#include "trace.h"
+
+/* maximum number of events recorded per thread, further ones are dropped */
+#define MAX_EVENTS   (1 << 20)
+#define MIN_COUNTERS 64
+
+typedef struct TraceEvent {
+    const char *category;
+    const char *name;
+    int64_t start;
+    int64_t duration;
+} TraceEvent;
+
+typedef struct TraceCounter {
+    const char *category;
+    const char *name;
+    uint64_t count;
+    int64_t total;
+    int64_t max;
+} TraceCounter;
+
+/**
+ * Recording state of one thread. The buffers are never freed: the buffer of
+ * a thread which exits is kept for the exports and handed to the next new
+ * thread, which continues it on the same timeline row.
+ */
+typedef struct TraceBuffer {
+    struct TraceBuffer *next;
+    int tid;
+    int in_use;
+
+    TraceEvent *events;
+    unsigned nb_events;
+    unsigned events_size;
+    uint64_t nb_dropped;
+
+    /* open addressing hash table keyed by the category and name pointers */
+    TraceCounter *counters;
+    unsigned counters_mask;
+    unsigned nb_counters;
+} TraceBuffer;
+
+static atomic_int trace_flags = ATOMIC_VAR_INIT(0);
+
+/* protects the list of buffers and their in_use fields */
+static AVMutex trace_mutex = AV_MUTEX_INITIALIZER;
+static TraceBuffer *trace_buffers;
+static int nb_trace_buffers;
+
+#if HAVE_PTHREADS
+static pthread_key_t trace_key;
+static int trace_key_ok;
+static AVOnce trace_key_once = AV_ONCE_INIT;
+
+static void release_buffer(void *opaque)
+{
+    TraceBuffer *buf = opaque;
+
+    ff_mutex_lock(&trace_mutex);
+    buf->in_use = 0;
+    ff_mutex_unlock(&trace_mutex);
+}
+
+static void create_key(void)
+{
+    trace_key_ok = !pthread_key_create(&trace_key, release_buffer);
+}
+#endif
+
+/* must be called with trace_mutex locked */
+static TraceBuffer *acquire_buffer(void)
+{
+    TraceBuffer *buf;
+
+    for (buf = trace_buffers; buf; buf = buf->next)
+        if (!buf->in_use)
+            break;
+    if (!buf) {
+        buf = av_mallocz(sizeof(*buf));
+        if (!buf)
+            return NULL;
+        buf->tid  = ++nb_trace_buffers;
+        buf->next = trace_buffers;
+        trace_buffers = buf;
+    }
+    buf->in_use = 1;
+    return buf;
+}
+
+static int64_t trace_time(void)
+{
+#if HAVE_CLOCK_GETTIME && defined(CLOCK_MONOTONIC) && !defined(__APPLE__)
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+#else
+    return av_gettime_relative() * 1000;
+#endif
+}
+
+static void add_event(TraceBuffer *buf, const char *category, const char *name,
+                      int64_t start, int64_t duration)
+{
+    TraceEvent *ev;
+
+    if (buf->nb_events == buf->events_size) {
+        unsigned size = buf->events_size ? 2 * buf->events_size : 1024;
+
+        if (size > MAX_EVENTS ||
+            !(ev = av_realloc_array(buf->events, size, sizeof(*ev)))) {
+            buf->nb_dropped++;
+            return;
+        }
+        buf->events      = ev;
+        buf->events_size = size;
+    }
+
+    ev = &buf->events[buf->nb_events++];
+    ev->category = category;
+    ev->name     = name;
+    ev->start    = start;
+    ev->duration = duration;
+}
+
+static unsigned counter_hash(const char *category, const char *name)
+{
+    uint32_t h = (uintptr_t)name ^ (uintptr_t)category * 31;
+    h *= 0x9e3779b1;
+    return h ^ h >> 16;
+}
+
+static TraceCounter *counter_slot(TraceCounter *counters, unsigned mask,
+                                  const char *category, const char *name)
+{
+    unsigned i = counter_hash(category, name) & mask;
+
+    while (counters[i].name &&
+           (counters[i].name != name || counters[i].category != category))
+        i = (i + 1) & mask;
+    return &counters[i];
+}
+
+static int grow_counters(TraceBuffer *buf)
+{
+    unsigned size = buf->counters ? 2 * (buf->counters_mask + 1) : MIN_COUNTERS;
+    TraceCounter *counters = av_mallocz_array(size, sizeof(*counters));
+    unsigned i;
+
+    if (!counters)
+        return AVERROR(ENOMEM);
+    for (i = 0; buf->counters && i <= buf->counters_mask; i++) {
+        TraceCounter *c = &buf->counters[i];
+        if (c->name)
+            *counter_slot(counters, size - 1, c->category, c->name) = *c;
+    }
+    av_free(buf->counters);
+    buf->counters      = counters;
+    buf->counters_mask = size - 1;
+    return 0;
+}
+
+static void add_counter(TraceBuffer *buf, const char *category, const char *name,
+                        int64_t duration)
+{
+    TraceCounter *c = NULL;
+
+    if (buf->counters)
+        c = counter_slot(buf->counters, buf->counters_mask, category, name);
+    if (!c || !c->name) {
+        if (2 * (buf->nb_counters + 1) > buf->counters_mask + 1) {
+            if (grow_counters(buf) < 0)
+                return;
+            c = counter_slot(buf->counters, buf->counters_mask, category, name);
+        }
+        c->category = category;
+        c->name     = name;
+        buf->nb_counters++;
+    }
+    c->count++;
+    c->total += duration;
+    c->max    = FFMAX(c->max, duration);
+}
+
+void av_trace_set_flags(int flags)
+{
+    atomic_store(&trace_flags, flags);
+}
+
+int av_trace_get_flags(void)
+{
+    return atomic_load(&trace_flags);
+}
+
+int64_t av_trace_begin(void)
+{
+    if (!atomic_load_explicit(&trace_flags, memory_order_relaxed))
+        return 0;
+    return trace_time();
+}
+
+void av_trace_end(const char *category, const char *name, int64_t start)
+{
+    int flags = atomic_load_explicit(&trace_flags, memory_order_relaxed);
+    TraceBuffer *buf;
+    int64_t duration;
+
+    if (!start || !flags)
+        return;
+    duration = trace_time() - start;
+
+#if HAVE_PTHREADS
+    ff_thread_once(&trace_key_once, create_key);
+    if (!trace_key_ok)
+        return;
+    buf = pthread_getspecific(trace_key);
+    if (!buf) {
+        ff_mutex_lock(&trace_mutex);
+        buf = acquire_buffer();
+        ff_mutex_unlock(&trace_mutex);
+        if (!buf || pthread_setspecific(trace_key, buf)) {
+            if (buf)
+                release_buffer(buf);
+            return;
+        }
+    }
+#else
+    /* without thread-specific data, all threads share a single buffer */
+    ff_mutex_lock(&trace_mutex);
+    buf = trace_buffers ? trace_buffers : acquire_buffer();
+    if (!buf) {
+        ff_mutex_unlock(&trace_mutex);
+        return;
+    }
+#endif
+
+    if (flags & AV_TRACE_FLAG_EVENTS)
+        add_event(buf, category, name, start, duration);
+    if (flags & AV_TRACE_FLAG_COUNTERS)
+        add_counter(buf, category, name, duration);
+
+#if !HAVE_PTHREADS
+    ff_mutex_unlock(&trace_mutex);
+#endif
+}
+
+static int compare_names(const void *a, const void *b)
+{
+    const TraceCounter *ca = a, *cb = b;
+    int ret = strcmp(ca->category, cb->category);
+    return ret ? ret : strcmp(ca->name, cb->name);
+}
+
+static int compare_totals(const void *a, const void *b)
+{
+    const TraceCounter *ca = a, *cb = b;
+    return (ca->total < cb->total) - (ca->total > cb->total);
+}
+
+void av_trace_report(void *avcl, int level)
+{
+    TraceCounter *counters;
+    TraceBuffer *buf;
+    uint64_t nb_dropped = 0;
+    unsigned nb = 0, i, j;
+
+    ff_mutex_lock(&trace_mutex);
+    for (buf = trace_buffers; buf; buf = buf->next)
+        nb += buf->nb_counters;
+    counters = av_malloc_array(nb, sizeof(*counters));
+    if (!counters && nb) {
+        ff_mutex_unlock(&trace_mutex);
+        av_log(avcl, AV_LOG_ERROR, "Could not allocate the trace report\n");
+        return;
+    }
+    nb = 0;
+    for (buf = trace_buffers; buf; buf = buf->next) {
+        for (i = 0; buf->counters && i <= buf->counters_mask; i++)
+            if (buf->counters[i].name)
+                counters[nb++] = buf->counters[i];
+        nb_dropped += buf->nb_dropped;
+    }
+    ff_mutex_unlock(&trace_mutex);
+
+    /* merge the counters of the same zone from different threads */
+    qsort(counters, nb, sizeof(*counters), compare_names);
+    for (i = j = 0; i < nb; i++) {
+        if (j && !compare_names(&counters[j - 1], &counters[i])) {
+            TraceCounter *c = &counters[j - 1];
+            c->count += counters[i].count;
+            c->total += counters[i].total;
+            c->max    = FFMAX(c->max, counters[i].max);
+        } else {
+            counters[j++] = counters[i];
+        }
+    }
+    nb = j;
+    qsort(counters, nb, sizeof(*counters), compare_totals);
+
+    av_log(avcl, level, "%12s %10s %10s %10s  %s\n",
+           "total ms", "runs", "avg us", "max us", "zone");
+    for (i = 0; i < nb; i++) {
+        const TraceCounter *c = &counters[i];
+        av_log(avcl, level, "%12.3f %10"PRIu64" %10.3f %10.3f  %s:%s\n",
+               c->total / 1e6, c->count, c->total / 1e3 / c->count, c->max / 1e3,
+               c->category, c->name);
+    }
+    if (nb_dropped)
+        av_log(avcl, level, "%"PRIu64" trace events dropped\n", nb_dropped);
+
+    av_free(counters);
+}
+
+static void put_string(AVBPrint *bp, const char *s)
+{
+    av_bprint_chars(bp, '"', 1);
+    for (; *s; s++) {
+        if (*s == '"' || *s == '\\')
+            av_bprintf(bp, "\\%c", *s);
+        else if ((unsigned char)*s < 0x20)
+            av_bprintf(bp, "\\u%04x", *s);
+        else
+            av_bprint_chars(bp, *s, 1);
+    }
+    av_bprint_chars(bp, '"', 1);
+}
+
+/* timestamps in microseconds with nanosecond precision */
+static void put_time(AVBPrint *bp, int64_t t)
+{
+    av_bprintf(bp, "%"PRId64".%03d", t / 1000, (int)(t % 1000));
+}
+
+int av_trace_export_json(AVBPrint *bp)
+{
+    TraceBuffer *buf;
+    int64_t origin = INT64_MAX;
+    const char *sep = "\n";
+    unsigned i;
+
+    ff_mutex_lock(&trace_mutex);
+    for (buf = trace_buffers; buf; buf = buf->next)
+        for (i = 0; i < buf->nb_events; i++)
+            origin = FFMIN(origin, buf->events[i].start);
+
+    av_bprintf(bp, "{\"traceEvents\":[");
+    for (buf = trace_buffers; buf; buf = buf->next) {
+        for (i = 0; i < buf->nb_events; i++) {
+            const TraceEvent *ev = &buf->events[i];
+
+            av_bprintf(bp, "%s{\"name\":", sep);
+            put_string(bp, ev->name);
+            av_bprintf(bp, ",\"cat\":");
+            put_string(bp, ev->category);
+            av_bprintf(bp, ",\"ph\":\"X\",\"ts\":");
+            put_time(bp, ev->start - origin);
+            av_bprintf(bp, ",\"dur\":");
+            put_time(bp, ev->duration);
+            av_bprintf(bp, ",\"pid\":1,\"tid\":%d}", buf->tid);
+            sep = ",\n";
+        }
+    }
+    av_bprintf(bp, "\n],\"displayTimeUnit\":\"ns\"}\n");
+    ff_mutex_unlock(&trace_mutex);
+
+    return av_bprint_is_complete(bp) ? 0 : AVERROR(ENOMEM);
+}
+
+void av_trace_reset(void)
+{
+    TraceBuffer *buf;
+
+    ff_mutex_lock(&trace_mutex);
+    for (buf = trace_buffers; buf; buf = buf->next) {
+        av_freep(&buf->events);
+        buf->nb_events   = 0;
+        buf->events_size = 0;
+        buf->nb_dropped  = 0;
+        av_freep(&buf->counters);
+        buf->counters_mask = 0;
+        buf->nb_counters   = 0;
+    }
+    ff_mutex_unlock(&trace_mutex);
+}
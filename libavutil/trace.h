@@ -0,0 +1,112 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef AVUTIL_TRACE_H
+#define AVUTIL_TRACE_H
+
+/**
+ * @file
+ * Runtime-enabled tracing of named zones
+ *
+ * The libraries mark the hot spots of a pipeline (decoding, encoding,
+ * filtering, I/O, slice threading jobs...) as zones, identified by a
+ * category and a name, e.g. "decode" and the name of the decoder. While
+ * tracing is enabled, each thread records the zones it runs into a buffer of
+ * its own, without locking, and keeps a count and the total and maximum
+ * duration of each zone.
+ *
+ * The results can be printed with av_trace_report() and exported in the
+ * JSON trace event format read by Chrome's about:tracing and by Perfetto
+ * with av_trace_export_json(). While tracing is disabled, a zone costs a
+ * function call and a load.
+ *
+ * av_trace_report(), av_trace_export_json() and av_trace_reset() read the
+ * buffers of all threads: they must not be called while traced code is
+ * running in other threads.
+ */
+
+#include <stdint.h>
+
+#include "bprint.h"
+
+/**
+ * Record each zone run as an event, for av_trace_export_json().
+ */
+#define AV_TRACE_FLAG_EVENTS   (1 << 0)
+/**
+ * Count the runs and the duration of each zone, for av_trace_report().
+ */
+#define AV_TRACE_FLAG_COUNTERS (1 << 1)
+
+/**
+ * Enable or disable tracing.
+ *
+ * @param flags a combination of AV_TRACE_FLAG_*, 0 to disable tracing
+ */
+void av_trace_set_flags(int flags);
+
+/**
+ * @return the current tracing flags
+ */
+int av_trace_get_flags(void);
+
+/**
+ * Start a zone.
+ *
+ * @return an opaque start time to pass to av_trace_end(), 0 if tracing is
+ *         disabled
+ */
+int64_t av_trace_begin(void);
+
+/**
+ * End a zone and record it for the calling thread.
+ *
+ * @param category category of the zone, e.g. "decode"
+ * @param name     name of the zone, e.g. the name of the decoder
+ * @param start    value returned by av_trace_begin(); nothing is recorded if
+ *                 it is 0
+ *
+ * category and name are stored as is: they must point to strings which stay
+ * valid until av_trace_reset() or the end of the process, such as string
+ * literals or the names of codecs, filters and formats.
+ */
+void av_trace_end(const char *category, const char *name, int64_t start);
+
+/**
+ * Print the counters of all zones, merged over all threads and sorted by
+ * total duration.
+ *
+ * @param avcl  logging context, may be NULL
+ * @param level logging level
+ */
+void av_trace_report(void *avcl, int level);
+
+/**
+ * Write the events recorded by all threads in the JSON trace event format.
+ *
+ * @param bp buffer to write to
+ * @return 0 on success, AVERROR(ENOMEM) if bp is truncated
+ */
+int av_trace_export_json(AVBPrint *bp);
+
+/**
+ * Discard all recorded events and counters.
+ */
+void av_trace_reset(void);
+
+#endif /* AVUTIL_TRACE_H */
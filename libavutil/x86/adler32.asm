@@ -0,0 +1,75 @@
+;*****************************************************************************
+;* x86-optimized Adler-32 checksum
+;*
+;* This file is part of FFmpeg.
+;*
+;* FFmpeg is free software; you can redistribute it and/or
+;* modify it under the terms of the GNU Lesser General Public
+;* License as published by the Free Software Foundation; either
+;* version 2.1 of the License, or (at your option) any later version.
+;*
+;* FFmpeg is distributed in the hope that it will be useful,
+;* but WITHOUT ANY WARRANTY; without even the implied warranty of
+;* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+;* Lesser General Public License for more details.
+;*
+;* You should have received a copy of the GNU Lesser General Public
+;* License along with FFmpeg; if not, write to the Free Software
+;* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+;******************************************************************************
+
+%include "libavutil/x86/x86util.asm"
+
+SECTION_RODATA
+
+adler32_weights: db 16, 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1
+adler32_pw_1:    times 8 dw 1
+
+SECTION .text
+
+;-----------------------------------------------------------------------------
+; void ff_adler32_blocks(uint32_t sums[2], const uint8_t *buf, int len)
+;
+; Add the bytes of buf to the sums s1 = sums[0] and s2 = sums[1] without
+; reducing them modulo 65521. len must be a non-zero multiple of 16, and
+; small enough for s2 not to overflow (at most 5552 with reduced sums).
+;-----------------------------------------------------------------------------
+INIT_XMM ssse3
+cglobal adler32_blocks, 3, 4, 8, sums, buf, len, n
+    mova         m6, [adler32_weights]
+    mova         m7, [adler32_pw_1]
+    pxor         m0, m0 ; s1 of the blocks
+    pxor         m1, m1 ; weighted sum of the bytes within their blocks
+    pxor         m2, m2 ; sum of s1 before each block
+    pxor         m3, m3
+    mov          nd, lend
+
+.loop:
+    movu         m4, [bufq]
+    paddd        m2, m0
+    mova         m5, m4
+    psadbw       m4, m3
+    pmaddubsw    m5, m6
+    pmaddwd      m5, m7
+    paddd        m0, m4
+    paddd        m1, m5
+    add        bufq, 16
+    sub        lend, 16
+    jg .loop
+
+    ; s2 += 16 * sum(s1 before each block) + weighted sum + len * s1
+    pslld        m2, 4
+    paddd        m1, m2
+    pshufd       m4, m1, q1032
+    paddd        m1, m4
+    pshufd       m4, m1, q2301
+    paddd        m1, m4
+    pshufd       m4, m0, q1032
+    paddd        m0, m4
+    imul         nd, [sumsq]
+    movd       bufd, m1
+    add          nd, bufd
+    add   [sumsq+4], nd
+    movd       bufd, m0
+    add     [sumsq], bufd
+    RET
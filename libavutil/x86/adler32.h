@@ -0,0 +1,44 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef AVUTIL_X86_ADLER32_H
+#define AVUTIL_X86_ADLER32_H
+
+#include <stdint.h>
+
+typedef void (*ff_adler32_blocks_fn)(uint32_t sums[2], const uint8_t *buf, int len);
+
+/**
+ * Get the function adding len bytes of buf to the sums s1 = sums[0] and
+ * s2 = sums[1], without reducing them modulo 65521, for the current cpu
+ * flags. len must be a non-zero multiple of 16 and at most 5552.
+ *
+ * @return the function, NULL if the cpu does not support any
+ */
+ff_adler32_blocks_fn ff_adler32_get_blocks_x86(void);
+
+/**
+ * Update the Adler-32 checksum with the leading multiple of 16 bytes of
+ * *buf, if the cpu supports it, and advance *buf and *len past them.
+ *
+ * @return the updated checksum
+ */
+unsigned long ff_adler32_update_x86(unsigned long adler, const uint8_t **buf,
+                                    unsigned int *len);
+
+#endif /* AVUTIL_X86_ADLER32_H */
@@ -0,0 +1,60 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "config.h"
+
+#include "libavutil/common.h"
+#include "libavutil/x86/cpu.h"
+#include "adler32.h"
+
+#define BASE 65521
+/* largest multiple of 16 n such that 255n(n+1)/2 + (n+1)(BASE-1) < 2^32 */
+#define NMAX 5552
+
+void ff_adler32_blocks_ssse3(uint32_t sums[2], const uint8_t *buf, int len);
+
+ff_adler32_blocks_fn ff_adler32_get_blocks_x86(void)
+{
+    int cpu_flags = av_get_cpu_flags();
+
+    if (EXTERNAL_SSSE3(cpu_flags))
+        return ff_adler32_blocks_ssse3;
+    return NULL;
+}
+
+unsigned long ff_adler32_update_x86(unsigned long adler, const uint8_t **buf,
+                                    unsigned int *len)
+{
+    ff_adler32_blocks_fn blocks = ff_adler32_get_blocks_x86();
+
+    if (blocks) {
+        uint32_t sums[2] = { adler & 0xffff, adler >> 16 };
+
+        while (*len >= 16) {
+            unsigned n = FFMIN(*len & ~15, NMAX);
+
+            blocks(sums, *buf, n);
+            sums[0] %= BASE;
+            sums[1] %= BASE;
+            *buf += n;
+            *len -= n;
+        }
+        adler = sums[1] << 16 | sums[0];
+    }
+    return adler;
+}
@@ -0,0 +1,173 @@
+;*****************************************************************************
+;* x86-optimized CRC functions
+;*
+;* This file is part of FFmpeg.
+;*
+;* FFmpeg is free software; you can redistribute it and/or
+;* modify it under the terms of the GNU Lesser General Public
+;* License as published by the Free Software Foundation; either
+;* version 2.1 of the License, or (at your option) any later version.
+;*
+;* FFmpeg is distributed in the hope that it will be useful,
+;* but WITHOUT ANY WARRANTY; without even the implied warranty of
+;* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+;* Lesser General Public License for more details.
+;*
+;* You should have received a copy of the GNU Lesser General Public
+;* License along with FFmpeg; if not, write to the Free Software
+;* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+;******************************************************************************
+
+%include "libavutil/x86/x86util.asm"
+
+SECTION_RODATA
+
+crc_mask32:      dd -1, 0, 0, 0
+crc_nibble_mask: times 16 db 0x0f
+; bit-reversed nibbles, in the high and in the low half of a byte
+crc_bitrev_hi:   db 0x00, 0x80, 0x40, 0xc0, 0x20, 0xa0, 0x60, 0xe0
+                 db 0x10, 0x90, 0x50, 0xd0, 0x30, 0xb0, 0x70, 0xf0
+crc_bitrev_lo:   db 0x00, 0x08, 0x04, 0x0c, 0x02, 0x0a, 0x06, 0x0e
+                 db 0x01, 0x09, 0x05, 0x0d, 0x03, 0x0b, 0x07, 0x0f
+
+SECTION .text
+
+%if ARCH_X86_64
+
+; reverse the bit order of each byte of %1
+; uses m8-m12
+%macro BITREV 1
+    mova        m11, %1
+    psrlw       m11, 4
+    pand         %1, m8
+    pand        m11, m8
+    mova        m12, m9
+    pshufb      m12, %1
+    mova         %1, m10
+    pshufb       %1, m11
+    por          %1, m12
+%endmacro
+
+%macro LOAD 2 ; dst, src
+    movu         %1, %2
+%if BE
+    BITREV       %1
+%endif
+%endmacro
+
+; %1 = %1 * x^N + %2, with the fold constants for N in m4; clobbers %3
+%macro FOLD 3
+    mova         %3, %1
+    pclmulqdq    %1, m4, 0x00
+    pclmulqdq    %3, m4, 0x11
+    pxor         %1, %2
+    pxor         %1, %3
+%endmacro
+
+;-----------------------------------------------------------------------------
+; uint32_t ff_crc_le(const uint64_t consts[8], uint32_t crc,
+;                    const uint8_t *buf, size_t len)
+; uint32_t ff_crc_be(const uint64_t consts[8], uint32_t crc,
+;                    const uint8_t *buf, size_t len)
+;
+; Folding CRC with carry-less multiplication, following Intel's paper "Fast
+; CRC Computation for Generic Polynomials Using PCLMULQDQ Instruction".
+; The state is kept bit-reflected, so that the same code handles all tables:
+; the big-endian tables reverse the bits of each input byte and of the state.
+; consts holds the fold constants for 4 * 128 + 32, 4 * 128 - 32, 128 + 32,
+; 128 - 32 and 64 bits, a padding zero and the Barrett reduction constants,
+; see crc_init_consts() in crc_init.c.
+; len must be a multiple of 16 and at least 64.
+;-----------------------------------------------------------------------------
+%macro CRC 1
+%ifidn %1, be
+    %define BE 1
+%else
+    %define BE 0
+%endif
+cglobal crc_%1, 4, 4, 13, consts, crc, buf, len
+%if BE
+    mova         m8, [crc_nibble_mask]
+    mova         m9, [crc_bitrev_hi]
+    mova        m10, [crc_bitrev_lo]
+%endif
+    movd         m5, crcd
+%if BE
+    BITREV       m5
+%endif
+    LOAD         m0, [bufq]
+    LOAD         m1, [bufq + 16]
+    LOAD         m2, [bufq + 32]
+    LOAD         m3, [bufq + 48]
+    pxor         m0, m5
+    mova         m4, [constsq]
+    add        bufq, 64
+    sub        lenq, 128
+    jb .fold_4to1
+
+.loop4:
+    LOAD         m6, [bufq]
+    FOLD         m0, m6, m5
+    LOAD         m6, [bufq + 16]
+    FOLD         m1, m6, m5
+    LOAD         m6, [bufq + 32]
+    FOLD         m2, m6, m5
+    LOAD         m6, [bufq + 48]
+    FOLD         m3, m6, m5
+    add        bufq, 64
+    sub        lenq, 64
+    jae .loop4
+
+.fold_4to1:
+    mova         m4, [constsq + 16]
+    FOLD         m0, m1, m5
+    FOLD         m0, m2, m5
+    FOLD         m0, m3, m5
+    add        lenq, 64
+    jz .reduce
+
+.loop1:
+    LOAD         m6, [bufq]
+    FOLD         m0, m6, m5
+    add        bufq, 16
+    sub        lenq, 16
+    jnz .loop1
+
+.reduce:
+    ; 128 -> 64 bits
+    mova         m5, m0
+    pclmulqdq    m5, m4, 0x10
+    psrldq       m0, 8
+    pxor         m0, m5
+    ; 64 -> 32 bits
+    mova         m7, [crc_mask32]
+    mova         m4, [constsq + 32]
+    mova         m5, m0
+    pand         m5, m7
+    psrldq       m0, 4
+    pclmulqdq    m5, m4, 0x00
+    pxor         m0, m5
+    ; Barrett reduction
+    mova         m4, [constsq + 48]
+    mova         m5, m0
+    pand         m5, m7
+    pclmulqdq    m5, m4, 0x10
+    pand         m5, m7
+    pclmulqdq    m5, m4, 0x00
+    pxor         m0, m5
+%if BE
+    psrldq       m0, 4
+    BITREV       m0
+    movd        eax, m0
+%else
+    pextrd      eax, m0, 1
+%endif
+    RET
+%undef BE
+%endmacro
+
+INIT_XMM clmul
+CRC le
+CRC be
+
+%endif ; ARCH_X86_64
@@ -0,0 +1,47 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef AVUTIL_X86_CRC_H
+#define AVUTIL_X86_CRC_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "libavutil/crc.h"
+
+typedef uint32_t (*ff_crc_fold_fn)(AVCRCId crc_id, uint32_t crc,
+                                  const uint8_t *buffer, size_t length);
+
+/**
+ * Get the function updating the CRC of one of the builtin tables with a
+ * buffer of a multiple of 16 bytes, at least 64, for the current cpu flags.
+ *
+ * @return the function, NULL if the cpu does not support any
+ */
+ff_crc_fold_fn ff_crc_get_fold_x86(void);
+
+/**
+ * Update the CRC of one of the builtin tables with the leading part of
+ * buffer, if the cpu supports it.
+ *
+ * @return the number of bytes processed, 0 if none
+ */
+size_t ff_crc_x86(AVCRCId crc_id, uint32_t *crc,
+                  const uint8_t *buffer, size_t length);
+
+#endif /* AVUTIL_X86_CRC_H */
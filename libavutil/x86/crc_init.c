@@ -0,0 +1,136 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "config.h"
+
+#include "libavutil/attributes.h"
+#include "libavutil/mem.h"
+#include "libavutil/thread.h"
+#include "libavutil/x86/cpu.h"
+#include "crc.h"
+
+uint32_t ff_crc_le_clmul(const uint64_t consts[8], uint32_t crc,
+                         const uint8_t *buf, size_t len);
+uint32_t ff_crc_be_clmul(const uint64_t consts[8], uint32_t crc,
+                         const uint8_t *buf, size_t len);
+
+static const struct {
+    uint8_t  le, bits;
+    uint32_t poly;
+} crc_params[AV_CRC_MAX] = {
+    [AV_CRC_8_ATM]      = { 0,  8,       0x07 },
+    [AV_CRC_16_ANSI]    = { 0, 16,     0x8005 },
+    [AV_CRC_16_CCITT]   = { 0, 16,     0x1021 },
+    [AV_CRC_24_IEEE]    = { 0, 24,   0x864CFB },
+    [AV_CRC_32_IEEE]    = { 0, 32, 0x04C11DB7 },
+    [AV_CRC_32_IEEE_LE] = { 1, 32, 0xEDB88320 },
+    [AV_CRC_16_ANSI_LE] = { 1, 16,     0xA001 },
+};
+
+static DECLARE_ALIGNED(16, uint64_t, crc_consts)[AV_CRC_MAX][8];
+static AVOnce crc_consts_once = AV_ONCE_INIT;
+
+static uint64_t reverse_bits(uint64_t x, int bits)
+{
+    uint64_t r = 0;
+    int i;
+
+    for (i = 0; i < bits; i++)
+        r |= (x >> i & 1) << (bits - 1 - i);
+    return r;
+}
+
+/**
+ * Compute the constants of the folding code for a polynomial of the given
+ * width. A CRC of less than 32 bits is computed as a 32-bit CRC with the
+ * polynomial multiplied by x^(32 - bits). All constants are bit-reflected.
+ */
+static av_cold void crc_init_consts(uint64_t *consts, int le, int bits, uint32_t poly)
+{
+    static const int fold_bits[5] = { 4 * 128 + 32, 4 * 128 - 32,
+                                       128 + 32, 128 - 32, 64 };
+    uint64_t g, q, rem;
+    uint32_t glow, r;
+    int i, j;
+
+    if (le)
+        poly = reverse_bits(poly, bits);
+    glow = poly << (32 - bits);
+    g    = 1ULL << 32 | glow;
+
+    /* x^N mod G */
+    for (i = 0; i < 5; i++) {
+        for (r = glow, j = 32; j < fold_bits[i]; j++)
+            r = (r << 1) ^ (r >> 31 ? glow : 0);
+        consts[i] = reverse_bits(r, 32) << 1;
+    }
+    consts[5] = 0;
+
+    /* Barrett reduction: G and floor(x^64 / G) */
+    q   = 1ULL << 32;
+    rem = (uint64_t)glow << 32;
+    for (i = 63; i >= 32; i--) {
+        if (rem >> i & 1) {
+            rem ^= g << (i - 32);
+            q   |= 1ULL << (i - 32);
+        }
+    }
+    consts[6] = reverse_bits(g, 33);
+    consts[7] = reverse_bits(q, 33);
+}
+
+static av_cold void crc_init_consts_once(void)
+{
+    int i;
+
+    for (i = 0; i < AV_CRC_MAX; i++)
+        crc_init_consts(crc_consts[i], crc_params[i].le,
+                        crc_params[i].bits, crc_params[i].poly);
+}
+
+static uint32_t crc_fold_clmul(AVCRCId crc_id, uint32_t crc,
+                               const uint8_t *buffer, size_t length)
+{
+    ff_thread_once(&crc_consts_once, crc_init_consts_once);
+    if (crc_params[crc_id].le)
+        return ff_crc_le_clmul(crc_consts[crc_id], crc, buffer, length);
+    else
+        return ff_crc_be_clmul(crc_consts[crc_id], crc, buffer, length);
+}
+
+ff_crc_fold_fn ff_crc_get_fold_x86(void)
+{
+    int cpu_flags = av_get_cpu_flags();
+
+    if (ARCH_X86_64 && EXTERNAL_CLMUL(cpu_flags))
+        return crc_fold_clmul;
+    return NULL;
+}
+
+size_t ff_crc_x86(AVCRCId crc_id, uint32_t *crc,
+                  const uint8_t *buffer, size_t length)
+{
+    ff_crc_fold_fn fold = ff_crc_get_fold_x86();
+
+    if (fold && length >= 64) {
+        length &= ~(size_t)15;
+        *crc = fold(crc_id, *crc, buffer, length);
+        return length;
+    }
+    return 0;
+}
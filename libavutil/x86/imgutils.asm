@@ -51,3 +51,35 @@ cglobal image_copy_plane_uc_from, 6, 7, 4, dst, dst_linesize, src, src_linesize,
     jnz .row_start
 
     RET
+
+; bw is a multiple of 4 * mmsize, dst and dst_linesize are mmsize-aligned
+INIT_XMM sse2
+cglobal image_copy_plane_stream, 6, 7, 4, dst, dst_linesize, src, src_linesize, bw, height, rowpos
+    add dstq, bwq
+    add srcq, bwq
+    neg bwq
+
+.row_start:
+    mov rowposq, bwq
+
+.loop:
+    movu m0, [srcq + rowposq + 0 * mmsize]
+    movu m1, [srcq + rowposq + 1 * mmsize]
+    movu m2, [srcq + rowposq + 2 * mmsize]
+    movu m3, [srcq + rowposq + 3 * mmsize]
+
+    movntdq [dstq + rowposq + 0 * mmsize], m0
+    movntdq [dstq + rowposq + 1 * mmsize], m1
+    movntdq [dstq + rowposq + 2 * mmsize], m2
+    movntdq [dstq + rowposq + 3 * mmsize], m3
+
+    add rowposq, 4 * mmsize
+    jnz .loop
+
+    add srcq, src_linesizeq
+    add dstq, dst_linesizeq
+    dec heightd
+    jnz .row_start
+
+    sfence
+    RET
@@ -18,6 +18,7 @@
 
 #include <stddef.h>
 #include <stdint.h>
+#include <string.h>
 
 #include "libavutil/cpu.h"
 #include "libavutil/error.h"
@@ -30,6 +31,9 @@
 void ff_image_copy_plane_uc_from_sse4(uint8_t *dst, ptrdiff_t dst_linesize,
                                       const uint8_t *src, ptrdiff_t src_linesize,
                                       ptrdiff_t bytewidth, int height);
+void ff_image_copy_plane_stream_sse2(uint8_t *dst, ptrdiff_t dst_linesize,
+                                     const uint8_t *src, ptrdiff_t src_linesize,
+                                     ptrdiff_t bytewidth, int height);
 
 int ff_image_copy_plane_uc_from_x86(uint8_t       *dst, ptrdiff_t dst_linesize,
                                     const uint8_t *src, ptrdiff_t src_linesize,
@@ -47,3 +51,34 @@ int ff_image_copy_plane_uc_from_x86(uint8_t       *dst, ptrdiff_t dst_linesize,
 
     return 0;
 }
+
+ff_image_copy_plane_fn ff_image_get_copy_plane_stream_x86(void)
+{
+    int cpu_flags = av_get_cpu_flags();
+
+    if (EXTERNAL_SSE2(cpu_flags))
+        return ff_image_copy_plane_stream_sse2;
+    return NULL;
+}
+
+int ff_image_copy_plane_stream_x86(uint8_t       *dst, ptrdiff_t dst_linesize,
+                                   const uint8_t *src, ptrdiff_t src_linesize,
+                                   ptrdiff_t bytewidth, int height)
+{
+    ff_image_copy_plane_fn copy = ff_image_get_copy_plane_stream_x86();
+    ptrdiff_t bw_body = bytewidth & ~63;
+    int i;
+
+    if (!copy || !bw_body || height <= 0 ||
+        ((intptr_t)dst | dst_linesize) & 15)
+        return AVERROR(ENOSYS);
+
+    copy(dst, dst_linesize, src, src_linesize, bw_body, height);
+    /* the end of the rows, past the last 64 bytes block */
+    if (bw_body < bytewidth)
+        for (i = 0; i < height; i++)
+            memcpy(dst + i * dst_linesize + bw_body, src + i * src_linesize + bw_body,
+                   bytewidth - bw_body);
+
+    return 0;
+}
@@ -0,0 +1,163 @@
+;*****************************************************************************
+;* x86-optimized SHA-1 and SHA-256 transforms
+;*
+;* This file is part of FFmpeg.
+;*
+;* FFmpeg is free software; you can redistribute it and/or
+;* modify it under the terms of the GNU Lesser General Public
+;* License as published by the Free Software Foundation; either
+;* version 2.1 of the License, or (at your option) any later version.
+;*
+;* FFmpeg is distributed in the hope that it will be useful,
+;* but WITHOUT ANY WARRANTY; without even the implied warranty of
+;* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+;* Lesser General Public License for more details.
+;*
+;* You should have received a copy of the GNU Lesser General Public
+;* License along with FFmpeg; if not, write to the Free Software
+;* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+;******************************************************************************
+
+%include "libavutil/x86/x86util.asm"
+
+SECTION_RODATA
+
+sha1_shuf:       db 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0
+sha256_shuf:     db 3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12
+sha256_k:        dd 0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5
+                 dd 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5
+                 dd 0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3
+                 dd 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174
+                 dd 0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc
+                 dd 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da
+                 dd 0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7
+                 dd 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967
+                 dd 0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13
+                 dd 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85
+                 dd 0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3
+                 dd 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070
+                 dd 0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5
+                 dd 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3
+                 dd 0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208
+                 dd 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+
+SECTION .text
+
+%if ARCH_X86_64
+
+INIT_XMM shani
+;-----------------------------------------------------------------------------
+; void ff_sha1_transform(uint32_t state[5], const uint8_t buffer[64])
+;-----------------------------------------------------------------------------
+cglobal sha1_transform, 2, 2, 10, state, buf
+    ; m0: ABCD, m1/m2: E, m3-m6: message schedule, m7/m8: input state
+    movu         m0, [stateq]
+    pshufd       m0, m0, q0123
+    movd         m1, [stateq + 16]
+    pslldq       m1, 12
+    mova         m7, m0
+    mova         m8, m1
+    mova         m9, [sha1_shuf]
+    movu         m3, [bufq]
+    pshufb       m3, m9
+    movu         m4, [bufq + 16]
+    pshufb       m4, m9
+    movu         m5, [bufq + 32]
+    pshufb       m5, m9
+    movu         m6, [bufq + 48]
+    pshufb       m6, m9
+
+%assign i 0
+%rep 20
+    %assign cur   3 + (i & 3)
+    %assign next  3 + ((i + 1) & 3)
+    %assign prev2 3 + ((i + 2) & 3)
+    %assign prev  3 + ((i + 3) & 3)
+%if i == 0
+    paddd        m1, m3
+%else
+    sha1nexte    m1, m %+ cur
+%endif
+    mova         m2, m0
+%if i >= 3 && i < 19
+    sha1msg2     m %+ next, m %+ cur
+%endif
+    sha1rnds4    m0, m1, i / 5
+    SWAP          1, 2
+%if i >= 1 && i < 17
+    sha1msg1     m %+ prev, m %+ cur
+%endif
+%if i >= 2 && i < 18
+    pxor         m %+ prev2, m %+ cur
+%endif
+    %assign i i + 1
+%endrep
+
+    sha1nexte    m1, m8
+    paddd        m0, m7
+    pshufd       m0, m0, q0123
+    psrldq       m1, 12
+    movu   [stateq], m0
+    movd   [stateq + 16], m1
+    RET
+
+;-----------------------------------------------------------------------------
+; void ff_sha256_transform(uint32_t state[8], const uint8_t buffer[64])
+;-----------------------------------------------------------------------------
+cglobal sha256_transform, 2, 2, 11, state, buf
+    ; m0: message + constants (implicit operand of sha256rnds2),
+    ; m1: ABEF, m2: CDGH, m3: temporary, m4-m7: message schedule,
+    ; m8/m9: input state
+    movu         m3, [stateq]
+    movu         m2, [stateq + 16]
+    pshufd       m3, m3, q2301
+    pshufd       m2, m2, q0123
+    mova         m1, m3
+    palignr      m1, m2, 8
+    pblendw      m2, m3, 0xf0
+    mova         m8, m1
+    mova         m9, m2
+    mova        m10, [sha256_shuf]
+    movu         m4, [bufq]
+    pshufb       m4, m10
+    movu         m5, [bufq + 16]
+    pshufb       m5, m10
+    movu         m6, [bufq + 32]
+    pshufb       m6, m10
+    movu         m7, [bufq + 48]
+    pshufb       m7, m10
+
+%assign i 0
+%rep 16
+    %assign cur   4 + (i & 3)
+    %assign next  4 + ((i + 1) & 3)
+    %assign prev  4 + ((i + 3) & 3)
+    mova         m0, [sha256_k + 16 * i]
+    paddd        m0, m %+ cur
+    sha256rnds2  m2, m1, m0
+    pshufd       m0, m0, q1032
+    sha256rnds2  m1, m2, m0
+%if i >= 3 && i < 15
+    mova         m3, m %+ cur
+    palignr      m3, m %+ prev, 4
+    paddd        m %+ next, m3
+    sha256msg2   m %+ next, m %+ cur
+%endif
+%if i >= 1 && i < 13
+    sha256msg1   m %+ prev, m %+ cur
+%endif
+    %assign i i + 1
+%endrep
+
+    paddd        m1, m8
+    paddd        m2, m9
+    pshufd       m3, m1, q0123
+    pshufd       m2, m2, q2301
+    mova         m1, m3
+    pblendw      m1, m2, 0xf0
+    palignr      m2, m3, 8
+    movu   [stateq], m1
+    movu   [stateq + 16], m2
+    RET
+
+%endif ; ARCH_X86_64
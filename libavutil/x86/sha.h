@@ -0,0 +1,32 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef AVUTIL_X86_SHA_H
+#define AVUTIL_X86_SHA_H
+
+#include "libavutil/sha_internal.h"
+
+/**
+ * Replace the transform function of an AVSHA context by an optimized one,
+ * if the cpu supports it.
+ *
+ * @param bits number of bits of the digest
+ */
+void ff_sha_init_x86(ff_sha_transform_fn *transform, int bits);
+
+#endif /* AVUTIL_X86_SHA_H */
@@ -0,0 +1,35 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "config.h"
+
+#include "libavutil/attributes.h"
+#include "libavutil/x86/cpu.h"
+#include "sha.h"
+
+void ff_sha1_transform_shani(uint32_t *state, const uint8_t buffer[64]);
+void ff_sha256_transform_shani(uint32_t *state, const uint8_t buffer[64]);
+
+av_cold void ff_sha_init_x86(ff_sha_transform_fn *transform, int bits)
+{
+    int cpu_flags = av_get_cpu_flags();
+
+    if (ARCH_X86_64 && EXTERNAL_SHANI(cpu_flags))
+        *transform = bits == 160 ? ff_sha1_transform_shani
+                                 : ff_sha256_transform_shani;
+}
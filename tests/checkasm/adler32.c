@@ -0,0 +1,84 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <string.h>
+
+#include "checkasm.h"
+#include "libavutil/common.h"
+#include "libavutil/internal.h"
+#include "libavutil/mem.h"
+#if ARCH_X86
+#include "libavutil/x86/adler32.h"
+#endif
+
+#define BASE 65521
+/* the longest buffer the sums may not overflow with */
+#define NMAX 5552
+
+typedef void (*adler32_blocks_fn)(uint32_t sums[2], const uint8_t *buf, int len);
+
+static void adler32_blocks_c(uint32_t sums[2], const uint8_t *buf, int len)
+{
+    uint32_t s1 = sums[0], s2 = sums[1];
+
+    while (len--) {
+        s1 += *buf++;
+        s2 += s1;
+    }
+    sums[0] = s1;
+    sums[1] = s2;
+}
+
+void checkasm_check_adler32(void)
+{
+    LOCAL_ALIGNED_16(uint8_t, buf, [NMAX + 16]);
+    adler32_blocks_fn blocks = adler32_blocks_c;
+    uint32_t sums[2] = { 0 };
+    int i;
+
+    declare_func(void, uint32_t sums[2], const uint8_t *buf, int len);
+
+    for (i = 0; i < NMAX + 16; i++)
+        buf[i] = rnd();
+    /* the worst case for the overflows */
+    memset(buf, 0xff, 64);
+
+#if ARCH_X86
+    if (ff_adler32_get_blocks_x86())
+        blocks = ff_adler32_get_blocks_x86();
+#endif
+
+    if (check_func(blocks, "adler32_blocks")) {
+        for (i = 0; i < 64; i++) {
+            int len    = i ? 16 + (rnd() % (NMAX / 16)) * 16 : NMAX;
+            int offset = i ? rnd() % 16 : 0;
+            uint32_t s1 = i ? rnd() % BASE : BASE - 1;
+            uint32_t s2 = i ? rnd() % BASE : BASE - 1;
+            uint32_t ref[2] = { s1, s2 }, new[2] = { s1, s2 };
+
+            call_ref(ref, buf + offset, len);
+            call_new(new, buf + offset, len);
+            if (ref[0] != new[0] || ref[1] != new[1]) {
+                fail();
+                break;
+            }
+        }
+        bench_new(sums, buf, NMAX);
+    }
+    report("adler32");
+}
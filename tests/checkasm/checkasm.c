@@ -155,13 +155,29 @@ static const struct {
     #if CONFIG_HFLIP_FILTER
         { "vf_hflip", checkasm_check_vf_hflip },
     #endif
+    #if CONFIG_NNEDI_FILTER
+        { "vf_nnedi", checkasm_check_vf_nnedi },
+    #endif
+    #if CONFIG_SMARTBLUR_FILTER
+        { "vf_smartblur", checkasm_check_vf_smartblur },
+    #endif
     #if CONFIG_THRESHOLD_FILTER
         { "vf_threshold", checkasm_check_vf_threshold },
     #endif
+    #if CONFIG_UNSHARP_FILTER
+        { "vf_unsharp", checkasm_check_vf_unsharp },
+    #endif
+    #if CONFIG_VECTORSCOPE_FILTER
+        { "vf_vectorscope", checkasm_check_vf_vectorscope },
+    #endif
 #endif
 #if CONFIG_AVUTIL
+        { "adler32", checkasm_check_adler32 },
+        { "crc", checkasm_check_crc },
         { "fixed_dsp", checkasm_check_fixed_dsp },
         { "float_dsp", checkasm_check_float_dsp },
+        { "imgutils", checkasm_check_imgutils },
+        { "sha", checkasm_check_sha },
 #endif
     { NULL }
 };
@@ -199,6 +215,8 @@ static const struct {
     { "SSE4.1",   "sse4",     AV_CPU_FLAG_SSE4 },
     { "SSE4.2",   "sse42",    AV_CPU_FLAG_SSE42 },
     { "AES-NI",   "aesni",    AV_CPU_FLAG_AESNI },
+    { "CLMUL",    "clmul",    AV_CPU_FLAG_CLMUL },
+    { "SHA-NI",   "shani",    AV_CPU_FLAG_SHANI },
     { "AVX",      "avx",      AV_CPU_FLAG_AVX },
     { "XOP",      "xop",      AV_CPU_FLAG_XOP },
     { "FMA3",     "fma3",     AV_CPU_FLAG_FMA3 },
@@ -0,0 +1,95 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <string.h>
+
+#include "checkasm.h"
+#include "libavutil/common.h"
+#include "libavutil/crc.h"
+#include "libavutil/internal.h"
+#include "libavutil/mem.h"
+#if ARCH_X86
+#include "libavutil/x86/crc.h"
+#endif
+
+#define BUF_SIZE 4096
+
+typedef uint32_t (*crc_fold_fn)(AVCRCId crc_id, uint32_t crc,
+                                const uint8_t *buffer, size_t length);
+
+static uint32_t crc_fold_c(AVCRCId crc_id, uint32_t crc,
+                           const uint8_t *buffer, size_t length)
+{
+    const AVCRC *table = av_crc_get_table(crc_id);
+
+    while (length--)
+        crc = table[(uint8_t)crc ^ *buffer++] ^ (crc >> 8);
+    return crc;
+}
+
+static void check_crc(AVCRCId crc_id, const uint8_t *buf)
+{
+    int i;
+
+    declare_func(uint32_t, AVCRCId crc_id, uint32_t crc,
+                 const uint8_t *buffer, size_t length);
+
+    for (i = 0; i < 64; i++) {
+        /* a multiple of 16 bytes, at least 64, at any alignment */
+        size_t len    = 64 + (rnd() % (BUF_SIZE / 16 - 4)) * 16;
+        size_t offset = rnd() % 16;
+        uint32_t crc  = rnd(), ref, new;
+
+        ref = call_ref(crc_id, crc, buf + offset, len);
+        new = call_new(crc_id, crc, buf + offset, len);
+        if (ref != new) {
+            fail();
+            break;
+        }
+    }
+    bench_new(crc_id, 0, buf, BUF_SIZE);
+}
+
+void checkasm_check_crc(void)
+{
+    static const char *const names[AV_CRC_MAX] = {
+        [AV_CRC_8_ATM]      = "8_atm",
+        [AV_CRC_16_ANSI]    = "16_ansi",
+        [AV_CRC_16_CCITT]   = "16_ccitt",
+        [AV_CRC_24_IEEE]    = "24_ieee",
+        [AV_CRC_32_IEEE]    = "32_ieee",
+        [AV_CRC_32_IEEE_LE] = "32_ieee_le",
+        [AV_CRC_16_ANSI_LE] = "16_ansi_le",
+    };
+    LOCAL_ALIGNED_16(uint8_t, buf, [BUF_SIZE + 16]);
+    crc_fold_fn fold = crc_fold_c;
+    int i;
+
+    for (i = 0; i < BUF_SIZE + 16; i++)
+        buf[i] = rnd();
+
+#if ARCH_X86
+    if (ff_crc_get_fold_x86())
+        fold = ff_crc_get_fold_x86();
+#endif
+
+    for (i = 0; i < AV_CRC_MAX; i++)
+        if (check_func(fold, "crc_%s", names[i]))
+            check_crc(i, buf);
+    report("crc");
+}
@@ -0,0 +1,88 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <string.h>
+
+#include "checkasm.h"
+#include "libavutil/common.h"
+#include "libavutil/imgutils_internal.h"
+#include "libavutil/internal.h"
+#include "libavutil/mem.h"
+
+#define MAX_WIDTH  1024
+#define MAX_HEIGHT 16
+#define BUF_SIZE   ((MAX_WIDTH + 64) * MAX_HEIGHT)
+
+static void copy_plane_c(uint8_t       *dst, ptrdiff_t dst_linesize,
+                         const uint8_t *src, ptrdiff_t src_linesize,
+                         ptrdiff_t bytewidth, int height)
+{
+    for (; height > 0; height--) {
+        memcpy(dst, src, bytewidth);
+        dst += dst_linesize;
+        src += src_linesize;
+    }
+}
+
+static void check_copy_plane_stream(void)
+{
+    LOCAL_ALIGNED_16(uint8_t, src, [BUF_SIZE + 16]);
+    LOCAL_ALIGNED_16(uint8_t, dst_ref, [BUF_SIZE]);
+    LOCAL_ALIGNED_16(uint8_t, dst_new, [BUF_SIZE]);
+    ff_image_copy_plane_fn copy = copy_plane_c;
+    int i;
+
+    declare_func(void, uint8_t *dst, ptrdiff_t dst_linesize,
+                 const uint8_t *src, ptrdiff_t src_linesize,
+                 ptrdiff_t bytewidth, int height);
+
+    for (i = 0; i < BUF_SIZE + 16; i++)
+        src[i] = rnd();
+
+#if ARCH_X86
+    if (ff_image_get_copy_plane_stream_x86())
+        copy = ff_image_get_copy_plane_stream_x86();
+#endif
+
+    if (check_func(copy, "image_copy_plane_stream")) {
+        for (i = 0; i < 32; i++) {
+            /* the destination is aligned, the source does not need to be */
+            ptrdiff_t bytewidth    = 64 * (1 + rnd() % (MAX_WIDTH / 64));
+            ptrdiff_t dst_linesize = bytewidth + 16 * (rnd() % 4);
+            ptrdiff_t src_linesize = bytewidth + rnd() % 64;
+            int height = 1 + rnd() % MAX_HEIGHT;
+            int offset = rnd() % 16;
+
+            memset(dst_ref, 0, BUF_SIZE);
+            memset(dst_new, 0, BUF_SIZE);
+            call_ref(dst_ref, dst_linesize, src + offset, src_linesize, bytewidth, height);
+            call_new(dst_new, dst_linesize, src + offset, src_linesize, bytewidth, height);
+            if (memcmp(dst_ref, dst_new, BUF_SIZE)) {
+                fail();
+                break;
+            }
+        }
+        bench_new(dst_new, MAX_WIDTH, src, MAX_WIDTH, MAX_WIDTH, MAX_HEIGHT);
+    }
+}
+
+void checkasm_check_imgutils(void)
+{
+    check_copy_plane_stream();
+    report("image_copy_plane_stream");
+}
@@ -0,0 +1,59 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <string.h>
+
+#include "checkasm.h"
+#include "libavutil/common.h"
+#include "libavutil/internal.h"
+#include "libavutil/mem.h"
+#include "libavutil/sha_internal.h"
+
+void checkasm_check_sha(void)
+{
+    static const int bits[] = { 160, 256 };
+    LOCAL_ALIGNED_16(uint8_t, buf, [64 + 16]);
+    uint32_t state[8] = { 0 };
+    int i, j;
+
+    declare_func(void, uint32_t *state, const uint8_t buffer[64]);
+
+    for (i = 0; i < 64 + 16; i++)
+        buf[i] = rnd();
+
+    for (i = 0; i < FF_ARRAY_ELEMS(bits); i++) {
+        if (check_func(ff_sha_get_transform(bits[i]), "sha%d_transform",
+                       bits[i] == 160 ? 1 : 256)) {
+            for (j = 0; j < 32; j++) {
+                uint32_t ref[8], new[8];
+                int offset = rnd() % 16, k;
+
+                for (k = 0; k < 8; k++)
+                    ref[k] = new[k] = rnd();
+                call_ref(ref, buf + offset);
+                call_new(new, buf + offset);
+                if (memcmp(ref, new, sizeof(ref))) {
+                    fail();
+                    break;
+                }
+            }
+            bench_new(state, buf);
+        }
+    }
+    report("sha");
+}
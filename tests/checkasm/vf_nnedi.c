@@ -0,0 +1,134 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <string.h>
+#include "checkasm.h"
+#include "libavfilter/nnedi.h"
+#include "libavutil/mem.h"
+
+#define NNS 32
+#define MAX_LEN (48 * 6)
+
+#define randomize_float(buf, size)                           \
+    do {                                                     \
+        int j;                                               \
+        for (j = 0; j < size; j++)                           \
+            buf[j] = ((int)(rnd() % 2001) - 1000) / 1000.0f; \
+    } while (0)
+
+#define randomize_int16(buf, size)                           \
+    do {                                                     \
+        int j;                                               \
+        for (j = 0; j < size; j++)                           \
+            buf[j] = (int)(rnd() % 4096) - 2048;             \
+    } while (0)
+
+static void check_dot_prod(NNEDIDSPContext *dsp)
+{
+    LOCAL_ALIGNED_32(float, data,    [MAX_LEN]);
+    LOCAL_ALIGNED_32(float, weights, [NNS * MAX_LEN + NNS]);
+    LOCAL_ALIGNED_32(float, vals_ref, [NNS]);
+    LOCAL_ALIGNED_32(float, vals_new, [NNS]);
+    static const int lens[] = { 4 * 12, 8 * 4, 16 * 6, 32 * 4, 48 * 6, 52 };
+    float scale = 0.25f;
+    int i;
+
+    declare_func(void, const float *data, const float *weights, float *vals,
+                 int n, int len, const float *scale);
+
+    randomize_float(data, MAX_LEN);
+    randomize_float(weights, NNS * MAX_LEN + NNS);
+
+    for (i = 0; i < FF_ARRAY_ELEMS(lens); i++) {
+        if (check_func(dsp->dot_prod, "nnedi_dot_prod_%d", lens[i])) {
+            call_ref(data, weights, vals_ref, NNS, lens[i], &scale);
+            call_new(data, weights, vals_new, NNS, lens[i], &scale);
+            if (!float_near_abs_eps_array(vals_ref, vals_new, 1e-4f, NNS))
+                fail();
+            bench_new(data, weights, vals_new, NNS, lens[i], &scale);
+        }
+    }
+}
+
+static void check_dot_prods(NNEDIDSPContext *dsp)
+{
+    LOCAL_ALIGNED_32(int16_t, data,    [MAX_LEN]);
+    LOCAL_ALIGNED_32(int16_t, weights, [NNS * MAX_LEN]);
+    LOCAL_ALIGNED_32(int32_t, sums_ref, [NNS]);
+    LOCAL_ALIGNED_32(int32_t, sums_new, [NNS]);
+    static const int lens[] = { 4 * 16, 8 * 4, 16 * 6, 32 * 4, 48 * 6 };
+    int i, j;
+
+    declare_func(void, const int16_t *data, const int16_t *weights,
+                 int32_t *sums, int n, int len);
+
+    /* the filter feeds 8 bit pixels with 16 bit weights */
+    for (j = 0; j < MAX_LEN; j++)
+        data[j] = rnd() & 0xFF;
+    randomize_int16(weights, NNS * MAX_LEN);
+
+    for (i = 0; i < FF_ARRAY_ELEMS(lens); i++) {
+        if (check_func(dsp->dot_prods, "nnedi_dot_prods_%d", lens[i])) {
+            call_ref(data, weights, sums_ref, NNS, lens[i]);
+            call_new(data, weights, sums_new, NNS, lens[i]);
+            if (memcmp(sums_ref, sums_new, NNS * sizeof(*sums_ref)))
+                fail();
+            bench_new(data, weights, sums_new, NNS, lens[i]);
+        }
+    }
+}
+
+static void check_elliott(NNEDIDSPContext *dsp)
+{
+    LOCAL_ALIGNED_32(float, src,      [NNS * 4]);
+    LOCAL_ALIGNED_32(float, data_ref, [NNS * 4]);
+    LOCAL_ALIGNED_32(float, data_new, [NNS * 4]);
+    int i;
+
+    declare_func(void, float *data, int n);
+
+    randomize_float(src, NNS * 4);
+    for (i = 0; i < NNS * 4; i++)
+        src[i] *= 16.0f;
+
+    if (check_func(dsp->elliott, "nnedi_elliott")) {
+        memcpy(data_ref, src, sizeof(*src) * NNS * 4);
+        memcpy(data_new, src, sizeof(*src) * NNS * 4);
+        call_ref(data_ref, NNS * 4);
+        call_new(data_new, NNS * 4);
+        if (!float_near_ulp_array(data_ref, data_new, 1, NNS * 4))
+            fail();
+        bench_new(data_new, NNS * 4);
+    }
+}
+
+void checkasm_check_vf_nnedi(void)
+{
+    NNEDIDSPContext dsp;
+
+    ff_nnedi_init_dsp(&dsp);
+
+    check_dot_prod(&dsp);
+    report("dot_prod");
+
+    check_dot_prods(&dsp);
+    report("dot_prods");
+
+    check_elliott(&dsp);
+    report("elliott");
+}
@@ -0,0 +1,64 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <string.h>
+#include "checkasm.h"
+#include "libavfilter/smartblur.h"
+#include "libavutil/mem.h"
+
+#define WIDTH 256
+
+static void check_threshold(SmartblurDSPContext *dsp)
+{
+    LOCAL_ALIGNED_32(uint8_t, src,     [WIDTH]);
+    LOCAL_ALIGNED_32(uint8_t, blur,    [WIDTH]);
+    LOCAL_ALIGNED_32(uint8_t, dst_ref, [WIDTH]);
+    LOCAL_ALIGNED_32(uint8_t, dst_new, [WIDTH]);
+    static const int thresholds[] = { 1, 7, 30, -1, -7, -30 };
+    int i, j;
+
+    declare_func(void, uint8_t *dst, const uint8_t *src, int w, int threshold);
+
+    for (i = 0; i < FF_ARRAY_ELEMS(thresholds); i++) {
+        /* keep the blurred line close enough to the source to hit every case */
+        for (j = 0; j < WIDTH; j++) {
+            src[j]  = rnd() & 0xFF;
+            blur[j] = av_clip_uint8(src[j] + (int)(rnd() % 161) - 80);
+        }
+        memcpy(dst_ref, blur, WIDTH);
+        memcpy(dst_new, blur, WIDTH);
+
+        if (check_func(dsp->threshold, "smartblur_threshold_%d", thresholds[i])) {
+            call_ref(dst_ref, src, WIDTH - 16, thresholds[i]);
+            call_new(dst_new, src, WIDTH - 16, thresholds[i]);
+            if (memcmp(dst_ref, dst_new, WIDTH))
+                fail();
+            bench_new(dst_new, src, WIDTH, thresholds[i]);
+        }
+    }
+}
+
+void checkasm_check_vf_smartblur(void)
+{
+    SmartblurDSPContext dsp;
+
+    ff_smartblur_init_dsp(&dsp);
+
+    check_threshold(&dsp);
+    report("threshold");
+}
@@ -0,0 +1,106 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <string.h>
+#include "checkasm.h"
+#include "libavfilter/unsharp.h"
+#include "libavutil/mem.h"
+
+#define WIDTH 256
+#define STEPS 5
+#define STRIDE (WIDTH + 8)
+
+static void check_vertical(UnsharpDSPContext *dsp)
+{
+    LOCAL_ALIGNED_32(uint32_t, sc_ref,   [STEPS * 2 * STRIDE]);
+    LOCAL_ALIGNED_32(uint32_t, sc_new,   [STEPS * 2 * STRIDE]);
+    LOCAL_ALIGNED_32(uint32_t, line_ref, [STRIDE]);
+    LOCAL_ALIGNED_32(uint32_t, line_new, [STRIDE]);
+    static const int widths[] = { 8, 24, WIDTH };
+    int i, j, steps;
+
+    declare_func(void, uint32_t *line, uint32_t *sc, int sc_stride,
+                 int steps, int w);
+
+    for (i = 0; i < FF_ARRAY_ELEMS(widths); i++) {
+        for (steps = 1; steps <= STEPS; steps += 2) {
+            /* sums of up to 2^24 pixels never overflow in the filter */
+            for (j = 0; j < STEPS * 2 * STRIDE; j++)
+                sc_ref[j] = rnd() & 0xFFFFFF;
+            for (j = 0; j < STRIDE; j++)
+                line_ref[j] = rnd() & 0xFFFF;
+            memcpy(sc_new,   sc_ref,   sizeof(sc_ref[0]) * STEPS * 2 * STRIDE);
+            memcpy(line_new, line_ref, sizeof(line_ref[0]) * STRIDE);
+
+            if (check_func(dsp->vertical, "unsharp_vertical_%d_%d", widths[i], steps)) {
+                /* offset the columns like the filter does */
+                call_ref(line_ref + 2, sc_ref + 2, STRIDE, steps, widths[i]);
+                call_new(line_new + 2, sc_new + 2, STRIDE, steps, widths[i]);
+                if (memcmp(line_ref, line_new, sizeof(line_ref[0]) * STRIDE) ||
+                    memcmp(sc_ref, sc_new, sizeof(sc_ref[0]) * STEPS * 2 * STRIDE))
+                    fail();
+                bench_new(line_new + 2, sc_new + 2, STRIDE, steps, widths[i]);
+            }
+        }
+    }
+}
+
+static void check_output(UnsharpDSPContext *dsp)
+{
+    LOCAL_ALIGNED_32(uint8_t,  src,     [WIDTH]);
+    LOCAL_ALIGNED_32(uint32_t, blur,    [WIDTH]);
+    LOCAL_ALIGNED_32(uint8_t,  dst_ref, [WIDTH + 8]);
+    LOCAL_ALIGNED_32(uint8_t,  dst_new, [WIDTH + 8]);
+    /* 3x3 sharpen, 5x5 blur and 23x23 sharpen at the option limits */
+    static const int amounts[]   = { 65536, -2 * 65536, 5 * 65536 };
+    static const int scalebits[] = { 4, 8, 24 };
+    int i, j;
+
+    declare_func(void, uint8_t *dst, const uint8_t *src, const uint32_t *blur,
+                 int w, int amount, int scalebits, int halfscale);
+
+    for (i = 0; i < FF_ARRAY_ELEMS(amounts); i++) {
+        for (j = 0; j < WIDTH; j++) {
+            src[j]  = rnd() & 0xFF;
+            blur[j] = (rnd() & 0xFF) << scalebits[i] | (rnd() & ((1 << scalebits[i]) - 1));
+        }
+        memset(dst_ref, 0, WIDTH + 8);
+        memset(dst_new, 0, WIDTH + 8);
+
+        if (check_func(dsp->output, "unsharp_output_%d", scalebits[i])) {
+            call_ref(dst_ref, src, blur, WIDTH - 8, amounts[i], scalebits[i], 1 << (scalebits[i] - 1));
+            call_new(dst_new, src, blur, WIDTH - 8, amounts[i], scalebits[i], 1 << (scalebits[i] - 1));
+            if (memcmp(dst_ref, dst_new, WIDTH + 8))
+                fail();
+            bench_new(dst_new, src, blur, WIDTH, amounts[i], scalebits[i], 1 << (scalebits[i] - 1));
+        }
+    }
+}
+
+void checkasm_check_vf_unsharp(void)
+{
+    UnsharpDSPContext dsp;
+
+    ff_unsharp_init_dsp(&dsp);
+
+    check_vertical(&dsp);
+    report("vertical");
+
+    check_output(&dsp);
+    report("output");
+}
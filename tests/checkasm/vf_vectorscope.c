@@ -0,0 +1,109 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <string.h>
+#include "checkasm.h"
+#include "libavfilter/vectorscope.h"
+#include "libavutil/mem.h"
+
+#define MAX_MAPS 4
+
+static void check_merge(VectorscopeDSPContext *dsp)
+{
+    LOCAL_ALIGNED_32(uint32_t, dst_ref, [256]);
+    LOCAL_ALIGNED_32(uint32_t, dst_new, [256]);
+    /* only the first row of every map is used */
+    uint32_t *maps = av_malloc(((MAX_MAPS - 1) * VECTORSCOPE_MAP_SIZE + 256) * sizeof(*maps));
+    int i, j, nb_maps;
+
+    declare_func(void, uint32_t *dst, const uint32_t *maps, int nb_maps);
+
+    if (!maps)
+        return;
+
+    for (i = 0; i < MAX_MAPS; i++)
+        for (j = 0; j < 256; j++)
+            maps[i * VECTORSCOPE_MAP_SIZE + j] = rnd() % 3 ? rnd() : 0;
+
+    for (nb_maps = 1; nb_maps <= MAX_MAPS; nb_maps++) {
+        if (check_func(dsp->sum_maps, "vectorscope_sum_maps_%d", nb_maps)) {
+            call_ref(dst_ref, maps, nb_maps);
+            call_new(dst_new, maps, nb_maps);
+            if (memcmp(dst_ref, dst_new, 256 * sizeof(*dst_ref)))
+                fail();
+            bench_new(dst_new, maps, nb_maps);
+        }
+        if (check_func(dsp->max_maps, "vectorscope_max_maps_%d", nb_maps)) {
+            call_ref(dst_ref, maps, nb_maps);
+            call_new(dst_new, maps, nb_maps);
+            if (memcmp(dst_ref, dst_new, 256 * sizeof(*dst_ref)))
+                fail();
+            bench_new(dst_new, maps, nb_maps);
+        }
+    }
+
+    av_free(maps);
+}
+
+static void check_add_hits(VectorscopeDSPContext *dsp)
+{
+    LOCAL_ALIGNED_32(uint32_t, hits, [256]);
+    LOCAL_ALIGNED_32(uint8_t, src,     [256]);
+    LOCAL_ALIGNED_32(uint8_t, dst_ref, [256]);
+    LOCAL_ALIGNED_32(uint8_t, dst_new, [256]);
+    static const int intensities[] = { 0, 1, 17, 255 };
+    int i, j;
+
+    declare_func(void, uint8_t *dst, const uint32_t *hits, int intensity);
+
+    for (j = 0; j < 256; j++) {
+        /* few hits, around the 256 clamp and huge counts */
+        switch (rnd() & 3) {
+        case 0:  hits[j] = 0;                  break;
+        case 1:  hits[j] = rnd() & 15;         break;
+        case 2:  hits[j] = 250 + (rnd() & 15); break;
+        default: hits[j] = rnd();              break;
+        }
+        src[j] = rnd();
+    }
+
+    for (i = 0; i < FF_ARRAY_ELEMS(intensities); i++) {
+        if (check_func(dsp->add_hits, "vectorscope_add_hits_%d", intensities[i])) {
+            memcpy(dst_ref, src, 256);
+            memcpy(dst_new, src, 256);
+            call_ref(dst_ref, hits, intensities[i]);
+            call_new(dst_new, hits, intensities[i]);
+            if (memcmp(dst_ref, dst_new, 256))
+                fail();
+            bench_new(dst_new, hits, intensities[i]);
+        }
+    }
+}
+
+void checkasm_check_vf_vectorscope(void)
+{
+    VectorscopeDSPContext dsp;
+
+    ff_vectorscope_init_dsp(&dsp);
+
+    check_merge(&dsp);
+    report("merge");
+
+    check_add_hits(&dsp);
+    report("add_hits");
+}
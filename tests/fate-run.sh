@@ -352,6 +352,28 @@ concat(){
     fi
 }
 
+dashenc(){
+    mpdfile="${outdir}/${test}.mpd"
+    initfile="${outdir}/${test}-init.m4s"
+    mp4file="${outdir}/${test}.mp4"
+    cleanfiles="$mpdfile $initfile $mp4file"
+    ffmpeg "$@" -f dash -init_seg_name ${test}-init.m4s \
+        -media_seg_name ${test}-\$Number%05d\$.m4s -y $(target_path $mpdfile) || return
+    cat $mpdfile
+    do_md5sum $initfile
+    cat $initfile > $mp4file
+    nb=1
+    segfile=${outdir}/${test}-$(printf %05d $nb).m4s
+    while test -e $segfile; do
+        cleanfiles="$cleanfiles $segfile"
+        do_md5sum $segfile
+        cat $segfile >> $mp4file
+        nb=$((nb + 1))
+        segfile=${outdir}/${test}-$(printf %05d $nb).m4s
+    done
+    ffmpeg -i $(target_path $mp4file) -c copy -bitexact -f framecrc -
+}
+
 null(){
     :
 }
@@ -1,8 +1,10 @@
 FATE_CHECKASM = fate-checkasm-aacpsdsp                                  \
+                fate-checkasm-adler32                                   \
                 fate-checkasm-alacdsp                                   \
                 fate-checkasm-audiodsp                                  \
                 fate-checkasm-blockdsp                                  \
                 fate-checkasm-bswapdsp                                  \
+                fate-checkasm-crc                                       \
                 fate-checkasm-exrdsp                                    \
                 fate-checkasm-fixed_dsp                                 \
                 fate-checkasm-flacdsp                                   \
@@ -14,16 +16,22 @@ FATE_CHECKASM = fate-checkasm-aacpsdsp                                  \
                 fate-checkasm-h264qpel                                  \
                 fate-checkasm-hevc_add_res                              \
                 fate-checkasm-hevc_idct                                 \
+                fate-checkasm-imgutils                                  \
                 fate-checkasm-jpeg2000dsp                               \
                 fate-checkasm-llviddsp                                  \
                 fate-checkasm-pixblockdsp                               \
                 fate-checkasm-sbrdsp                                    \
+                fate-checkasm-sha                                       \
                 fate-checkasm-synth_filter                              \
                 fate-checkasm-v210enc                                   \
                 fate-checkasm-vf_blend                                  \
                 fate-checkasm-vf_colorspace                             \
                 fate-checkasm-vf_hflip                                  \
+                fate-checkasm-vf_nnedi                                  \
+                fate-checkasm-vf_smartblur                              \
                 fate-checkasm-vf_threshold                              \
+                fate-checkasm-vf_unsharp                                \
+                fate-checkasm-vf_vectorscope                            \
                 fate-checkasm-videodsp                                  \
                 fate-checkasm-vp8dsp                                    \
                 fate-checkasm-vp9dsp                                    \
@@ -0,0 +1,7 @@
+# Low latency streaming: one CMAF chunk (moof and mdat) per frame, written
+# to the segment files as soon as the frames are muxed.
+FATE_DASHENC-$(call ALLYES, DASH_MUXER MOV_DEMUXER MPEG4_ENCODER TESTSRC2_FILTER LAVFI_INDEV FRAMECRC_MUXER) += fate-dashenc-streaming
+fate-dashenc-streaming: CMD = dashenc -f lavfi -i testsrc2=size=160x120:rate=25:duration=2 -c:v mpeg4 -g 25 -threads 1 -idct simple -dct fastint -flags +bitexact -fflags +bitexact -streaming 1 -min_seg_duration 1000000
+
+FATE_FFMPEG += $(FATE_DASHENC-yes)
+fate-dashenc: $(FATE_DASHENC-yes)
@@ -62,9 +62,50 @@ fate-filter-paletteuse-bayer: CMD = framecrc -i $(TARGET_SAMPLES)/filter/anim.mk
 FATE_FILTER_PALETTEUSE += fate-filter-paletteuse-sierra2_4a
 fate-filter-paletteuse-sierra2_4a: CMD = framecrc -i $(TARGET_SAMPLES)/filter/anim.mkv -i $(TARGET_SAMPLES)/filter/anim-palette.png -lavfi paletteuse=sierra2_4a:diff_mode=rectangle -pix_fmt bgra
 
+FATE_FILTER_PALETTEUSE += fate-filter-paletteuse-bayer-threads
+fate-filter-paletteuse-bayer-threads: CMD = framecrc -i $(TARGET_SAMPLES)/filter/anim.mkv -i $(TARGET_SAMPLES)/filter/anim-palette.png -filter_threads 4 -lavfi paletteuse=bayer -pix_fmt bgra
+fate-filter-paletteuse-bayer-threads: REF = $(SRC_PATH)/tests/ref/fate/filter-paletteuse-bayer
+
+FATE_FILTER_PALETTEUSE += fate-filter-paletteuse-sierra2_4a-threads
+fate-filter-paletteuse-sierra2_4a-threads: CMD = framecrc -i $(TARGET_SAMPLES)/filter/anim.mkv -i $(TARGET_SAMPLES)/filter/anim-palette.png -filter_threads 4 -lavfi paletteuse=sierra2_4a:diff_mode=rectangle -pix_fmt bgra
+fate-filter-paletteuse-sierra2_4a-threads: REF = $(SRC_PATH)/tests/ref/fate/filter-paletteuse-sierra2_4a
+
 fate-filter-paletteuse: $(FATE_FILTER_PALETTEUSE)
 FATE_FILTER_SAMPLES-$(call ALLYES, PALETTEUSE_FILTER MATROSKA_DEMUXER H264_DECODER IMAGE2_DEMUXER PNG_DECODER) += $(FATE_FILTER_PALETTEUSE)
 
+FATE_FILTER-$(call ALLYES, TESTSRC2_FILTER SPLIT_FILTER PALETTEGEN_FILTER PALETTEUSE_FILTER) += fate-filter-paletteuse-bayer0
+fate-filter-paletteuse-bayer0: tests/data/filtergraphs/paletteuse-bayer0
+fate-filter-paletteuse-bayer0: CMD = framecrc -filter_complex_script $(TARGET_PATH)/tests/data/filtergraphs/paletteuse-bayer0 -pix_fmt bgra
+
+FATE_FILTER-$(call ALLYES, TESTSRC2_FILTER SPLIT_FILTER PALETTEGEN_FILTER PALETTEUSE_FILTER) += fate-filter-paletteuse-bayer0-threads
+fate-filter-paletteuse-bayer0-threads: tests/data/filtergraphs/paletteuse-bayer0
+fate-filter-paletteuse-bayer0-threads: CMD = framecrc -filter_threads 4 -filter_complex_script $(TARGET_PATH)/tests/data/filtergraphs/paletteuse-bayer0 -pix_fmt bgra
+fate-filter-paletteuse-bayer0-threads: REF = $(SRC_PATH)/tests/ref/fate/filter-paletteuse-bayer0
+
+FATE_FILTER_DRAWTEXT = drawtext=fontfile=$(TARGET_PATH)/tests/data/fonts/fate.bdf:text=FATE0123%{n}:x=7:y=33:fontcolor=white@0.7:box=1:boxborderw=3:boxcolor=blue@0.5:shadowx=2:shadowy=3:shadowcolor=red@0.5
+
+FATE_FILTER-$(call ALLYES, TESTSRC2_FILTER FORMAT_FILTER DRAWTEXT_FILTER) += fate-filter-drawtext
+fate-filter-drawtext: tests/data/fonts/fate.bdf
+fate-filter-drawtext: CMD = framecrc -lavfi testsrc2=s=160x120:r=5:d=2,format=yuv420p,$(FATE_FILTER_DRAWTEXT)
+
+FATE_FILTER-$(call ALLYES, TESTSRC2_FILTER FORMAT_FILTER DRAWTEXT_FILTER) += fate-filter-drawtext-threads
+fate-filter-drawtext-threads: tests/data/fonts/fate.bdf
+fate-filter-drawtext-threads: CMD = framecrc -filter_threads 4 -lavfi testsrc2=s=160x120:r=5:d=2,format=yuv420p,$(FATE_FILTER_DRAWTEXT)
+fate-filter-drawtext-threads: REF = $(SRC_PATH)/tests/ref/fate/filter-drawtext
+
+# static text reuses the cached run: the glyphs separated by the narrow 1 are
+# blended as one composited mask, the touching ones glyph by glyph
+FATE_FILTER_DRAWTEXT_STATIC = drawtext=fontfile=$(TARGET_PATH)/tests/data/fonts/fate.bdf:text=1F1A1T1E1:x=3+n:y=5+n*3:fontcolor=yellow@0.8:shadowx=-1:shadowy=2:shadowcolor=black@0.6,drawtext=fontfile=$(TARGET_PATH)/tests/data/fonts/fate.bdf:text=FATE0123:x=40-n:y=70:fontcolor=white@0.7:box=1:boxcolor=blue@0.5
+
+FATE_FILTER-$(call ALLYES, TESTSRC2_FILTER FORMAT_FILTER DRAWTEXT_FILTER) += fate-filter-drawtext-static
+fate-filter-drawtext-static: tests/data/fonts/fate.bdf
+fate-filter-drawtext-static: CMD = framecrc -lavfi testsrc2=s=160x120:r=5:d=2,format=yuv420p,$(FATE_FILTER_DRAWTEXT_STATIC)
+
+FATE_FILTER-$(call ALLYES, TESTSRC2_FILTER FORMAT_FILTER DRAWTEXT_FILTER) += fate-filter-drawtext-static-threads
+fate-filter-drawtext-static-threads: tests/data/fonts/fate.bdf
+fate-filter-drawtext-static-threads: CMD = framecrc -filter_threads 4 -lavfi testsrc2=s=160x120:r=5:d=2,format=yuv420p,$(FATE_FILTER_DRAWTEXT_STATIC)
+fate-filter-drawtext-static-threads: REF = $(SRC_PATH)/tests/ref/fate/filter-drawtext-static
+
 FATE_FILTER-$(call ALLYES, AVDEVICE LIFE_FILTER) += fate-filter-lavd-life
 fate-filter-lavd-life: CMD = framecrc -f lavfi -i life=s=40x40:r=5:seed=42:mold=64:ratio=0.1:death_color=red:life_color=green -t 2
 
@@ -113,6 +154,15 @@ FATE_FILTER-$(call ALLYES, FRAMERATE_FILTER TESTSRC2_FILTER) += fate-filter-fram
 fate-filter-framerate-up: CMD = framecrc -lavfi testsrc2=r=2:d=10,framerate=fps=10 -t 1
 fate-filter-framerate-down: CMD = framecrc -lavfi testsrc2=r=2:d=10,framerate=fps=1 -t 1
 
+FATE_FILTER-$(call ALLYES, MINTERPOLATE_FILTER TESTSRC2_FILTER) += fate-filter-minterpolate-bidir fate-filter-minterpolate-aobmc
+fate-filter-minterpolate-bidir: CMD = framecrc -lavfi testsrc2=s=176x144:r=5:d=1,minterpolate=fps=12:me_mode=bidir:me=umh -t 1
+fate-filter-minterpolate-aobmc: CMD = framecrc -lavfi testsrc2=s=176x144:r=5:d=1,minterpolate=fps=12:mc_mode=aobmc:vsbmc=1 -t 1
+
+FATE_FILTER-$(CONFIG_TONEMAP_FILTER) += fate-filter-tonemap-accuracy
+fate-filter-tonemap-accuracy: libavfilter/tests/tonemap$(EXESUF)
+fate-filter-tonemap-accuracy: CMD = run libavfilter/tests/tonemap
+fate-filter-tonemap-accuracy: CMP = null
+
 FATE_FILTER-$(call ALLYES, FRAMERATE_FILTER TESTSRC2_FILTER FORMAT_FILTER) += fate-filter-framerate-12bit-up fate-filter-framerate-12bit-down
 fate-filter-framerate-12bit-up: CMD = framecrc -lavfi testsrc2=r=50:d=1,format=pix_fmts=yuv422p12le,framerate=fps=60 -t 1 -pix_fmt yuv422p12le
 fate-filter-framerate-12bit-down: CMD = framecrc -lavfi testsrc2=r=60:d=1,format=pix_fmts=yuv422p12le,framerate=fps=50 -t 1 -pix_fmt yuv422p12le
@@ -120,6 +170,10 @@ fate-filter-framerate-12bit-down: CMD = framecrc -lavfi testsrc2=r=60:d=1,format
 FATE_FILTER_VSYNTH-$(CONFIG_BOXBLUR_FILTER) += fate-filter-boxblur
 fate-filter-boxblur: CMD = framecrc -c:v pgmyuv -i $(SRC) -vf boxblur=2:1
 
+FATE_FILTER_VSYNTH-$(CONFIG_BOXBLUR_FILTER) += fate-filter-boxblur-threads
+fate-filter-boxblur-threads: CMD = framecrc -c:v pgmyuv -i $(SRC) -filter_threads 4 -vf boxblur=2:1
+fate-filter-boxblur-threads: REF = $(SRC_PATH)/tests/ref/fate/filter-boxblur
+
 FATE_FILTER_VSYNTH-$(call ALLYES, COLORCHANNELMIXER_FILTER FORMAT_FILTER PERMS_FILTER) += fate-filter-colorchannelmixer
 fate-filter-colorchannelmixer: CMD = framecrc -c:v pgmyuv -i $(SRC) -vf format=rgb24,perms=random,colorchannelmixer=.31415927:.4:.31415927:0:.27182818:.8:.27182818:0:.2:.6:.2:0 -flags +bitexact -sws_flags +accurate_rnd+bitexact
 
@@ -148,6 +202,10 @@ fate-filter-gradfun: CMD = framecrc -c:v pgmyuv -i $(SRC) -vf gradfun
 FATE_FILTER_VSYNTH-$(CONFIG_HQDN3D_FILTER) += fate-filter-hqdn3d
 fate-filter-hqdn3d: CMD = framecrc -c:v pgmyuv -i $(SRC) -vf hqdn3d
 
+FATE_FILTER_VSYNTH-$(CONFIG_HQDN3D_FILTER) += fate-filter-hqdn3d-threads
+fate-filter-hqdn3d-threads: CMD = framecrc -c:v pgmyuv -i $(SRC) -filter_threads 4 -vf hqdn3d
+fate-filter-hqdn3d-threads: REF = $(SRC_PATH)/tests/ref/fate/filter-hqdn3d
+
 FATE_FILTER_VSYNTH-$(CONFIG_INTERLACE_FILTER) += fate-filter-interlace
 fate-filter-interlace: CMD = framecrc -c:v pgmyuv -i $(SRC) -vf interlace
 
@@ -157,15 +215,31 @@ fate-filter-interlace-complex: CMD = framecrc -c:v pgmyuv -i $(SRC) -vf interlac
 FATE_FILTER_VSYNTH-$(call ALLYES, NEGATE_FILTER PERMS_FILTER) += fate-filter-negate
 fate-filter-negate: CMD = framecrc -c:v pgmyuv -i $(SRC) -vf perms=random,negate
 
+FATE_FILTER_VSYNTH-$(call ALLYES, NEGATE_FILTER PERMS_FILTER) += fate-filter-negate-threads
+fate-filter-negate-threads: CMD = framecrc -c:v pgmyuv -i $(SRC) -filter_threads 4 -vf perms=random,negate
+fate-filter-negate-threads: REF = $(SRC_PATH)/tests/ref/fate/filter-negate
+
 FATE_FILTER_VSYNTH-$(CONFIG_HISTOGRAM_FILTER) += fate-filter-histogram-levels
 fate-filter-histogram-levels: CMD = framecrc -c:v pgmyuv -i $(SRC) -vf histogram -flags +bitexact -sws_flags +accurate_rnd+bitexact
 
+FATE_FILTER_VSYNTH-$(CONFIG_HISTOGRAM_FILTER) += fate-filter-histogram-levels-threads
+fate-filter-histogram-levels-threads: CMD = framecrc -c:v pgmyuv -i $(SRC) -filter_threads 4 -vf histogram -flags +bitexact -sws_flags +accurate_rnd+bitexact
+fate-filter-histogram-levels-threads: REF = $(SRC_PATH)/tests/ref/fate/filter-histogram-levels
+
 FATE_FILTER_VSYNTH-$(CONFIG_WAVEFORM_FILTER) += fate-filter-waveform_column
 fate-filter-waveform_column: CMD = framecrc -c:v pgmyuv -i $(SRC) -vf waveform -flags +bitexact -sws_flags +accurate_rnd+bitexact
 
+FATE_FILTER_VSYNTH-$(CONFIG_WAVEFORM_FILTER) += fate-filter-waveform_column-threads
+fate-filter-waveform_column-threads: CMD = framecrc -c:v pgmyuv -i $(SRC) -filter_threads 4 -vf waveform -flags +bitexact -sws_flags +accurate_rnd+bitexact
+fate-filter-waveform_column-threads: REF = $(SRC_PATH)/tests/ref/fate/filter-waveform_column
+
 FATE_FILTER_VSYNTH-$(CONFIG_WAVEFORM_FILTER) += fate-filter-waveform_row
 fate-filter-waveform_row: CMD = framecrc -c:v pgmyuv -i $(SRC) -vf waveform=m=row -flags +bitexact -sws_flags +accurate_rnd+bitexact
 
+FATE_FILTER_VSYNTH-$(CONFIG_WAVEFORM_FILTER) += fate-filter-waveform_row-threads
+fate-filter-waveform_row-threads: CMD = framecrc -c:v pgmyuv -i $(SRC) -filter_threads 4 -vf waveform=m=row -flags +bitexact -sws_flags +accurate_rnd+bitexact
+fate-filter-waveform_row-threads: REF = $(SRC_PATH)/tests/ref/fate/filter-waveform_row
+
 FATE_FILTER_VSYNTH-$(CONFIG_WAVEFORM_FILTER) += fate-filter-waveform_envelope
 fate-filter-waveform_envelope: CMD = framecrc -c:v pgmyuv -i $(SRC) -vf waveform=e=3 -flags +bitexact -sws_flags +accurate_rnd+bitexact
 
@@ -184,6 +258,10 @@ fate-filter-vectorscope_color2: CMD = framecrc -c:v pgmyuv -i $(SRC) -vf vectors
 FATE_FILTER_VSYNTH-$(CONFIG_VECTORSCOPE_FILTER) += fate-filter-vectorscope_color3
 fate-filter-vectorscope_color3: CMD = framecrc -c:v pgmyuv -i $(SRC) -vf vectorscope=color3 -sws_flags +accurate_rnd+bitexact -frames:v 3
 
+FATE_FILTER_VSYNTH-$(CONFIG_VECTORSCOPE_FILTER) += fate-filter-vectorscope_color3-threads
+fate-filter-vectorscope_color3-threads: CMD = framecrc -c:v pgmyuv -i $(SRC) -filter_threads 4 -vf vectorscope=color3 -sws_flags +accurate_rnd+bitexact -frames:v 3
+fate-filter-vectorscope_color3-threads: REF = $(SRC_PATH)/tests/ref/fate/filter-vectorscope_color3
+
 FATE_FILTER_VSYNTH-$(CONFIG_VECTORSCOPE_FILTER) += fate-filter-vectorscope_color4
 fate-filter-vectorscope_color4: CMD = framecrc -c:v pgmyuv -i $(SRC) -vf vectorscope=color4 -sws_flags +accurate_rnd+bitexact -frames:v 3
 
@@ -202,6 +280,18 @@ FATE_FILTER_VSYNTH-$(CONFIG_VSTACK_FILTER) += fate-filter-vstack
 fate-filter-vstack: tests/data/filtergraphs/vstack
 fate-filter-vstack: CMD = framecrc -c:v pgmyuv -i $(SRC) -c:v pgmyuv -i $(SRC) -filter_complex_script $(TARGET_PATH)/tests/data/filtergraphs/vstack
 
+FATE_FILTER-$(call ALLYES, TESTSRC2_FILTER FORMAT_FILTER SPLIT_FILTER SCALE_FILTER BOXBLUR_FILTER HSTACK_FILTER) += fate-filter-hstack-direct
+fate-filter-hstack-direct: tests/data/filtergraphs/hstack-direct
+fate-filter-hstack-direct: CMD = framecrc -filter_complex_script $(TARGET_PATH)/tests/data/filtergraphs/hstack-direct
+
+FATE_FILTER-$(call ALLYES, TESTSRC2_FILTER FORMAT_FILTER SPLIT_FILTER SCALE_FILTER BOXBLUR_FILTER VSTACK_FILTER) += fate-filter-vstack-direct
+fate-filter-vstack-direct: tests/data/filtergraphs/vstack-direct
+fate-filter-vstack-direct: CMD = framecrc -filter_complex_script $(TARGET_PATH)/tests/data/filtergraphs/vstack-direct
+
+FATE_FILTER-$(call ALLYES, TESTSRC2_FILTER FORMAT_FILTER SCALE_FILTER HSTACK_FILTER) += fate-filter-hstack-rates
+fate-filter-hstack-rates: tests/data/filtergraphs/hstack-rates
+fate-filter-hstack-rates: CMD = framecrc -filter_complex_script $(TARGET_PATH)/tests/data/filtergraphs/hstack-rates
+
 FATE_FILTER_VSYNTH-$(CONFIG_OVERLAY_FILTER) += fate-filter-overlay
 fate-filter-overlay: tests/data/filtergraphs/overlay
 fate-filter-overlay: CMD = framecrc -c:v pgmyuv -i $(SRC) -c:v pgmyuv -i $(SRC) -filter_complex_script $(TARGET_PATH)/tests/data/filtergraphs/overlay
@@ -390,6 +480,17 @@ FATE_FILTER_VSYNTH-$(CONFIG_TRIM_FILTER) += $(FATE_TRIM)
 FATE_FILTER_VSYNTH-$(CONFIG_UNSHARP_FILTER) += fate-filter-unsharp
 fate-filter-unsharp: CMD = framecrc -c:v pgmyuv -i $(SRC) -vf unsharp=11:11:-1.5:11:11:-1.5
 
+FATE_FILTER_VSYNTH-$(CONFIG_UNSHARP_FILTER) += fate-filter-unsharp-threads
+fate-filter-unsharp-threads: CMD = framecrc -c:v pgmyuv -i $(SRC) -filter_threads 4 -vf unsharp=11:11:-1.5:11:11:-1.5
+fate-filter-unsharp-threads: REF = $(SRC_PATH)/tests/ref/fate/filter-unsharp
+
+FATE_FILTER_VSYNTH-$(CONFIG_SMARTBLUR_FILTER) += fate-filter-smartblur
+fate-filter-smartblur: CMD = framecrc -c:v pgmyuv -i $(SRC) -vf smartblur=lr=2:ls=-0.8:lt=-8:cr=1.5:cs=0.6:ct=10
+
+FATE_FILTER_VSYNTH-$(CONFIG_SMARTBLUR_FILTER) += fate-filter-smartblur-threads
+fate-filter-smartblur-threads: CMD = framecrc -c:v pgmyuv -i $(SRC) -filter_threads 4 -vf smartblur=lr=2:ls=-0.8:lt=-8:cr=1.5:cs=0.6:ct=10
+fate-filter-smartblur-threads: REF = $(SRC_PATH)/tests/ref/fate/filter-smartblur
+
 FATE_FILTER_SAMPLES-$(call ALLYES, SMJPEG_DEMUXER MJPEG_DECODER PERMS_FILTER HQDN3D_FILTER) += fate-filter-hqdn3d-sample
 fate-filter-hqdn3d-sample: tests/data/filtergraphs/hqdn3d
 fate-filter-hqdn3d-sample: CMD = framecrc -idct simple -i $(TARGET_SAMPLES)/smjpeg/scenwin.mjpg -filter_complex_script $(TARGET_PATH)/tests/data/filtergraphs/hqdn3d -an
@@ -14,6 +14,10 @@ FATE_LIBAVFORMAT-$(CONFIG_SRTP) += fate-srtp
 fate-srtp: libavformat/tests/srtp$(EXESUF)
 fate-srtp: CMD = run libavformat/tests/srtp
 
+FATE_LIBAVFORMAT-$(CONFIG_UDP_PROTOCOL) += fate-udp
+fate-udp: libavformat/tests/udp$(EXESUF)
+fate-udp: CMD = run libavformat/tests/udp
+
 FATE_LIBAVFORMAT-yes += fate-url
 fate-url: libavformat/tests/url$(EXESUF)
 fate-url: CMD = run libavformat/tests/url
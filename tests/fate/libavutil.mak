@@ -94,6 +94,10 @@ FATE_LIBAVUTIL += fate-lfg
 fate-lfg: libavutil/tests/lfg$(EXESUF)
 fate-lfg: CMD = run libavutil/tests/lfg
 
+FATE_LIBAVUTIL-$(HAVE_THREADS) += fate-log
+fate-log: libavutil/tests/log$(EXESUF)
+fate-log: CMD = run libavutil/tests/log
+
 FATE_LIBAVUTIL += fate-md5
 fate-md5: libavutil/tests/md5$(EXESUF)
 fate-md5: CMD = run libavutil/tests/md5
@@ -134,6 +138,26 @@ FATE_LIBAVUTIL += fate-sha512
 fate-sha512: libavutil/tests/sha512$(EXESUF)
 fate-sha512: CMD = run libavutil/tests/sha512
 
+FATE_LIBAVUTIL-$(HAVE_THREADS) += fate-slicethread
+fate-slicethread: libavutil/tests/slicethread$(EXESUF)
+fate-slicethread: CMD = run libavutil/tests/slicethread
+fate-slicethread: CMP = null
+
+FATE_LIBAVUTIL-$(HAVE_THREADS) += fate-mem
+fate-mem: libavutil/tests/mem$(EXESUF)
+fate-mem: CMD = run libavutil/tests/mem
+fate-mem: CMP = null
+
+FATE_LIBAVUTIL-$(HAVE_THREADS) += fate-threadpool
+fate-threadpool: libavutil/tests/threadpool$(EXESUF)
+fate-threadpool: CMD = run libavutil/tests/threadpool
+fate-threadpool: CMP = null
+
+FATE_LIBAVUTIL-$(HAVE_THREADS) += fate-trace
+fate-trace: libavutil/tests/trace$(EXESUF)
+fate-trace: CMD = run libavutil/tests/trace
+fate-trace: CMP = null
+
 FATE_LIBAVUTIL += fate-tree
 fate-tree: libavutil/tests/tree$(EXESUF)
 fate-tree: CMD = run libavutil/tests/tree
@@ -52,7 +52,7 @@ do_image_formats()
     file=${outfile}%02d.$1
     run_avconv $DEC_OPTS -f image2 -vcodec pgmyuv -i $raw_src $2 $ENC_OPTS -frames 13 -y -qscale 10 $target_path/$file
     do_md5sum ${outfile}02.$1
-    do_avconv_crc $file $DEC_OPTS -i $target_path/$file $3
+    do_avconv_crc $file $DEC_OPTS $4 -i $target_path/$file $3
     echo $(wc -c ${outfile}02.$1)
 }
 
@@ -130,6 +130,8 @@ if [ -n "$do_mov" ] ; then
 mov_common_opt="-acodec pcm_alaw -vcodec mpeg4 -threads 1"
 do_lavf mov "" "-movflags +rtphint $mov_common_opt"
 do_lavf_timecode mov "-movflags +faststart $mov_common_opt"
+do_lavf mov "" "-movflags +faststart+reserve_moov $mov_common_opt"
+do_lavf mov "" "-movflags +faststart -moov_size 1000 $mov_common_opt"
 do_lavf_timecode mp4 "-vcodec mpeg4 -an -threads 1"
 fi
 
@@ -261,6 +263,7 @@ if [ -n "$do_png" ] ; then
 do_image_formats png
 do_image_formats png "-pix_fmt gray16be"
 do_image_formats png "-pix_fmt rgb48be"
+do_image_formats png "-io_threads 2" "" "-io_threads 2"
 fi
 
 if [ -n "$do_xbm" ] ; then